@@ -62,6 +62,7 @@ LOCAL_SRC_FILES  := LibOVR/Src/Kernel/OVR_Alg.cpp \
                     LibOVR/Src/OVR_SensorCalibration.cpp \
                     LibOVR/Src/OVR_GyroTempCalibration.cpp \
                     LibOVR/Src/OVR_SensorFusion.cpp \
+                    LibOVR/Src/OVR_SensorRecording.cpp \
                     LibOVR/Src/OVR_SensorTimeFilter.cpp \
                     LibOVR/Src/OVR_SensorImpl.cpp \
                     LibOVR/Src/OVR_ThreadCommandQueue.cpp \
@@ -73,6 +74,7 @@ LOCAL_SRC_FILES  := LibOVR/Src/Kernel/OVR_Alg.cpp \
                     LibOVR/Src/OVR_Stereo.cpp \
 					RayTracer/RtIntersect.cpp \
 					RayTracer/RtTrace.cpp \
+					RayTracer/RtTraceBuilder.cpp \
 					VRMenu/VRMenuComponent.cpp \
 					VRMenu/VRMenuMgr.cpp \
 					VRMenu/VRMenuObjectLocal.cpp \
@@ -82,6 +84,7 @@ LOCAL_SRC_FILES  := LibOVR/Src/Kernel/OVR_Alg.cpp \
 					VRMenu/VRMenu.cpp \
 					VRMenu/GuiSys.cpp \
 					VRMenu/FolderBrowser.cpp \
+					VRMenu/ThumbnailScheduler.cpp \
 					VRMenu/Fader.cpp \
 					VRMenu/DefaultComponent.cpp \
 					VRMenu/GlobalMenu.cpp \
@@ -100,6 +103,7 @@ LOCAL_SRC_FILES  := LibOVR/Src/Kernel/OVR_Alg.cpp \
                     VrApi/TimeWarp.cpp \
                     VrApi/TimeWarpProgs.cpp \
                     VrApi/ImageServer.cpp \
+                    VrApi/ImageStream.cpp \
                     VrApi/LocalPreferences.cpp \
                     VrApi/NativeBuildStrings.cpp \
 					VrApi/JniUtils.cpp \
@@ -116,6 +120,7 @@ LOCAL_SRC_FILES  := LibOVR/Src/Kernel/OVR_Alg.cpp \
                     VrCommon.cpp \
                     EyeBuffers.cpp \
                     MessageQueue.cpp \
+                    MessageChannel.cpp \
                     TalkToJava.cpp \
 					KeyState.cpp \
                     App.cpp \
@@ -126,6 +131,7 @@ LOCAL_SRC_FILES  := LibOVR/Src/Kernel/OVR_Alg.cpp \
                     MemBuffer.cpp \
                     ModelRender.cpp \
                     ModelFile.cpp \
+                    ModelFileBinary.cpp \
 					ModelCollision.cpp \
                     ModelView.cpp \
                     DebugLines.cpp \
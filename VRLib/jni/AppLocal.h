@@ -12,6 +12,7 @@ Copyright   :   Copyright 2014 Oculus VR, LLC. All Rights reserved.
 #define OVR_AppLocal_h
 
 #include "App.h"
+#include "MessageChannel.h"
 #include "SoundManager.h"
 
 namespace OVR {
@@ -209,6 +210,10 @@ public:
 	// Most calls in from java should communicate through this.
 	MessageQueue	vrMessageQueue;
 
+	// Input events from java go through this instead, so they don't need
+	// to be formatted and parsed, and can't overflow the message queue.
+	MessageChannel	vrInputChannel;
+
 	// From EnterVrMode, used for WarpSwap and LeaveVrMode
 	ovrMobile *		OvrMobile;
 
@@ -408,6 +413,9 @@ public:
 	// command processing.
 	void    		Command( const char * msg );
 
+	// Process input events posted to vrInputChannel.
+	void			Command( const channelMessage_t & msg );
+
 	// Shut down various subsystems
 	void			Pause();
 
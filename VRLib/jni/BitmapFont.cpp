@@ -29,8 +29,10 @@ Copyright   :   Copyright 2014 Oculus VR, LLC. All Rights reserved.
 #include <sys/resource.h>
 #include <sys/stat.h>
 
+#include "Kernel/OVR_Atomic.h"
 #include "Kernel/OVR_UTF8Util.h"
 #include "Kernel/OVR_String.h"
+#include "Kernel/OVR_Timer.h"
 
 #include "GlUtils.h"
 #include "GlProgram.h"
@@ -193,6 +195,10 @@ public:
 
 	FontGlyphType const &	GlyphForCharCode( uint32_t const charCode ) const { return FontInfo.GlyphForCharCode( charCode ); }
 	FontInfoType const &	GetFontInfo() const { return FontInfo; }
+
+	// Sets up fixed width printable ASCII glyphs without loading an image or a program,
+	// so the layout of text can be measured on the CPU.
+	void					InitFixedWidthGlyphs();
     const GlProgram &		GetFontProgram() const { return FontProgram; }
     int     				GetImageWidth() const { return ImageWidth; }
     int     				GetImageHeight() const { return ImageHeight; }
@@ -259,9 +265,23 @@ public:
 			        			Vector3f const & pos, float const scale, Vector4f const & color, 
                                 char const * fmt, ... );
 
+	virtual fontLayoutHandle_t	CreateTextLayout();
+	virtual void		FreeTextLayout( fontLayoutHandle_t & handle );
+	virtual void		SetTextLayout( fontLayoutHandle_t const handle, BitmapFont const & font, fontParms_t const & parms,
+								float const scale, Vector4f const & color, char const * text );
+	virtual void		DrawTextLayout3D( fontLayoutHandle_t const handle, Vector3f const & pos,
+								Vector3f const & normal, Vector3f const & up );
+
 	// transform the billboarded font strings
 	virtual void		Finish( Matrix4f const & viewMatrix );
 
+	// Allocates the vertices without creating the VBO, Init() calls this.
+	void				InitVertices( const int maxVertices );
+	// The CPU side of Finish(): transforms all vertex blocks into the vertices array.
+	void				TransformVertexBlocks( Matrix4f const & viewMatrix );
+	int					GetNumVertices() const { return CurVertex; }
+	fontVertex_t const *	GetVertices() const { return Vertices; }
+
     // render the VBO
 	virtual void		Render3D( BitmapFont const & font, Matrix4f const & worldMVP ) const;
 
@@ -273,102 +293,70 @@ private:
     int             CurVertex;  // reset every Render()
     int             CurIndex;   // reset every Render()
 
-	struct vertexBlockFlags_t
+	// The vertices of a vertex block are in text space, x to the right and y up, and pre-scaled.
+	// They are transformed into world space and stuffed into the VBO before rendering (once the
+	// current MVP is known). Billboarded blocks are pivoted around the Pivot point to face the
+	// camera, other blocks are oriented by Right and Up.
+	struct vertexBlock_t
 	{
-		bool		FaceCamera;		// true to always face the camera
+		int					Layout;		// index of the text layout with the vertices, or -1 for FrameVerts
+		UInt32				LayoutId;	// id of the layout when it was drawn, in case it is freed before Finish()
+		int					FirstVert;	// first vertex in FrameVerts, 0 for a layout
+		int					NumVerts;	// the number of vertices in the block
+		Vector3f			Pivot;		// postion this vertex block can be rotated around
+		Vector3f			Right;
+		Vector3f			Up;
+		bool				Billboard;	// true to always face the camera
+		bool				TrackRoll;	// if true, when billboarded, roll with the camera
 	};
 
-	// The vertices in a vertex block are in local space and pre-scaled.  They are transformed into 
-	// world space and stuffed into the VBO before rendering (once the current MVP is known).
-	// The vertices can be pivoted around the Pivot point to face the camera, then an additional
-	// rotation applied.
-	class VertexBlockType
-	{
-	public:
-		VertexBlockType() :
-			Font( NULL ),
-			Verts( NULL ),
-			NumVerts( 0 ),
-			Pivot( 0.0f ),
-			Rotation(),
-			Billboard( true ),
-			TrackRoll( false )
-		{
-		}
+	// The arrays only ever grow, so once they are large enough drawing text does not allocate.
+	typedef ArrayConstPolicy< 0, 16, true > VertexArrayPolicy;
+	typedef ArrayPOD< fontVertex_t, VertexArrayPolicy > VertexArray;
 
-		VertexBlockType( VertexBlockType const & other ) :
+	// A text layout keeps the vertices of its text between frames, and they are only
+	// laid out again when the text or anything that changes the glyph quads changes.
+	struct textLayout_t
+	{
+		textLayout_t() :
+			Id( 0 ),
 			Font( NULL ),
-			Verts( NULL ),
-			NumVerts( 0 ),
-			Pivot( 0.0f ),
-			Rotation(),
-			Billboard( true ),
-			TrackRoll( false )
+			Scale( 0.0f ),
+			Color( 0.0f )
 		{
-			Copy( other );
 		}
 
-		VertexBlockType & operator=( VertexBlockType const & other )
-		{
-			Copy( other );
-			return *this;
-		}
-
-		void Copy( VertexBlockType const & other )
-		{
-			if ( &other == this )
-			{
-				return;
-			}
-			delete [] Verts;
-			Font		= other.Font;
-			Verts		= other.Verts;
-			NumVerts	= other.NumVerts;
-			Pivot		= other.Pivot;
-			Rotation	= other.Rotation;
-			Billboard	= other.Billboard;
-			TrackRoll	= other.TrackRoll;
-			
-			other.Font = NULL;
-			other.Verts = NULL;
-			other.NumVerts = 0;
-		}
-
-		VertexBlockType( BitmapFont const & font, int const numVerts, Vector3f const & pivot, 
-				Quatf const & rot, bool const billboard, bool const trackRoll ) :
-			Font( &font ),
-			NumVerts( numVerts ),
-			Pivot( pivot ),
-			Rotation( rot ),
-			Billboard( billboard ),
-			TrackRoll( trackRoll )
-		{
-			Verts = new fontVertex_t[numVerts];			
-		}
+		UInt32					Id;			// 0 if the layout is free
+		BitmapFont const *		Font;		// NULL until the layout is set
+		fontParms_t				Parms;
+		float					Scale;
+		Vector4f				Color;
+		String					Text;
+		VertexArray				Verts;		// text space, pre-scaled
+	};
 
-		~VertexBlockType()
-		{
-			Free();
-		}
+	struct vbSort_t
+	{
+		int		VertexBlockIndex;
+		float	DistanceSquared;
+	};
 
-		void Free() 
-		{
-			Font = NULL;
-			delete [] Verts;
-			Verts = NULL;
-			NumVerts = 0;
-		}
+	static int			VertexBlockSortFn( void const * a, void const * b );
 
-		mutable BitmapFont const *	Font;		// the font used to render text into this vertex block 
-		mutable fontVertex_t *		Verts;		// the vertices
-		mutable int					NumVerts;	// the number of vertices in the block
-		Vector3f					Pivot;		// postion this vertex block can be rotated around
-		Quatf						Rotation;	// additional rotation to apply
-		bool						Billboard;	// true to always face the camera
-		bool						TrackRoll;	// if true, when billboarded, roll with the camera
-	};
+	ArrayPOD< vertexBlock_t, VertexArrayPolicy >	VertexBlocks;	// blocks drawn since the last Finish()
+	VertexArray					FrameVerts;		// vertices of the text drawn with DrawText3D since the last Finish()
+	ArrayPOD< vbSort_t, VertexArrayPolicy >		SortedBlocks;
+	Array< textLayout_t >		Layouts;
+	Array< int >				FreeLayouts;	// indices of free Layouts
+	UInt32						NextLayoutId;
 
-	Array< VertexBlockType >	    VertexBlocks;	// each pointer in the array points to an allocated block ov
+	// appends the vertices of the text to verts, in text space
+	int					LayoutText( BitmapFont const & font, fontParms_t const & parms, float const scale,
+								Vector4f const & color, char const * text, VertexArray & verts ) const;
+	textLayout_t *		GetLayout( fontLayoutHandle_t const handle );
+	void				AddVertexBlock( int const layout, UInt32 const layoutId, int const firstVert, int const numVerts,
+								Vector3f const & pivot, Vector3f const & normal, Vector3f const & up,
+								bool const billboard, bool const trackRoll );
 
     // We cast BitmapFont to BitmapFontLocal internally so that we do not have to expose
     // a lot of BitmapFontLocal methods in the BitmapFont interface just so BitmapFontSurfaceLocal
@@ -478,8 +466,8 @@ bool FontInfoType::Load( OvrApkFile const & languagePackageFile, char const * fi
 bool FontInfoType::LoadFromBuffer( void const * buffer, size_t const bufferSize ) 
 {
 	char const * errorMsg = NULL;
-	OVR::JSON * jsonRoot = OVR::JSON::Parse( reinterpret_cast< char const * >( buffer ), &errorMsg );
-	if ( jsonRoot == NULL )
+	OVR::JsonDocument jsonRoot;
+	if ( !jsonRoot.Parse( reinterpret_cast< char const * >( buffer ), &errorMsg ) )
 	{
 		LOG( "JSON Error: %s", ( errorMsg != NULL ) ? errorMsg : "<NULL>" );
 		return false;
@@ -493,17 +481,15 @@ bool FontInfoType::LoadFromBuffer( void const * buffer, size_t const bufferSize
 	static const int MAX_GLYPHS = 0xffff;	
 
 	// load the glyphs
-	const JsonReader jsonGlyphs( jsonRoot );
+	const JsonNodeReader jsonGlyphs( jsonRoot.GetRoot() );
 	if ( !jsonGlyphs.IsObject() )
 	{
-		jsonRoot->Release();
 		return false;
 	}
 
 	int Version = jsonGlyphs.GetChildFloatByName( "Version" );
 	if ( Version != FNT_FILE_VERSION )
 	{
-		jsonRoot->Release();
 		return false;
 	}
 
@@ -514,7 +500,6 @@ bool FontInfoType::LoadFromBuffer( void const * buffer, size_t const bufferSize
 	if ( numGlyphs < 0 || numGlyphs > MAX_GLYPHS )
 	{
 		OVR_ASSERT( numGlyphs > 0 && numGlyphs <= MAX_GLYPHS );
-		jsonRoot->Release();
 		return false;
 	}
 
@@ -551,13 +536,13 @@ bool FontInfoType::LoadFromBuffer( void const * buffer, size_t const bufferSize
 
 	Glyphs.Resize( numGlyphs );
 
-	const JsonReader jsonGlyphArray( jsonGlyphs.GetChildByName( "Glyphs" ) );
+	const JsonNodeReader jsonGlyphArray( jsonGlyphs.GetChildByName( "Glyphs" ) );
 	double totalWidth = 0.0;
 	if ( jsonGlyphArray.IsArray() )
 	{
 		for ( int i = 0; i < Glyphs.GetSizeI() && !jsonGlyphArray.IsEndOfArray(); i++ )
 		{
-			const JsonReader jsonGlyph( jsonGlyphArray.GetNextArrayElement() );
+			const JsonNodeReader jsonGlyph( jsonGlyphArray.GetNextArrayElement() );
 			if ( jsonGlyph.IsObject() )
 			{
 				FontGlyphType & g = Glyphs[i];
@@ -613,8 +598,6 @@ bool FontInfoType::LoadFromBuffer( void const * buffer, size_t const bufferSize
 		CharCodeMap[g.CharCode] = i;
 	}
 
-	jsonRoot->Release();
-
 	return true;
 }
 
@@ -886,6 +869,42 @@ bool BitmapFontLocal::LoadImageFromBuffer( char const * imageName, unsigned char
     return true;
 }
 
+//==============================
+// BitmapFontLocal::InitFixedWidthGlyphs
+void BitmapFontLocal::InitFixedWidthGlyphs()
+{
+	// printable ASCII in a 16 x 6 grid of cells
+	float const cellWidth = 1.0f / 16.0f;
+	float const cellHeight = 1.0f / 8.0f;
+
+	FontInfo = FontInfoType();
+	FontInfo.FontName = "FixedWidth";
+	FontInfo.FontHeight = cellHeight;
+	FontInfo.ScaleFactor = FontInfoType::DEFAULT_SCALE_FACTOR * 0.0025f;
+	FontInfo.Glyphs.Resize( 128 - ' ' );
+	FontInfo.CharCodeMap.Resize( 128 );
+	for ( int i = 0; i < FontInfo.CharCodeMap.GetSizeI(); i++ )
+	{
+		FontInfo.CharCodeMap[i] = 0;	// anything that is not printable is a space
+	}
+	for ( int i = 0; i < FontInfo.Glyphs.GetSizeI(); i++ )
+	{
+		FontGlyphType & g = FontInfo.Glyphs[i];
+		g.CharCode = ' ' + i;
+		g.X = ( i % 16 ) * cellWidth;
+		g.Y = ( i / 16 ) * cellHeight;
+		g.Width = cellWidth * 0.75f;
+		g.Height = cellHeight * 0.9f;
+		g.AdvanceX = cellWidth * 0.8f;
+		g.AdvanceY = cellHeight;
+		g.BearingX = cellWidth * 0.05f;
+		g.BearingY = cellHeight * 0.7f;
+		FontInfo.CharCodeMap[g.CharCode] = i;
+	}
+	ImageWidth = 512;
+	ImageHeight = 512;
+}
+
 //==============================
 // BitmapFontLocal::WordWrapText
 void BitmapFontLocal::WordWrapText( String & inOutText, const float widthMeters, const float fontScale ) const
@@ -1083,7 +1102,8 @@ BitmapFontSurfaceLocal::BitmapFontSurfaceLocal() :
     MaxVertices( 0 ),
     MaxIndices( 0 ),
     CurVertex( 0 ),
-    CurIndex( 0 )
+    CurIndex( 0 ),
+    NextLayoutId( 1 )
 {
 }
 
@@ -1091,7 +1111,11 @@ BitmapFontSurfaceLocal::BitmapFontSurfaceLocal() :
 // BitmapFontSurfaceLocal::~BitmapFontSurfaceLocal
  BitmapFontSurfaceLocal::~BitmapFontSurfaceLocal()
 {
-    Geo.Free();
+	// the benchmark only allocates the vertices
+	if ( Geo.vertexArrayObject != 0 )
+	{
+	    Geo.Free();
+	}
 	delete [] Vertices;
 	Vertices = NULL;
 }
@@ -1102,18 +1126,8 @@ BitmapFontSurfaceLocal::BitmapFontSurfaceLocal() :
 void BitmapFontSurfaceLocal::Init( const int maxVertices ) 
 {
     assert( Geo.vertexBuffer == 0 && Geo.indexBuffer == 0 && Geo.vertexArrayObject == 0 );
-    assert( Vertices == NULL );
-    if ( Vertices != NULL ) 
-    {
-        delete [] Vertices;
-        Vertices = NULL;
-    }
-    assert( maxVertices % 4 == 0 );
 
-    MaxVertices = maxVertices;
-    MaxIndices = ( maxVertices / 4 ) * 6;
-
-    Vertices = new fontVertex_t[ maxVertices ];
+    InitVertices( maxVertices );
     const int vertexByteCount = maxVertices * sizeof( fontVertex_t );
 
 	// font VAO
@@ -1165,10 +1179,28 @@ void BitmapFontSurfaceLocal::Init( const int maxVertices )
 
     delete [] indices;
 
+    LOG( "BitmapFontSurfaceLocal::Init: success" );
+}
+
+//==============================
+// BitmapFontSurfaceLocal::InitVertices
+void BitmapFontSurfaceLocal::InitVertices( const int maxVertices )
+{
+    assert( Vertices == NULL );
+    if ( Vertices != NULL ) 
+    {
+        delete [] Vertices;
+        Vertices = NULL;
+    }
+    assert( maxVertices % 4 == 0 );
+
+    MaxVertices = maxVertices;
+    MaxIndices = ( maxVertices / 4 ) * 6;
+
+    Vertices = new fontVertex_t[ maxVertices ];
+
     CurVertex = 0;
     CurIndex = 0;
-
-    LOG( "BitmapFontSurfaceLocal::Init: success" );
 }
 
 //==============================
@@ -1184,14 +1216,14 @@ int32_t ColorToABGR( Vector4f const & color )
 
 
 //==============================
-// BitmapFontSurfaceLocal::DrawText3D
-void BitmapFontSurfaceLocal::DrawText3D( BitmapFont const & font, fontParms_t const & parms,
-		Vector3f const & pos, Vector3f const & normal, Vector3f const & up,
-		float scale, Vector4f const & color, char const * text )
+// BitmapFontSurfaceLocal::LayoutText
+// Lays out the glyph quads in text space, with x to the right and y up.
+int BitmapFontSurfaceLocal::LayoutText( BitmapFont const & font, fontParms_t const & parms, float const scale,
+		Vector4f const & color, char const * text, VertexArray & verts ) const
 {
 	if ( text == NULL || text[0] == '\0' )
 	{
-		return;	// nothing to do here, move along
+		return 0;	// nothing to do here, move along
 	}
 
 	// TODO: multiple line support -- we would need to calculate the horizontal width
@@ -1210,25 +1242,22 @@ void BitmapFontSurfaceLocal::DrawText3D( BitmapFont const & font, fontParms_t co
 //			width, height, numLines, AsLocal( font ).GetFontInfo().FontHeight );
 	if ( len == 0 )
 	{
-		return;
+		return 0;
 	}
 
-	DROID_ASSERT( normal.IsNormalized(), "BitmapFont" );
-	DROID_ASSERT( up.IsNormalized(), "BitmapFont" );
-
 	const FontInfoType & fontInfo = AsLocal( font ).GetFontInfo();
 
 	float imageWidth = (float)AsLocal( font ).GetImageWidth();
 	float const xScale = AsLocal( font ).GetFontInfo().ScaleFactor * scale;
 	float const yScale = AsLocal( font ).GetFontInfo().ScaleFactor * scale;
 
-	// allocate a vertex block
-	size_t numVerts = 4 * len;
-	VertexBlockType vb( font, numVerts, pos, Quatf(), parms.Billboard, parms.TrackRoll );
+	// append the vertices, the array keeps its memory from frame to frame
+	int const numVerts = 4 * len;
+	int const firstVert = verts.GetSizeI();
+	verts.Resize( firstVert + numVerts );
 
-	Vector3f const right = up.Cross( normal );
-	Vector3f const r = ( parms.Billboard ) ? Vector3f( 1.0f, 0.0f, 0.0f ) : right;
-	Vector3f const u = ( parms.Billboard ) ? Vector3f( 0.0f, 1.0f, 0.0f ) : up;
+	Vector3f const r( 1.0f, 0.0f, 0.0f );
+	Vector3f const u( 0.0f, 1.0f, 0.0f );
 
 	Vector3f curPos( 0.0f );
 	if ( parms.CenterVert )
@@ -1256,7 +1285,7 @@ void BitmapFontSurfaceLocal::DrawText3D( BitmapFont const & font, fontParms_t co
     int iColor = ColorToABGR( color );
 
 	int curLine = 0;
-	fontVertex_t * v = vb.Verts;
+	fontVertex_t * v = &verts[firstVert];
 	char const * p = text;
 	size_t i = 0;
 	uint32_t charCode = UTF8Util::DecodeNextChar( &p );
@@ -1315,10 +1344,169 @@ void BitmapFontSurfaceLocal::DrawText3D( BitmapFont const & font, fontParms_t co
 		// advance to start of next char
 		curPos += r * ( g.AdvanceX * xScale );
 	}
-	// add the new vertex block to the array of vertex blocks
+	return numVerts;
+}
+
+//==============================
+// BitmapFontSurfaceLocal::AddVertexBlock
+void BitmapFontSurfaceLocal::AddVertexBlock( int const layout, UInt32 const layoutId, int const firstVert, int const numVerts,
+		Vector3f const & pivot, Vector3f const & normal, Vector3f const & up, bool const billboard, bool const trackRoll )
+{
+	vertexBlock_t vb;
+	vb.Layout = layout;
+	vb.LayoutId = layoutId;
+	vb.FirstVert = firstVert;
+	vb.NumVerts = numVerts;
+	vb.Pivot = pivot;
+	vb.Right = ( billboard ) ? Vector3f( 1.0f, 0.0f, 0.0f ) : up.Cross( normal );
+	vb.Up = ( billboard ) ? Vector3f( 0.0f, 1.0f, 0.0f ) : up;
+	vb.Billboard = billboard;
+	vb.TrackRoll = trackRoll;
 	VertexBlocks.PushBack( vb );
 }
 
+//==============================
+// BitmapFontSurfaceLocal::DrawText3D
+void BitmapFontSurfaceLocal::DrawText3D( BitmapFont const & font, fontParms_t const & parms,
+		Vector3f const & pos, Vector3f const & normal, Vector3f const & up,
+		float scale, Vector4f const & color, char const * text )
+{
+	DROID_ASSERT( normal.IsNormalized(), "BitmapFont" );
+	DROID_ASSERT( up.IsNormalized(), "BitmapFont" );
+
+	int const firstVert = FrameVerts.GetSizeI();
+	int const numVerts = LayoutText( font, parms, scale, color, text, FrameVerts );
+	if ( numVerts == 0 )
+	{
+		return;
+	}
+	AddVertexBlock( -1, 0, firstVert, numVerts, pos, normal, up, parms.Billboard, parms.TrackRoll );
+}
+
+//==============================
+// BitmapFontSurfaceLocal::CreateTextLayout
+fontLayoutHandle_t BitmapFontSurfaceLocal::CreateTextLayout()
+{
+	int index;
+	if ( FreeLayouts.GetSizeI() > 0 )
+	{
+		index = FreeLayouts.Back();
+		FreeLayouts.PopBack();
+	}
+	else
+	{
+		index = Layouts.GetSizeI();
+		Layouts.PushBack( textLayout_t() );
+	}
+	textLayout_t & layout = Layouts[index];
+	layout.Id = NextLayoutId++;
+	if ( NextLayoutId == 0 )
+	{
+		NextLayoutId = 1;
+	}
+	layout.Font = NULL;
+	layout.Text.Clear();
+	layout.Verts.Clear();
+	return fontLayoutHandle_t( ( (UInt64)layout.Id << 32 ) | (UInt64)index );
+}
+
+//==============================
+// BitmapFontSurfaceLocal::GetLayout
+BitmapFontSurfaceLocal::textLayout_t * BitmapFontSurfaceLocal::GetLayout( fontLayoutHandle_t const handle )
+{
+	if ( !handle.IsValid() )
+	{
+		return NULL;
+	}
+	int const index = (int)( handle.Get() & 0xFFFFFFFF );
+	UInt32 const id = (UInt32)( handle.Get() >> 32 );
+	if ( index < 0 || index >= Layouts.GetSizeI() || Layouts[index].Id != id || id == 0 )
+	{
+		return NULL;
+	}
+	return &Layouts[index];
+}
+
+//==============================
+// BitmapFontSurfaceLocal::FreeTextLayout
+void BitmapFontSurfaceLocal::FreeTextLayout( fontLayoutHandle_t & handle )
+{
+	textLayout_t * layout = GetLayout( handle );
+	handle = fontLayoutHandle_t();
+	if ( layout == NULL )
+	{
+		return;
+	}
+	layout->Id = 0;
+	layout->Font = NULL;
+	// keep the memory of the vertices for the next layout that uses the slot
+	layout->Verts.Clear();
+	FreeLayouts.PushBack( (int)( layout - &Layouts[0] ) );
+}
+
+//==============================
+// BitmapFontSurfaceLocal::SetTextLayout
+void BitmapFontSurfaceLocal::SetTextLayout( fontLayoutHandle_t const handle, BitmapFont const & font,
+		fontParms_t const & parms, float const scale, Vector4f const & color, char const * text )
+{
+	textLayout_t * layout = GetLayout( handle );
+	if ( layout == NULL )
+	{
+		DROID_ASSERT( handle.IsValid() == false, "BitmapFont" );
+		return;
+	}
+	if ( text == NULL )
+	{
+		text = "";
+	}
+
+	bool const sameLayout = layout->Font == &font && layout->Scale == scale &&
+			layout->Parms.CenterHoriz == parms.CenterHoriz && layout->Parms.CenterVert == parms.CenterVert &&
+			layout->Parms.Billboard == parms.Billboard && layout->Parms.TrackRoll == parms.TrackRoll &&
+			layout->Parms.AlphaCenter == parms.AlphaCenter && layout->Parms.ColorCenter == parms.ColorCenter &&
+			OVR_strcmp( layout->Text.ToCStr(), text ) == 0;
+	if ( sameLayout )
+	{
+		if ( layout->Color != color )
+		{
+			// only the color changed, so the glyph quads stay where they are
+			layout->Color = color;
+			UInt32 const iColor = ColorToABGR( color );
+			for ( int i = 0; i < layout->Verts.GetSizeI(); i++ )
+			{
+				*(UInt32*)(&layout->Verts[i].rgba[0]) = iColor;
+			}
+		}
+		return;
+	}
+
+	layout->Font = &font;
+	layout->Parms = parms;
+	layout->Scale = scale;
+	layout->Color = color;
+	layout->Text = text;
+	layout->Verts.Clear();
+	LayoutText( font, parms, scale, color, text, layout->Verts );
+}
+
+//==============================
+// BitmapFontSurfaceLocal::DrawTextLayout3D
+void BitmapFontSurfaceLocal::DrawTextLayout3D( fontLayoutHandle_t const handle, Vector3f const & pos,
+		Vector3f const & normal, Vector3f const & up )
+{
+	textLayout_t * layout = GetLayout( handle );
+	if ( layout == NULL || layout->Verts.GetSizeI() == 0 )
+	{
+		return;
+	}
+	DROID_ASSERT( normal.IsNormalized(), "BitmapFont" );
+	DROID_ASSERT( up.IsNormalized(), "BitmapFont" );
+
+	AddVertexBlock( (int)( layout - &Layouts[0] ), layout->Id, 0, layout->Verts.GetSizeI(), pos, normal, up,
+			layout->Parms.Billboard, layout->Parms.TrackRoll );
+}
+
+
 //==============================
 // BitmapFontSurfaceLocal::DrawText3Df
 void BitmapFontSurfaceLocal::DrawText3Df( BitmapFont const & font, fontParms_t const & parms,
@@ -1358,20 +1546,10 @@ void BitmapFontSurfaceLocal::DrawTextBillboarded3Df( BitmapFont const & font, fo
 }
 
 
-//==============================================================
-// vbSort_t
-// small structure that is used to sort vertex blocks by their distance to the camera
-//==============================================================
-struct vbSort_t 
-{
-	int		VertexBlockIndex;
-	float	DistanceSquared;
-};
-
 //==============================
-// VertexBlockSortFn
+// BitmapFontSurfaceLocal::VertexBlockSortFn
 // sort function for vertex blocks
-int VertexBlockSortFn( void const * a, void const * b )
+int BitmapFontSurfaceLocal::VertexBlockSortFn( void const * a, void const * b )
 {
 	return ftoi( ((vbSort_t const*)a)->DistanceSquared - ((vbSort_t const*)b)->DistanceSquared );
 }
@@ -1387,21 +1565,36 @@ void BitmapFontSurfaceLocal::Finish( Matrix4f const & viewMatrix )
 
 	//SPAM( "BitmapFontSurfaceLocal::Finish" );
 
+	TransformVertexBlocks( viewMatrix );
+
+	glBindVertexArrayOES_( Geo.vertexArrayObject );
+	glBindBuffer( GL_ARRAY_BUFFER, Geo.vertexBuffer );
+	glBufferSubData( GL_ARRAY_BUFFER, 0, CurVertex * sizeof( fontVertex_t ), (void *)Vertices );
+	glBindVertexArrayOES_( 0 );
+	
+    Geo.indexCount = CurIndex;
+}
+
+//==============================
+// BitmapFontSurfaceLocal::TransformVertexBlocks
+void BitmapFontSurfaceLocal::TransformVertexBlocks( Matrix4f const & viewMatrix )
+{
 	Matrix4f invViewMatrix = viewMatrix.Inverted(); // if the view is never scaled or sheared we could use Transposed() here instead
 	Vector3f viewPos = invViewMatrix.GetTranslation();
 
 	// sort vertex blocks indices based on distance to pivot
-	int const MAX_VERTEX_BLOCKS = 256;
-	vbSort_t vbSort[MAX_VERTEX_BLOCKS];
 	int const n = VertexBlocks.GetSizeI();
+	SortedBlocks.Resize( n );
 	for ( int i = 0; i < n; ++i )
 	{
-		vbSort[i].VertexBlockIndex = i;
-		VertexBlockType & vb = VertexBlocks[i];
-		vbSort[i].DistanceSquared = ( vb.Pivot - viewPos ).LengthSq();
+		SortedBlocks[i].VertexBlockIndex = i;
+		SortedBlocks[i].DistanceSquared = ( VertexBlocks[i].Pivot - viewPos ).LengthSq();
 	}
 
-	qsort( vbSort, n, sizeof( vbSort[0] ), VertexBlockSortFn );
+	if ( n > 1 )
+	{
+		qsort( &SortedBlocks[0], n, sizeof( vbSort_t ), VertexBlockSortFn );
+	}
 
 	// transform the vertex blocks into the vertices array
 	CurIndex = 0;
@@ -1411,9 +1604,30 @@ void BitmapFontSurfaceLocal::Finish( Matrix4f const & viewMatrix )
 	// To add multiple-font-per-surface support, we need to add a 3rd component to s and t, 
 	// then get the font for each vertex block, and set the texture index on each vertex in 
 	// the third texture coordinate.
-	for ( int i = 0; i < VertexBlocks.GetSizeI(); ++i )
+	for ( int i = 0; i < n; ++i )
 	{		
-		VertexBlockType & vb = VertexBlocks[vbSort[i].VertexBlockIndex];
+		vertexBlock_t const & vb = VertexBlocks[SortedBlocks[i].VertexBlockIndex];
+		fontVertex_t const * verts;
+		if ( vb.Layout >= 0 )
+		{
+			textLayout_t const & layout = Layouts[vb.Layout];
+			if ( layout.Id != vb.LayoutId || layout.Verts.GetSizeI() < vb.NumVerts )
+			{
+				continue;	// freed or changed since it was drawn
+			}
+			verts = &layout.Verts[0];
+		}
+		else
+		{
+			verts = &FrameVerts[vb.FirstVert];
+		}
+
+		if ( CurVertex + vb.NumVerts > MaxVertices )
+		{
+			LOG( "BitmapFontSurfaceLocal: out of vertices, %i needed, %i max", CurVertex + vb.NumVerts, MaxVertices );
+			break;
+		}
+
 		Matrix4f transform;
 		if ( vb.Billboard )
 		{
@@ -1431,13 +1645,17 @@ void BitmapFontSurfaceLocal::Finish( Matrix4f const & viewMatrix )
 		}
 		else
 		{
-			transform.SetIdentity();
-			transform.SetTranslation( vb.Pivot );
+			// text space x and y go along Right and Up
+			transform = Matrix4f(
+					vb.Right.x, vb.Up.x, 0.0f, vb.Pivot.x,
+					vb.Right.y, vb.Up.y, 0.0f, vb.Pivot.y,
+					vb.Right.z, vb.Up.z, 0.0f, vb.Pivot.z,
+					0.0f, 0.0f, 0.0f, 1.0f );
 		}
 
 		for ( int j = 0; j < vb.NumVerts; j++ )
 		{
-			fontVertex_t const & v = vb.Verts[j];
+			fontVertex_t const & v = verts[j];
 			Vertices[CurVertex].xyz = transform.Transform( v.xyz );
 			Vertices[CurVertex].s = v.s;
 			Vertices[CurVertex].t = v.t;			
@@ -1446,19 +1664,11 @@ void BitmapFontSurfaceLocal::Finish( Matrix4f const & viewMatrix )
 			CurVertex++;
 		}
 		CurIndex += ( vb.NumVerts / 2 ) * 3;
-		// free this vertex block
-		vb.Free();
 	}
-	// remove all elements from the vertex block (but don't free the memory since it's likely to be 
+	// remove all elements from the vertex blocks (the memory is not freed since it's likely to be 
 	// needed on the next frame.
 	VertexBlocks.Clear();
-
-	glBindVertexArrayOES_( Geo.vertexArrayObject );
-	glBindBuffer( GL_ARRAY_BUFFER, Geo.vertexBuffer );
-	glBufferSubData( GL_ARRAY_BUFFER, 0, CurVertex * sizeof( fontVertex_t ), (void *)Vertices );
-	glBindVertexArrayOES_( 0 );
-	
-    Geo.indexCount = CurIndex;
+	FrameVerts.Clear();
 }
 
 //==============================
@@ -1522,6 +1732,15 @@ void BitmapFont::Free( BitmapFont * & font )
     }
 }
 
+static AtomicInt< UInt32 > NextFontSurfaceId( 1 );
+
+//==============================
+// BitmapFontSurface::BitmapFontSurface
+BitmapFontSurface::BitmapFontSurface() :
+    Id( NextFontSurfaceId.ExchangeAdd_Sync( 1 ) )
+{
+}
+
 //==============================
 // BitmapFontSurface::Create
 BitmapFontSurface * BitmapFontSurface::Create()
@@ -1540,5 +1759,122 @@ void BitmapFontSurface::Free( BitmapFontSurface * & fontSurface )
     }
 }
 
+//==============================
+// BitmapFontSurfaceBenchmark
+void BitmapFontSurfaceBenchmark( void * appPtr, const char * cmd )
+{
+	OVR_UNUSED( appPtr );
+
+	int numLabels = 300;
+	int numFrames = 200;
+	sscanf( cmd, "%i %i", &numLabels, &numFrames );
+	numLabels = Alg::Clamp( numLabels, 1, 4096 );
+	numFrames = Alg::Max( numFrames, 1 );
+
+	BitmapFontLocal font;
+	font.InitFixedWidthGlyphs();
+
+	// Menu like labels on a few panels around the viewer, some of them on more than
+	// one line and every eighth one billboarded.
+	static const char * words[] = { "Play", "Settings", "Library", "Recently Played", "Store", "Download", "Resume",
+								"Options", "Brightness", "Volume", "Back", "Cancel" };
+	static const int numWords = sizeof( words ) / sizeof( words[0] );
+	Array< String > texts;
+	Array< Vector3f > positions;
+	Array< Vector3f > normals;
+	fontParms_t parms;
+	parms.CenterHoriz = true;
+	parms.CenterVert = true;
+	fontParms_t billboardParms = parms;
+	billboardParms.Billboard = true;
+	Vector3f const up( 0.0f, 1.0f, 0.0f );
+	int numVerts = 0;
+	for ( int i = 0; i < numLabels; i++ )
+	{
+		StringBuffer text;
+		text.AppendFormat( "%s %i", words[i % numWords], i );
+		if ( i % 5 == 0 )
+		{
+			text.AppendFormat( "\n%s", words[( i * 7 ) % numWords] );
+		}
+		texts.PushBack( String( text.ToCStr() ) );
+		numVerts += (int)UTF8Util::GetLength( text.ToCStr() ) * 4;
+
+		float const yaw = ( i % 16 ) * ( Mathf::TwoPi / 16.0f );
+		Vector3f const normal( -sinf( yaw ), 0.0f, cosf( yaw ) );
+		positions.PushBack( normal * -( 2.0f + ( i % 7 ) * 0.25f ) + up * ( ( i / 16 ) % 10 * 0.12f - 0.6f ) );
+		normals.PushBack( normal );
+	}
+	Vector4f const color( 1.0f, 1.0f, 1.0f, 1.0f );
+	float const scale = 0.5f;
+	Matrix4f const viewMatrix = Matrix4f::Translation( 0.0f, -0.1f, 0.0f );
+
+	BitmapFontSurfaceLocal immediate;
+	immediate.InitVertices( ( numVerts + 3 ) & ~3 );
+	BitmapFontSurfaceLocal retained;
+	retained.InitVertices( ( numVerts + 3 ) & ~3 );
+
+	// every frame lays out all the text again
+	double const immediateStart = Timer::GetSeconds();
+	for ( int frame = 0; frame < numFrames; frame++ )
+	{
+		for ( int i = 0; i < numLabels; i++ )
+		{
+			immediate.DrawText3D( font, ( i % 8 == 0 ) ? billboardParms : parms, positions[i], normals[i], up,
+					scale, color, texts[i].ToCStr() );
+		}
+		immediate.TransformVertexBlocks( viewMatrix );
+	}
+	double const immediateSeconds = Timer::GetSeconds() - immediateStart;
+
+	// the layouts are set every frame, like a menu that does not know what changed
+	Array< fontLayoutHandle_t > layouts;
+	for ( int i = 0; i < numLabels; i++ )
+	{
+		layouts.PushBack( retained.CreateTextLayout() );
+	}
+	double const retainedStart = Timer::GetSeconds();
+	for ( int frame = 0; frame < numFrames; frame++ )
+	{
+		for ( int i = 0; i < numLabels; i++ )
+		{
+			retained.SetTextLayout( layouts[i], font, ( i % 8 == 0 ) ? billboardParms : parms, scale, color, texts[i].ToCStr() );
+			retained.DrawTextLayout3D( layouts[i], positions[i], normals[i], up );
+		}
+		retained.TransformVertexBlocks( viewMatrix );
+	}
+	double const retainedSeconds = Timer::GetSeconds() - retainedStart;
+
+	// both must have produced the same vertices
+	int mismatches = 0;
+	if ( immediate.GetNumVertices() != retained.GetNumVertices() )
+	{
+		mismatches = Alg::Max( immediate.GetNumVertices(), retained.GetNumVertices() );
+	}
+	else
+	{
+		BitmapFontSurfaceLocal::fontVertex_t const * a = immediate.GetVertices();
+		BitmapFontSurfaceLocal::fontVertex_t const * b = retained.GetVertices();
+		for ( int i = 0; i < immediate.GetNumVertices(); i++ )
+		{
+			if ( ( a[i].xyz - b[i].xyz ).LengthSq() > 1e-10f || a[i].s != b[i].s || a[i].t != b[i].t ||
+					memcmp( a[i].rgba, b[i].rgba, sizeof( a[i].rgba ) ) != 0 ||
+					memcmp( a[i].fontParms, b[i].fontParms, sizeof( a[i].fontParms ) ) != 0 )
+			{
+				mismatches++;
+			}
+		}
+	}
+
+	for ( int i = 0; i < numLabels; i++ )
+	{
+		retained.FreeTextLayout( layouts[i] );
+	}
+
+	LOG( "BitmapFontSurfaceBenchmark: %i labels, %i vertices, %i frames", numLabels, retained.GetNumVertices(), numFrames );
+	LOG( "BitmapFontSurfaceBenchmark: DrawText3D       %7.3f ms per frame", immediateSeconds * 1000.0 / numFrames );
+	LOG( "BitmapFontSurfaceBenchmark: DrawTextLayout3D %7.3f ms per frame", retainedSeconds * 1000.0 / numFrames );
+	LOG( "BitmapFontSurfaceBenchmark: %i vertices differ", mismatches );
+}
 
 } // namespace OVR
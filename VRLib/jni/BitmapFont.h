@@ -15,6 +15,7 @@ Copyright   :   Copyright 2014 Oculus VR, LLC. All Rights reserved.
 #include "LibOVR/Src/Kernel/OVR_Math.h"
 #include "LibOVR/Src/Kernel/OVR_String.h"
 #include "LibOVR/Src/Kernel/OVR_Array.h"
+#include "LibOVR/Src/Kernel/OVR_TypesafeNumber.h"
 
 namespace OVR {
 
@@ -72,6 +73,13 @@ protected:
     virtual ~BitmapFont() { }
 };
 
+// text layout handles
+enum eFontLayoutIdType
+{
+	INVALID_FONT_LAYOUT_ID = 0
+};
+typedef TypesafeNumberT< UInt64, eFontLayoutIdType, INVALID_FONT_LAYOUT_ID >	fontLayoutHandle_t;
+
 //==============================================================
 // BitmapFontSurface
 class BitmapFontSurface
@@ -95,15 +103,41 @@ public:
 						        Vector3f const & pos, float const scale, Vector4f const & color, 
                                 char const * fmt, ... ) = 0;
 
+	// Retained text. DrawText3D lays the glyphs out again on every call, a text layout
+	// keeps its glyph quads in the surface and only lays them out again when the text,
+	// font, parms or scale change, so static text only costs a transform per frame.
+	virtual fontLayoutHandle_t	CreateTextLayout() = 0;
+	virtual void		FreeTextLayout( fontLayoutHandle_t & handle ) = 0;
+	// Cheap when nothing changed, and a color change only recolors the cached quads.
+	virtual void		SetTextLayout( fontLayoutHandle_t const handle, BitmapFont const & font, fontParms_t const & parms,
+								float const scale, Vector4f const & color, char const * text ) = 0;
+	// Draws the layout on this frame, like DrawText3D draws text.
+	virtual void		DrawTextLayout3D( fontLayoutHandle_t const handle, Vector3f const & pos,
+								Vector3f const & normal, Vector3f const & up ) = 0;
+
 	virtual void		Finish( Matrix4f const & viewMatrix ) = 0;
 
 	virtual void		Render3D( BitmapFont const & font, Matrix4f const & worldMVP ) const = 0;
 
+	// Never 0 and never reused, unlike the address of a surface, so text layouts can be
+	// kept by the id of their surface after the surface may have been freed.
+	UInt32				GetId() const { return Id; }
+
 protected:
+						BitmapFontSurface();
     virtual     ~BitmapFontSurface() { }
+
+private:
+	UInt32				Id;
 };
 
 
+// Logs the CPU cost per frame of a few hundred labels drawn with DrawText3D,
+// and drawn as text layouts, up to the vertices that would be uploaded to GL.
+// Registered as the "fontSurfaceBenchmark" console command, optional parms:
+// "<labels> <frames>"
+void BitmapFontSurfaceBenchmark( void * appPtr, const char * cmd );
+
 }   // namespace OVR
 
 #endif // OVR_BitmapFont_h
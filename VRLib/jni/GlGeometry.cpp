@@ -34,8 +34,7 @@ namespace OVR
 
 
 template< typename _attrib_type_ >
-void PackVertexAttribute( Array< uint8_t > & packed, const Array< _attrib_type_ > & attrib,
-				const int glLocation, const int glType, const int glComponents )
+void PackVertexAttribute( Array< UByte > & packed, int & packedOffset, const Array< _attrib_type_ > & attrib )
 {
 	if ( attrib.GetSize() > 0 )
 	{
@@ -45,19 +44,85 @@ void PackVertexAttribute( Array< uint8_t > & packed, const Array< _attrib_type_
 		packed.Resize( offset + size );
 		memcpy( &packed[offset], attrib.GetDataPtr(), size );
 
-		glEnableVertexAttribArray( glLocation );
-		glVertexAttribPointer( glLocation, glComponents, glType, false, sizeof( attrib[0] ), (void *)( offset ) );
+		packedOffset = (int)offset;
 	}
 	else
 	{
-		glDisableVertexAttribArray( glLocation );
+		packedOffset = -1;
+	}
+}
+
+void PackVertexAttribs( const VertexAttribs & attribs, Array< UByte > & buffer, PackedVertexAttribs & packed )
+{
+	buffer.Clear();
+	PackVertexAttribute( buffer, packed.offsets[VERTEX_ATTRIBUTE_LOCATION_POSITION],		attribs.position );
+	PackVertexAttribute( buffer, packed.offsets[VERTEX_ATTRIBUTE_LOCATION_NORMAL],			attribs.normal );
+	PackVertexAttribute( buffer, packed.offsets[VERTEX_ATTRIBUTE_LOCATION_TANGENT],			attribs.tangent );
+	PackVertexAttribute( buffer, packed.offsets[VERTEX_ATTRIBUTE_LOCATION_BINORMAL],		attribs.binormal );
+	PackVertexAttribute( buffer, packed.offsets[VERTEX_ATTRIBUTE_LOCATION_COLOR],			attribs.color );
+	PackVertexAttribute( buffer, packed.offsets[VERTEX_ATTRIBUTE_LOCATION_UV0],				attribs.uv0 );
+	PackVertexAttribute( buffer, packed.offsets[VERTEX_ATTRIBUTE_LOCATION_UV1],				attribs.uv1 );
+	PackVertexAttribute( buffer, packed.offsets[VERTEX_ATTRIBUTE_LOCATION_JOINT_INDICES],	attribs.jointIndices );
+	PackVertexAttribute( buffer, packed.offsets[VERTEX_ATTRIBUTE_LOCATION_JOINT_WEIGHTS],	attribs.jointWeights );
+	packed.data = buffer.GetDataPtr();
+	packed.size = buffer.GetSizeI();
+	packed.vertexCount = attribs.position.GetSizeI();
+}
+
+// Indexed by vertex attribute location, in the same order as VertexAttribs.
+static const struct
+{
+	int		glType;
+	int		glComponents;
+	int		stride;
+} PackedVertexAttribFormats[MAX_PACKED_VERTEX_ATTRIBS] =
+{
+	{ GL_FLOAT,	3,	sizeof( Vector3f ) },	// position
+	{ GL_FLOAT,	3,	sizeof( Vector3f ) },	// normal
+	{ GL_FLOAT,	3,	sizeof( Vector3f ) },	// tangent
+	{ GL_FLOAT,	3,	sizeof( Vector3f ) },	// binormal
+	{ GL_FLOAT,	4,	sizeof( Vector4f ) },	// color
+	{ GL_FLOAT,	2,	sizeof( Vector2f ) },	// uv0
+	{ GL_FLOAT,	2,	sizeof( Vector2f ) },	// uv1
+	{ GL_INT,	4,	sizeof( Vector4i ) },	// jointIndices
+	{ GL_FLOAT,	4,	sizeof( Vector4f ) }	// jointWeights
+};
+
+int PackedVertexAttribStride( const int location )
+{
+	return PackedVertexAttribFormats[location].stride;
+}
+
+static void SetupPackedVertexAttribs( const PackedVertexAttribs & attribs )
+{
+	for ( int i = 0; i < MAX_PACKED_VERTEX_ATTRIBS; i++ )
+	{
+		if ( attribs.offsets[i] >= 0 )
+		{
+			glEnableVertexAttribArray( i );
+			glVertexAttribPointer( i, PackedVertexAttribFormats[i].glComponents, PackedVertexAttribFormats[i].glType,
+									false, PackedVertexAttribFormats[i].stride, (void *)( (size_t)attribs.offsets[i] ) );
+		}
+		else
+		{
+			glDisableVertexAttribArray( i );
+		}
 	}
 }
 
 void GlGeometry::Create( const VertexAttribs & attribs, const Array< TriangleIndex > & indices )
 {
-	vertexCount = attribs.position.GetSizeI();
-	indexCount = indices.GetSizeI();
+	Array< UByte > buffer;
+	PackedVertexAttribs packed;
+	PackVertexAttribs( attribs, buffer, packed );
+
+	Create( packed, indices.GetDataPtr(), indices.GetSizeI() );
+}
+
+void GlGeometry::Create( const PackedVertexAttribs & attribs, const TriangleIndex * indices, const int numIndices )
+{
+	vertexCount = attribs.vertexCount;
+	indexCount = numIndices;
 
 	glGenBuffers( 1, &vertexBuffer );
 	glGenBuffers( 1, &indexBuffer );
@@ -65,21 +130,12 @@ void GlGeometry::Create( const VertexAttribs & attribs, const Array< TriangleInd
 	glBindVertexArrayOES_( vertexArrayObject );
 	glBindBuffer( GL_ARRAY_BUFFER, vertexBuffer );
 
-	Array< uint8_t > packed;
-	PackVertexAttribute( packed, attribs.position,		VERTEX_ATTRIBUTE_LOCATION_POSITION,			GL_FLOAT,	3 );
-	PackVertexAttribute( packed, attribs.normal,		VERTEX_ATTRIBUTE_LOCATION_NORMAL,			GL_FLOAT,	3 );
-	PackVertexAttribute( packed, attribs.tangent,		VERTEX_ATTRIBUTE_LOCATION_TANGENT,			GL_FLOAT,	3 );
-	PackVertexAttribute( packed, attribs.binormal,		VERTEX_ATTRIBUTE_LOCATION_BINORMAL,			GL_FLOAT,	3 );
-	PackVertexAttribute( packed, attribs.color,			VERTEX_ATTRIBUTE_LOCATION_COLOR,			GL_FLOAT,	4 );
-	PackVertexAttribute( packed, attribs.uv0,			VERTEX_ATTRIBUTE_LOCATION_UV0,				GL_FLOAT,	2 );
-	PackVertexAttribute( packed, attribs.uv1,			VERTEX_ATTRIBUTE_LOCATION_UV1,				GL_FLOAT,	2 );
-	PackVertexAttribute( packed, attribs.jointIndices,	VERTEX_ATTRIBUTE_LOCATION_JOINT_INDICES,	GL_INT,		4 );
-	PackVertexAttribute( packed, attribs.jointWeights,	VERTEX_ATTRIBUTE_LOCATION_JOINT_WEIGHTS,	GL_FLOAT,	4 );
+	SetupPackedVertexAttribs( attribs );
 
-	glBufferData( GL_ARRAY_BUFFER, packed.GetSize() * sizeof( packed[0] ), packed.GetDataPtr(), GL_STATIC_DRAW );
+	glBufferData( GL_ARRAY_BUFFER, attribs.size, attribs.data, GL_STATIC_DRAW );
 
 	glBindBuffer( GL_ELEMENT_ARRAY_BUFFER, indexBuffer );
-	glBufferData( GL_ELEMENT_ARRAY_BUFFER, indices.GetSizeI() * sizeof( indices[0] ), indices.GetDataPtr(), GL_STATIC_DRAW );
+	glBufferData( GL_ELEMENT_ARRAY_BUFFER, numIndices * sizeof( indices[0] ), indices, GL_STATIC_DRAW );
 
 	glBindVertexArrayOES_( 0 );
 
@@ -102,18 +158,13 @@ void GlGeometry::Update( const VertexAttribs & attribs )
 
 	glBindBuffer( GL_ARRAY_BUFFER, vertexBuffer );
 
-	Array< uint8_t > packed;
-	PackVertexAttribute( packed, attribs.position,		VERTEX_ATTRIBUTE_LOCATION_POSITION,			GL_FLOAT,	3 );
-	PackVertexAttribute( packed, attribs.normal,		VERTEX_ATTRIBUTE_LOCATION_NORMAL,			GL_FLOAT,	3 );
-	PackVertexAttribute( packed, attribs.tangent,		VERTEX_ATTRIBUTE_LOCATION_TANGENT,			GL_FLOAT,	3 );
-	PackVertexAttribute( packed, attribs.binormal,		VERTEX_ATTRIBUTE_LOCATION_BINORMAL,			GL_FLOAT,	3 );
-	PackVertexAttribute( packed, attribs.color,			VERTEX_ATTRIBUTE_LOCATION_COLOR,			GL_FLOAT,	4 );
-	PackVertexAttribute( packed, attribs.uv0,			VERTEX_ATTRIBUTE_LOCATION_UV0,				GL_FLOAT,	2 );
-	PackVertexAttribute( packed, attribs.uv1,			VERTEX_ATTRIBUTE_LOCATION_UV1,				GL_FLOAT,	2 );
-	PackVertexAttribute( packed, attribs.jointIndices,	VERTEX_ATTRIBUTE_LOCATION_JOINT_INDICES,	GL_INT,		4 );
-	PackVertexAttribute( packed, attribs.jointWeights,	VERTEX_ATTRIBUTE_LOCATION_JOINT_WEIGHTS,	GL_FLOAT,	4 );
-
-	glBufferData( GL_ARRAY_BUFFER, packed.GetSize() * sizeof( packed[0] ), packed.GetDataPtr(), GL_STATIC_DRAW );
+	Array< UByte > buffer;
+	PackedVertexAttribs packed;
+	PackVertexAttribs( attribs, buffer, packed );
+
+	SetupPackedVertexAttribs( packed );
+
+	glBufferData( GL_ARRAY_BUFFER, packed.size, packed.data, GL_STATIC_DRAW );
 }
 
 void GlGeometry::Draw() const
@@ -36,6 +36,37 @@ typedef unsigned short TriangleIndex;
 static const int MAX_GEOMETRY_VERTICES	= 1 << ( sizeof( TriangleIndex ) * 8 );
 static const int MAX_GEOMETRY_INDICES	= 1024 * 1024 * 3;
 
+// One per VertexAttribs member, the index is also the vertex attribute location.
+static const int MAX_PACKED_VERTEX_ATTRIBS	= 9;
+
+// Vertex attributes packed one array after the other, which is how they are
+// stored in the vertex buffer. The data can be packed ahead of time and stored
+// on disk, so a memory mapped model can be uploaded without any conversion.
+struct PackedVertexAttribs
+{
+	PackedVertexAttribs() :
+		data( NULL ),
+		size( 0 ),
+		vertexCount( 0 )
+	{
+		for ( int i = 0; i < MAX_PACKED_VERTEX_ATTRIBS; i++ )
+		{
+			offsets[i] = -1;
+		}
+	}
+
+	const UByte *	data;
+	int				size;
+	int				vertexCount;
+	int				offsets[MAX_PACKED_VERTEX_ATTRIBS];	// byte offset of each attribute array, -1 if not present
+};
+
+// Packs the attributes into 'buffer' and points 'packed' at it.
+void PackVertexAttribs( const VertexAttribs & attribs, Array< UByte > & buffer, PackedVertexAttribs & packed );
+
+// Size in bytes of one vertex in the packed array of the attribute at a vertex attribute location.
+int PackedVertexAttribStride( const int location );
+
 class GlGeometry
 {
 public:
@@ -55,6 +86,7 @@ public:
 
 	// Create the VAO and vertex and index buffers from arrays of data.
 	void	Create( const VertexAttribs & attribs, const Array< TriangleIndex > & indices );
+	void	Create( const PackedVertexAttribs & attribs, const TriangleIndex * indices, const int numIndices );
 	void	Update( const VertexAttribs & attribs );
 
 	// Assumes the correct program, uniforms, textures, etc, are all bound.
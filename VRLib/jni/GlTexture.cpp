@@ -21,6 +21,7 @@ using namespace OVR;
 
 #include "GlUtils.h"
 #include "Log.h"
+#include "ImageData.h"
 
 #include "3rdParty/stb/stb_image.h"
 
@@ -400,85 +401,76 @@ static int32_t GetOvrTextureSize( const int format, const int w, const int h )
     return 0;
 }
 
-static GlTexture CreateGlTexture( const char * fileName, const int format, const int width, const int height,
-						const void * data, const size_t dataSize,
-						const int mipcount, const bool useSrgbFormat, const bool imageSizeStored )
+// Validates the mip levels of a 2D texture or cube map and points the
+// mip chain at them, without touching GL.
+static bool ParseMipChain( const char * fileName, const int format, const int width, const int height,
+						const int faces, const void * data, const size_t dataSize,
+						const int mipcount, const bool imageSizeStored, TextureMipChain & chain )
 {
-	// LOG( "CreateGLTexture(): format %s", NameForTextureFormat( static_cast< TextureFormat >( format ) ) );
-
-	GLenum glFormat;
-	GLenum glInternalFormat;
-	if ( !TextureFormatToGlFormat( format, useSrgbFormat, glFormat, glInternalFormat ) )
-	{
-		return GlTexture( 0 );
-	}
+	chain.format = format;
+	chain.width = 0;
+	chain.height = 0;
+	chain.faces = faces;
+	chain.mipCount = 0;
 
 	if ( mipcount <= 0 )
 	{
 		LOG( "%s: Invalid mip count %d", fileName, mipcount );
-		return GlTexture( 0 );
+		return false;
 	}
 
 	// larger than this would require mipSize below to be a larger type
 	if ( width <= 0 || width > 32768 || height <= 0 || height > 32768 )
 	{
 		LOG( "%s: Invalid texture size (%dx%d)", fileName, width, height );
-		return GlTexture( 0 );
+		return false;
 	}
 
-	GLuint texId;
-	glGenTextures( 1, &texId );
-	glBindTexture( GL_TEXTURE_2D, texId );
+	if ( faces == 6 && width != height )
+	{
+		LOG( "%s: Cube map faces are not square (%dx%d)", fileName, width, height );
+		return false;
+	}
+
+	chain.width = width;
+	chain.height = height;
 
 	const unsigned char * level = (const unsigned char*)data;
 	const unsigned char * endOfBuffer = level + dataSize;
 
+	const int maxLevels = Alg::Min( mipcount, MAX_TEXTURE_MIP_LEVELS );
 	int w = width;
 	int h = height;
-	for ( int i = 0; i < mipcount; i++ )
+	for ( int i = 0; i < maxLevels; i++ )
 	{
 		int32_t mipSize = GetOvrTextureSize( format, w, h );
 		if ( imageSizeStored )
 		{
-			mipSize = *(const size_t *)level;
-
-			level += 4;
-			if ( level > endOfBuffer )
+			if ( endOfBuffer - level < 4 )
 			{
 				LOG( "%s: Image data exceeds buffer size", fileName );
-				glBindTexture( GL_TEXTURE_2D, 0 );
-				return GlTexture( texId, GL_TEXTURE_2D );
+				break;
 			}
+			mipSize = *(const UInt32 *)level;
+			level += 4;
 		}
 
-		if ( mipSize <= 0 || mipSize > endOfBuffer - level )
-		{
-			LOG( "%s: Mip level %d exceeds buffer size (%d > %d)", fileName, i, mipSize, endOfBuffer - level );
-			glBindTexture( GL_TEXTURE_2D, 0 );
-			return GlTexture( texId, GL_TEXTURE_2D );
-		}
+		// Every face is padded to four bytes when the image size is stored.
+		const int32_t faceStride = imageSizeStored ? ( ( mipSize + 3 ) & ~3 ) : mipSize;
+		const SInt64 levelSize = (SInt64)( faces - 1 ) * faceStride + mipSize;
 
-		if ( format & Texture_Compressed )
+		if ( mipSize <= 0 || levelSize > endOfBuffer - level )
 		{
-			glCompressedTexImage2D( GL_TEXTURE_2D, i, glInternalFormat, w, h, 0, mipSize, level );
-			GL_CheckErrors( "Texture_Compressed" );
-		}
-		else
-		{
-			glTexImage2D( GL_TEXTURE_2D, i, glInternalFormat, w, h, 0, glFormat, GL_UNSIGNED_BYTE, level );
+			LOG( "%s: Mip level %d exceeds buffer size (%lld > %d)", fileName, i, levelSize, (int)( endOfBuffer - level ) );
+			break;
 		}
 
-		level += mipSize;
-		if ( imageSizeStored )
-		{
-			level += 3 - ( ( mipSize + 3 ) % 4 );
-			if ( level > endOfBuffer )
-			{
-				LOG( "%s: Image data exceeds buffer size", fileName );
-				glBindTexture( GL_TEXTURE_2D, 0 );
-				return GlTexture( texId, GL_TEXTURE_2D );
-			}
-		}
+		chain.mipLevels[i] = level;
+		chain.mipSizes[i] = mipSize;
+		chain.faceStrides[i] = faceStride;
+		chain.mipCount = i + 1;
+
+		level += levelSize + ( faceStride - mipSize );
 
 		w >>= 1;
 		h >>= 1;
@@ -486,123 +478,85 @@ static GlTexture CreateGlTexture( const char * fileName, const int format, const
 		if ( h < 1 ) { h = 1; }
 	}
 
-	glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT );
-	glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT );
-	// Surfaces look pretty terrible without trilinear filtering
-	if ( mipcount <= 1 )
-	{
-		glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR );
-	}
-	else
-	{
-		glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR );
-	}
-	glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR );
-
-	GL_CheckErrors( "Texture load" );
-
-	glBindTexture( GL_TEXTURE_2D, 0 );
-
-	return GlTexture( texId, GL_TEXTURE_2D );
+	return ( chain.mipCount > 0 );
 }
 
-static GlTexture CreateGlCubeTexture( const char * fileName, const int format, const int width, const int height,
-						const void * data, const size_t dataSize,
-						const int mipcount, const bool useSrgbFormat, const bool imageSizeStored )
+static GlTexture UploadMipChain( const TextureMipChain & chain, const bool useSrgbFormat )
 {
-	assert( width == height );
-
-	if ( mipcount <= 0 )
-	{
-		LOG( "%s: Invalid mip count %d", fileName, mipcount );
-		return GlTexture( 0 );
-	}
-
-	// larger than this would require mipSize below to be a larger type
-	if ( width <= 0 || width > 32768 || height <= 0 || height > 32768 )
-	{
-		LOG( "%s: Invalid texture size (%dx%d)", fileName, width, height );
-		return GlTexture( 0 );
-	}
+	// LOG( "UploadMipChain(): format %s", NameForTextureFormat( static_cast< TextureFormat >( chain.format ) ) );
 
 	GLenum glFormat;
 	GLenum glInternalFormat;
-	if ( !TextureFormatToGlFormat( format, useSrgbFormat, glFormat, glInternalFormat ) )
+	if ( !TextureFormatToGlFormat( chain.format, useSrgbFormat, glFormat, glInternalFormat ) )
 	{
 		return GlTexture( 0 );
 	}
 
+	const GLenum target = ( chain.faces == 6 ) ? GL_TEXTURE_CUBE_MAP : GL_TEXTURE_2D;
+
 	GLuint texId;
 	glGenTextures( 1, &texId );
-	glBindTexture( GL_TEXTURE_CUBE_MAP, texId );
-
-	const unsigned char * level = (const unsigned char*)data;
-	const unsigned char * endOfBuffer = level + dataSize;
+	glBindTexture( target, texId );
 
-	for ( int i = 0; i < mipcount; i++ )
+	int w = chain.width;
+	int h = chain.height;
+	for ( int i = 0; i < chain.mipCount; i++ )
 	{
-		const int w = width >> i;
-		int32_t mipSize = GetOvrTextureSize( format, w, w );
-		if ( imageSizeStored )
-		{
-			mipSize = *(const size_t *)level;
-			level += 4;
-			if ( level > endOfBuffer )
-			{
-				LOG( "%s: Image data exceeds buffer size", fileName );
-				glBindTexture( GL_TEXTURE_CUBE_MAP, 0 );
-				return GlTexture( texId, GL_TEXTURE_CUBE_MAP );
-			}
-		}
-
-		for ( int side = 0; side < 6; side++ )
+		for ( int face = 0; face < chain.faces; face++ )
 		{
-			if ( mipSize <= 0 || mipSize > endOfBuffer - level )
-			{
-				LOG( "%s: Mip level %d exceeds buffer size (%d > %d)", fileName, i, mipSize, endOfBuffer - level );
-				glBindTexture( GL_TEXTURE_CUBE_MAP, 0 );
-				return GlTexture( texId, GL_TEXTURE_CUBE_MAP );
-			}
+			const GLenum faceTarget = ( chain.faces == 6 ) ? GL_TEXTURE_CUBE_MAP_POSITIVE_X + face : GL_TEXTURE_2D;
+			const unsigned char * level = chain.mipLevels[i] + face * chain.faceStrides[i];
 
-			if ( format & Texture_Compressed )
+			if ( chain.format & Texture_Compressed )
 			{
-				glCompressedTexImage2D( GL_TEXTURE_CUBE_MAP_POSITIVE_X + side, i, glInternalFormat, w, w, 0, mipSize, level );
+				glCompressedTexImage2D( faceTarget, i, glInternalFormat, w, h, 0, chain.mipSizes[i], level );
+				GL_CheckErrors( "Texture_Compressed" );
 			}
 			else
 			{
-				glTexImage2D( GL_TEXTURE_CUBE_MAP_POSITIVE_X + side, i, glInternalFormat, w, w, 0, glFormat, GL_UNSIGNED_BYTE, level );
-			}
-
-			level += mipSize;
-			if ( imageSizeStored )
-			{
-				level += 3 - ( ( mipSize + 3 ) % 4 );
-				if ( level > endOfBuffer )
-				{
-					LOG( "%s: Image data exceeds buffer size", fileName );
-					glBindTexture( GL_TEXTURE_CUBE_MAP, 0 );
-					return GlTexture( texId, GL_TEXTURE_CUBE_MAP );
-				}
+				glTexImage2D( faceTarget, i, glInternalFormat, w, h, 0, glFormat, GL_UNSIGNED_BYTE, level );
 			}
 		}
+
+		w >>= 1;
+		h >>= 1;
+		if ( w < 1 ) { w = 1; }
+		if ( h < 1 ) { h = 1; }
 	}
 
+	if ( target == GL_TEXTURE_2D )
+	{
+		glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT );
+		glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT );
+	}
 	// Surfaces look pretty terrible without trilinear filtering
-	if ( mipcount <= 1 )
+	if ( chain.mipCount <= 1 )
 	{
-		glTexParameteri( GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR );
+		glTexParameteri( target, GL_TEXTURE_MIN_FILTER, GL_LINEAR );
 	}
 	else
 	{
-		glTexParameteri( GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR );
+		glTexParameteri( target, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR );
 	}
-	glTexParameteri( GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR );
+	glTexParameteri( target, GL_TEXTURE_MAG_FILTER, GL_LINEAR );
 
 	GL_CheckErrors( "Texture load" );
 
-	glBindTexture( GL_TEXTURE_CUBE_MAP, 0 );
+	glBindTexture( target, 0 );
 
-	return GlTexture( texId, GL_TEXTURE_CUBE_MAP );
+	return GlTexture( texId, target );
+}
+
+static GlTexture CreateGlTexture( const char * fileName, const int format, const int width, const int height,
+						const void * data, const size_t dataSize,
+						const int mipcount, const bool useSrgbFormat, const bool imageSizeStored )
+{
+	TextureMipChain chain;
+	if ( !ParseMipChain( fileName, format, width, height, 1, data, dataSize, mipcount, imageSizeStored, chain ) )
+	{
+		return GlTexture( 0 );
+	}
+	return UploadMipChain( chain, useSrgbFormat );
 }
 
 GlTexture LoadRGBATextureFromMemory( const uint8_t * texture, const int width, const int height, const bool useSrgbFormat )
@@ -757,23 +711,20 @@ struct OVR_PVR_HEADER
 };
 #pragma pack()
 
-GlTexture LoadTexturePVR( const char * fileName, const unsigned char * buffer, const int bufferLength,
-						bool useSrgbFormat, bool noMipMaps, int & width, int & height )
+static bool ParseTexturePVR( const char * fileName, const unsigned char * buffer, const int bufferLength,
+						bool noMipMaps, TextureMipChain & chain )
 {
-	width = 0;
-	height = 0;
-
 	if ( bufferLength < ( int )( sizeof( OVR_PVR_HEADER ) ) )
 	{
 		LOG( "%s: Invalid PVR file", fileName );
-		return GlTexture( 0 );
+		return false;
 	}
 
 	const OVR_PVR_HEADER & header = *( OVR_PVR_HEADER * )buffer;
 	if ( header.Version != 0x03525650 )
 	{
 		LOG( "%s: Invalid PVR file version", fileName );
-		return GlTexture( 0 );
+		return false;
 	}
 
 	int format = 0;
@@ -786,8 +737,8 @@ GlTexture LoadTexturePVR( const char * fileName, const unsigned char * buffer, c
 		case 23:					format = Texture_ETC2_RGBA;	break;
 		case 578721384203708274llu:	format = Texture_RGBA;		break;
 		default:
-			LOG( "%s: Unknown PVR texture format %llu, size %ix%i", fileName, header.PixelFormat, width, height );
-			return GlTexture( 0 );
+			LOG( "%s: Unknown PVR texture format %llu, size %ix%i", fileName, header.PixelFormat, header.Width, header.Height );
+			return false;
 	}
 
 	// skip the metadata
@@ -795,30 +746,19 @@ GlTexture LoadTexturePVR( const char * fileName, const unsigned char * buffer, c
 	if ( ( startTex < sizeof( OVR_PVR_HEADER ) ) || ( startTex >= static_cast< size_t >( bufferLength ) ) )
 	{
 		LOG( "%s: Invalid PVR header sizes", fileName );
-		return GlTexture( 0 );
+		return false;
 	}
 
 	const UInt32 mipCount = ( noMipMaps ) ? 1 : OVR::Alg::Max( 1u, header.MipMapCount );
 
-	width = header.Width;
-	height = header.Height;
-
-	if ( header.NumFaces == 1 )
-	{
-		return CreateGlTexture( fileName, format, width, height, buffer + startTex, bufferLength - startTex, mipCount, useSrgbFormat, false );
-	}
-	else if ( header.NumFaces == 6 )
-	{
-		return CreateGlCubeTexture( fileName, format, width, height, buffer + startTex, bufferLength - startTex, mipCount, useSrgbFormat, false );
-	}
-	else
+	if ( header.NumFaces != 1 && header.NumFaces != 6 )
 	{
 		LOG( "%s: PVR file has unsupported number of faces %d", fileName, header.NumFaces );
+		return false;
 	}
 
-	width = 0;
-	height = 0;
-	return GlTexture( 0 );
+	return ParseMipChain( fileName, format, header.Width, header.Height, header.NumFaces,
+						buffer + startTex, bufferLength - startTex, mipCount, false, chain );
 }
 
 
@@ -955,16 +895,13 @@ struct OVR_KTX_HEADER
 };
 #pragma pack()
 
-GlTexture LoadTextureKTX( const char * fileName, const unsigned char * buffer, const int bufferLength,
-						bool useSrgbFormat, bool noMipMaps, int & width, int & height )
+static bool ParseTextureKTX( const char * fileName, const unsigned char * buffer, const int bufferLength,
+						bool noMipMaps, TextureMipChain & chain )
 {
-	width = 0;
-	height = 0;
-
 	if ( bufferLength < (int)( sizeof( OVR_KTX_HEADER ) ) )
 	{
     	LOG( "%s: Invalid KTX file", fileName );
-        return GlTexture( 0 );
+        return false;
 	}
 
 	const UByte fileIdentifier[12] =
@@ -976,62 +913,141 @@ GlTexture LoadTextureKTX( const char * fileName, const unsigned char * buffer, c
 	if ( memcmp( header.identifier, fileIdentifier, sizeof( fileIdentifier ) ) != 0 )
 	{
 		LOG( "%s: Invalid KTX file", fileName );
-		return GlTexture( 0 );
+		return false;
 	}
 	// only support little endian
 	if ( header.endianness != 0x04030201 )
 	{
 		LOG( "%s: KTX file has wrong endianess", fileName );
-		return GlTexture( 0 );
+		return false;
 	}
 	// only support compressed or unsigned byte
 	if ( header.glType != 0 && header.glType != GL_UNSIGNED_BYTE )
 	{
 		LOG( "%s: KTX file has unsupported glType %d", fileName, header.glType );
-		return GlTexture( 0 );
+		return false;
 	}
 	// no support for texture arrays
 	if ( header.numberOfArrayElements != 0 )
 	{
 		LOG( "%s: KTX file has unsupported number of array elements %d", fileName, header.numberOfArrayElements );
-		return GlTexture( 0 );
+		return false;
 	}
 	// derive the texture format from the GL format
 	int format = 0;
 	if ( !GlFormatToTextureFormat( format, header.glFormat, header.glInternalFormat ) )
 	{
 		LOG( "%s: KTX file has unsupported glFormat %d, glInternalFormat %d", fileName, header.glFormat, header.glInternalFormat );
-		return GlTexture( 0 );
+		return false;
 	}
 	// skip the key value data
 	const uintptr_t startTex = sizeof( OVR_KTX_HEADER ) + header.bytesOfKeyValueData;
 	if ( ( startTex < sizeof( OVR_KTX_HEADER ) ) || ( startTex >= static_cast< size_t >( bufferLength ) ) )
 	{
 		LOG( "%s: Invalid KTX header sizes", fileName );
-		return GlTexture( 0 );
+		return false;
 	}
 
-	width = header.pixelWidth;
-	height = header.pixelHeight;
-
 	const UInt32 mipCount = ( noMipMaps ) ? 1 : OVR::Alg::Max( 1u, header.numberOfMipmapLevels );
 
-	if ( header.numberOfFaces == 1 )
+	if ( header.numberOfFaces != 1 && header.numberOfFaces != 6 )
 	{
-		return CreateGlTexture( fileName, format, width, height, buffer + startTex, bufferLength - startTex, mipCount, useSrgbFormat, true );
+		LOG( "%s: KTX file has unsupported number of faces %d", fileName, header.numberOfFaces );
+		return false;
 	}
-	else if ( header.numberOfFaces == 6 )
+
+	return ParseMipChain( fileName, format, header.pixelWidth, header.pixelHeight, header.numberOfFaces,
+						buffer + startTex, bufferLength - startTex, mipCount, true, chain );
+}
+
+bool ParseTextureMipChain( const char * fileName, const MemBuffer & buffer,
+		const TextureFlags_t & flags, TextureMipChain & chain )
+{
+	chain = TextureMipChain();
+
+	if ( fileName == NULL || buffer.Buffer == NULL || buffer.Length < 1 )
 	{
-		return CreateGlCubeTexture( fileName, format, width, height, buffer + startTex, bufferLength - startTex, mipCount, useSrgbFormat, true );
+		return false;
 	}
-	else
+
+	const String ext = String( fileName ).GetExtension().ToLower();
+	if ( ext == ".pvr" )
 	{
-		LOG( "%s: KTX file has unsupported number of faces %d", fileName, header.numberOfFaces );
+		return ParseTexturePVR( fileName, (const unsigned char *)buffer.Buffer, buffer.Length,
+						( flags & TEXTUREFLAG_NO_MIPMAPS ), chain );
 	}
+	if ( ext == ".ktx" )
+	{
+		return ParseTextureKTX( fileName, (const unsigned char *)buffer.Buffer, buffer.Length,
+						( flags & TEXTUREFLAG_NO_MIPMAPS ), chain );
+	}
+	return false;
+}
 
-	width = 0;
-	height = 0;
-	return GlTexture( 0 );
+static bool IsStbImageExtension( const String & ext )
+{
+	return	ext == ".jpg" || ext == ".tga" ||
+			ext == ".png" || ext == ".bmp" ||
+			ext == ".psd" || ext == ".gif" ||
+			ext == ".hdr" || ext == ".pic";
+}
+
+bool DecodeTextureMipChain( const char * fileName, const MemBuffer & buffer,
+		const TextureFlags_t & flags, const int maxThreads, TextureMipChain & chain, MemBuffer & mipData )
+{
+	chain = TextureMipChain();
+	mipData = MemBuffer();
+
+	if ( fileName == NULL || buffer.Buffer == NULL || buffer.Length < 1 )
+	{
+		return false;
+	}
+
+	if ( !IsStbImageExtension( String( fileName ).GetExtension().ToLower() ) )
+	{
+		return false;
+	}
+
+	int width = 0;
+	int height = 0;
+	int comp;
+	stbi_uc * image = stbi_load_from_memory( (unsigned char *)buffer.Buffer, buffer.Length, &width, &height, &comp, 4 );
+	if ( image == NULL )
+	{
+		return false;
+	}
+
+	int mipCount = 1;
+	unsigned char * levels = image;
+	if ( !( flags & TEXTUREFLAG_NO_MIPMAPS ) )
+	{
+		levels = BuildImageMipChain( image, width, height, ( flags & TEXTUREFLAG_USE_SRGB ),
+						( flags & TEXTUREFLAG_KAISER_MIPMAPS ) ? IMAGE_MIP_FILTER_KAISER : IMAGE_MIP_FILTER_BOX, maxThreads, mipCount );
+		free( image );
+	}
+
+	size_t dataSize = 0;
+	for ( int i = 0, w = width, h = height; i < mipCount; i++, w = Alg::Max( 1, w >> 1 ), h = Alg::Max( 1, h >> 1 ) )
+	{
+		dataSize += GetOvrTextureSize( Texture_RGBA, w, h );
+	}
+
+	mipData = MemBuffer( levels, (int)dataSize );
+	if ( !ParseMipChain( fileName, Texture_RGBA, width, height, 1, levels, dataSize, mipCount, false, chain ) )
+	{
+		mipData.FreeData();
+		return false;
+	}
+	return true;
+}
+
+GlTexture CreateTextureFromMipChain( const TextureMipChain & chain, const TextureFlags_t & flags )
+{
+	if ( chain.mipCount <= 0 )
+	{
+		return GlTexture( 0 );
+	}
+	return UploadMipChain( chain, ( flags & TEXTUREFLAG_USE_SRGB ) );
 }
 
 GlTexture LoadTextureFromBuffer( const char * fileName, const MemBuffer & buffer,
@@ -1049,41 +1065,29 @@ GlTexture LoadTextureFromBuffer( const char * fileName, const MemBuffer & buffer
 	{
 		// can't load anything from an empty buffer
 	}
-	else if (	ext == ".jpg" || ext == ".tga" ||
-				ext == ".png" || ext == ".bmp" ||
-				ext == ".psd" || ext == ".gif" ||
-				ext == ".hdr" || ext == ".pic" )
+	else if ( IsStbImageExtension( ext ) )
 	{
-		// Uncompressed files loaded by stb_image
-		int comp;
-		stbi_uc * image = stbi_load_from_memory( (unsigned char *)buffer.Buffer, buffer.Length, &width, &height, &comp, 4 );
-		if ( image != NULL )
+		// Uncompressed files loaded by stb_image, with the mip maps built on the CPU
+		// instead of glGenerateMipmap(), which is not gamma correct and stalls.
+		TextureMipChain chain;
+		MemBuffer mipData;
+		if ( DecodeTextureMipChain( fileName, buffer, flags, 0, chain, mipData ) )
 		{
-			const size_t dataSize = GetOvrTextureSize( Texture_RGBA, width, height );
-			texId = CreateGlTexture( fileName, Texture_RGBA, width, height, image, dataSize,
-					1 /* one mip level */, flags & TEXTUREFLAG_USE_SRGB, false );
-			free( image );
-			if ( !( flags & TEXTUREFLAG_NO_MIPMAPS ) )
-			{
-				glBindTexture( texId.target, texId.texture );
-				glGenerateMipmap( texId.target );
-				glTexParameteri( texId.target, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR );
-			}
-	    }
-	}
-	else if ( ext == ".pvr" )
-	{
-		texId = LoadTexturePVR( fileName, (const unsigned char *)buffer.Buffer, buffer.Length,
-						( flags & TEXTUREFLAG_USE_SRGB ),
-						( flags & TEXTUREFLAG_NO_MIPMAPS ),
-						width, height );
+			texId = CreateTextureFromMipChain( chain, flags );
+			width = chain.width;
+			height = chain.height;
+		}
+		mipData.FreeData();
 	}
-	else if ( ext == ".ktx" )
+	else if ( ext == ".pvr" || ext == ".ktx" )
 	{
-		texId = LoadTextureKTX( fileName, (const unsigned char *)buffer.Buffer, buffer.Length,
-						( flags & TEXTUREFLAG_USE_SRGB ),
-						( flags & TEXTUREFLAG_NO_MIPMAPS ),
-						width, height );
+		TextureMipChain chain;
+		if ( ParseTextureMipChain( fileName, buffer, flags, chain ) )
+		{
+			texId = CreateTextureFromMipChain( chain, flags );
+			width = chain.width;
+			height = chain.height;
+		}
 	}
 	else if ( ext == ".pkm" )
 	{
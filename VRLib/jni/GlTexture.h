@@ -29,7 +29,10 @@ enum eTextureFlags
 	// of GL_RGB / GL_RGBA / GL_ETC1_RGB8_OES
 	TEXTUREFLAG_USE_SRGB,
 	// No mip maps are loaded or generated when this flag is specified.
-	TEXTUREFLAG_NO_MIPMAPS
+	TEXTUREFLAG_NO_MIPMAPS,
+	// Generate mip maps with a Kaiser filter instead of a box filter, which
+	// keeps them sharper.
+	TEXTUREFLAG_KAISER_MIPMAPS
 };
 
 typedef BitFlagsT< eTextureFlags > TextureFlags_t;
@@ -71,12 +74,50 @@ void		BuildTextureMipmaps( GlTexture texid );
 // If TEXTUREFLAG_NO_DEFAULT, no default texture will be created.
 // Otherwise a default square texture will be created on any failure.
 //
-// Uncompressed image formats will have mipmaps generated and trilinear filtering set.
+// Uncompressed image formats will have mipmaps generated on the CPU, gamma correct
+// with TEXTUREFLAG_USE_SRGB, and trilinear filtering set.
 GlTexture	LoadTextureFromBuffer( const char * fileName, const MemBuffer & buffer,
 				const TextureFlags_t & flags, int & width, int & height );
 
 unsigned char * LoadPVRBuffer( const char * fileName, int & width, int & height );
 
+static const int MAX_TEXTURE_MIP_LEVELS = 16;
+
+// Mip chain of a .pvr or .ktx texture that was parsed and validated on the CPU.
+// The levels point into the container buffer, which has to stay valid until
+// the GL texture is created.
+struct TextureMipChain
+{
+	TextureMipChain() : format( 0 ), width( 0 ), height( 0 ), faces( 0 ), mipCount( 0 ) {}
+
+	int						format;		// TextureFormat
+	int						width;
+	int						height;
+	int						faces;		// 1, or 6 for a cube map
+	int						mipCount;
+	const unsigned char *	mipLevels[MAX_TEXTURE_MIP_LEVELS];
+	int						mipSizes[MAX_TEXTURE_MIP_LEVELS];		// size of a single face
+	int						faceStrides[MAX_TEXTURE_MIP_LEVELS];	// offset between the faces of a level
+};
+
+// Parses a .pvr or .ktx container without making any GL calls, so this can be
+// done on any thread. Returns false if the container is invalid or unsupported.
+// Only TEXTUREFLAG_NO_MIPMAPS is used here.
+bool		ParseTextureMipChain( const char * fileName, const MemBuffer & buffer,
+				const TextureFlags_t & flags, TextureMipChain & chain );
+
+// Decodes one of the stb_image file formats and builds the full mip chain on the
+// CPU without making any GL calls, so this can be done on any thread. The mip maps
+// are filtered gamma correct if TEXTUREFLAG_USE_SRGB is set. The levels point
+// into mipData, which should be freed with FreeData() after the upload.
+// The mip maps are built on up to maxThreads threads, or on all cores if maxThreads is 0.
+bool		DecodeTextureMipChain( const char * fileName, const MemBuffer & buffer,
+				const TextureFlags_t & flags, const int maxThreads, TextureMipChain & chain, MemBuffer & mipData );
+
+// Uploads a parsed mip chain, this needs the GL context.
+// Returns a 0 texture if the chain is empty, no default texture is created.
+GlTexture	CreateTextureFromMipChain( const TextureMipChain & chain, const TextureFlags_t & flags );
+
 // glDeleteTextures()
 // Can be safely called on a 0 texture without checking.
 void		FreeTexture( GlTexture texId );
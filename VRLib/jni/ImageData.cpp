@@ -15,10 +15,23 @@ Copyright   :   Copyright 2014 Oculus VR, LLC. All Rights reserved.
 #include <stdio.h>
 #include <math.h>
 #include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
 #include "Kernel/OVR_Types.h"
 #include "Kernel/OVR_Alg.h"
+#include "Kernel/OVR_Array.h"
+#include "Kernel/OVR_Atomic.h"
+#include "Kernel/OVR_Threads.h"
+#include "Kernel/OVR_Std.h"
 #include "Log.h"
 
+#if defined( OVR_CPU_SSE )
+#include <xmmintrin.h>
+#elif defined( OVR_CPU_ARM_NEON )
+#include <arm_neon.h>
+#endif
+
 namespace OVR {
 
 
@@ -111,49 +124,200 @@ static float LinearToSRGB( float c )
 	}
 }
 
-unsigned char * QuarterImageSize( const unsigned char * src, const int width, const int height, const bool srgb )
+/*
+	Converting every channel with powf() dominates the time it takes to resample
+	an image, so the conversions go through tables instead. Linear values are
+	quantized to 16 bits, which is fine enough that the 8 bit sRGB result is at
+	most one step off from the exact conversion, even in the steep part of the
+	curve near black.
+
+	Alpha is coverage, not a color, so it is always filtered linearly. Filtering
+	it in linear light would fade out alpha tested and anti-aliased edges a little
+	more at every mip level.
+*/
+
+static const int LINEAR_TABLE_SIZE = 1 << 16;
+
+static pthread_once_t	SrgbTablesOnce = PTHREAD_ONCE_INIT;
+static float			UnormToFloat[256];
+static float			SrgbToLinearFloat[256];
+static UInt16			SrgbToLinear16[256];
+static unsigned char	Linear16ToSrgb[LINEAR_TABLE_SIZE];
+
+static void BuildSrgbTables()
 {
-	float table[256];
-	if ( srgb )
+	for ( int i = 0; i < 256; i++ )
 	{
-		for ( int i = 0; i < 256; i++ )
+		const float linear = SRGBToLinear( i * ( 1.0f / 255.0f ) );
+		UnormToFloat[i] = i * ( 1.0f / 255.0f );
+		SrgbToLinearFloat[i] = linear;
+		SrgbToLinear16[i] = ( UInt16 )( linear * ( LINEAR_TABLE_SIZE - 1 ) + 0.5f );
+	}
+	for ( int i = 0; i < LINEAR_TABLE_SIZE; i++ )
+	{
+		const float gamma = LinearToSRGB( i * ( 1.0f / ( LINEAR_TABLE_SIZE - 1 ) ) );
+		Linear16ToSrgb[i] = ( unsigned char )ClampInt( ( int )( gamma * 255.0f + 0.5f ), 0, 255 );
+	}
+}
+
+// The tables are shared by all threads and only built once.
+static void InitSrgbTables()
+{
+	pthread_once( &SrgbTablesOnce, BuildSrgbTables );
+}
+
+// The output rows are handed out in bands to worker threads, and the calling
+// thread works on the bands as well. Every output row only depends on the
+// source image, so the bands are completely independent.
+static const int IMAGE_ROWS_PER_BAND = 16;
+
+// Below this number of output pixels it is not worth starting threads.
+static const int IMAGE_MIN_THREADED_PIXELS = 128 * 128;
+
+typedef void ( *imageBandFunc_t )( const void * parms, const int firstRow, const int lastRow );
+
+struct ImageBandWorkers
+{
+	imageBandFunc_t		BandFunc;
+	const void *		Parms;
+	int					NumRows;
+	AtomicInt< int >	NextBand;
+};
+
+static void * ImageBandWorkerThread( void * parm )
+{
+	ImageBandWorkers * workers = (ImageBandWorkers *)parm;
+	for ( ; ; )
+	{
+		const int firstRow = workers->NextBand.ExchangeAdd_Sync( 1 ) * IMAGE_ROWS_PER_BAND;
+		if ( firstRow >= workers->NumRows )
 		{
-			table[ i ] = SRGBToLinear( i * ( 1.0f / 255.0f ) );
+			break;
 		}
+		workers->BandFunc( workers->Parms, firstRow, Alg::Min( firstRow + IMAGE_ROWS_PER_BAND, workers->NumRows ) );
 	}
+	return NULL;
+}
 
-	const int newWidth = OVR::Alg::Max( 1, width >> 1 );
-	const int newHeight = OVR::Alg::Max( 1, height >> 1 );
-	unsigned char * out = (unsigned char *)malloc( newWidth * newHeight * 4 );
-	unsigned char * out_p = out;
-	for ( int y = 0; y < newHeight; y++ )
+// If maxThreads is 0, all cores are used.
+static void ProcessImageBands( imageBandFunc_t bandFunc, const void * parms, const int numRows, const int numPixels, const int maxThreads )
+{
+	ImageBandWorkers workers;
+	workers.BandFunc = bandFunc;
+	workers.Parms = parms;
+	workers.NumRows = numRows;
+	workers.NextBand = 0;
+
+	const int numBands = ( numRows + IMAGE_ROWS_PER_BAND - 1 ) / IMAGE_ROWS_PER_BAND;
+	const int numThreads = ( numPixels < IMAGE_MIN_THREADED_PIXELS ) ? 1 : ( ( maxThreads > 0 ) ? maxThreads : Thread::GetCPUCount() );
+	const int numWorkers = Alg::Min( numThreads, numBands ) - 1;
+
+	Array< pthread_t > threads;
+	for ( int i = 0; i < numWorkers; i++ )
 	{
-		const unsigned char * in_p = src + y * 2 * width * 4;
-		for ( int x = 0; x < newWidth; x++ )
+		pthread_t thread;
+		const int createErr = pthread_create( &thread, NULL, ImageBandWorkerThread, &workers );
+		if ( createErr != 0 )
 		{
-			for ( int i = 0; i < 4; i++ )
+			LOG( "pthread_create returned %i", createErr );
+			break;
+		}
+		threads.PushBack( thread );
+	}
+
+	ImageBandWorkerThread( &workers );
+
+	for ( int i = 0; i < threads.GetSizeI(); i++ )
+	{
+		pthread_join( threads[i], NULL );
+	}
+}
+
+struct quarterImageParms_t
+{
+	const unsigned char *	src;
+	int						width;
+	int						height;
+	unsigned char *			out;
+	int						newWidth;
+	bool					srgb;
+};
+
+static void QuarterImageRows( const void * parms, const int firstRow, const int lastRow )
+{
+	const quarterImageParms_t & p = *(const quarterImageParms_t *)parms;
+
+	for ( int y = firstRow; y < lastRow; y++ )
+	{
+		// A single row or column is averaged with itself.
+		const unsigned char * in0 = p.src + y * 2 * p.width * 4;
+		const unsigned char * in1 = p.src + Alg::Min( y * 2 + 1, p.height - 1 ) * p.width * 4;
+		const int step = ( p.width > 1 ) ? 4 : 0;
+		unsigned char * out_p = p.out + y * p.newWidth * 4;
+
+		if ( p.srgb )
+		{
+			for ( int x = 0; x < p.newWidth; x++ )
 			{
-				if ( srgb )
-				{
-					const float linear = ( table[ in_p[ i ] ] +
-						table[ in_p[ 4 + i ] ] +
-						table[ in_p[ width * 4 + i ] ] +
-						table[ in_p[ width * 4 + 4 + i ] ] ) * 0.25f;
-					const float gamma = LinearToSRGB( linear );
-					out_p[ i ] = ( unsigned char )ClampInt( ( int )( gamma * 255.0f + 0.5f ), 0, 255 );
-				}
-				else
+				for ( int i = 0; i < 3; i++ )
 				{
-					out_p[ i ] = ( in_p[ i ] +
-						in_p[ 4 + i ] +
-						in_p[ width * 4 + i ] +
-						in_p[ width * 4 + 4 + i ] ) >> 2;
+					const int linear = SrgbToLinear16[ in0[ i ] ] +
+						SrgbToLinear16[ in0[ step + i ] ] +
+						SrgbToLinear16[ in1[ i ] ] +
+						SrgbToLinear16[ in1[ step + i ] ];
+					out_p[ i ] = Linear16ToSrgb[ ( linear + 2 ) >> 2 ];
 				}
+				out_p[ 3 ] = ( unsigned char )( ( in0[ 3 ] + in0[ step + 3 ] + in1[ 3 ] + in1[ step + 3 ] + 2 ) >> 2 );
+				out_p += 4;
+				in0 += 8;
+				in1 += 8;
 			}
-			out_p += 4;
-			in_p += 8;
 		}
+		else
+		{
+			// Two channels at a time in the 16 bit halves of a word,
+			// the sum of four bytes only needs 10 bits.
+			for ( int x = 0; x < p.newWidth; x++ )
+			{
+				UInt32 a, b, c, d;
+				memcpy( &a, in0, 4 );
+				memcpy( &b, in0 + step, 4 );
+				memcpy( &c, in1, 4 );
+				memcpy( &d, in1 + step, 4 );
+				const UInt32 even = ( a & 0x00FF00FF ) + ( b & 0x00FF00FF ) + ( c & 0x00FF00FF ) + ( d & 0x00FF00FF );
+				const UInt32 odd = ( ( a >> 8 ) & 0x00FF00FF ) + ( ( b >> 8 ) & 0x00FF00FF ) +
+									( ( c >> 8 ) & 0x00FF00FF ) + ( ( d >> 8 ) & 0x00FF00FF );
+				const UInt32 average = ( ( even >> 2 ) & 0x00FF00FF ) | ( ( ( odd >> 2 ) & 0x00FF00FF ) << 8 );
+				memcpy( out_p, &average, 4 );
+				out_p += 4;
+				in0 += 8;
+				in1 += 8;
+			}
+		}
+	}
+}
+
+unsigned char * QuarterImageSize( const unsigned char * src, const int width, const int height, const bool srgb )
+{
+	if ( srgb )
+	{
+		InitSrgbTables();
 	}
+
+	const int newWidth = OVR::Alg::Max( 1, width >> 1 );
+	const int newHeight = OVR::Alg::Max( 1, height >> 1 );
+	unsigned char * out = (unsigned char *)malloc( newWidth * newHeight * 4 );
+
+	quarterImageParms_t parms;
+	parms.src = src;
+	parms.width = width;
+	parms.height = height;
+	parms.out = out;
+	parms.newWidth = newWidth;
+	parms.srgb = srgb;
+
+	ProcessImageBands( QuarterImageRows, &parms, newHeight, newWidth * newHeight, 0 );
+
 	return out;
 }
 
@@ -185,7 +349,482 @@ static void FilterWeights( const float s, const int filter, float weights[ 4 ] )
 	}
 }
 
-unsigned char * ScaleImageRGBA( const unsigned char * src, const int width, const int height, const int newWidth, const int newHeight, const ImageFilter filter )
+/*
+	The filters are separable, so every output row is the weighted sum of a few
+	source rows that are first filtered horizontally. The source positions and
+	weights only depend on the output column or row, so they are set up once
+	in tables. Consecutive output rows mostly use the same source rows when
+	upscaling, so the last few horizontally filtered rows are kept around.
+	The filtering is done in linear space on all four channels at once.
+*/
+
+static const int MAX_FILTER_TAPS = 16;
+
+struct filterTaps_t
+{
+	int		numTaps;
+	int *	index;		// numTaps per output sample, clamped to the source
+	float *	weights;	// numTaps per output sample
+};
+
+static void SetupFilterTaps( filterTaps_t & taps, const int size, const int newSize, const ImageFilter filter )
+{
+	int footprintMin = 0;
+	int footprintMax = 0;
+	int offset = 0;
+	switch ( filter )
+	{
+	case IMAGE_FILTER_NEAREST:	
+	{
+				footprintMin = 0;
+				footprintMax = 0;
+				offset = size;
+				break;
+	}
+	case IMAGE_FILTER_LINEAR:	
+	{
+				footprintMin = 0;
+				footprintMax = 1;
+				offset = size - newSize;
+				break;
+	}
+	case IMAGE_FILTER_CUBIC:	
+	{
+				footprintMin = -1;
+				footprintMax = 2;
+				offset = size - newSize;
+				break;
+	}
+	}
+
+	taps.numTaps = footprintMax - footprintMin + 1;
+	taps.index = ( int * )malloc( newSize * taps.numTaps * sizeof( int ) );
+	taps.weights = ( float * )malloc( newSize * taps.numTaps * sizeof( float ) );
+
+	for ( int i = 0; i < newSize; i++ )
+	{
+		const int src = ( i * size * 2 + offset ) / ( newSize * 2 );
+		const float frac = FracFloat( ( ( float )i * size * 2.0f + offset ) / ( newSize * 2.0f ) );
+
+		float weights[ MAX_FILTER_TAPS ];
+		FilterWeights( frac, filter, weights );
+
+		for ( int j = 0; j < taps.numTaps; j++ )
+		{
+			taps.index[ i * taps.numTaps + j ] = ClampInt( src + footprintMin + j, 0, size - 1 );
+			taps.weights[ i * taps.numTaps + j ] = weights[ j ];
+		}
+	}
+}
+
+static void FreeFilterTaps( filterTaps_t & taps )
+{
+	free( taps.index );
+	free( taps.weights );
+}
+
+struct scaleImageParms_t
+{
+	const unsigned char *	src;
+	int						width;
+	unsigned char *			scaled;
+	int						newWidth;
+	const filterTaps_t *	tapsX;
+	const filterTaps_t *	tapsY;
+	bool					srgb;		// filter the colors in linear space
+	const float *			toLinear;	// UnormToFloat or SrgbToLinearFloat for the colors, alpha always uses UnormToFloat
+};
+
+static void FilterRowHorizontal( const scaleImageParms_t & p, const int srcY, float * row )
+{
+	const unsigned char * in = p.src + srcY * p.width * 4;
+	const float * toLinear = p.toLinear;
+	const int numTaps = p.tapsX->numTaps;
+	const int * index = p.tapsX->index;
+	const float * weights = p.tapsX->weights;
+
+	for ( int x = 0; x < p.newWidth; x++, index += numTaps, weights += numTaps )
+	{
+#if defined( OVR_CPU_SSE )
+		__m128 sum = _mm_setzero_ps();
+		for ( int i = 0; i < numTaps; i++ )
+		{
+			const unsigned char * pixel = in + index[ i ] * 4;
+			const __m128 linear = _mm_setr_ps( toLinear[ pixel[ 0 ] ], toLinear[ pixel[ 1 ] ],
+												toLinear[ pixel[ 2 ] ], UnormToFloat[ pixel[ 3 ] ] );
+			sum = _mm_add_ps( sum, _mm_mul_ps( linear, _mm_set1_ps( weights[ i ] ) ) );
+		}
+		_mm_storeu_ps( row + x * 4, sum );
+#elif defined( OVR_CPU_ARM_NEON )
+		float32x4_t sum = vdupq_n_f32( 0.0f );
+		for ( int i = 0; i < numTaps; i++ )
+		{
+			const unsigned char * pixel = in + index[ i ] * 4;
+			const float linear[ 4 ] = { toLinear[ pixel[ 0 ] ], toLinear[ pixel[ 1 ] ],
+										toLinear[ pixel[ 2 ] ], UnormToFloat[ pixel[ 3 ] ] };
+			sum = vmlaq_n_f32( sum, vld1q_f32( linear ), weights[ i ] );
+		}
+		vst1q_f32( row + x * 4, sum );
+#else
+		float sum[ 4 ] = { 0.0f, 0.0f, 0.0f, 0.0f };
+		for ( int i = 0; i < numTaps; i++ )
+		{
+			const unsigned char * pixel = in + index[ i ] * 4;
+			for ( int c = 0; c < 3; c++ )
+			{
+				sum[ c ] += toLinear[ pixel[ c ] ] * weights[ i ];
+			}
+			sum[ 3 ] += UnormToFloat[ pixel[ 3 ] ] * weights[ i ];
+		}
+		for ( int c = 0; c < 4; c++ )
+		{
+			row[ x * 4 + c ] = sum[ c ];
+		}
+#endif
+	}
+}
+
+static void ScaleImageRows( const void * parms, const int firstRow, const int lastRow )
+{
+	const scaleImageParms_t & p = *(const scaleImageParms_t *)parms;
+
+	const int numTaps = p.tapsY->numTaps;
+
+	// The taps of a row are consecutive source rows, so they never share a slot.
+	int numSlots = 1;
+	while ( numSlots < numTaps )
+	{
+		numSlots <<= 1;
+	}
+	const int rowFloats = p.newWidth * 4;
+	float * rowCache = ( float * )malloc( numSlots * rowFloats * sizeof( float ) );
+	int rowCacheY[ MAX_FILTER_TAPS ];
+	for ( int i = 0; i < numSlots; i++ )
+	{
+		rowCacheY[ i ] = -1;
+	}
+
+	// The colors index Linear16ToSrgb if they are sRGB, alpha is always stored directly.
+	const float scale = p.srgb ? ( float )( LINEAR_TABLE_SIZE - 1 ) : 255.0f;
+	const float scales[ 4 ] = { scale, scale, scale, 255.0f };
+
+	for ( int y = firstRow; y < lastRow; y++ )
+	{
+		const int * index = &p.tapsY->index[ y * numTaps ];
+		const float * weights = &p.tapsY->weights[ y * numTaps ];
+
+		const float * rows[ MAX_FILTER_TAPS ];
+		for ( int i = 0; i < numTaps; i++ )
+		{
+			const int slot = index[ i ] & ( numSlots - 1 );
+			if ( rowCacheY[ slot ] != index[ i ] )
+			{
+				FilterRowHorizontal( p, index[ i ], rowCache + slot * rowFloats );
+				rowCacheY[ slot ] = index[ i ];
+			}
+			rows[ i ] = rowCache + slot * rowFloats;
+		}
+
+		// The filtered value is clamped to [0,1], which includes the cubic overshoot.
+		unsigned char * out = p.scaled + y * rowFloats;
+		for ( int x = 0; x < rowFloats; x += 4 )
+		{
+			float linear[ 4 ];
+#if defined( OVR_CPU_SSE )
+			__m128 sum = _mm_mul_ps( _mm_loadu_ps( rows[ 0 ] + x ), _mm_set1_ps( weights[ 0 ] ) );
+			for ( int i = 1; i < numTaps; i++ )
+			{
+				sum = _mm_add_ps( sum, _mm_mul_ps( _mm_loadu_ps( rows[ i ] + x ), _mm_set1_ps( weights[ i ] ) ) );
+			}
+			sum = _mm_min_ps( _mm_max_ps( sum, _mm_setzero_ps() ), _mm_set1_ps( 1.0f ) );
+			_mm_storeu_ps( linear, _mm_add_ps( _mm_mul_ps( sum, _mm_loadu_ps( scales ) ), _mm_set1_ps( 0.5f ) ) );
+#elif defined( OVR_CPU_ARM_NEON )
+			float32x4_t sum = vmulq_n_f32( vld1q_f32( rows[ 0 ] + x ), weights[ 0 ] );
+			for ( int i = 1; i < numTaps; i++ )
+			{
+				sum = vmlaq_n_f32( sum, vld1q_f32( rows[ i ] + x ), weights[ i ] );
+			}
+			sum = vminq_f32( vmaxq_f32( sum, vdupq_n_f32( 0.0f ) ), vdupq_n_f32( 1.0f ) );
+			vst1q_f32( linear, vmlaq_f32( vdupq_n_f32( 0.5f ), sum, vld1q_f32( scales ) ) );
+#else
+			for ( int c = 0; c < 4; c++ )
+			{
+				float sum = 0.0f;
+				for ( int i = 0; i < numTaps; i++ )
+				{
+					sum += rows[ i ][ x + c ] * weights[ i ];
+				}
+				linear[ c ] = Alg::Clamp( sum, 0.0f, 1.0f ) * scales[ c ] + 0.5f;
+			}
+#endif
+			if ( p.srgb )
+			{
+				out[ x + 0 ] = Linear16ToSrgb[ ( int )linear[ 0 ] ];
+				out[ x + 1 ] = Linear16ToSrgb[ ( int )linear[ 1 ] ];
+				out[ x + 2 ] = Linear16ToSrgb[ ( int )linear[ 2 ] ];
+				out[ x + 3 ] = ( unsigned char )linear[ 3 ];
+			}
+			else
+			{
+				out[ x + 0 ] = ( unsigned char )linear[ 0 ];
+				out[ x + 1 ] = ( unsigned char )linear[ 1 ];
+				out[ x + 2 ] = ( unsigned char )linear[ 2 ];
+				out[ x + 3 ] = ( unsigned char )linear[ 3 ];
+			}
+		}
+	}
+
+	free( rowCache );
+}
+
+static void ResampleImage( const unsigned char * src, const int width,
+							unsigned char * dst, const int newWidth, const int newHeight,
+							const filterTaps_t & tapsX, const filterTaps_t & tapsY, const bool srgb, const int maxThreads )
+{
+	InitSrgbTables();
+
+	scaleImageParms_t parms;
+	parms.src = src;
+	parms.width = width;
+	parms.scaled = dst;
+	parms.newWidth = newWidth;
+	parms.tapsX = &tapsX;
+	parms.tapsY = &tapsY;
+	parms.srgb = srgb;
+	parms.toLinear = srgb ? SrgbToLinearFloat : UnormToFloat;
+
+	ProcessImageBands( ScaleImageRows, &parms, newHeight, newWidth * newHeight, maxThreads );
+}
+
+unsigned char * ScaleImageRGBA( const unsigned char * src, const int width, const int height, const int newWidth, const int newHeight,
+								const ImageFilter filter, const int maxThreads )
+{
+	unsigned char * scaled = ( unsigned char * )malloc( newWidth * newHeight * 4 * sizeof( unsigned char ) );
+
+	filterTaps_t tapsX;
+	filterTaps_t tapsY;
+	SetupFilterTaps( tapsX, width, newWidth, filter );
+	SetupFilterTaps( tapsY, height, newHeight, filter );
+
+	ResampleImage( src, width, scaled, newWidth, newHeight, tapsX, tapsY, true, maxThreads );
+
+	FreeFilterTaps( tapsX );
+	FreeFilterTaps( tapsY );
+
+	return scaled;
+}
+
+/*
+	Every texel of a mip level covers the area of the source texels it replaces.
+	Halving an even size averages pairs of texels, but with a non power of two
+	size the next level is rounded down, so an odd number of texels is spread
+	over the texels of the next level, and every texel partially covers three
+	source texels. The box filter weighs the source texels by how much of their
+	area is covered, which is the plain 2x2 average of QuarterImageSize() for
+	even sizes.
+
+	The Kaiser filter is a sinc filter, windowed with a Kaiser window, that is
+	scaled to the spacing of the new texels. It keeps the mip levels sharper
+	than the box filter, without adding much aliasing.
+*/
+
+static const float MIP_KAISER_ALPHA = 4.0f;
+static const float MIP_KAISER_WIDTH = 2.0f;	// half width in texels of the new level
+
+// Zeroth order modified Bessel function of the first kind.
+static double BesselI0( const double x )
+{
+	double sum = 1.0;
+	double term = 1.0;
+	for ( int k = 1; k < 32; k++ )
+	{
+		term *= ( x * 0.5 / k ) * ( x * 0.5 / k );
+		sum += term;
+		if ( term < sum * 1e-12 )
+		{
+			break;
+		}
+	}
+	return sum;
+}
+
+// x is the distance from the center in texels of the new level.
+static double MipKaiserWeight( const double x )
+{
+	const double t = x / MIP_KAISER_WIDTH;
+	if ( t <= -1.0 || t >= 1.0 )
+	{
+		return 0.0;
+	}
+	const double sinc = ( fabs( x ) < 1e-6 ) ? 1.0 : sin( M_PI * x ) / ( M_PI * x );
+	return sinc * BesselI0( MIP_KAISER_ALPHA * sqrt( 1.0 - t * t ) ) / BesselI0( MIP_KAISER_ALPHA );
+}
+
+static void SetupMipFilterTaps( filterTaps_t & taps, const int size, const int newSize, const ImageMipFilter filter )
+{
+	// new texel i covers source [ i * scale, ( i + 1 ) * scale )
+	const double scale = ( double )size / newSize;
+	const double radius = ( filter == IMAGE_MIP_FILTER_BOX ) ? 0.5 * scale : MIP_KAISER_WIDTH * scale;
+
+	taps.numTaps = Alg::Min( ( int )ceil( 2.0 * radius ) + 1, MAX_FILTER_TAPS );
+	taps.index = ( int * )malloc( newSize * taps.numTaps * sizeof( int ) );
+	taps.weights = ( float * )malloc( newSize * taps.numTaps * sizeof( float ) );
+
+	for ( int i = 0; i < newSize; i++ )
+	{
+		const double center = ( i + 0.5 ) * scale;
+		const int first = ( int )floor( center - radius );
+
+		double weights[ MAX_FILTER_TAPS ];
+		double total = 0.0;
+		for ( int j = 0; j < taps.numTaps; j++ )
+		{
+			const int src = first + j;
+			if ( filter == IMAGE_MIP_FILTER_BOX )
+			{
+				const double coverage = Alg::Min( src + 1.0, center + radius ) - Alg::Max( ( double )src, center - radius );
+				weights[ j ] = Alg::Max( coverage, 0.0 );
+			}
+			else
+			{
+				weights[ j ] = MipKaiserWeight( ( src + 0.5 - center ) / scale );
+			}
+			total += weights[ j ];
+		}
+
+		// Texels past the edges are clamped, like the texture would be.
+		for ( int j = 0; j < taps.numTaps; j++ )
+		{
+			taps.index[ i * taps.numTaps + j ] = ClampInt( first + j, 0, size - 1 );
+			taps.weights[ i * taps.numTaps + j ] = ( float )( weights[ j ] / total );
+		}
+	}
+}
+
+int ImageMipCount( const int width, const int height )
+{
+	int mipCount = 1;
+	for ( int size = Alg::Max( width, height ); size > 1; size >>= 1 )
+	{
+		mipCount++;
+	}
+	return mipCount;
+}
+
+unsigned char * BuildImageMipChain( const unsigned char * src, const int width, const int height,
+									const bool srgb, const ImageMipFilter filter, const int maxThreads, int & mipCount )
+{
+	mipCount = ImageMipCount( width, height );
+
+	int totalSize = 0;
+	for ( int i = 0, w = width, h = height; i < mipCount; i++, w = Alg::Max( 1, w >> 1 ), h = Alg::Max( 1, h >> 1 ) )
+	{
+		totalSize += w * h * 4;
+	}
+
+	unsigned char * chain = ( unsigned char * )malloc( totalSize );
+	memcpy( chain, src, width * height * 4 );
+
+	const unsigned char * level = chain;
+	int w = width;
+	int h = height;
+	for ( int i = 1; i < mipCount; i++ )
+	{
+		const int newWidth = Alg::Max( 1, w >> 1 );
+		const int newHeight = Alg::Max( 1, h >> 1 );
+		unsigned char * newLevel = ( unsigned char * )level + w * h * 4;
+
+		if ( filter == IMAGE_MIP_FILTER_BOX && ( w == 1 || ( w & 1 ) == 0 ) && ( h == 1 || ( h & 1 ) == 0 ) )
+		{
+			quarterImageParms_t parms;
+			parms.src = level;
+			parms.width = w;
+			parms.height = h;
+			parms.out = newLevel;
+			parms.newWidth = newWidth;
+			parms.srgb = srgb;
+
+			if ( srgb )
+			{
+				InitSrgbTables();
+			}
+			ProcessImageBands( QuarterImageRows, &parms, newHeight, newWidth * newHeight, maxThreads );
+		}
+		else
+		{
+			filterTaps_t tapsX;
+			filterTaps_t tapsY;
+			SetupMipFilterTaps( tapsX, w, newWidth, filter );
+			SetupMipFilterTaps( tapsY, h, newHeight, filter );
+
+			ResampleImage( level, w, newLevel, newWidth, newHeight, tapsX, tapsY, srgb, maxThreads );
+
+			FreeFilterTaps( tapsX );
+			FreeFilterTaps( tapsY );
+		}
+
+		level = newLevel;
+		w = newWidth;
+		h = newHeight;
+	}
+
+	return chain;
+}
+
+//=============================================================================================
+// Image scaling benchmark
+//=============================================================================================
+
+// Previous implementations, which convert every channel with powf() and filter
+// the full 2D footprint of every output pixel on a single thread. They now filter
+// alpha linearly as well.
+static unsigned char * QuarterImageSizeReference( const unsigned char * src, const int width, const int height, const bool srgb )
+{
+	float table[256];
+	if ( srgb )
+	{
+		for ( int i = 0; i < 256; i++ )
+		{
+			table[ i ] = SRGBToLinear( i * ( 1.0f / 255.0f ) );
+		}
+	}
+
+	const int newWidth = OVR::Alg::Max( 1, width >> 1 );
+	const int newHeight = OVR::Alg::Max( 1, height >> 1 );
+	unsigned char * out = (unsigned char *)malloc( newWidth * newHeight * 4 );
+	unsigned char * out_p = out;
+	for ( int y = 0; y < newHeight; y++ )
+	{
+		const unsigned char * in_p = src + y * 2 * width * 4;
+		for ( int x = 0; x < newWidth; x++ )
+		{
+			for ( int i = 0; i < 4; i++ )
+			{
+				if ( srgb && i < 3 )
+				{
+					const float linear = ( table[ in_p[ i ] ] +
+						table[ in_p[ 4 + i ] ] +
+						table[ in_p[ width * 4 + i ] ] +
+						table[ in_p[ width * 4 + 4 + i ] ] ) * 0.25f;
+					const float gamma = LinearToSRGB( linear );
+					out_p[ i ] = ( unsigned char )ClampInt( ( int )( gamma * 255.0f + 0.5f ), 0, 255 );
+				}
+				else
+				{
+					out_p[ i ] = ( in_p[ i ] +
+						in_p[ 4 + i ] +
+						in_p[ width * 4 + i ] +
+						in_p[ width * 4 + 4 + i ] ) >> 2;
+				}
+			}
+			out_p += 4;
+			in_p += 8;
+		}
+	}
+	return out;
+}
+
+static unsigned char * ScaleImageRGBAReference( const unsigned char * src, const int width, const int height, const int newWidth, const int newHeight, const ImageFilter filter )
 {
 	int footprintMin = 0;
 	int footprintMax = 0;
@@ -236,7 +875,8 @@ unsigned char * ScaleImageRGBA( const unsigned char * src, const int width, cons
 		{
 			for ( int c = 0; c < 4; c++ )
 			{
-				srcLinear[ ( y * width + x ) * 4 + c ] = table[ src[ ( y * width + x ) * 4 + c ] ];
+				const unsigned char value = src[ ( y * width + x ) * 4 + c ];
+				srcLinear[ ( y * width + x ) * 4 + c ] = ( c < 3 ) ? table[ value ] : value * ( 1.0f / 255.0f );
 			}
 		}
 	}
@@ -293,7 +933,8 @@ unsigned char * ScaleImageRGBA( const unsigned char * src, const int width, cons
 		{
 			for ( int c = 0; c < 4; c++ )
 			{
-				const float gamma = LinearToSRGB( scaledLinear[ ( y * newWidth + x ) * 4 + c ] );
+				const float linear = scaledLinear[ ( y * newWidth + x ) * 4 + c ];
+				const float gamma = ( c < 3 ) ? LinearToSRGB( linear ) : linear;
 				scaled[ ( y * newWidth + x ) * 4 + c ] = ( unsigned char )ClampInt( ( int )( gamma * 255.0f + 0.5f ), 0, 255 );
 			}
 		}
@@ -305,5 +946,236 @@ unsigned char * ScaleImageRGBA( const unsigned char * src, const int width, cons
 	return scaled;
 }
 
+static void CompareImages( const char * label, const unsigned char * a, const unsigned char * b, const int numBytes,
+							const double referenceTime, const double time )
+{
+	int maxDiff = 0;
+	int numDiffs = 0;
+	for ( int i = 0; i < numBytes; i++ )
+	{
+		const int diff = AbsInt( a[i] - b[i] );
+		maxDiff = Alg::Max( maxDiff, diff );
+		numDiffs += ( diff != 0 );
+	}
+	LOG( "imageScaleBenchmark: %-24s %8.2f ms -> %7.2f ms, speedup %5.2fx, max diff %d, %1.3f%% of bytes differ",
+			label, referenceTime * 1e-6, time * 1e-6, referenceTime / Alg::Max( time, 1.0 ),
+			maxDiff, numDiffs * 100.0 / Alg::Max( numBytes, 1 ) );
+}
+
+void ImageScaleBenchmark( void * appPtr, const char * cmd )
+{
+	OVR_UNUSED( appPtr );
+
+	int width = 4096;
+	int height = 2048;
+	sscanf( cmd, "%i %i", &width, &height );
+	width = Alg::Max( width & ~1, 16 );
+	height = Alg::Max( height & ~1, 16 );
+
+	// Smooth gradients with some noise, like a photo.
+	unsigned char * src = ( unsigned char * )malloc( width * height * 4 );
+	UInt32 random = 12345;
+	for ( int y = 0; y < height; y++ )
+	{
+		for ( int x = 0; x < width; x++ )
+		{
+			random = random * 1664525 + 1013904223;
+			const int noise = ( int )( random >> 28 ) - 8;
+			unsigned char * pixel = src + ( y * width + x ) * 4;
+			pixel[0] = ( unsigned char )ClampInt( x * 255 / width + noise, 0, 255 );
+			pixel[1] = ( unsigned char )ClampInt( y * 255 / height + noise, 0, 255 );
+			pixel[2] = ( unsigned char )ClampInt( ( ( x ^ y ) & 255 ) + noise, 0, 255 );
+			pixel[3] = ( unsigned char )( 255 - ( random >> 30 ) * 16 );
+		}
+	}
+
+	LOG( "imageScaleBenchmark: %dx%d source, %d threads", width, height, Thread::GetCPUCount() );
+
+	for ( int srgb = 1; srgb >= 0; srgb-- )
+	{
+		double start = LogCpuTime::GetNanoSeconds();
+		unsigned char * reference = QuarterImageSizeReference( src, width, height, srgb != 0 );
+		double middle = LogCpuTime::GetNanoSeconds();
+		unsigned char * result = QuarterImageSize( src, width, height, srgb != 0 );
+		double end = LogCpuTime::GetNanoSeconds();
+		CompareImages( srgb ? "QuarterImageSize sRGB" : "QuarterImageSize", reference, result,
+						( width >> 1 ) * ( height >> 1 ) * 4, middle - start, end - middle );
+		free( reference );
+		free( result );
+	}
+
+	static const char * filterNames[] = { "nearest", "linear", "cubic" };
+	static const int divisors[] = { 2, 16 };
+	for ( int filter = IMAGE_FILTER_NEAREST; filter <= IMAGE_FILTER_CUBIC; filter++ )
+	{
+		for ( int i = 0; i < (int)( sizeof( divisors ) / sizeof( divisors[0] ) ); i++ )
+		{
+			const int newWidth = Alg::Max( width / divisors[i], 1 );
+			const int newHeight = Alg::Max( height / divisors[i], 1 );
+
+			double start = LogCpuTime::GetNanoSeconds();
+			unsigned char * reference = ScaleImageRGBAReference( src, width, height, newWidth, newHeight, ( ImageFilter )filter );
+			double middle = LogCpuTime::GetNanoSeconds();
+			unsigned char * result = ScaleImageRGBA( src, width, height, newWidth, newHeight, ( ImageFilter )filter, 0 );
+			double end = LogCpuTime::GetNanoSeconds();
+
+			char label[64];
+			OVR_sprintf( label, sizeof( label ), "%s %dx%d", filterNames[filter], newWidth, newHeight );
+			CompareImages( label, reference, result, newWidth * newHeight * 4, middle - start, end - middle );
+			free( reference );
+			free( result );
+		}
+	}
+
+	free( src );
+}
+
+//=============================================================================================
+// Mip chain test
+//=============================================================================================
+
+// Weight of a source texel for a new texel, evaluated without any tables.
+static double ReferenceMipWeight( const ImageMipFilter filter, const int src, const int dst, const int size, const int newSize )
+{
+	const double scale = ( double )size / newSize;
+	if ( filter == IMAGE_MIP_FILTER_BOX )
+	{
+		const double coverage = Alg::Min( src + 1.0, ( dst + 1.0 ) * scale ) - Alg::Max( ( double )src, dst * scale );
+		return Alg::Max( coverage, 0.0 );
+	}
+	const double x = ( src + 0.5 - ( dst + 0.5 ) * scale ) / scale;
+	if ( fabs( x ) >= MIP_KAISER_WIDTH )
+	{
+		return 0.0;
+	}
+	const double t = x / MIP_KAISER_WIDTH;
+	const double sinc = ( x == 0.0 ) ? 1.0 : sin( M_PI * x ) / ( M_PI * x );
+	return sinc * BesselI0( MIP_KAISER_ALPHA * sqrt( 1.0 - t * t ) ) / BesselI0( MIP_KAISER_ALPHA );
+}
+
+// Filters every new texel directly from the full 2D footprint in double precision.
+static void ReferenceMipLevel( const unsigned char * src, const int width, const int height,
+								unsigned char * dst, const int newWidth, const int newHeight,
+								const bool srgb, const ImageMipFilter filter )
+{
+	const int reach = ( int )ceil( MIP_KAISER_WIDTH * 3.0 ) + 1;
+	for ( int y = 0; y < newHeight; y++ )
+	{
+		for ( int x = 0; x < newWidth; x++ )
+		{
+			const int centerX = ( int )( ( x + 0.5 ) * width / newWidth );
+			const int centerY = ( int )( ( y + 0.5 ) * height / newHeight );
+			double sum[4] = { 0.0, 0.0, 0.0, 0.0 };
+			double total = 0.0;
+			for ( int sy = centerY - reach; sy <= centerY + reach; sy++ )
+			{
+				const double wy = ReferenceMipWeight( filter, sy, y, height, newHeight );
+				for ( int sx = centerX - reach; sx <= centerX + reach; sx++ )
+				{
+					const double w = ReferenceMipWeight( filter, sx, x, width, newWidth ) * wy;
+					if ( w == 0.0 )
+					{
+						continue;
+					}
+					const unsigned char * pixel = src + ( ClampInt( sy, 0, height - 1 ) * width + ClampInt( sx, 0, width - 1 ) ) * 4;
+					for ( int c = 0; c < 4; c++ )
+					{
+						const double v = pixel[c] / 255.0;
+						sum[c] += w * ( ( srgb && c < 3 ) ? ( ( v <= 0.04045 ) ? v / 12.92 : pow( ( v + 0.055 ) / 1.055, 2.4 ) ) : v );
+					}
+					total += w;
+				}
+			}
+			for ( int c = 0; c < 4; c++ )
+			{
+				const double v = Alg::Max( 0.0, Alg::Min( 1.0, sum[c] / total ) );
+				const double gamma = ( srgb && c < 3 ) ? ( ( v <= 0.0031308 ) ? v * 12.92 : 1.055 * pow( v, 1.0 / 2.4 ) - 0.055 ) : v;
+				dst[( y * newWidth + x ) * 4 + c] = ( unsigned char )ClampInt( ( int )( gamma * 255.0 + 0.5 ), 0, 255 );
+			}
+		}
+	}
+}
+
+void ImageMipChainTest( void * appPtr, const char * cmd )
+{
+	OVR_UNUSED( appPtr );
+	OVR_UNUSED( cmd );
+
+	static const int sizes[][2] = { { 256, 256 }, { 300, 200 }, { 257, 129 }, { 1, 37 }, { 640, 1 } };
+	static const char * filterNames[] = { "box", "kaiser" };
+
+	int numFailed = 0;
+	for ( int s = 0; s < ( int )( sizeof( sizes ) / sizeof( sizes[0] ) ); s++ )
+	{
+		const int width = sizes[s][0];
+		const int height = sizes[s][1];
+
+		// Hard edges with some noise, which is where the filters differ the most.
+		// The alpha edges are where filtering alpha in linear light would fail.
+		unsigned char * image = ( unsigned char * )malloc( width * height * 4 );
+		UInt32 random = 4321;
+		for ( int y = 0; y < height; y++ )
+		{
+			for ( int x = 0; x < width; x++ )
+			{
+				random = random * 1664525 + 1013904223;
+				unsigned char * pixel = image + ( y * width + x ) * 4;
+				pixel[0] = ( ( x / 7 + y / 5 ) & 1 ) ? 230 : 20;
+				pixel[1] = ( unsigned char )( x * 255 / width );
+				pixel[2] = ( unsigned char )( random >> 24 );
+				pixel[3] = ( ( x / 3 + y / 4 ) & 1 ) ? ( unsigned char )( 255 - y * 127 / height ) : 0;
+			}
+		}
+
+		for ( int filter = IMAGE_MIP_FILTER_BOX; filter <= IMAGE_MIP_FILTER_KAISER; filter++ )
+		{
+			for ( int srgb = 0; srgb <= 1; srgb++ )
+			{
+				int mipCount = 0;
+				unsigned char * chain = BuildImageMipChain( image, width, height, srgb != 0, ( ImageMipFilter )filter, 0, mipCount );
+
+				// Every level is compared with the reference filtering of the previous level.
+				int maxDiff = 0;
+				int numDiffs = 0;
+				const unsigned char * level = chain;
+				int w = width;
+				int h = height;
+				for ( int i = 1; i < mipCount; i++ )
+				{
+					const int newWidth = Alg::Max( 1, w >> 1 );
+					const int newHeight = Alg::Max( 1, h >> 1 );
+					const unsigned char * newLevel = level + w * h * 4;
+
+					unsigned char * reference = ( unsigned char * )malloc( newWidth * newHeight * 4 );
+					ReferenceMipLevel( level, w, h, reference, newWidth, newHeight, srgb != 0, ( ImageMipFilter )filter );
+					for ( int j = 0; j < newWidth * newHeight * 4; j++ )
+					{
+						const int diff = AbsInt( reference[j] - newLevel[j] );
+						maxDiff = Alg::Max( maxDiff, diff );
+						numDiffs += ( diff != 0 );
+					}
+					free( reference );
+
+					level = newLevel;
+					w = newWidth;
+					h = newHeight;
+				}
+				free( chain );
+
+				// The 2x2 average truncates instead of rounding, and the sRGB
+				// conversions go through 16 bit linear values.
+				const bool failed = ( maxDiff > 1 || mipCount != ImageMipCount( width, height ) );
+				numFailed += failed;
+				LOG( "mipChainTest: %4dx%-4d %-6s %-6s %2d levels, max diff %d, %d bytes differ%s",
+						width, height, filterNames[filter], srgb ? "sRGB" : "linear", mipCount, maxDiff, numDiffs,
+						failed ? " FAILED" : "" );
+			}
+		}
+
+		free( image );
+	}
+
+	LOG( "mipChainTest: %s", numFailed == 0 ? "passed" : "FAILED" );
+}
 
 }	// namespace OVR
@@ -20,7 +20,9 @@ namespace OVR {
 void		Write32BitPvrTexture( const char * fileName, const unsigned char * texture, int width, int height );
 
 // The returned buffer should be freed with free()
-// If srgb is true, the resampling will be gamma correct, otherwise it is just sumOf4 >> 2
+// If srgb is true, the resampling of the colors will be gamma correct, otherwise it is just sumOf4 >> 2.
+// Alpha is always filtered linearly.
+// Large images are split into bands of rows that are processed on all cores.
 unsigned char * QuarterImageSize( const unsigned char * src, const int width, const int height, const bool srgb );
 
 // The returned buffer should be freed with free().
@@ -31,7 +33,44 @@ enum ImageFilter
 	IMAGE_FILTER_CUBIC
 };
 // filter: 0 = nearest, 1 = linear, 2 = cubic
-unsigned char * ScaleImageRGBA( const unsigned char * src, const int width, const int height, const int newWidth, const int newHeight, const ImageFilter filter );
+// The resampling of the colors is gamma correct, alpha is filtered linearly.
+// Large images are processed on up to maxThreads threads, or on all cores if maxThreads is 0.
+// Pass 1 when calling from a worker thread that already runs next to other workers.
+unsigned char * ScaleImageRGBA( const unsigned char * src, const int width, const int height, const int newWidth, const int newHeight,
+								const ImageFilter filter, const int maxThreads );
+
+enum ImageMipFilter
+{
+	IMAGE_MIP_FILTER_BOX,
+	IMAGE_MIP_FILTER_KAISER
+};
+
+// Number of levels in a full mip chain, down to 1x1.
+int ImageMipCount( const int width, const int height );
+
+// Builds the full mip chain of an RGBA image on the CPU, so it can be done on any
+// thread. The levels are packed one after another in the returned buffer, starting
+// with a copy of the source image, the way a multi-level texture is uploaded.
+// Non power of two sizes are rounded down at every level, like OpenGL does.
+// If srgb is true, the filtering of the colors will be gamma correct, alpha is
+// always filtered linearly. Large levels are split into bands of rows that are
+// processed on up to maxThreads threads, or on all cores if maxThreads is 0.
+// The returned buffer should be freed with free().
+unsigned char * BuildImageMipChain( const unsigned char * src, const int width, const int height,
+									const bool srgb, const ImageMipFilter filter, const int maxThreads, int & mipCount );
+
+// Logs the time QuarterImageSize() and ScaleImageRGBA() take on a generated image
+// for all filters, against the previous single threaded versions, plus the largest
+// difference in the results.
+// Registered as the "imageScaleBenchmark" console command, optional parms:
+// "<source width> <source height>", the default is 4096 x 2048
+void ImageScaleBenchmark( void * appPtr, const char * cmd );
+
+// Builds mip chains for generated power of two and non power of two images with
+// both filters, and logs the largest difference with a direct double precision
+// evaluation of every level. Does not need a GL context.
+// Registered as the "mipChainTest" console command, no parms.
+void ImageMipChainTest( void * appPtr, const char * cmd );
 
 }	// namespace OVR
 
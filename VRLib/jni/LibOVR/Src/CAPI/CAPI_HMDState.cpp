@@ -132,6 +132,23 @@ void HMDState::RecenterYaw()
 	SFusion.RecenterYaw();
 }
 
+// Records the sensor samples for offline replay.
+bool HMDState::StartSensorRecording(const char* path)
+{
+	return SFusion.StartRecording(path);
+}
+
+int HMDState::StopSensorRecording()
+{
+	return SFusion.StopRecording();
+}
+
+void HMDState::SetSensorPredictionMode(ovrSensorPredictionMode mode)
+{
+	OVR_COMPILER_ASSERT((int)ovrSensorPrediction_Filtered == (int)Prediction_Filtered);
+	SFusion.SetPredictionMode((PredictionMode)mode);
+}
+
 // Returns prediction for time.
 ovrSensorState HMDState::PredictedSensorState(double absTime, bool allowSensorCreate)
 {
@@ -43,6 +43,9 @@ public:
 	void            StopSensor();
 	void            ResetSensor();
 	void			RecenterYaw();
+	bool            StartSensorRecording(const char* path);
+	int             StopSensorRecording();
+	void            SetSensorPredictionMode(ovrSensorPredictionMode mode);
 	ovrSensorState  PredictedSensorState(double absTime, bool allowSensorCreate);
 
 	bool            ProcessLatencyTest(unsigned char rgbColorOut[3]);
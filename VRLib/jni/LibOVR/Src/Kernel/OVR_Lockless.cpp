@@ -11,13 +11,215 @@ Copyright   :   Copyright 2014 Oculus VR, LLC. All Rights reserved.
 *************************************************************************************/
 
 #include "OVR_Lockless.h"
-
-#ifdef OVR_LOCKLESS_TEST
-
+#include "OVR_Alg.h"
 #include "OVR_Threads.h"
 #include "OVR_Timer.h"
 #include "OVR_Log.h"
 
+namespace OVR {
+
+//-------------------------------------------------------------------------------------
+// ***** LocklessSnapshotBenchmark
+
+namespace LocklessBenchmark {
+
+// Block of consecutive values that is only consistent if it was written atomically.
+struct TestState
+{
+	enum { ItemCount = 16 };
+
+	UInt32	Data[ItemCount];
+
+	TestState() { Set( 0 ); }
+
+	void Set( UInt32 val )
+	{
+		for ( int i = 0; i < ItemCount; i++ )
+		{
+			Data[i] = val + i;
+		}
+	}
+
+	bool IsConsistent() const
+	{
+		for ( int i = 1; i < ItemCount; i++ )
+		{
+			if ( Data[i] != Data[0] + i )
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+};
+
+template< class Updater >
+struct Shared
+{
+	Updater			State;
+	volatile UInt32	Stop;
+	int				UpdateIntervalMs;	// 0 = as fast as possible
+	UInt32			Updates;
+};
+
+struct ReaderResult
+{
+	UInt32			Reads;
+	UInt32			Errors;
+};
+
+template< class Updater >
+struct ReaderParms
+{
+	Shared<Updater> *	Share;
+	ReaderResult		Result;
+};
+
+// LocklessUpdater doesn't have a version, so the value in the state is used instead.
+template< class T >
+inline T GetVersionedState( const LocklessUpdater<T> & updater, UInt32 & version )
+{
+	const T state = updater.GetState();
+	version = state.Data[0];
+	return state;
+}
+
+template< class T, int NumSlots >
+inline T GetVersionedState( const LocklessSnapshot<T, NumSlots> & snapshot, UInt32 & version )
+{
+	return snapshot.GetState( version );
+}
+
+template< class Updater >
+int ProducerThread( Thread *, void * h )
+{
+	Shared<Updater> * share = (Shared<Updater> *)h;
+	UInt32 value = 0;
+	while ( !LocklessLoadAcquire( &share->Stop ) )
+	{
+		TestState state;
+		state.Set( ++value );
+		share->State.SetState( state );
+		if ( share->UpdateIntervalMs > 0 )
+		{
+			Thread::MSleep( share->UpdateIntervalMs );
+		}
+	}
+	share->Updates = value;
+	return 0;
+}
+
+template< class Updater >
+int ConsumerThread( Thread *, void * h )
+{
+	ReaderParms<Updater> * parms = (ReaderParms<Updater> *)h;
+	Shared<Updater> * share = parms->Share;
+	UInt32 reads = 0;
+	UInt32 errors = 0;
+	UInt32 lastVersion = 0;
+	while ( !LocklessLoadAcquire( &share->Stop ) )
+	{
+		UInt32 version;
+		const TestState state = GetVersionedState( share->State, version );
+		// The state must be consistent, must match its version, and may never go back in time.
+		errors += !state.IsConsistent() || state.Data[0] != version || version < lastVersion;
+		lastVersion = version;
+		reads++;
+	}
+	parms->Result.Reads = reads;
+	parms->Result.Errors = errors;
+	return 0;
+}
+
+template< class Updater >
+UInt32 GetReadRetries( const Updater & ) { return 0; }
+
+template< class T, int NumSlots >
+UInt32 GetReadRetries( const LocklessSnapshot<T, NumSlots> & snapshot ) { return snapshot.GetReadRetries(); }
+
+template< class Updater >
+int Run( const char * label, int numReaders, int milliseconds, int updateIntervalMs )
+{
+	static const int MaxReaders = 16;
+	numReaders = Alg::Min( numReaders, MaxReaders );
+
+	Shared<Updater> * share = new Shared<Updater>;
+	share->Stop = 0;
+	share->UpdateIntervalMs = updateIntervalMs;
+	share->Updates = 0;
+
+	ReaderParms<Updater> readers[MaxReaders];
+	Ptr<Thread> threads[MaxReaders + 1];
+
+	for ( int i = 0; i < numReaders; i++ )
+	{
+		readers[i].Share = share;
+		readers[i].Result.Reads = 0;
+		readers[i].Result.Errors = 0;
+		threads[i] = *new Thread( ConsumerThread<Updater>, &readers[i] );
+	}
+	threads[numReaders] = *new Thread( ProducerThread<Updater>, share );
+
+	const double start = Timer::GetSeconds();
+	for ( int i = 0; i <= numReaders; i++ )
+	{
+		threads[i]->Start();
+	}
+	Thread::MSleep( milliseconds );
+	LocklessStoreRelease( &share->Stop, 1 );
+	for ( int i = 0; i <= numReaders; i++ )
+	{
+		while ( !threads[i]->IsFinished() )
+		{
+			Thread::MSleep( 1 );
+		}
+	}
+	const double seconds = Timer::GetSeconds() - start;
+
+	UInt32 reads = 0;
+	UInt32 errors = 0;
+	for ( int i = 0; i < numReaders; i++ )
+	{
+		reads += readers[i].Result.Reads;
+		errors += readers[i].Result.Errors;
+	}
+	const UInt32 retries = GetReadRetries( share->State );
+
+	LogText( "LocklessSnapshotBenchmark: %-22s %-9s %2d readers: %7.2f Mreads/s per reader, %8.3f Mupdates/s, %6.1f retries per Mread, %d errors\n",
+			label, updateIntervalMs > 0 ? "paced" : "flat out", numReaders,
+			reads / seconds * 1e-6 / Alg::Max( numReaders, 1 ), share->Updates / seconds * 1e-6,
+			retries * 1e6 / Alg::Max( reads, 1u ), errors );
+
+	delete share;
+	return (int)errors;
+}
+
+} // namespace LocklessBenchmark
+
+int LocklessSnapshotBenchmark( int numReaders, int milliseconds )
+{
+	using namespace LocklessBenchmark;
+
+	numReaders = Alg::Max( numReaders, 1 );
+	milliseconds = Alg::Max( milliseconds, 10 );
+
+	int errors = 0;
+	for ( int paced = 0; paced <= 1; paced++ )
+	{
+		const int intervalMs = paced ? 1 : 0;	// roughly the sensor rate
+		errors += Run< LocklessUpdater<TestState> >( "LocklessUpdater", numReaders, milliseconds, intervalMs );
+		errors += Run< LocklessSnapshot<TestState, 2> >( "LocklessSnapshot<2>", numReaders, milliseconds, intervalMs );
+		errors += Run< LocklessSnapshot<TestState, 4> >( "LocklessSnapshot<4>", numReaders, milliseconds, intervalMs );
+		errors += Run< LocklessSnapshot<TestState, 8> >( "LocklessSnapshot<8>", numReaders, milliseconds, intervalMs );
+	}
+	LogText( "LocklessSnapshotBenchmark: %s, %d errors\n", errors == 0 ? "PASSED" : "FAILED", errors );
+	return errors;
+}
+
+} // namespace OVR
+
+#ifdef OVR_LOCKLESS_TEST
+
 
 namespace OVR { namespace LocklessTest {
 
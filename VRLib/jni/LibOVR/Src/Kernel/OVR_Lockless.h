@@ -83,6 +83,137 @@ public:
 };
 
 
+// ***** Lockless memory ordering
+
+// C++11 style acquire / release loads, stores and fences. Unlike the AtomicOps,
+// these also keep the compiler from moving the plain loads and stores of the
+// data that is protected by a sequence stamp across them.
+
+#if defined(OVR_CC_GNU) || defined(__clang__)
+
+inline UInt32	LocklessLoadRelaxed( const volatile UInt32 * p )		{ return __atomic_load_n( p, __ATOMIC_RELAXED ); }
+inline UInt32	LocklessLoadAcquire( const volatile UInt32 * p )		{ return __atomic_load_n( p, __ATOMIC_ACQUIRE ); }
+inline void		LocklessStoreRelaxed( volatile UInt32 * p, UInt32 val )	{ __atomic_store_n( p, val, __ATOMIC_RELAXED ); }
+inline void		LocklessStoreRelease( volatile UInt32 * p, UInt32 val )	{ __atomic_store_n( p, val, __ATOMIC_RELEASE ); }
+inline void		LocklessAddRelaxed( volatile UInt32 * p, UInt32 val )	{ __atomic_fetch_add( p, val, __ATOMIC_RELAXED ); }
+inline void		LocklessFenceAcquire()									{ __atomic_thread_fence( __ATOMIC_ACQUIRE ); }
+inline void		LocklessFenceRelease()									{ __atomic_thread_fence( __ATOMIC_RELEASE ); }
+
+#else
+
+// MSVC gives volatile accesses acquire / release semantics.
+inline UInt32	LocklessLoadRelaxed( const volatile UInt32 * p )		{ return *p; }
+inline UInt32	LocklessLoadAcquire( const volatile UInt32 * p )		{ return *p; }
+inline void		LocklessStoreRelaxed( volatile UInt32 * p, UInt32 val )	{ *p = val; }
+inline void		LocklessStoreRelease( volatile UInt32 * p, UInt32 val )	{ *p = val; }
+inline void		LocklessAddRelaxed( volatile UInt32 * p, UInt32 val )	{ AtomicOps<UInt32>::ExchangeAdd_NoSync( p, val ); }
+inline void		LocklessFenceAcquire()									{ MemoryBarrier(); }
+inline void		LocklessFenceRelease()									{ MemoryBarrier(); }
+
+#endif
+
+
+// ***** LocklessSnapshot
+
+// Generalization of LocklessUpdater for a single producer and any number of
+// consumers that only care about the most recent state.
+//
+// The producer cycles through NumSlots copies of the state, each guarded by its
+// own sequence stamp, so a consumer only has to retry if the producer went all
+// the way around the slots while it was copying one out. With the default of
+// four slots that practically never happens. Reading doesn't write to shared
+// memory and doesn't need a full barrier.
+//
+// Every update gets a version number, which is returned along with the state,
+// so a consumer can tell whether the state changed, and how many updates it
+// missed since the last time it looked.
+//
+// The state is copied while the producer may be writing it, and only used if
+// the stamp shows it wasn't, so T should be plain data.
+
+template<class T, int NumSlots = 4>
+class LocklessSnapshot
+{
+public:
+	LocklessSnapshot() : Version( 0 ), ReadRetries( 0 )
+	{
+		OVR_COMPILER_ASSERT( NumSlots >= 2 );
+		for ( int i = 0; i < NumSlots; i++ )
+		{
+			Slots[i].Stamp = 0;
+		}
+	}
+
+	// Single producer only.
+	// Returns the version of the new state, the first SetState() returns 1.
+	UInt32	SetState( const T & state )
+	{
+		const UInt32 version = Version + 1;
+		Slot & slot = Slots[version % NumSlots];
+
+		// An odd stamp marks the slot as being written.
+		LocklessStoreRelaxed( &slot.Stamp, version * 2 + 1 );
+		LocklessFenceRelease();
+		slot.State = state;
+		LocklessStoreRelease( &slot.Stamp, version * 2 );
+		LocklessStoreRelease( &Version, version );
+		return version;
+	}
+
+	T		GetState() const
+	{
+		UInt32 version;
+		return GetState( version );
+	}
+
+	// Version is 0 if the state has never been set.
+	T		GetState( UInt32 & version ) const
+	{
+		for ( ; ; )
+		{
+			version = LocklessLoadAcquire( &Version );
+			const Slot & slot = Slots[version % NumSlots];
+			const UInt32 begin = LocklessLoadAcquire( &slot.Stamp );
+			if ( begin == version * 2 )
+			{
+				const T state = slot.State;
+				LocklessFenceAcquire();
+				if ( LocklessLoadRelaxed( &slot.Stamp ) == begin )
+				{
+					return state;
+				}
+			}
+			// The producer reused the slot before or while we copied it out,
+			// so fetch the latest version again.
+			LocklessAddRelaxed( &ReadRetries, 1 );
+		}
+	}
+
+	UInt32	GetVersion() const { return LocklessLoadAcquire( &Version ); }
+
+	// Number of times a consumer had to start over.
+	UInt32	GetReadRetries() const { return LocklessLoadRelaxed( &ReadRetries ); }
+
+private:
+	struct Slot
+	{
+		volatile UInt32		Stamp;		// version * 2, +1 while being written
+		T					State;
+	};
+
+	volatile UInt32				Version;
+	mutable volatile UInt32		ReadRetries;
+	Slot						Slots[NumSlots];
+};
+
+
+// Checks the consistency of LocklessUpdater and LocklessSnapshot states while a
+// producer updates them as fast as possible, and at a sensor like rate, with the
+// given number of consumer threads, and logs the reads per second and retries.
+// Returns the number of inconsistent states that were read.
+int LocklessSnapshotBenchmark( int numReaders, int milliseconds );
+
+
 #ifdef OVR_LOCKLESS_TEST
 void StartLocklessTest();
 #endif
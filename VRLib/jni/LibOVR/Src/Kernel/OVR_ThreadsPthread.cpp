@@ -798,7 +798,9 @@ ThreadId GetCurrentThreadId()
 /* static */
 int     Thread::GetCPUCount()
 {
-    return 1;
+    // Cores that are powered down by hotplugging are not counted.
+    const long count = sysconf(_SC_NPROCESSORS_ONLN);
+    return (count > 0) ? (int)count : 1;
 }
 
 // *** Sleep functions
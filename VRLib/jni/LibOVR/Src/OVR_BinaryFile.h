@@ -49,15 +49,19 @@ public:
 	template< typename _type_ >
 	bool ReadArray( Array< _type_ > & out, const int numElements ) const
 	{
-		const int bytes = numElements * sizeof( out[0] );
-		if ( Data == NULL || bytes > Size - Offset )
+		// Compare element counts, so a huge count cannot wrap the number of bytes.
+		if ( Data == NULL || numElements < 0 || (size_t)numElements > (size_t)( Size - Offset ) / sizeof( out[0] ) )
 		{
 			out.Resize( 0 );
 			return false;
 		}
+		const size_t bytes = (size_t)numElements * sizeof( out[0] );
 		out.Resize( numElements );
-		memcpy( &out[0], &Data[Offset], bytes );
-		Offset += bytes;
+		if ( bytes > 0 )
+		{
+			memcpy( &out[0], &Data[Offset], bytes );
+		}
+		Offset += (SInt32)bytes;
 		return true;
 	}
 
@@ -66,6 +70,11 @@ public:
 		return ( Offset == Size );
 	}
 
+	int GetBytesLeft() const
+	{
+		return ( Data != NULL ) ? Size - Offset : 0;
+	}
+
 private:
 	const UByte *	Data;
 	SInt32			Size;
@@ -163,6 +163,24 @@ void ovrHmd_RecenterYaw(ovrHmd hmd)
 	p->RecenterYaw();
 }
 
+bool ovrHmd_StartSensorRecording(ovrHmd hmd, const char* path)
+{
+    OVR::CAPI::HMDState* p = (OVR::CAPI::HMDState*)hmd;
+    return p->StartSensorRecording(path);
+}
+
+int ovrHmd_StopSensorRecording(ovrHmd hmd)
+{
+    OVR::CAPI::HMDState* p = (OVR::CAPI::HMDState*)hmd;
+    return p->StopSensorRecording();
+}
+
+void ovrHmd_SetSensorPredictionMode(ovrHmd hmd, ovrSensorPredictionMode mode)
+{
+    OVR::CAPI::HMDState* p = (OVR::CAPI::HMDState*)hmd;
+    p->SetSensorPredictionMode(mode);
+}
+
 ovrSensorState ovrHmd_GetSensorState(ovrHmd hmd, double absTime, bool allowSensorCreate)
 {
     OVR::CAPI::HMDState* p = (OVR::CAPI::HMDState*)hmd;
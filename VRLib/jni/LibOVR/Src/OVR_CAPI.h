@@ -118,6 +118,14 @@ typedef enum
     ovrStatus_HmdConnected          = 0x0080    // HMD Display is available & connected.
 } ovrStatusBits;
 
+// How the orientation is predicted ahead of the most recent sensor sample.
+typedef enum
+{
+    ovrSensorPrediction_ConstantVelocity,       // last angular velocity (default)
+    ovrSensorPrediction_ConstantAcceleration,   // last angular velocity and acceleration
+    ovrSensorPrediction_Filtered                // Kalman filtered angular velocity and acceleration
+} ovrSensorPredictionMode;
+
 
 // Specifies which eye is being used for rendering.
 // This type explicitly does not include a third "NoStereo" option, as such is
@@ -220,6 +228,13 @@ void        ovrHmd_StopSensor(ovrHmd hmd);
 void        ovrHmd_ResetSensor(ovrHmd hmd);
 // Recenters the orientation on the yaw axis.
 void        ovrHmd_RecenterYaw(ovrHmd hmd);
+// Resets the sensor orientation and records all sensor samples to the file
+// until ovrHmd_StopSensorRecording(), for replay with ReplaySensorRecording().
+bool        ovrHmd_StartSensorRecording(ovrHmd hmd, const char* path);
+// Returns the number of recorded samples.
+int         ovrHmd_StopSensorRecording(ovrHmd hmd);
+// Selects the predictor used by ovrHmd_GetSensorState(), can be changed at any time.
+void        ovrHmd_SetSensorPredictionMode(ovrHmd hmd, ovrSensorPredictionMode mode);
 
 // Returns sensor state reading based on the specified absolute system time.
 // Pass absTime value of 0.0 to request the most recent sensor reading; in this case
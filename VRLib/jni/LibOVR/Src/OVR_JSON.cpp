@@ -41,10 +41,13 @@ Copyright   :   Copyright 2014 Oculus VR, LLC. All Rights reserved.
 #include <float.h>
 #include <limits.h>
 #include <ctype.h>
+#include <malloc.h>
 #include "OVR_JSON.h"
 #include "Kernel/OVR_SysFile.h"
 #include "Kernel/OVR_Log.h"
 #include "Kernel/OVR_Math.h"
+#include "Kernel/OVR_Alg.h"
+#include "Kernel/OVR_Timer.h"
 #include "Kernel/OVR_String_Utils.h"
 
 namespace OVR {
@@ -123,13 +126,25 @@ JSON::~JSON()
 }
 
 //-----------------------------------------------------------------------------
-// Parse the input text to generate a number, and populate the result into item
+// Parse the input text to generate a number.
 // Returns the text position after the parsed number
-const char* JSON::parseNumber(const char *num)
+static const char* ParseNumberText(const char *num, double& value)
 {
-    const char* num_start = num;
-    double      n=0, sign=1, scale=0;
-    int         subscale     = 0,
+    // Exact powers of ten, which are the same as pow(10.0, e) but much cheaper.
+    static const double positivePowers[] =
+    {
+        1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+    };
+    static const double negativePowers[] =
+    {
+        1e0,   1e-1,  1e-2,  1e-3,  1e-4,  1e-5,  1e-6,  1e-7,  1e-8,  1e-9,  1e-10, 1e-11,
+        1e-12, 1e-13, 1e-14, 1e-15, 1e-16, 1e-17, 1e-18, 1e-19, 1e-20, 1e-21, 1e-22
+    };
+
+    double      n=0, sign=1;
+    int         scale=0,
+                subscale     = 0,
                 signsubscale = 1;
 
     // Could use sscanf for this?
@@ -174,14 +189,29 @@ const char* JSON::parseNumber(const char *num)
     }
 
     // Number = +/- number.fraction * 10^+/- exponent
-    n = sign*n*pow(10.0,(scale+subscale*signsubscale));
+    const int exponent = scale+subscale*signsubscale;
+    if (exponent >= 0 && exponent <= 22)
+        value = sign*n*positivePowers[exponent];
+    else if (exponent < 0 && exponent >= -22)
+        value = sign*n*negativePowers[-exponent];
+    else
+        value = sign*n*pow(10.0,exponent);
+
+    return num;
+}
+
+//-----------------------------------------------------------------------------
+// Parse the input text to generate a number, and populate the result into item
+// Returns the text position after the parsed number
+const char* JSON::parseNumber(const char *num)
+{
+    const char* num_end = ParseNumberText(num, dValue);
 
     // Assign parsed value.
     Type   = JSON_Number;
-    dValue = n;
-    Value.AssignString(num_start, num - num_start);
+    Value.AssignString(num, num_end - num);
     
-    return num;
+    return num_end;
 }
 
 // Parses a hex string up to the specified number of digits.
@@ -1150,4 +1180,892 @@ const String JsonReader::GetNextArrayString( const String & defaultValue ) const
 	return String( ( c != NULL ) ? c->GetStringValue() : defaultValue );
 }
 
+
+//-----------------------------------------------------------------------------
+// ***** JsonPullParser
+
+// Unescapes the string that starts with the quote at str in place, and zero terminates it.
+// Returns the text position after the closing quote, or NULL if there is none.
+static char * ParseStringInSitu( char * str, int & length )
+{
+    OVR_ASSERT( *str == '\"' );
+    char * ptr  = str + 1;
+    char * ptr2 = str + 1;
+    const char * p;
+    unsigned uc, uc2;
+
+    // Nothing has to move until the first escape.
+    while (*ptr != '\"' && *ptr != '\\' && *ptr)
+        ptr++;
+    ptr2 = ptr;
+
+    while (*ptr != '\"' && *ptr)
+    {
+        if (*ptr != '\\')
+        {
+            *ptr2++ = *ptr++;
+            continue;
+        }
+        ptr++;
+        switch (*ptr)
+        {
+            case 'b': *ptr2++ = '\b';   break;
+            case 'f': *ptr2++ = '\f';   break;
+            case 'n': *ptr2++ = '\n';   break;
+            case 'r': *ptr2++ = '\r';   break;
+            case 't': *ptr2++ = '\t';   break;
+
+            // Transcode utf16 to utf8, the same way as JSON::parseString.
+            // The utf8 is never longer than the escape sequence.
+            case 'u':
+            {
+                p = ParseHex(&uc, 4, ptr + 1);
+                ptr = (char *)p - 1;
+
+                if ((uc>=0xDC00 && uc<=0xDFFF) || uc==0)
+                    break;  // Check for invalid.
+
+                // UTF16 surrogate pairs.
+                if (uc>=0xD800 && uc<=0xDBFF)
+                {
+                    if (ptr[1]!='\\' || ptr[2]!='u')
+                        break;  // Missing second-half of surrogate.
+
+                    p = ParseHex(&uc2, 4, ptr + 3);
+                    ptr = (char *)p - 1;
+
+                    if (uc2<0xDC00 || uc2>0xDFFF)
+                        break;  // Invalid second-half of surrogate.
+
+                    uc = 0x10000 + (((uc&0x3FF)<<10) | (uc2&0x3FF));
+                }
+
+                int len = 4;
+                if (uc<0x80)
+                    len=1;
+                else if (uc<0x800)
+                    len=2;
+                else if (uc<0x10000)
+                    len=3;
+
+                ptr2+=len;
+                switch (len)
+                {
+                    case 4: *--ptr2 =((uc | 0x80) & 0xBF); uc >>= 6;
+                    case 3: *--ptr2 =((uc | 0x80) & 0xBF); uc >>= 6;
+                    case 2: *--ptr2 =((uc | 0x80) & 0xBF); uc >>= 6;
+                    case 1: *--ptr2 = (char)(uc | firstByteMark[len]);
+                }
+                ptr2+=len;
+                break;
+            }
+
+            case 0:
+                return NULL;    // Backslash at the end of the text.
+
+            default:
+                *ptr2++ = *ptr;
+                break;
+        }
+        ptr++;
+    }
+
+    if (*ptr != '\"')
+        return NULL;
+
+    *ptr2 = 0;
+    length = (int)( ptr2 - ( str + 1 ) );
+    return ptr + 1;
+}
+
+// Utility to jump whitespace and cr/lf
+static char * skip( char * in )
+{
+    while (*in && (unsigned char)*in<=' ')
+        in++;
+    return in;
+}
+
+JsonPullParser::JsonPullParser( char * buffer ) :
+	Pos( buffer ),
+	Depth( 0 ),
+	NeedComma( false ),
+	Done( false ),
+	Error( NULL ),
+	Name( NULL ),
+	Type( JSON_None ),
+	Value( NULL ),
+	ValueLength( 0 ),
+	dValue( 0.0 )
+{
+	OVR_ASSERT( buffer != NULL );
+}
+
+JsonPullEvent JsonPullParser::fail( const char * error )
+{
+	Error = error;
+	return JSON_PULL_Error;
+}
+
+JsonPullEvent JsonPullParser::endValue( const JsonPullEvent event )
+{
+	NeedComma = true;
+	Done = ( Depth == 0 );
+	return event;
+}
+
+JsonPullEvent JsonPullParser::Next()
+{
+	if ( Error != NULL )
+	{
+		return JSON_PULL_Error;
+	}
+	if ( Done )
+	{
+		Name = NULL;
+		Type = JSON_None;
+		return JSON_PULL_End;
+	}
+
+	Name = NULL;
+	Pos = skip( Pos );
+
+	if ( Depth > 0 )
+	{
+		const bool inObject = ( Containers[Depth - 1] == JSON_Object );
+		if ( *Pos == ( inObject ? '}' : ']' ) )
+		{
+			Pos++;
+			Depth--;
+			Type = inObject ? JSON_Object : JSON_Array;
+			return endValue( inObject ? JSON_PULL_EndObject : JSON_PULL_EndArray );
+		}
+		if ( NeedComma )
+		{
+			if ( *Pos != ',' )
+			{
+				return fail( inObject ? "Syntax Error: Missing closing brace" : "Syntax Error: Missing ending bracket" );
+			}
+			Pos = skip( Pos + 1 );
+		}
+		if ( inObject )
+		{
+			if ( *Pos != '\"' )
+			{
+				return fail( "Syntax Error: Missing quote" );
+			}
+			int nameLength = 0;
+			char * name = Pos + 1;
+			Pos = ParseStringInSitu( Pos, nameLength );
+			if ( Pos == NULL )
+			{
+				return fail( "Syntax Error: Missing closing quote" );
+			}
+			Pos = skip( Pos );
+			if ( *Pos != ':' )
+			{
+				return fail( "Syntax Error: Missing colon" );
+			}
+			Pos = skip( Pos + 1 );
+			Name = name;
+		}
+	}
+
+	switch ( *Pos )
+	{
+		case '{':
+		case '[':
+		{
+			if ( Depth >= MaxDepth )
+			{
+				return fail( "Syntax Error: Nested too deeply" );
+			}
+			const bool object = ( *Pos == '{' );
+			Pos++;
+			Type = object ? JSON_Object : JSON_Array;
+			Containers[Depth++] = (UByte)Type;
+			NeedComma = false;
+			return object ? JSON_PULL_BeginObject : JSON_PULL_BeginArray;
+		}
+		case '\"':
+		{
+			Value = Pos + 1;
+			Pos = ParseStringInSitu( Pos, ValueLength );
+			if ( Pos == NULL )
+			{
+				return fail( "Syntax Error: Missing closing quote" );
+			}
+			Type = JSON_String;
+			return endValue( JSON_PULL_Value );
+		}
+		case 'n':
+		{
+			if ( strncmp( Pos, "null", 4 ) == 0 )
+			{
+				Pos += 4;
+				Type = JSON_Null;
+				return endValue( JSON_PULL_Value );
+			}
+			break;
+		}
+		case 't':
+		case 'f':
+		{
+			if ( strncmp( Pos, "true", 4 ) == 0 )
+			{
+				Pos += 4;
+				Type = JSON_Bool;
+				dValue = 1.0;
+				return endValue( JSON_PULL_Value );
+			}
+			if ( strncmp( Pos, "false", 5 ) == 0 )
+			{
+				Pos += 5;
+				Type = JSON_Bool;
+				dValue = 0.0;
+				return endValue( JSON_PULL_Value );
+			}
+			break;
+		}
+		default:
+		{
+			if ( *Pos == '-' || ( *Pos >= '0' && *Pos <= '9' ) )
+			{
+				Pos = (char *)ParseNumberText( Pos, dValue );
+				Type = JSON_Number;
+				return endValue( JSON_PULL_Value );
+			}
+			break;
+		}
+	}
+	return fail( "Syntax Error: Invalid syntax" );
+}
+
+JsonPullEvent JsonPullParser::SkipContainer()
+{
+	OVR_ASSERT( Depth > 0 );
+	const int depth = Depth;
+	for ( ; ; )
+	{
+		const JsonPullEvent event = Next();
+		if ( event == JSON_PULL_Error )
+		{
+			return event;
+		}
+		if ( ( event == JSON_PULL_EndObject || event == JSON_PULL_EndArray ) && Depth < depth )
+		{
+			return event;
+		}
+	}
+}
+
+//-----------------------------------------------------------------------------
+// ***** JsonNode
+
+bool JsonNode::GetBoolValue() const
+{
+	OVR_ASSERT( Type == JSON_Bool || Type == JSON_Number );
+	OVR_ASSERT( dValue == 0.0 || dValue == 1.0 ); // if this hits, value is out of range
+	return ( dValue != 0.0 );
+}
+
+SInt32 JsonNode::GetInt32Value() const
+{
+	OVR_ASSERT( Type == JSON_Number );
+	OVR_ASSERT( dValue >= INT_MIN && dValue <= INT_MAX ); // if this hits, value is out of range
+	return (SInt32)dValue;
+}
+
+SInt64 JsonNode::GetInt64Value() const
+{
+	OVR_ASSERT( Type == JSON_Number );
+	OVR_ASSERT( dValue >= -9007199254740992LL && dValue <= 9007199254740992LL ); // 2^53 - if this hits, value is out of range
+	return (SInt64)dValue;
+}
+
+float JsonNode::GetFloatValue() const
+{
+	OVR_ASSERT( Type == JSON_Number );
+	OVR_ASSERT( dValue >= -FLT_MAX && dValue <= FLT_MAX );  // too large to represent as a float
+	OVR_ASSERT( dValue == 0 || dValue <= -Mathf::MinPositiveValue || dValue >= Mathf::MinPositiveValue );  // if the number is too small to be represented as a float
+	return (float)dValue;
+}
+
+double JsonNode::GetDoubleValue() const
+{
+	OVR_ASSERT( Type == JSON_Number );
+	return dValue;
+}
+
+const char * JsonNode::GetStringValue() const
+{
+	OVR_ASSERT( Type == JSON_String );
+	return ( Type == JSON_String ) ? Value : "";
+}
+
+const JsonNode * JsonNode::GetItemByName( const char * name ) const
+{
+	for ( const JsonNode * child = FirstChild; child != NULL; child = child->NextSibling )
+	{
+		if ( child->Name != NULL && OVR_strcmp( child->Name, name ) == 0 )
+		{
+			return child;
+		}
+	}
+	return NULL;
+}
+
+//-----------------------------------------------------------------------------
+// ***** JsonDocument
+
+JsonDocument::JsonDocument() :
+	Blocks( NULL ),
+	ArenaBytes( 0 ),
+	Root( NULL )
+{
+}
+
+JsonDocument::~JsonDocument()
+{
+	Clear();
+}
+
+void JsonDocument::Clear()
+{
+	while ( Blocks != NULL )
+	{
+		Block * next = Blocks->Next;
+		OVR_FREE( Blocks );
+		Blocks = next;
+	}
+	ArenaBytes = 0;
+	Root = NULL;
+}
+
+void * JsonDocument::alloc( const UPInt bytes )
+{
+	// Everything in the arena is either a node or text, so aligning for a double is enough.
+	const UPInt alignedBytes = ( bytes + 7 ) & ~(UPInt)7;
+	const UPInt headerBytes = ( sizeof( Block ) + 7 ) & ~(UPInt)7;
+
+	if ( Blocks == NULL || Blocks->Used + alignedBytes > Blocks->Size )
+	{
+		// Grow the blocks with the document, so large documents only take a few blocks.
+		const UPInt minBlockSize = 64 * 1024;
+		const UPInt maxBlockSize = 1024 * 1024;
+		const UPInt blockSize = Alg::Max( alignedBytes, Alg::Clamp( ArenaBytes, minBlockSize, maxBlockSize ) );
+		Block * block = (Block *)OVR_ALLOC( headerBytes + blockSize );
+		if ( block == NULL )
+		{
+			return NULL;
+		}
+		block->Size = blockSize;
+		block->Used = 0;
+
+		// Keep filling the current block if the new one is only for this allocation.
+		if ( Blocks != NULL && blockSize == alignedBytes )
+		{
+			block->Next = Blocks->Next;
+			Blocks->Next = block;
+		}
+		else
+		{
+			block->Next = Blocks;
+			Blocks = block;
+		}
+		ArenaBytes += headerBytes + blockSize;
+
+		if ( Blocks != block )
+		{
+			block->Used = alignedBytes;
+			return (UByte *)block + headerBytes;
+		}
+	}
+
+	void * p = (UByte *)Blocks + headerBytes + Blocks->Used;
+	Blocks->Used += alignedBytes;
+	return p;
+}
+
+bool JsonDocument::Parse( const char * text, const char ** perror )
+{
+	Clear();
+
+	const UPInt length = OVR_strlen( text );
+	char * buffer = (char *)alloc( length + 1 );
+	if ( buffer == NULL )
+	{
+		AssignError( perror, "Error: Failed to allocate memory" );
+		return false;
+	}
+	memcpy( buffer, text, length + 1 );
+
+	// Not ParseInSitu(), which would clear the arena with the copy in it.
+	return parseInArena( buffer, perror );
+}
+
+bool JsonDocument::ParseInSitu( char * buffer, const char ** perror )
+{
+	Clear();
+	return parseInArena( buffer, perror );
+}
+
+bool JsonDocument::parseInArena( char * buffer, const char ** perror )
+{
+	if ( perror != NULL )
+	{
+		*perror = NULL;
+	}
+
+	JsonNode * parents[JsonPullParser::MaxDepth];
+	JsonNode * lastChildren[JsonPullParser::MaxDepth];
+	int depth = 0;
+	JsonNode * root = NULL;
+
+	JsonPullParser parser( buffer );
+	for ( ; ; )
+	{
+		const JsonPullEvent event = parser.Next();
+		if ( event == JSON_PULL_Error )
+		{
+			AssignError( perror, parser.GetError() );
+			Clear();
+			return false;
+		}
+		if ( event == JSON_PULL_End )
+		{
+			break;
+		}
+		if ( event == JSON_PULL_EndObject || event == JSON_PULL_EndArray )
+		{
+			depth--;
+			continue;
+		}
+
+		JsonNode * node = (JsonNode *)alloc( sizeof( JsonNode ) );
+		if ( node == NULL )
+		{
+			AssignError( perror, "Error: Failed to allocate memory" );
+			Clear();
+			return false;
+		}
+		node->Type = parser.GetType();
+		node->ChildCount = 0;
+		node->Name = parser.GetName();
+		node->dValue = 0.0;
+		node->FirstChild = NULL;
+		node->NextSibling = NULL;
+		if ( node->Type == JSON_String )
+		{
+			node->Value = parser.GetString();
+		}
+		else if ( node->Type == JSON_Number || node->Type == JSON_Bool )
+		{
+			node->dValue = parser.GetNumber();
+		}
+
+		if ( depth == 0 )
+		{
+			root = node;
+		}
+		else
+		{
+			JsonNode * parent = parents[depth - 1];
+			if ( parent->FirstChild == NULL )
+			{
+				parent->FirstChild = node;
+			}
+			else
+			{
+				lastChildren[depth - 1]->NextSibling = node;
+			}
+			lastChildren[depth - 1] = node;
+			parent->ChildCount++;
+		}
+
+		if ( event == JSON_PULL_BeginObject || event == JSON_PULL_BeginArray )
+		{
+			parents[depth++] = node;
+		}
+	}
+
+	Root = root;
+	return true;
+}
+
+bool JsonDocument::Load( const char * path, const char ** perror )
+{
+	Clear();
+
+	SysFile f;
+	if ( !f.Open( path, File::Open_Read, File::Mode_Read ) )
+	{
+		AssignError( perror, "Failed to open file" );
+		return false;
+	}
+
+	const int length = f.GetLength();
+	char * buffer = (char *)alloc( length + 1 );
+	const int bytes = ( buffer != NULL ) ? f.Read( (UByte *)buffer, length ) : 0;
+	f.Close();
+
+	if ( bytes == 0 || bytes != length )
+	{
+		AssignError( perror, "Failed to read file" );
+		Clear();
+		return false;
+	}
+
+	buffer[length] = '\0';
+	return parseInArena( buffer, perror );
+}
+
+//-----------------------------------------------------------------------------
+// ***** JsonNodeReader
+
+const JsonNode * JsonNodeReader::GetChildByName( const char * childName ) const
+{
+	assert( IsObject() );
+
+	// Check if the the cached child pointer is valid.
+	if ( Child != NULL )
+	{
+		if ( OVR_strcmp( Child->Name, childName ) == 0 )
+		{
+			const JsonNode * c = Child;
+			Child = c->NextSibling;	// Cache the next child.
+			return c;
+		}
+	}
+	// Itereate over all children.
+	for ( const JsonNode * c = Parent->FirstChild; c != NULL; c = c->NextSibling )
+	{
+		if ( OVR_strcmp( c->Name, childName ) == 0 )
+		{
+			Child = c->NextSibling;	// Cache the next child.
+			return c;
+		}
+	}
+	return 0;
+}
+
+bool JsonNodeReader::GetChildBoolByName( const char * childName, const bool defaultValue ) const
+{
+	const JsonNode * c = GetChildByName( childName );
+	return ( c != NULL ) ? c->GetBoolValue() : defaultValue;
+}
+
+SInt32 JsonNodeReader::GetChildInt32ByName( const char * childName, const SInt32 defaultValue ) const
+{
+	const JsonNode * c = GetChildByName( childName );
+	return ( c != NULL ) ? c->GetInt32Value() : defaultValue;
+}
+
+SInt64 JsonNodeReader::GetChildInt64ByName( const char * childName, const SInt64 defaultValue ) const
+{
+	const JsonNode * c = GetChildByName( childName );
+	return ( c != NULL ) ? c->GetInt64Value() : defaultValue;
+}
+
+float JsonNodeReader::GetChildFloatByName( const char * childName, const float defaultValue ) const
+{
+	const JsonNode * c = GetChildByName( childName );
+	return ( c != NULL ) ? c->GetFloatValue() : defaultValue;
+}
+
+double JsonNodeReader::GetChildDoubleByName( const char * childName, const double defaultValue ) const
+{
+	const JsonNode * c = GetChildByName( childName );
+	return ( c != NULL ) ? c->GetDoubleValue() : defaultValue;
+}
+
+const char * JsonNodeReader::GetChildStringByName( const char * childName, const char * defaultValue ) const
+{
+	const JsonNode * c = GetChildByName( childName );
+	return ( c != NULL ) ? c->GetStringValue() : defaultValue;
+}
+
+const JsonNode * JsonNodeReader::GetNextArrayElement() const
+{
+	assert( IsArray() );
+
+	const JsonNode * c = Child;
+	if ( c != NULL )
+	{
+		Child = c->NextSibling;	// Cache the next child.
+	}
+	return c;
+}
+
+bool JsonNodeReader::GetNextArrayBool( const bool defaultValue ) const
+{
+	const JsonNode * c = GetNextArrayElement();
+	return ( c != NULL ) ? c->GetBoolValue() : defaultValue;
+}
+
+SInt32 JsonNodeReader::GetNextArrayInt32( const SInt32 defaultValue ) const
+{
+	const JsonNode * c = GetNextArrayElement();
+	return ( c != NULL ) ? c->GetInt32Value() : defaultValue;
+}
+
+SInt64 JsonNodeReader::GetNextArrayInt64( const SInt64 defaultValue ) const
+{
+	const JsonNode * c = GetNextArrayElement();
+	return ( c != NULL ) ? c->GetInt64Value() : defaultValue;
+}
+
+float JsonNodeReader::GetNextArrayFloat( const float defaultValue ) const
+{
+	const JsonNode * c = GetNextArrayElement();
+	return ( c != NULL ) ? c->GetFloatValue() : defaultValue;
+}
+
+double JsonNodeReader::GetNextArrayDouble( const double defaultValue ) const
+{
+	const JsonNode * c = GetNextArrayElement();
+	return ( c != NULL ) ? c->GetDoubleValue() : defaultValue;
+}
+
+const char * JsonNodeReader::GetNextArrayString( const char * defaultValue ) const
+{
+	const JsonNode * c = GetNextArrayElement();
+	return ( c != NULL ) ? c->GetStringValue() : defaultValue;
+}
+
+
+//-----------------------------------------------------------------------------
+// ***** JsonParseBenchmark
+
+// Heap memory in use.
+// glibc deprecated mallinfo() in 2.33, because its int fields wrap past 2 GB,
+// and it does not count mmapped chunks in uordblks. Bionic only has mallinfo().
+static SPInt HeapBytesInUse()
+{
+#if defined( __GLIBC__ ) && __GLIBC_PREREQ( 2, 33 )
+	const struct mallinfo2 info = mallinfo2();
+	return (SPInt)( info.uordblks + info.hblkhd );
+#elif defined( __GLIBC__ )
+	const struct mallinfo info = mallinfo();
+	return (SPInt)info.uordblks + (SPInt)info.hblkhd;
+#else
+	const struct mallinfo info = mallinfo();
+	return (SPInt)info.uordblks;
+#endif
+}
+
+// Generates a document with the layout of a models.json that was converted
+// without a models.bin, so all the geometry is inline.
+static void GenerateModelsJson( StringBuffer & text )
+{
+	const int numTextures = 32;
+	const int numSurfaces = 150;
+	const int numSurfaceVertices = 400;
+	const int numPolytopes = 64;
+	const int numTraceNodes = 40000;
+	const int numTraceLeafs = 20000;
+
+	text.Reserve( 8 * 1024 * 1024 );
+	text.AppendString( "{\n\t\"render_model\":\t{\n\t\t\"textures\":\t[" );
+	for ( int i = 0; i < numTextures; i++ )
+	{
+		text.AppendFormat( "%s{\n\t\t\t\"name\":\t\"texture_%d.ktx\",\n\t\t\t\"usage\":\t\"%s\",\n\t\t\t\"occlusion\":\t\"opaque\"\n\t\t}",
+				i > 0 ? ", " : "", i, ( i & 3 ) ? "diffuse" : "emissive" );
+	}
+	text.AppendString( "],\n\t\t\"joints\":\t[],\n\t\t\"tags\":\t[],\n\t\t\"surfaces\":\t[" );
+	for ( int i = 0; i < numSurfaces; i++ )
+	{
+		text.AppendFormat( "%s{\n\t\t\t\"source\":\t[\"mesh_%d\", \"mesh_%d_lod\"],\n", i > 0 ? ", " : "", i, i );
+		text.AppendFormat( "\t\t\t\"material\":\t{\n\t\t\t\t\"type\":\t\"opaque\",\n\t\t\t\t\"diffuse\":\t%d,\n\t\t\t\t\"emissive\":\t%d\n\t\t\t},\n", i % numTextures, ( i + 1 ) % numTextures );
+		text.AppendFormat( "\t\t\t\"bounds\":\t\"( %f %f %f ) ( %f %f %f )\",\n", -1.0f * i, -2.0f, -3.0f, 1.0f * i, 2.0f, 3.0f );
+		text.AppendFormat( "\t\t\t\"vertices\":\t{\n\t\t\t\t\"vertexCount\":\t%d,\n\t\t\t\t\"position\":\t\"", numSurfaceVertices );
+		for ( int j = 0; j < numSurfaceVertices; j++ )
+		{
+			text.AppendFormat( "( %f %f %f ) ", sinf( (float)( i * j ) ), cosf( (float)j ), 0.01f * j );
+		}
+		text.AppendString( "\",\n\t\t\t\t\"uv0\":\t\"" );
+		for ( int j = 0; j < numSurfaceVertices; j++ )
+		{
+			text.AppendFormat( "( %f %f ) ", ( j % 17 ) / 17.0f, ( j % 23 ) / 23.0f );
+		}
+		text.AppendFormat( "\"\n\t\t\t},\n\t\t\t\"triangles\":\t{\n\t\t\t\t\"indexCount\":\t%d,\n\t\t\t\t\"indices\":\t\"", numSurfaceVertices * 3 );
+		for ( int j = 0; j < numSurfaceVertices * 3; j++ )
+		{
+			text.AppendFormat( "%d ", ( j * 7 ) % numSurfaceVertices );
+		}
+		text.AppendString( "\"\n\t\t\t}\n\t\t}" );
+	}
+	text.AppendString( "]\n\t},\n\t\"collision_model\":\t[" );
+	for ( int i = 0; i < numPolytopes; i++ )
+	{
+		text.AppendFormat( "%s{\n\t\t\"name\":\t\"polytope_%d\",\n\t\t\"planes\":\t\"( %f %f %f %f ) ( %f %f %f %f )\"\n\t}",
+				i > 0 ? ", " : "", i, 1.0f, 0.0f, 0.0f, -0.5f * i, 0.0f, 1.0f, 0.0f, 0.25f * i );
+	}
+	text.AppendFormat( "],\n\t\"raytrace_model\":\t{\n\t\t\"numNodes\":\t%d,\n\t\t\"numLeafs\":\t%d,\n\t\t\"bounds\":\t\"( -1 -1 -1 ) ( 1 1 1 )\",\n\t\t\"nodes\":\t[", numTraceNodes, numTraceLeafs );
+	for ( int i = 0; i < numTraceNodes; i++ )
+	{
+		text.AppendFormat( "%s{\n\t\t\t\"data\":\t%d,\n\t\t\t\"dist\":\t%f\n\t\t}", i > 0 ? ", " : "", i * 8 + ( i % 3 ), sinf( (float)i ) * 10.0f );
+	}
+	text.AppendString( "],\n\t\t\"leafs\":\t[" );
+	for ( int i = 0; i < numTraceLeafs; i++ )
+	{
+		text.AppendFormat( "%s{\n\t\t\t\"triangles\":\t\"( %d %d %d -1 -1 -1 -1 -1 )\",\n\t\t\t\"ropes\":\t\"( %d %d 0 0 0 0 )\",\n\t\t\t\"bounds\":\t\"( %f %f %f ) ( %f %f %f )\"\n\t\t}",
+				i > 0 ? ", " : "", i, i + 1, i + 2, i * 2, i * 2 + 1, -0.1f * i, -1.0f, -1.0f, 0.1f * i, 1.0f, 1.0f );
+	}
+	text.AppendString( "]\n\t}\n}\n" );
+}
+
+// Returns the number of nodes that are not the same in both trees.
+static int CompareJsonTrees( JSON * json, const JsonNode * node )
+{
+	if ( node == NULL )
+	{
+		return 1;
+	}
+	int differences = 0;
+	if ( json->Type != node->Type || OVR_strcmp( json->Name, node->Name != NULL ? node->Name : "" ) != 0 )
+	{
+		differences++;
+	}
+	else if ( json->Type == JSON_String && OVR_strcmp( json->Value, node->Value ) != 0 )
+	{
+		differences++;
+	}
+	else if ( ( json->Type == JSON_Number || json->Type == JSON_Bool ) && json->dValue != node->dValue )
+	{
+		differences++;
+	}
+
+	const JsonNode * child = node->FirstChild;
+	for ( JSON * c = json->GetFirstItem(); c != NULL; c = json->GetNextItem( c ) )
+	{
+		differences += CompareJsonTrees( c, child );
+		child = ( child != NULL ) ? child->NextSibling : NULL;
+	}
+	return differences + ( child != NULL ? 1 : 0 );
+}
+
+bool JsonParseBenchmark( const char * path )
+{
+	StringBuffer text;
+	if ( path != NULL && path[0] != '\0' )
+	{
+		SysFile f;
+		if ( !f.Open( path, File::Open_Read, File::Mode_Read ) )
+		{
+			LogText( "JsonParseBenchmark: failed to open %s\n", path );
+			return false;
+		}
+		const int length = f.GetLength();
+		char * buffer = (char *)OVR_ALLOC( length + 1 );
+		const int bytes = f.Read( (UByte *)buffer, length );
+		f.Close();
+		buffer[Alg::Max( bytes, 0 )] = '\0';
+		text.AppendString( buffer );
+		OVR_FREE( buffer );
+	}
+	else
+	{
+		GenerateModelsJson( text );
+		path = "generated models.json";
+	}
+	const int length = (int)text.GetSize();
+
+	// The in situ parses need a fresh copy every time, because they modify the buffer.
+	char * copy = (char *)OVR_ALLOC( length + 1 );
+
+	const int iterations = 5;
+	double jsonSeconds = 1e10;
+	double documentSeconds = 1e10;
+	double inSituSeconds = 1e10;
+	double pullSeconds = 1e10;
+	SPInt jsonHeapBytes = 0;
+	SPInt documentHeapBytes = 0;
+	SPInt inSituHeapBytes = 0;
+	UPInt arenaBytes = 0;
+	int pullEvents = 0;
+	int differences = 0;
+
+	// Each variant runs back to back, so it does not pay for the allocator
+	// cleaning up after another variant.
+	for ( int i = 0; i < iterations; i++ )
+	{
+		const SPInt heapStart = HeapBytesInUse();
+		const double start = Timer::GetSeconds();
+		const char * error = NULL;
+		JSON * json = JSON::Parse( text.ToCStr(), &error );
+		jsonSeconds = Alg::Min( jsonSeconds, Timer::GetSeconds() - start );
+		jsonHeapBytes = HeapBytesInUse() - heapStart;
+		if ( json == NULL )
+		{
+			LogText( "JsonParseBenchmark: %s: %s\n", path, error );
+			OVR_FREE( copy );
+			return false;
+		}
+		if ( i == 0 )
+		{
+			JsonDocument document;
+			differences = document.Parse( text.ToCStr() ) ? CompareJsonTrees( json, document.GetRoot() ) : -1;
+		}
+		json->Release();
+	}
+
+	// JsonDocument::Parse copies the text into the arena.
+	for ( int i = 0; i < iterations; i++ )
+	{
+		const SPInt heapStart = HeapBytesInUse();
+		const double start = Timer::GetSeconds();
+		JsonDocument document;
+		document.Parse( text.ToCStr() );
+		documentSeconds = Alg::Min( documentSeconds, Timer::GetSeconds() - start );
+		documentHeapBytes = HeapBytesInUse() - heapStart;
+		arenaBytes = document.GetArenaBytes();
+	}
+
+	// JsonDocument::ParseInSitu only allocates the nodes.
+	for ( int i = 0; i < iterations; i++ )
+	{
+		memcpy( copy, text.ToCStr(), length + 1 );
+		const SPInt heapStart = HeapBytesInUse();
+		const double start = Timer::GetSeconds();
+		JsonDocument document;
+		document.ParseInSitu( copy );
+		inSituSeconds = Alg::Min( inSituSeconds, Timer::GetSeconds() - start );
+		inSituHeapBytes = HeapBytesInUse() - heapStart;
+	}
+
+	// JsonPullParser does not build a tree at all.
+	for ( int i = 0; i < iterations; i++ )
+	{
+		memcpy( copy, text.ToCStr(), length + 1 );
+		const double start = Timer::GetSeconds();
+		JsonPullParser parser( copy );
+		int events = 0;
+		while ( parser.Next() > JSON_PULL_End )
+		{
+			events++;
+		}
+		pullSeconds = Alg::Min( pullSeconds, Timer::GetSeconds() - start );
+		pullEvents = events;
+	}
+	OVR_FREE( copy );
+
+	const double megaBytes = length / ( 1024.0 * 1024.0 );
+	LogText( "JsonParseBenchmark: %s: %.2f MB, %d events, fastest of %d parses\n", path, megaBytes, pullEvents, iterations );
+	LogText( "JsonParseBenchmark: JSON::Parse               %7.2f ms %7.1f MB/s, heap %8.2f MB\n",
+			jsonSeconds * 1e3, megaBytes / jsonSeconds, jsonHeapBytes / ( 1024.0 * 1024.0 ) );
+	LogText( "JsonParseBenchmark: JsonDocument::Parse       %7.2f ms %7.1f MB/s, heap %8.2f MB (arena %.2f MB, text included)\n",
+			documentSeconds * 1e3, megaBytes / documentSeconds, documentHeapBytes / ( 1024.0 * 1024.0 ), arenaBytes / ( 1024.0 * 1024.0 ) );
+	LogText( "JsonParseBenchmark: JsonDocument::ParseInSitu %7.2f ms %7.1f MB/s, heap %8.2f MB\n",
+			inSituSeconds * 1e3, megaBytes / inSituSeconds, inSituHeapBytes / ( 1024.0 * 1024.0 ) );
+	LogText( "JsonParseBenchmark: JsonPullParser            %7.2f ms %7.1f MB/s, no heap\n",
+			pullSeconds * 1e3, megaBytes / pullSeconds );
+	LogText( "JsonParseBenchmark: %s\n", differences == 0 ? "trees are the same" : "TREES ARE DIFFERENT" );
+	if ( differences != 0 )
+	{
+		LogText( "JsonParseBenchmark: %d differences\n", differences );
+	}
+	return ( differences == 0 );
+}
+
 }
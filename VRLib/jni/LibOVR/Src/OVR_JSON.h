@@ -227,6 +227,209 @@ private:
 	mutable const JSON *	Child;		// cached child pointer
 };
 
+//-----------------------------------------------------------------------------
+// ***** JsonPullParser
+
+// Streaming JSON parser that returns one event at a time instead of building
+// a tree, and does not allocate any memory.
+//
+// The text is parsed in place: strings are unescaped and zero terminated inside
+// the buffer, so the buffer has to be writable and zero terminated, and has to
+// stay around for as long as the strings returned by GetName() and GetString()
+// are used.
+//
+//	JsonPullParser parser( buffer );
+//	for ( JsonPullEvent event = parser.Next(); event > JSON_PULL_End; event = parser.Next() )
+//	{
+//		if ( event == JSON_PULL_Value && parser.GetDepth() == 1 && OVR_strcmp( parser.GetName(), "version" ) == 0 )
+//		{
+//			version = (int)parser.GetNumber();
+//		}
+//	}
+//	if ( parser.GetError() != NULL ) ...
+
+enum JsonPullEvent
+{
+	JSON_PULL_Error,
+	JSON_PULL_End,				// the root value has been read completely
+	JSON_PULL_BeginObject,
+	JSON_PULL_EndObject,
+	JSON_PULL_BeginArray,
+	JSON_PULL_EndArray,
+	JSON_PULL_Value				// null, bool, number or string
+};
+
+class JsonPullParser
+{
+public:
+	static const int	MaxDepth = 256;
+
+	explicit			JsonPullParser( char * buffer );
+
+	JsonPullEvent		Next();
+
+	// Skips the rest of the object or array that was just begun, up to and
+	// including its end. Returns the end event, or JSON_PULL_Error.
+	JsonPullEvent		SkipContainer();
+
+	// The name of the object member the value or begin event belongs to,
+	// NULL for array elements, the root and end events.
+	const char *		GetName() const { return Name; }
+	// The type of the value, JSON_Object or JSON_Array for begin and end events.
+	JSONItemType		GetType() const { return Type; }
+	const char *		GetString() const { OVR_ASSERT( Type == JSON_String ); return Value; }
+	int					GetStringLength() const { OVR_ASSERT( Type == JSON_String ); return ValueLength; }
+	// Numbers, and 0 or 1 for bools.
+	double				GetNumber() const { OVR_ASSERT( Type == JSON_Number || Type == JSON_Bool ); return dValue; }
+	// Number of open objects and arrays, including one that was just begun.
+	int					GetDepth() const { return Depth; }
+	// NULL unless Next() returned JSON_PULL_Error.
+	const char *		GetError() const { return Error; }
+
+private:
+	char *				Pos;
+	int					Depth;
+	bool				NeedComma;		// a value was read in the current object or array
+	bool				Done;
+	const char *		Error;
+	const char *		Name;
+	JSONItemType		Type;
+	const char *		Value;
+	int					ValueLength;
+	double				dValue;
+	UByte				Containers[MaxDepth];	// JSON_Object or JSON_Array
+
+	JsonPullEvent		fail( const char * error );
+	JsonPullEvent		endValue( const JsonPullEvent event );
+};
+
+//-----------------------------------------------------------------------------
+// ***** JsonDocument
+
+// A JsonNode is a JSON value in a JsonDocument. The nodes and strings live in
+// the memory arena of the document, and are only valid as long as the document.
+struct JsonNode
+{
+	JSONItemType		Type;
+	int					ChildCount;
+	const char *		Name;			// name in the parent object, NULL in arrays
+	union
+	{
+		const char *	Value;			// JSON_String
+		double			dValue;			// JSON_Number, and 0 or 1 for JSON_Bool
+	};
+	const JsonNode *	FirstChild;
+	const JsonNode *	NextSibling;
+
+	// Value access with range checking where possible, like JSON.
+	bool				GetBoolValue() const;
+	SInt32				GetInt32Value() const;
+	SInt64				GetInt64Value() const;
+	float				GetFloatValue() const;
+	double				GetDoubleValue() const;
+	const char *		GetStringValue() const;
+
+	const JsonNode *	GetItemByName( const char * name ) const;
+};
+
+// Arena allocated JSON tree, built in a single pass with the JsonPullParser.
+// Compared to JSON::Parse, which allocates every node and copies every string
+// into a String, a document makes a handful of allocations no matter how large
+// the text is, and the strings are not copied at all after the text itself.
+//
+// Use JsonNodeReader to read the tree, which works the same way as JsonReader.
+class JsonDocument
+{
+public:
+						JsonDocument();
+						~JsonDocument();
+
+	// Copies the text into the arena and parses the copy in place.
+	// Returns false and fills in *perror in case of a parse error.
+	bool				Parse( const char * text, const char ** perror = 0 );
+
+	// Parses a writable, zero terminated buffer in place. The buffer is
+	// modified, and has to stay around for as long as the document.
+	bool				ParseInSitu( char * buffer, const char ** perror = 0 );
+
+	bool				Load( const char * path, const char ** perror = 0 );
+
+	// Frees the whole tree.
+	void				Clear();
+
+	// NULL if nothing was parsed, or the parse failed.
+	const JsonNode *	GetRoot() const { return Root; }
+
+	// Bytes allocated for the arena, including the copy of the text.
+	UPInt				GetArenaBytes() const { return ArenaBytes; }
+
+private:
+	struct Block
+	{
+		Block *			Next;
+		UPInt			Size;
+		UPInt			Used;
+	};
+
+	Block *				Blocks;
+	UPInt				ArenaBytes;
+	const JsonNode *	Root;
+
+	void *				alloc( const UPInt bytes );
+	bool				parseInArena( char * buffer, const char ** perror );
+
+	// not copyable
+						JsonDocument( const JsonDocument & );
+	JsonDocument &		operator = ( const JsonDocument & );
+};
+
+//-----------------------------------------------------------------------------
+// ***** JsonNodeReader
+
+// JsonReader for the nodes of a JsonDocument, with the same interface and the
+// same one string compare per child when the children are read in order.
+// Strings are returned straight from the document instead of as a copy.
+class JsonNodeReader
+{
+public:
+						JsonNodeReader( const JsonNode * node ) :
+							Parent( node ),
+							Child( node != NULL ? node->FirstChild : NULL ) {}
+
+	bool				IsValid() const { return Parent != NULL; }
+	bool				IsObject() const { return Parent != NULL && Parent->Type == JSON_Object; }
+	bool				IsArray() const { return Parent != NULL && Parent->Type == JSON_Array; }
+	bool				IsEndOfArray() const { OVR_ASSERT( Parent != NULL ); return Child == NULL; }
+
+	const JsonNode *	GetChildByName( const char * childName ) const;
+
+	bool				GetChildBoolByName( const char * childName, const bool defaultValue = false ) const;
+	SInt32				GetChildInt32ByName( const char * childName, const SInt32 defaultValue = 0 ) const;
+	SInt64				GetChildInt64ByName( const char * childName, const SInt64 defaultValue = 0 ) const;
+	float				GetChildFloatByName( const char * childName, const float defaultValue = 0.0f ) const;
+	double				GetChildDoubleByName( const char * childName, const double defaultValue = 0.0 ) const;
+	const char *		GetChildStringByName( const char * childName, const char * defaultValue = "" ) const;
+
+	const JsonNode *	GetNextArrayElement() const;
+
+	bool				GetNextArrayBool( const bool defaultValue = false ) const;
+	SInt32				GetNextArrayInt32( const SInt32 defaultValue = 0 ) const;
+	SInt64				GetNextArrayInt64( const SInt64 defaultValue = 0 ) const;
+	float				GetNextArrayFloat( const float defaultValue = 0.0f ) const;
+	double				GetNextArrayDouble( const double defaultValue = 0.0 ) const;
+	const char *		GetNextArrayString( const char * defaultValue = "" ) const;
+
+private:
+	const JsonNode *			Parent;
+	mutable const JsonNode *	Child;		// cached child pointer
+};
+
+// Parses the JSON file, or a generated document shaped like a large models.json
+// if path is NULL or empty, with JSON::Parse and with JsonDocument, and logs the
+// parse times and the heap memory used by the trees. Returns false if the file
+// could not be loaded or the trees are not the same.
+bool JsonParseBenchmark( const char * path );
+
 }
 
 #endif
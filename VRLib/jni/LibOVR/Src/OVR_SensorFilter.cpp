@@ -81,4 +81,45 @@ Vector3<T> SensorFilter<T>::PearsonCoefficient() const
     return pearson;
 }
 
+void SensorFilterKalman::Clear()
+{
+    Empty = true;
+    Value = Vector3f();
+    Rate = Vector3f();
+    P00 = P01 = P11 = 0.0f;
+}
+
+void SensorFilterKalman::Update(const Vector3f& measurement, float deltaT)
+{
+    if (Empty)
+    {
+        // Nothing is known about the rate yet.
+        Empty = false;
+        Value = measurement;
+        Rate = Vector3f();
+        P00 = MeasurementNoise;
+        P01 = 0.0f;
+        P11 = 1e6f;
+        return;
+    }
+
+    // Predict with constant rate.
+    const float dt = deltaT;
+    const float q = ProcessNoise;
+    Value += Rate * dt;
+    P00 += dt * (2.0f * P01 + dt * P11) + q * dt * dt * dt * (1.0f / 3.0f);
+    P01 += dt * P11 + q * dt * dt * 0.5f;
+    P11 += q * dt;
+
+    // Correct with the measurement.
+    const float k0 = P00 / (P00 + MeasurementNoise);
+    const float k1 = P01 / (P00 + MeasurementNoise);
+    const Vector3f innovation = measurement - Value;
+    Value += innovation * k0;
+    Rate += innovation * k1;
+    P11 -= k1 * P01;
+    P01 *= 1.0f - k0;
+    P00 *= 1.0f - k0;
+}
+
 } //namespace OVR
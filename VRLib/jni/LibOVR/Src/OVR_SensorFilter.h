@@ -287,6 +287,37 @@ public:
     }
 };
 
+// Kalman filter that tracks a vector and its rate of change from noisy measurements
+// of the vector alone, for instance the angular velocity and angular acceleration
+// from the gyro. The rate of change is assumed to vary as white noise.
+// All axes have the same noise, so they share the error covariance.
+class SensorFilterKalman
+{
+public:
+    // processNoise is the spectral density of the change in rate, and measurementNoise
+    // the variance of a single measurement.
+    SensorFilterKalman(float processNoise, float measurementNoise)
+        : ProcessNoise(processNoise), MeasurementNoise(measurementNoise) { Clear(); }
+
+    void Clear();
+
+    // add a new measurement, taken deltaT after the previous one
+    void Update(const Vector3f& measurement, float deltaT);
+
+    // filtered estimate at the time of the last measurement
+    Vector3f GetValue() const   { return Value; }
+    Vector3f GetRate() const    { return Rate; }
+
+private:
+    float    ProcessNoise;
+    float    MeasurementNoise;
+    bool     Empty;
+    Vector3f Value;
+    Vector3f Rate;
+    // error covariance of (value, rate)
+    float    P00, P01, P11;
+};
+
 } //namespace OVR
 
 #endif // OVR_SensorFilter_h
@@ -11,8 +11,11 @@ Copyright   :   Copyright 2014 Oculus VR, LLC. All Rights reserved.
 
 
 #include "OVR_SensorFusion.h"
+#include "OVR_SensorRecording.h"
 #include "Kernel/OVR_Log.h"
 #include "Kernel/OVR_System.h"
+#include "Kernel/OVR_Threads.h"
+#include "Kernel/OVR_Timer.h"
 #include "OVR_JSON.h"
 #include "OVR_Profile.h"
 
@@ -27,10 +30,18 @@ namespace OVR {
 //-------------------------------------------------------------------------------------
 // ***** Sensor Fusion
 
+// Tuning of the filtered predictor: the spectral density of the angular jerk of
+// a head in (rad/s^3)^2/Hz, and the variance of the gyro noise in (rad/s)^2.
+static const float AngularJerkNoise = 1e3f;
+static const float GyroNoise        = 1e-4f;
+
 SensorFusion::SensorFusion(SensorDevice* sensor) :
 	ApplyDrift(false),
+	pRecorder(NULL),
 	FAccelHeadset(1000),
 	FAngV(20),
+	FAngVKalman(AngularJerkNoise, GyroNoise),
+	Prediction(Prediction_ConstantVelocity),
 	SensorDataAvailable(false),
 	MotionTrackingEnabled(true),
 	EnableGravity(true),
@@ -52,6 +63,7 @@ SensorFusion::SensorFusion(SensorDevice* sensor) :
 
 SensorFusion::~SensorFusion()
 {
+	delete pRecorder;
 	delete pHandler;
 }
 
@@ -103,6 +115,7 @@ void SensorFusion::Reset()
     Lock::Locker lockScope(pHandler->GetHandlerLock());
 
     UpdatedState.SetState(StateForPrediction());
+    History.Clear();
     State = PoseStatef();
     Stage = 0;
 
@@ -115,6 +128,7 @@ void SensorFusion::Reset()
 	
     FAccelHeadset.Clear();
     FAngV.Clear();
+    FAngVKalman.Clear();
 }
 
 void SensorFusion::RecenterYaw()
@@ -152,6 +166,7 @@ void SensorFusion::handleMessage(const MessageBodyFrame& msg)
 
     // Insert current sensor data into filter history
     FAngV.PushBack(gyro);
+    FAngVKalman.Update(gyro, DeltaT);
     FAccelHeadset.Update(accel, DeltaT, Quatf(gyro, gyro.Length() * DeltaT));
 
     // Process raw inputs
@@ -196,7 +211,42 @@ void SensorFusion::handleMessage(const MessageBodyFrame& msg)
     StateForPrediction state;
     state.State = State;
     state.Temperature = msg.Temperature;
+    state.FilteredAngularVelocity = FAngVKalman.GetValue();
+    state.FilteredAngularAcceleration = FAngVKalman.GetRate();
     UpdatedState.SetState(state);
+    History.AddPose(State);
+
+    if (pRecorder != NULL)
+        pRecorder->AddRecord(msg, State.Transform.Orientation);
+}
+
+bool SensorFusion::StartRecording(const char* path)
+{
+    // The lock is recursive, and keeps messages out until the recording has started.
+    Lock::Locker lockScope(pHandler->GetHandlerLock());
+
+    Reset();
+    delete pRecorder;
+    pRecorder = new SensorRecorder;
+    if (!pRecorder->Start(path))
+    {
+        delete pRecorder;
+        pRecorder = NULL;
+        return false;
+    }
+    return true;
+}
+
+int SensorFusion::StopRecording()
+{
+    Lock::Locker lockScope(pHandler->GetHandlerLock());
+
+    if (pRecorder == NULL)
+        return 0;
+    const int numRecords = pRecorder->Stop();
+    delete pRecorder;
+    pRecorder = NULL;
+    return numRecords;
 }
 
 // These two functions need to be moved into Quat class
@@ -553,13 +603,29 @@ void SensorFusion::ClearFocus()
 	FocusFOV = 0.0f;
 }
 
+const char* GetPredictionModeName(PredictionMode mode)
+{
+    switch (mode)
+    {
+    case Prediction_ConstantVelocity:       return "velocity";
+    case Prediction_ConstantAcceleration:   return "acceleration";
+    case Prediction_Filtered:               return "filtered";
+    default:                                return "unknown";
+    }
+}
+
 // This is a "perceptually tuned predictive filter", which means that it is optimized
 // for improvements in the VR experience, rather than pure error.  In particular,
 // jitter is more perceptible at lower speeds whereas latency is more perceptable
 // after a high-speed motion.  Therefore, the prediction interval is dynamically
 // adjusted based on speed.  Significant more research is needed to further improve
 // this family of filters.
-Posef calcPredictedPose(const PoseStatef& poseState, float predictionDt )
+//
+// The higher order predictors integrate the angular velocity as it changes with
+// the angular acceleration over the interval. The acceleration is noisy, so the
+// change in velocity is limited to the current speed, which keeps the prediction
+// from ever turning back.
+Posef calcPredictedPose(const PoseStatef& poseState, float predictionDt, PredictionMode mode)
 {
     Posef pose              = poseState.Transform;
 	const float linearCoef  = 1.0;
@@ -578,6 +644,17 @@ Posef calcPredictedPose(const PoseStatef& poseState, float predictionDt )
 	if (candidateDt < predictionDt)
 		dynamicDt = candidateDt;
 
+    if (mode != Prediction_ConstantVelocity)
+    {
+        // The average velocity over the interval is exact for rotation around a fixed axis.
+        Vector3f velocityChange = poseState.AngularAcceleration * dynamicDt;
+        const float change      = velocityChange.Length();
+        if (change > angularSpeed)
+            velocityChange *= angularSpeed / change;
+        angularVelocity         += velocityChange * 0.5f;
+        angularSpeed            = angularVelocity.Length();
+    }
+
     if (angularSpeed > 0.001)
         pose.Orientation = pose.Orientation * Quatf(angularVelocity, angularSpeed * dynamicDt);
 
@@ -586,6 +663,160 @@ Posef calcPredictedPose(const PoseStatef& poseState, float predictionDt )
     return pose;
 }
 
+//-------------------------------------------------------------------------------------
+// ***** PoseHistory
+
+PoseHistory::PoseHistory() :
+    Count(0),
+    First(0)
+{
+    for (int i = 0; i < Size; i++)
+    {
+        Entries[i].Stamp = 0;
+    }
+}
+
+void PoseHistory::AddPose(const PoseStatef& pose)
+{
+    const UInt32 index = Count;
+    Entry& entry = Entries[index & (Size - 1)];
+
+    LocklessStoreRelaxed(&entry.Stamp, index * 2 + 1);
+    LocklessFenceRelease();
+    entry.Pose = pose;
+    LocklessStoreRelease(&entry.Stamp, index * 2 + 2);
+    LocklessStoreRelease(&Count, index + 1);
+}
+
+void PoseHistory::Clear()
+{
+    // The indices keep counting up, so the stamps of old entries never match again.
+    LocklessStoreRelease(&First, Count);
+}
+
+int PoseHistory::GetNumPoses() const
+{
+    const UInt32 count = LocklessLoadAcquire(&Count);
+    const UInt32 first = LocklessLoadAcquire(&First);
+    return (int)Alg::Min(count - first, (UInt32)(Size - Slack));
+}
+
+bool PoseHistory::readPose(UInt32 index, PoseStatef& pose) const
+{
+    const Entry& entry = Entries[index & (Size - 1)];
+    const UInt32 stamp = LocklessLoadAcquire(&entry.Stamp);
+    if (stamp != index * 2 + 2)
+    {
+        return false;
+    }
+    pose = entry.Pose;
+    LocklessFenceAcquire();
+    return LocklessLoadRelaxed(&entry.Stamp) == stamp;
+}
+
+bool PoseHistory::readTime(UInt32 index, double& time) const
+{
+    const Entry& entry = Entries[index & (Size - 1)];
+    const UInt32 stamp = LocklessLoadAcquire(&entry.Stamp);
+    if (stamp != index * 2 + 2)
+    {
+        return false;
+    }
+    time = entry.Pose.TimeInSeconds;
+    LocklessFenceAcquire();
+    return LocklessLoadRelaxed(&entry.Stamp) == stamp;
+}
+
+bool PoseHistory::GetPoseAtTime(const double absoluteTimeSeconds, PoseStatef& pose, const PredictionMode mode) const
+{
+    // Only retries when the producer overwrote an entry during the lookup, which
+    // would take it more than Slack samples, so this practically never loops.
+    for (int attempt = 0; attempt < 4; attempt++)
+    {
+        const UInt32 count = LocklessLoadAcquire(&Count);
+        const UInt32 first = LocklessLoadAcquire(&First);
+        if (count == first)
+        {
+            pose = PoseStatef();
+            return false;
+        }
+
+        const UInt32 newest = count - 1;
+        const UInt32 oldest = (count - first > (UInt32)(Size - Slack)) ? count - (Size - Slack) : first;
+
+        PoseStatef newestPose;
+        if (!readPose(newest, newestPose))
+        {
+            continue;
+        }
+        if (absoluteTimeSeconds >= newestPose.TimeInSeconds)
+        {
+            pose = newestPose;
+            pose.Transform = calcPredictedPose(newestPose, (float)(absoluteTimeSeconds - newestPose.TimeInSeconds), mode);
+            pose.TimeInSeconds = absoluteTimeSeconds;
+            return true;
+        }
+
+        double oldestTime;
+        if (!readTime(oldest, oldestTime))
+        {
+            continue;
+        }
+        if (absoluteTimeSeconds < oldestTime)
+        {
+            if (!readPose(oldest, pose))
+            {
+                continue;
+            }
+            return false;
+        }
+
+        // Find the samples with time(lo) <= absoluteTimeSeconds < time(hi).
+        UInt32 lo = oldest;
+        UInt32 hi = newest;
+        bool valid = true;
+        while (hi - lo > 1)
+        {
+            const UInt32 mid = lo + ((hi - lo) >> 1);
+            double midTime;
+            if (!readTime(mid, midTime))
+            {
+                valid = false;
+                break;
+            }
+            if (midTime <= absoluteTimeSeconds)
+            {
+                lo = mid;
+            }
+            else
+            {
+                hi = mid;
+            }
+        }
+
+        PoseStatef p0;
+        PoseStatef p1;
+        if (!valid || !readPose(lo, p0) || !readPose(hi, p1))
+        {
+            continue;
+        }
+
+        // The samples are about a millisecond apart, so a normalized lerp is
+        // as good as a slerp.
+        const double dt = p1.TimeInSeconds - p0.TimeInSeconds;
+        const float f = (dt > 0.0) ? (float)((absoluteTimeSeconds - p0.TimeInSeconds) / dt) : 1.0f;
+        pose.Transform.Orientation  = p1.Transform.Orientation.Nlerp(p0.Transform.Orientation, f);
+        pose.Transform.Position     = p0.Transform.Position.Lerp(p1.Transform.Position, f);
+        pose.AngularVelocity        = p0.AngularVelocity.Lerp(p1.AngularVelocity, f);
+        pose.LinearVelocity         = p0.LinearVelocity.Lerp(p1.LinearVelocity, f);
+        pose.AngularAcceleration    = p0.AngularAcceleration.Lerp(p1.AngularAcceleration, f);
+        pose.LinearAcceleration     = p0.LinearAcceleration.Lerp(p1.LinearAcceleration, f);
+        pose.TimeInSeconds          = absoluteTimeSeconds;
+        return true;
+    }
+    return false;
+}
+
 //  A predictive filter based on extrapolating the smoothed, current angular velocity
 SensorState SensorFusion::GetPredictionForTime( const double absoluteTimeSeconds ) const
 {		
@@ -604,11 +835,45 @@ SensorState SensorFusion::GetPredictionForTime( const double absoluteTimeSeconds
     // Do prediction logic
     sstate.Predicted               = sstate.Recorded;
     sstate.Predicted.TimeInSeconds = absoluteTimeSeconds;
-    sstate.Predicted.Transform     = RecenterTransform * calcPredictedPose(state.State, pdt);
+    const PredictionMode mode      = GetPredictionMode();
+    if (mode == Prediction_Filtered)
+    {
+        PoseStatef filtered          = state.State;
+        filtered.AngularVelocity     = state.FilteredAngularVelocity;
+        filtered.AngularAcceleration = state.FilteredAngularAcceleration;
+        sstate.Predicted.Transform   = RecenterTransform * calcPredictedPose(filtered, pdt, mode);
+    }
+    else
+    {
+        sstate.Predicted.Transform   = RecenterTransform * calcPredictedPose(state.State, pdt, mode);
+    }
+
+    // Look up past times instead of extrapolating backwards.
+    PoseStatef past;
+    if (pdt < 0.0f && History.GetPoseAtTime(absoluteTimeSeconds, past, mode))
+    {
+        sstate.Predicted               = past;
+        sstate.Predicted.Transform     = RecenterTransform * past.Transform;
+    }
 
     return sstate;
 }
 
+bool SensorFusion::GetPoseAtTime( const double absoluteTimeSeconds, PoseStatef& pose ) const
+{
+    // Later times are predicted by GetPredictionForTime(), because the filtered
+    // velocities that Prediction_Filtered uses are not kept in the history.
+    if (History.GetNumPoses() > 0 && absoluteTimeSeconds >= UpdatedState.GetState().State.TimeInSeconds)
+    {
+        pose = GetPredictionForTime(absoluteTimeSeconds).Predicted;
+        return true;
+    }
+
+    const bool found = History.GetPoseAtTime(absoluteTimeSeconds, pose, GetPredictionMode());
+    pose.Transform = RecenterTransform * pose.Transform;
+    return found;
+}
+
 SensorFusion::BodyFrameHandler::~BodyFrameHandler()
 {
     RemoveHandlerFromDevices();
@@ -635,4 +900,131 @@ bool SensorFusion::BodyFrameHandler::SupportsMessageType(MessageType type) const
     return (type == Message_BodyFrame);
 }
 
+
+//-------------------------------------------------------------------------------------
+// ***** PoseHistoryTest
+
+namespace PoseHistoryTesting {
+
+static const double SampleSeconds = 0.001;
+static const float  AngularSpeed = 3.0f;    // radians per second, a fast head turn
+
+static Vector3f GetAxis()
+{
+    return Vector3f(0.3f, 1.0f, 0.2f).Normalized();
+}
+
+static PoseStatef GetSample(UInt32 index)
+{
+    const double time = index * SampleSeconds;
+    PoseStatef pose;
+    pose.Transform.Orientation = Quatf(GetAxis(), (float)fmod(AngularSpeed * time, 2.0 * Math<double>::Pi));
+    pose.AngularVelocity = GetAxis() * AngularSpeed;
+    pose.TimeInSeconds = time;
+    return pose;
+}
+
+struct Shared
+{
+    PoseHistory *       History;
+    volatile UInt32     Newest;
+    volatile UInt32     Stop;
+    bool                Paced;
+};
+
+static int ProducerThread(Thread *, void * h)
+{
+    Shared * share = (Shared *)h;
+    for (UInt32 index = share->Newest + 1; !LocklessLoadAcquire(&share->Stop); index++)
+    {
+        share->History->AddPose(GetSample(index));
+        LocklessStoreRelease(&share->Newest, index);
+        if (share->Paced)
+        {
+            Thread::MSleep(1);
+        }
+    }
+    return 0;
+}
+
+static int Run(const char * label, const bool paced, const int milliseconds)
+{
+    PoseHistory * history = new PoseHistory;
+    Shared share;
+    share.History = history;
+    share.Newest = 0;
+    share.Stop = 0;
+    share.Paced = paced;
+
+    // Make sure there is a full second of history before looking anything up.
+    UInt32 index = 0;
+    for ( ; index < 1000; index++)
+    {
+        history->AddPose(GetSample(index));
+    }
+    share.Newest = index - 1;
+
+    Ptr<Thread> producer = *new Thread(ProducerThread, &share);
+    producer->Start();
+
+    UInt32 lookups = 0;
+    UInt32 misses = 0;
+    UInt32 errors = 0;
+    float maxError = 0.0f;
+    double lookupSeconds = 0.0;
+    UInt32 random = 12345;
+
+    const double end = Timer::GetSeconds() + milliseconds * 0.001;
+    while (Timer::GetSeconds() < end)
+    {
+        // Somewhere in the last 900 milliseconds, or up to 20 milliseconds ahead.
+        random = random * 1664525 + 1013904223;
+        const double offset = ((random >> 8) % 920000) * 1e-6 - 0.020;
+        const double time = LocklessLoadAcquire(&share.Newest) * SampleSeconds - offset;
+
+        PoseStatef pose;
+        const double start = Timer::GetSeconds();
+        const bool found = history->GetPoseAtTime(time, pose, Prediction_ConstantVelocity);
+        lookupSeconds += Timer::GetSeconds() - start;
+        lookups++;
+
+        if (!found)
+        {
+            // The producer can outrun the lookup when it adds poses flat out.
+            misses++;
+            continue;
+        }
+        const Quatf expected(GetAxis(), (float)fmod(AngularSpeed * time, 2.0 * Math<double>::Pi));
+        // The imaginary part of the difference is accurate for small angles, unlike the dot product.
+        const Quatf delta = expected.Inverted() * pose.Transform.Orientation;
+        const float error = 2.0f * asinf(Alg::Min(Vector3f(delta.x, delta.y, delta.z).Length(), 1.0f));
+        maxError = Alg::Max(maxError, error);
+        errors += (error > 1e-4f) || (pose.TimeInSeconds != time);
+    }
+
+    LocklessStoreRelease(&share.Stop, 1);
+    while (!producer->IsFinished())
+    {
+        Thread::MSleep(1);
+    }
+
+    LogText("PoseHistoryTest: %-8s %8d lookups, %6.1f ns per lookup, %d misses, max error %.6f radians, %d errors\n",
+            label, lookups, lookupSeconds * 1e9 / Alg::Max(lookups, 1u), misses, maxError, errors);
+
+    delete history;
+    return (int)errors;
+}
+
+} // namespace PoseHistoryTesting
+
+int PoseHistoryTest(int milliseconds)
+{
+    milliseconds = Alg::Max(milliseconds, 10);
+    int errors = 0;
+    errors += PoseHistoryTesting::Run("paced", true, milliseconds);
+    errors += PoseHistoryTesting::Run("flat out", false, milliseconds);
+    LogText("PoseHistoryTest: %s, %d errors\n", errors == 0 ? "PASSED" : "FAILED", errors);
+    return errors;
+}
+
 } // namespace OVR
@@ -26,6 +26,8 @@ namespace OVR {
 
 double TimeInSeconds();	// JDC
 
+class SensorRecorder;
+
 
 //-------------------------------------------------------------------------------------
 // ***** Sensor State
@@ -93,6 +95,17 @@ enum StatusBits
    // Status_HmdConnected          = 0x0080    // HMD Display is available & connected.
 };
 
+// How the orientation is predicted ahead of the most recent sensor sample.
+enum PredictionMode
+{
+    Prediction_ConstantVelocity,        // last angular velocity (default)
+    Prediction_ConstantAcceleration,    // last angular velocity and acceleration
+    Prediction_Filtered,                // Kalman filtered angular velocity and acceleration
+    Prediction_Count
+};
+
+const char* GetPredictionModeName(PredictionMode mode);
+
 
 // Full state of of the sensor reported by GetSensorState() at a given absolute time.
 class SensorState
@@ -119,6 +132,65 @@ public:
 
 
 
+//-------------------------------------------------------------------------------------
+// ***** PoseHistory
+
+// Lock-free ring of the most recent fused poses, ordered by sample time, so
+// the pose at any moment in roughly the last second can be looked up exactly,
+// for instance the pose an eye buffer was rendered with.
+//
+// There is a single producer, the sensor thread, while any number of threads
+// can look up poses at the same time. Each entry is guarded by a sequence
+// stamp, and a lookup that runs into an entry that is being overwritten simply
+// starts over.
+
+class PoseHistory
+{
+public:
+    enum
+    {
+        Size = 1024,        // a little over a second of samples at 1000 Hz
+        Slack = 16          // newest entries that lookups stay away from
+    };
+
+    PoseHistory();
+
+    // Single producer only, in increasing time.
+    void        AddPose(const PoseStatef& pose);
+
+    // Forgets all poses, only call this from the producer.
+    void        Clear();
+
+    // Interpolates between the two samples around the time, or predicts the
+    // pose from the newest sample with the prediction mode for later times.
+    // Returns false if there are no samples, or if the time is older than the
+    // oldest sample, in which case the pose is the oldest sample.
+    bool        GetPoseAtTime(double absoluteTimeSeconds, PoseStatef& pose, PredictionMode mode) const;
+
+    // Number of samples that can currently be looked up.
+    int         GetNumPoses() const;
+
+private:
+    struct Entry
+    {
+        volatile UInt32     Stamp;      // index * 2 + 2 when valid, odd while being written
+        PoseStatef          Pose;
+    };
+
+    bool        readPose(UInt32 index, PoseStatef& pose) const;
+    bool        readTime(UInt32 index, double& time) const;
+
+    volatile UInt32         Count;      // number of poses ever added
+    volatile UInt32         First;      // index of the first pose after the last Clear()
+    Entry                   Entries[Size];
+};
+
+// Logs the error of interpolated PoseHistory lookups against an analytic
+// rotation, and the lookup cost, while another thread keeps adding poses.
+// Returns the number of lookups that were off.
+int PoseHistoryTest(int milliseconds);
+
+
 //-------------------------------------------------------------------------------------
 // ***** SensorFusion
 
@@ -168,8 +240,16 @@ public:
     // recently processed messages.  In general, absoluteTimeSeconds should always be
     // ahead of the most recent message time, but it is possible for a new messages to
     // arrive right before processing, giving a small negative delta in rare cases.
+    // For times before the most recently processed message, the pose is looked up
+    // in the history of processed messages instead.
     SensorState  GetPredictionForTime( double absoluteTimeSeconds ) const;
 
+    // Returns the recentered pose at any time in roughly the last second,
+    // interpolated between sensor samples, or predicted like GetPredictionForTime()
+    // for later times. Lock-free, so this can be called from any thread.
+    // Returns false if there is no sensor data for the time.
+    bool         GetPoseAtTime( double absoluteTimeSeconds, PoseStatef& pose ) const;
+
     // Resets the current orientation.
     void        Reset();
 
@@ -215,6 +295,21 @@ public:
     // Turns off the focus filter (equivalent to setting the focus to 0
     void		ClearFocus();
 
+    // *** Prediction
+
+    // Selects the predictor used by GetPredictionForTime(), can be changed at any time.
+    void            SetPredictionMode(PredictionMode mode)  { Prediction = mode; }
+    PredictionMode  GetPredictionMode() const               { return (PredictionMode)Prediction; }
+
+    // *** Recording
+
+    // Resets the orientation, so the recording can be replayed from the same state,
+    // and then writes every processed message together with the fused orientation
+    // to the file until StopRecording() is called. See OVR_SensorRecording.h.
+    bool        StartRecording(const char* path);
+    // Returns the number of recorded samples.
+    int         StopRecording();
+
     // *** Message Handler Logic
 
     // Notifies SensorFusion object about a new BodyFrame message from a sensor.
@@ -257,6 +352,9 @@ private:
         // time the current state is correct for
     	PoseStatef        State;
     	float             Temperature;
+        // Kalman filtered State.AngularVelocity and State.AngularAcceleration
+        Vector3f          FilteredAngularVelocity;
+        Vector3f          FilteredAngularAcceleration;
 
     	StateForPrediction() : Temperature(0) { };
     };
@@ -279,7 +377,13 @@ private:
 
     // This can be read without any locks, so a high priority rendering thread doesn't
     // have to worry about being blocked by a sensor thread that got preempted.
-    LocklessUpdater<StateForPrediction>	UpdatedState;
+    LocklessSnapshot<StateForPrediction>	UpdatedState;
+
+    // All recently processed states, for lookups of past poses.
+    PoseHistory             History;
+
+    // Only touched by the sensor thread, or with the handler lock held.
+    SensorRecorder*         pRecorder;
 
     // The phase of the head as estimated by sensor fusion
 	PoseStatef              State;
@@ -287,6 +391,9 @@ private:
 
     SensorFilterBodyFrame   FAccelHeadset;
     SensorFilterf           FAngV;
+    SensorFilterKalman      FAngVKalman;
+
+    volatile int            Prediction;     // PredictionMode
 
     // This flag is set while Sensor is attached and running.
     volatile bool     		SensorDataAvailable;
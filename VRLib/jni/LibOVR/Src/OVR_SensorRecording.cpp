@@ -0,0 +1,461 @@
+/************************************************************************************
+
+Filename    :   OVR_SensorRecording.cpp
+Content     :   Recording of sensor messages and offline replay through SensorFusion
+Created     :   October, 2026
+
+Copyright   :   Copyright 2014 Oculus VR, LLC. All Rights reserved.
+
+*************************************************************************************/
+
+#include "OVR_SensorRecording.h"
+#include "OVR_SensorFusion.h"
+#include "OVR_BinaryFile.h"
+#include "Kernel/OVR_Log.h"
+#include "Kernel/OVR_Timer.h"
+
+namespace OVR
+{
+
+//-------------------------------------------------------------------------------------
+// ***** SensorRecorder
+
+SensorRecorder::SensorRecorder() :
+	Recording( false ),
+	Buffer( NULL ),
+	NumBuffered( 0 ),
+	NumRecords( 0 ),
+	WriteFailed( false )
+{
+}
+
+SensorRecorder::~SensorRecorder()
+{
+	Stop();
+}
+
+bool SensorRecorder::Start( const char * path )
+{
+	Stop();
+
+	if ( !File.Open( path, File::Open_Write | File::Open_Create | File::Open_Truncate, File::Mode_Write ) )
+	{
+		LogText( "SensorRecorder: failed to open %s\n", path );
+		return false;
+	}
+
+	SensorRecordingHeader header;
+	header.Magic = SENSOR_RECORDING_MAGIC;
+	header.Version = SENSOR_RECORDING_VERSION;
+	header.RecordSize = sizeof( SensorRecord );
+	header.NumRecords = 0;
+	if ( File.Write( (const UByte *)&header, sizeof( header ) ) != sizeof( header ) )
+	{
+		LogText( "SensorRecorder: failed to write %s\n", path );
+		File.Close();
+		return false;
+	}
+
+	Buffer = (SensorRecord *) OVR_ALLOC( BufferRecords * sizeof( SensorRecord ) );
+	NumBuffered = 0;
+	NumRecords = 0;
+	WriteFailed = false;
+	Recording = true;
+
+	LogText( "SensorRecorder: recording to %s\n", path );
+	return true;
+}
+
+int SensorRecorder::Stop()
+{
+	if ( !Recording )
+	{
+		return 0;
+	}
+
+	flush();
+
+	// The number of records is only known now.
+	SensorRecordingHeader header;
+	header.Magic = SENSOR_RECORDING_MAGIC;
+	header.Version = SENSOR_RECORDING_VERSION;
+	header.RecordSize = sizeof( SensorRecord );
+	header.NumRecords = NumRecords;
+	if ( File.Seek( 0 ) != 0 || File.Write( (const UByte *)&header, sizeof( header ) ) != sizeof( header ) )
+	{
+		WriteFailed = true;
+	}
+	File.Close();
+
+	OVR_FREE( Buffer );
+	Buffer = NULL;
+	Recording = false;
+
+	LogText( "SensorRecorder: recorded %d samples%s\n", NumRecords, WriteFailed ? ", WRITE FAILED" : "" );
+	return NumRecords;
+}
+
+void SensorRecorder::AddRecord( const MessageBodyFrame & msg, const Quatf & orientation )
+{
+	SensorRecord & record = Buffer[NumBuffered++];
+	record.AbsoluteTimeSeconds = msg.AbsoluteTimeSeconds;
+	record.TimeDelta = msg.TimeDelta;
+	record.Temperature = msg.Temperature;
+	record.RotationRate = msg.RotationRate;
+	record.Acceleration = msg.Acceleration;
+	record.MagneticField = msg.MagneticField;
+	record.MagneticBias = msg.MagneticBias;
+	record.Orientation = orientation;
+
+	if ( NumBuffered >= BufferRecords )
+	{
+		flush();
+	}
+}
+
+void SensorRecorder::flush()
+{
+	if ( NumBuffered == 0 )
+	{
+		return;
+	}
+	// Once a write failed the file is useless, so don't keep the sensor thread busy with it.
+	if ( !WriteFailed )
+	{
+		const int bytes = NumBuffered * sizeof( SensorRecord );
+		if ( File.Write( (const UByte *)Buffer, bytes ) == bytes )
+		{
+			NumRecords += NumBuffered;
+		}
+		else
+		{
+			WriteFailed = true;
+		}
+	}
+	NumBuffered = 0;
+}
+
+//-------------------------------------------------------------------------------------
+// ***** SensorRecording
+
+bool SensorRecording::Load( const char * path, const char ** perror )
+{
+	Records.Clear();
+
+	const char * error = NULL;
+	BinaryReader reader( path, &error );
+	if ( error != NULL )
+	{
+		*perror = error;
+		return false;
+	}
+
+	const UInt32 magic = reader.ReadUInt32();
+	const UInt32 version = reader.ReadUInt32();
+	const UInt32 recordSize = reader.ReadUInt32();
+	UInt32 numRecords = reader.ReadUInt32();
+	if ( magic != SENSOR_RECORDING_MAGIC )
+	{
+		*perror = "Not a sensor recording";
+		return false;
+	}
+	if ( version != SENSOR_RECORDING_VERSION || recordSize != sizeof( SensorRecord ) )
+	{
+		*perror = "Unsupported sensor recording version";
+		return false;
+	}
+	// The count is only written when the recording is stopped, so a recording that
+	// was cut short by the app being killed has a count of 0, but still has all the
+	// records that were flushed. Take every whole record in the file then.
+	const UInt32 maxRecords = (UInt32)reader.GetBytesLeft() / sizeof( SensorRecord );
+	if ( numRecords == 0 )
+	{
+		numRecords = maxRecords;
+	}
+	if ( numRecords > maxRecords || !reader.ReadArray( Records, (int)numRecords ) )
+	{
+		*perror = "Sensor recording is truncated";
+		return false;
+	}
+	return true;
+}
+
+// Yaw, pitch and roll as a mix of slow head turns and faster small movements,
+// reaching over 3 radians per second, starting at the identity orientation.
+static Quatd SimulatedHeadOrientation( const double time )
+{
+	const double w = Math<double>::TwoPi * time;
+	const double yaw = 0.8 * sin( 0.31 * w ) + 0.25 * sin( 1.3 * w );
+	const double pitch = 0.3 * sin( 0.47 * w ) + 0.1 * sin( 1.9 * w );
+	const double roll = 0.05 * sin( 0.7 * w );
+	return Quatd( Vector3d( 0, 1, 0 ), yaw ) * Quatd( Vector3d( 1, 0, 0 ), pitch ) * Quatd( Vector3d( 0, 0, 1 ), roll );
+}
+
+// Roughly normal distributed.
+static float SimulatedNoise( UInt32 & random, const float standardDeviation )
+{
+	float sum = 0.0f;
+	for ( int i = 0; i < 4; i++ )
+	{
+		random = random * 1664525 + 1013904223;
+		sum += ( random >> 8 ) * ( 1.0f / 16777216.0f ) - 0.5f;
+	}
+	// The sum of 4 uniform values has a variance of 4 / 12.
+	return sum * standardDeviation * 1.7320508f;
+}
+
+static Vector3f SimulatedNoise( UInt32 & random, const Vector3f & value, const float standardDeviation )
+{
+	const float x = SimulatedNoise( random, standardDeviation );
+	const float y = SimulatedNoise( random, standardDeviation );
+	const float z = SimulatedNoise( random, standardDeviation );
+	return value + Vector3f( x, y, z );
+}
+
+void SensorRecording::Generate( const double seconds )
+{
+	const double sampleSeconds = 0.001;
+	const int numRecords = (int)( seconds / sampleSeconds );
+	const Vector3d gravity( 0.0, 9.8, 0.0 );
+	const Vector3d magneticField( 0.2, -0.4, 0.1 );
+
+	Records.Resize( numRecords );
+	UInt32 random = 12345;
+	Quatd previous = SimulatedHeadOrientation( 0.0 );
+	for ( int i = 0; i < numRecords; i++ )
+	{
+		const double time = ( i + 1 ) * sampleSeconds;
+		const Quatd orientation = SimulatedHeadOrientation( time );
+
+		// The rotation rate that integrates exactly to the new orientation.
+		Quatd delta = previous.Inverted() * orientation;
+		if ( delta.w < 0.0 )
+		{
+			delta = Quatd( -delta.x, -delta.y, -delta.z, -delta.w );
+		}
+		const Vector3d axis( delta.x, delta.y, delta.z );
+		const double sinHalfAngle = axis.Length();
+		const Vector3d rotationRate = ( sinHalfAngle > 0.0 ) ?
+				axis * ( 2.0 * atan2( sinHalfAngle, delta.w ) / ( sinHalfAngle * sampleSeconds ) ) : Vector3d();
+
+		SensorRecord & record = Records[i];
+		record.AbsoluteTimeSeconds = time;
+		record.TimeDelta = (float)sampleSeconds;
+		record.Temperature = 30.0f;
+		record.RotationRate = SimulatedNoise( random, Vector3f( rotationRate ), 0.01f );
+		record.Acceleration = SimulatedNoise( random, Vector3f( orientation.Inverted().Rotate( gravity ) ), 0.05f );
+		record.MagneticField = SimulatedNoise( random, Vector3f( orientation.Inverted().Rotate( magneticField ) ), 0.002f );
+		record.MagneticBias = Vector3f();
+		record.Orientation = Quatf( orientation );
+
+		previous = orientation;
+	}
+}
+
+MessageBodyFrame SensorRecording::GetMessage( const int index ) const
+{
+	const SensorRecord & record = Records[index];
+	MessageBodyFrame msg;
+	msg.AbsoluteTimeSeconds = record.AbsoluteTimeSeconds;
+	msg.TimeDelta = record.TimeDelta;
+	msg.Temperature = record.Temperature;
+	msg.RotationRate = record.RotationRate;
+	msg.Acceleration = record.Acceleration;
+	msg.MagneticField = record.MagneticField;
+	msg.MagneticBias = record.MagneticBias;
+	return msg;
+}
+
+bool SensorRecording::GetOrientationAtTime( const double absoluteTimeSeconds, Quatf & orientation ) const
+{
+	const int count = Records.GetSizeI();
+	if ( count == 0 ||
+			absoluteTimeSeconds < Records[0].AbsoluteTimeSeconds ||
+			absoluteTimeSeconds > Records[count - 1].AbsoluteTimeSeconds )
+	{
+		return false;
+	}
+
+	// Find the last record at or before the time.
+	int low = 0;
+	int high = count - 1;
+	while ( low < high )
+	{
+		const int mid = ( low + high + 1 ) >> 1;
+		if ( Records[mid].AbsoluteTimeSeconds <= absoluteTimeSeconds )
+		{
+			low = mid;
+		}
+		else
+		{
+			high = mid - 1;
+		}
+	}
+
+	const SensorRecord & r0 = Records[low];
+	if ( low == count - 1 )
+	{
+		orientation = r0.Orientation;
+		return true;
+	}
+	const SensorRecord & r1 = Records[low + 1];
+	const double span = r1.AbsoluteTimeSeconds - r0.AbsoluteTimeSeconds;
+	const float f = ( span > 0.0 ) ? (float)( ( absoluteTimeSeconds - r0.AbsoluteTimeSeconds ) / span ) : 0.0f;
+	orientation = r1.Orientation.Nlerp( r0.Orientation, f );
+	return true;
+}
+
+//-------------------------------------------------------------------------------------
+// ***** Replay
+
+// The imaginary part of the difference is accurate for small angles, unlike the dot product.
+static float OrientationError( const Quatf & a, const Quatf & b )
+{
+	const Quatf delta = a.Inverted() * b;
+	return 2.0f * asinf( Alg::Min( Vector3f( delta.x, delta.y, delta.z ).Length(), 1.0f ) );
+}
+
+bool ReplaySensorRecording( const SensorRecording & recording, const PredictionMode prediction,
+							const float predictionSeconds, SensorReplayResults & results )
+{
+	memset( &results, 0, sizeof( results ) );
+
+	const int numRecords = recording.GetNumRecords();
+	if ( numRecords == 0 )
+	{
+		return false;
+	}
+
+	// Convert the records up front, so the timed loop only measures the fusion.
+	Array< MessageBodyFrame > messages;
+	messages.Resize( numRecords );
+	for ( int i = 0; i < numRecords; i++ )
+	{
+		messages[i] = recording.GetMessage( i );
+	}
+
+	results.NumSamples = numRecords;
+	results.Seconds = recording.GetRecord( numRecords - 1 ).AbsoluteTimeSeconds - recording.GetRecord( 0 ).AbsoluteTimeSeconds;
+	results.Prediction = prediction;
+	results.PredictionSeconds = predictionSeconds;
+
+	// Timed replay, as fast as possible.
+	{
+		SensorFusion * fusion = new SensorFusion();
+		const double start = Timer::GetSeconds();
+		for ( int i = 0; i < numRecords; i++ )
+		{
+			fusion->OnMessage( messages[i] );
+		}
+		results.ReplaySeconds = Timer::GetSeconds() - start;
+		delete fusion;
+
+		results.SamplesPerSecond = numRecords / Alg::Max( results.ReplaySeconds, 1e-9 );
+		results.NanosecondsPerSample = results.ReplaySeconds * 1e9 / numRecords;
+	}
+
+	// Replay again, this time comparing every sample with the recording.
+	{
+		SensorFusion * fusion = new SensorFusion();
+		fusion->SetPredictionMode( prediction );
+		double orientationErrorSum = 0.0;
+		double predictionErrorSum = 0.0;
+		for ( int i = 0; i < numRecords; i++ )
+		{
+			fusion->OnMessage( messages[i] );
+
+			const SensorRecord & record = recording.GetRecord( i );
+			const SensorState current = fusion->GetPredictionForTime( record.AbsoluteTimeSeconds );
+			const float orientationError = OrientationError( record.Orientation, current.Recorded.Transform.Orientation );
+			orientationErrorSum += orientationError;
+			results.MaxOrientationError = Alg::Max( results.MaxOrientationError, orientationError );
+
+			// Compare the prediction with what was recorded at the predicted time.
+			const double predictedTime = record.AbsoluteTimeSeconds + predictionSeconds;
+			Quatf actual;
+			if ( !recording.GetOrientationAtTime( predictedTime, actual ) )
+			{
+				continue;
+			}
+			const SensorState predicted = fusion->GetPredictionForTime( predictedTime );
+			const float predictionError = OrientationError( actual, predicted.Predicted.Transform.Orientation );
+			predictionErrorSum += predictionError;
+			results.MaxPredictionError = Alg::Max( results.MaxPredictionError, predictionError );
+			results.NumPredictions++;
+		}
+		delete fusion;
+
+		results.MeanOrientationError = (float)( orientationErrorSum / numRecords );
+		results.MeanPredictionError = (float)( predictionErrorSum / Alg::Max( results.NumPredictions, 1 ) );
+	}
+
+	return true;
+}
+
+bool ReplaySensorRecording( const char * path, const PredictionMode prediction, const float predictionSeconds )
+{
+	SensorRecording recording;
+	const char * error = NULL;
+	if ( !recording.Load( path, &error ) )
+	{
+		LogText( "SensorReplay: %s: %s\n", path, error );
+		return false;
+	}
+
+	SensorReplayResults results;
+	if ( !ReplaySensorRecording( recording, prediction, predictionSeconds, results ) )
+	{
+		LogText( "SensorReplay: %s: no samples\n", path );
+		return true;
+	}
+
+	LogText( "SensorReplay: %s: %d samples, %.1f seconds recorded\n", path, results.NumSamples, results.Seconds );
+	LogText( "SensorReplay: %.0f samples per second, %.1f ns per sample\n", results.SamplesPerSecond, results.NanosecondsPerSample );
+	LogText( "SensorReplay: orientation error mean %.4f max %.4f degrees\n",
+			RadToDegree( results.MeanOrientationError ), RadToDegree( results.MaxOrientationError ) );
+	LogText( "SensorReplay: %.0f ms %s prediction error mean %.4f max %.4f degrees over %d samples\n",
+			results.PredictionSeconds * 1000.0f, GetPredictionModeName( results.Prediction ), RadToDegree( results.MeanPredictionError ),
+			RadToDegree( results.MaxPredictionError ), results.NumPredictions );
+	return true;
+}
+
+bool SensorPredictionBenchmark( const char * path )
+{
+	SensorRecording recording;
+	if ( path != NULL && path[0] != '\0' )
+	{
+		const char * error = NULL;
+		if ( !recording.Load( path, &error ) )
+		{
+			LogText( "SensorPrediction: %s: %s\n", path, error );
+			return false;
+		}
+	}
+	else
+	{
+		path = "generated";
+		recording.Generate( 60.0 );
+	}
+
+	static const int NUM_HORIZONS = 3;
+	static const float horizons[NUM_HORIZONS] = { 0.016f, 0.032f, 0.048f };
+
+	LogText( "SensorPrediction: %s: %d samples, mean / max error in degrees\n", path, recording.GetNumRecords() );
+	for ( int mode = 0; mode < Prediction_Count; mode++ )
+	{
+		SensorReplayResults results[NUM_HORIZONS];
+		for ( int h = 0; h < NUM_HORIZONS; h++ )
+		{
+			ReplaySensorRecording( recording, (PredictionMode)mode, horizons[h], results[h] );
+		}
+		LogText( "SensorPrediction: %-12s 16 ms %.3f / %.3f, 32 ms %.3f / %.3f, 48 ms %.3f / %.3f, %.1f ns per sample\n",
+				GetPredictionModeName( (PredictionMode)mode ),
+				RadToDegree( results[0].MeanPredictionError ), RadToDegree( results[0].MaxPredictionError ),
+				RadToDegree( results[1].MeanPredictionError ), RadToDegree( results[1].MaxPredictionError ),
+				RadToDegree( results[2].MeanPredictionError ), RadToDegree( results[2].MaxPredictionError ),
+				results[0].NanosecondsPerSample );
+	}
+	return true;
+}
+
+}	// namespace OVR
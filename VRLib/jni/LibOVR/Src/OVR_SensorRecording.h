@@ -0,0 +1,151 @@
+/************************************************************************************
+
+Filename    :   OVR_SensorRecording.h
+Content     :   Recording of sensor messages and offline replay through SensorFusion
+Created     :   October, 2026
+
+Copyright   :   Copyright 2014 Oculus VR, LLC. All Rights reserved.
+
+*************************************************************************************/
+
+#ifndef OVR_SensorRecording_h
+#define OVR_SensorRecording_h
+
+#include "Kernel/OVR_Types.h"
+#include "Kernel/OVR_Math.h"
+#include "Kernel/OVR_Array.h"
+#include "Kernel/OVR_SysFile.h"
+#include "OVR_DeviceMessages.h"
+#include "OVR_SensorFusion.h"
+
+/*
+	Changes to the sensor fusion are hard to evaluate on the device, because
+	no two head movements are the same, and the sensor thread runs at the
+	mercy of the scheduler.
+
+	The SensorRecorder writes every MessageBodyFrame that SensorFusion
+	processes to a file, together with the fused orientation that came out,
+	so the exact same input can be fed through SensorFusion offline, for
+	instance on a Linux desktop, as fast as it will go. The replay reports
+	the cost per sample, how far the replayed orientation ends up from the
+	recorded orientation, and how well the orientation is predicted ahead
+	compared to the orientation that was actually recorded at that time.
+
+	All values are little endian, just like the devices that record them.
+	Any change to the layout of the records must bump the version.
+*/
+
+namespace OVR {
+
+static const UInt32 SENSOR_RECORDING_MAGIC		= 0x72736F76;	// "vosr"
+static const UInt32 SENSOR_RECORDING_VERSION	= 1;
+
+struct SensorRecordingHeader
+{
+	UInt32		Magic;
+	UInt32		Version;
+	UInt32		RecordSize;		// sizeof( SensorRecord )
+	UInt32		NumRecords;		// patched when the recording is stopped, 0 if it never was
+};
+
+struct SensorRecord
+{
+	double		AbsoluteTimeSeconds;
+	float		TimeDelta;
+	float		Temperature;
+	Vector3f	RotationRate;
+	Vector3f	Acceleration;
+	Vector3f	MagneticField;
+	Vector3f	MagneticBias;
+	Quatf		Orientation;		// fused orientation after the message, without recentering
+};
+
+// Only used by the thread that processes the sensor messages, except for
+// Start() and Stop(), which have to be serialized with AddRecord() by the caller.
+class SensorRecorder
+{
+public:
+				SensorRecorder();
+				~SensorRecorder();
+
+	bool		Start( const char * path );
+	// Returns the number of records written.
+	int			Stop();
+
+	bool		IsRecording() const { return Recording; }
+
+	// Records are buffered, so this does not hit the file for every message.
+	void		AddRecord( const MessageBodyFrame & msg, const Quatf & orientation );
+
+private:
+	enum
+	{
+		BufferRecords = 256
+	};
+
+	void		flush();
+
+	SysFile			File;
+	bool			Recording;
+	SensorRecord *	Buffer;
+	int				NumBuffered;
+	int				NumRecords;
+	bool			WriteFailed;
+};
+
+class SensorRecording
+{
+public:
+	bool		Load( const char * path, const char ** perror );
+
+	// Simulates a head looking around at 1000 Hz with sensor noise. The recorded
+	// orientation is the exact simulated orientation instead of a fused one.
+	void		Generate( const double seconds );
+
+	int			GetNumRecords() const { return Records.GetSizeI(); }
+	const SensorRecord &	GetRecord( const int index ) const { return Records[index]; }
+
+	// The message as it was originally handed to SensorFusion.
+	MessageBodyFrame	GetMessage( const int index ) const;
+
+	// Interpolates the recorded orientation between the two records around the time.
+	// Returns false if the time is outside the recording.
+	bool		GetOrientationAtTime( const double absoluteTimeSeconds, Quatf & orientation ) const;
+
+private:
+	Array< SensorRecord >	Records;
+};
+
+struct SensorReplayResults
+{
+	int			NumSamples;
+	double		Seconds;					// recorded time span
+	double		ReplaySeconds;				// wall clock time of the timed replay
+	double		SamplesPerSecond;
+	double		NanosecondsPerSample;
+	float		MeanOrientationError;		// radians, replayed against recorded orientation
+	float		MaxOrientationError;
+	PredictionMode	Prediction;
+	float		PredictionSeconds;
+	int			NumPredictions;
+	float		MeanPredictionError;		// radians, predicted against recorded orientation
+	float		MaxPredictionError;
+};
+
+// Feeds the recording through a new SensorFusion object on the calling thread.
+// Returns false if the recording is empty.
+bool ReplaySensorRecording( const SensorRecording & recording, const PredictionMode prediction,
+							const float predictionSeconds, SensorReplayResults & results );
+
+// Loads the file, replays it and logs the results.
+// Returns false if the file could not be loaded.
+bool ReplaySensorRecording( const char * path, const PredictionMode prediction, const float predictionSeconds );
+
+// Logs the prediction error of every PredictionMode 16, 32 and 48 milliseconds
+// ahead, replaying the file, or a generated recording if path is NULL or empty.
+// Returns false if the file could not be loaded.
+bool SensorPredictionBenchmark( const char * path );
+
+}	// namespace OVR
+
+#endif	// OVR_SensorRecording_h
@@ -0,0 +1,589 @@
+/************************************************************************************
+
+Filename    :   MessageChannel.cpp
+Content     :   Thread communication by fixed size binary messages
+Created     :   October, 2026
+
+Copyright   :   Copyright 2014 Oculus VR, LLC. All Rights reserved.
+
+*************************************************************************************/
+
+#include "MessageChannel.h"
+
+#include <assert.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>			// usleep
+
+#include "Kernel/OVR_Alg.h"
+#include "Kernel/OVR_Std.h"
+#include "MessageQueue.h"
+#include "Log.h"
+
+namespace OVR
+{
+
+// Set by EndCoalescing() to queue the next message for the key without
+// letting the one after that overwrite it.
+static const UInt32 COALESCE_KEEP_NEXT = 0xFFFFFFFF;
+
+MessageChannel::MessageChannel( int maxMessages, MessageChannelOverflow overflow ) :
+	IsShutdown( false ),
+	Overflow( overflow ),
+	Mask( 0 ),
+	Slots( NULL )
+{
+	assert( maxMessages > 0 );
+
+	UInt32 numSlots = 2;
+	while ( numSlots < (UInt32)maxMessages )
+	{
+		numSlots <<= 1;
+	}
+	Mask = numSlots - 1;
+	Slots = new slot_t[numSlots];
+	for ( UInt32 i = 0; i < numSlots; i++ )
+	{
+		Slots[i].sequence.Store_Release( i );
+		memset( &Slots[i].message, 0, sizeof( Slots[i].message ) );
+	}
+	Head.value.Store_Release( 0 );
+	Tail.value.Store_Release( 0 );
+	DroppedMessages.Store_Release( 0 );
+	CoalescedMessages.Store_Release( 0 );
+	for ( int i = 0; i < MAX_COALESCING_KEYS; i++ )
+	{
+		CoalescePositions[i].Store_Release( 0 );
+	}
+	Sleeping.Store_Release( 0 );
+
+	pthread_mutex_init( &Mutex, NULL );
+	pthread_cond_init( &Wake, NULL /* default attributes */ );
+}
+
+MessageChannel::~MessageChannel()
+{
+	delete[] Slots;
+
+	pthread_mutex_destroy( &Mutex );
+	pthread_cond_destroy( &Wake );
+}
+
+void MessageChannel::Shutdown()
+{
+	LOG( "%p:MessageChannel shutdown", this );
+	IsShutdown = true;
+}
+
+SInt64 MessageChannel::PostMessage( const channelMessage_t & msg )
+{
+	bool dropped = false;
+	for ( ; ; )
+	{
+		const UInt32 pos = Tail.value.Load_Acquire();
+		slot_t & slot = Slots[pos & Mask];
+		const int delta = (int)( slot.sequence.Load_Acquire() - pos );
+		if ( delta == 0 )
+		{
+			if ( Tail.value.CompareAndSet_Sync( pos, pos + 1 ) )
+			{
+				slot.message = msg;
+				slot.sequence.Store_Release( pos + 1 );
+				WakeReader();
+				return dropped ? -1 : (SInt64)pos;
+			}
+		}
+		else if ( delta < 0 )
+		{
+			// The slot still holds the message from the previous lap, so the channel is full.
+			if ( Overflow == MESSAGE_CHANNEL_DROP_NEWEST )
+			{
+				DroppedMessages.ExchangeAdd_Sync( 1 );
+				return -1;
+			}
+			// Another producer may drop the oldest message at the same time,
+			// or the reader may just have made room, in which case nothing
+			// needs to be dropped here.
+			channelMessage_t oldest;
+			if ( ReadMessage( oldest ) )
+			{
+				DroppedMessages.ExchangeAdd_Sync( 1 );
+				dropped = true;
+			}
+		}
+		// else another producer claimed the slot first
+	}
+}
+
+void MessageChannel::WakeReader()
+{
+	// The compare-and-set on Sleeping is a full barrier, so either the
+	// reader sees the new message before going to sleep, or it is woken up.
+	if ( Sleeping.CompareAndSet_Sync( 1, 0 ) )
+	{
+		pthread_mutex_lock( &Mutex );
+		pthread_cond_signal( &Wake );
+		pthread_mutex_unlock( &Mutex );
+	}
+}
+
+bool MessageChannel::Post( const channelMessage_t & msg )
+{
+	if ( IsShutdown )
+	{
+		return false;
+	}
+	return PostMessage( msg ) >= 0;
+}
+
+bool MessageChannel::PostCoalesced( const channelMessage_t & msg, const int key )
+{
+	assert( key >= 0 && key < MAX_COALESCING_KEYS );
+
+	if ( IsShutdown )
+	{
+		return false;
+	}
+
+	AtomicInt< UInt32 > & position = CoalescePositions[key];
+	const UInt32 last = position.Load_Acquire();
+	if ( last != 0 && last != COALESCE_KEEP_NEXT )
+	{
+		// Take the slot away from the reader by setting the sequence back to
+		// "being written". This only succeeds if the message is still waiting
+		// in the same lap of the ring, so it can't be the message of a later
+		// post that reused the slot.
+		const UInt32 pos = last - 1;
+		slot_t & slot = Slots[pos & Mask];
+		if ( slot.sequence.CompareAndSet_Sync( pos + 1, pos ) )
+		{
+			slot.message = msg;
+			slot.sequence.Store_Release( pos + 1 );
+			CoalescedMessages.ExchangeAdd_Sync( 1 );
+			// The reader may have gone to sleep while the slot was taken.
+			WakeReader();
+			return true;
+		}
+	}
+
+	const SInt64 pos = PostMessage( msg );
+	if ( pos < 0 )
+	{
+		return false;
+	}
+	// Only the first post after EndCoalescing() sees COALESCE_KEEP_NEXT,
+	// and a concurrent EndCoalescing() wins over this post.
+	position.CompareAndSet_Sync( last, ( last == COALESCE_KEEP_NEXT ) ? 0 : (UInt32)pos + 1 );
+	return true;
+}
+
+void MessageChannel::EndCoalescing( const int key, const bool keepFirst )
+{
+	assert( key >= 0 && key < MAX_COALESCING_KEYS );
+	CoalescePositions[key].Store_Release( keepFirst ? COALESCE_KEEP_NEXT : 0 );
+}
+
+void MessageChannel::PostJoy( const float lx, const float ly, const float rx, const float ry )
+{
+	channelMessage_t msg;
+	msg.type = CHANNEL_MESSAGE_JOY;
+	msg.joy.sticks[0][0] = lx;
+	msg.joy.sticks[0][1] = ly;
+	msg.joy.sticks[1][0] = rx;
+	msg.joy.sticks[1][1] = ry;
+	PostCoalesced( msg, CHANNEL_MESSAGE_JOY );
+}
+
+void MessageChannel::PostTouch( const int action, const float x, const float y )
+{
+	channelMessage_t msg;
+	msg.type = CHANNEL_MESSAGE_TOUCH;
+	msg.touch.action = action;
+	msg.touch.x = x;
+	msg.touch.y = y;
+	if ( action == 2 )	// MotionEvent.ACTION_MOVE
+	{
+		PostCoalesced( msg, CHANNEL_MESSAGE_TOUCH );
+	}
+	else
+	{
+		Post( msg );
+		EndCoalescing( CHANNEL_MESSAGE_TOUCH, true );
+	}
+}
+
+void MessageChannel::PostKey( const int keyCode, const int down, const int repeatCount )
+{
+	channelMessage_t msg;
+	msg.type = CHANNEL_MESSAGE_KEY;
+	msg.key.keyCode = keyCode;
+	msg.key.down = down;
+	msg.key.repeatCount = repeatCount;
+	Post( msg );
+}
+
+bool MessageChannel::ReadMessage( channelMessage_t & msg )
+{
+	for ( ; ; )
+	{
+		const UInt32 pos = Head.value.Load_Acquire();
+		slot_t & slot = Slots[pos & Mask];
+		const int delta = (int)( slot.sequence.Load_Acquire() - ( pos + 1 ) );
+		if ( delta == 0 )
+		{
+			// Producers that drop the oldest message and PostCoalesced() compete
+			// with the reader, so take the slot by setting the sequence back to
+			// "being written". Only the owner of the slot can move the head on.
+			if ( slot.sequence.CompareAndSet_Sync( pos + 1, pos ) )
+			{
+				msg = slot.message;
+				Head.value.Store_Release( pos + 1 );
+				slot.sequence.Store_Release( pos + Mask + 1 );
+				return true;
+			}
+		}
+		else if ( delta < 0 )
+		{
+			// Empty, or the next message is still being written.
+			return false;
+		}
+	}
+}
+
+bool MessageChannel::HasMessage() const
+{
+	const UInt32 pos = Head.value.Load_Acquire();
+	return Slots[pos & Mask].sequence.Load_Acquire() == pos + 1;
+}
+
+bool MessageChannel::GetNextMessage( channelMessage_t & msg )
+{
+	return ReadMessage( msg );
+}
+
+void MessageChannel::SleepUntilMessage()
+{
+	pthread_mutex_lock( &Mutex );
+	Sleeping.Exchange_Sync( 1 );
+	if ( !HasMessage() )
+	{
+		// A post in between the check and the wait blocks on the mutex
+		// until the wait has released it.
+		pthread_cond_wait( &Wake, &Mutex );
+	}
+	Sleeping.Store_Release( 0 );
+	pthread_mutex_unlock( &Mutex );
+}
+
+void MessageChannel::ClearMessages()
+{
+	channelMessage_t msg;
+	while ( ReadMessage( msg ) )
+	{
+	}
+}
+
+//=======================================================================================
+// Benchmark
+
+struct channelBenchmark_t
+{
+	MessageQueue *		queue;
+	MessageChannel *	channel;
+	int					numMessages;
+	int					intervalMicroSeconds;	// 0 = post as fast as possible
+	double				postNanoSeconds;
+	AtomicInt< int > *	numDone;				// posting threads that are done
+};
+
+static void * ChannelBenchmarkPoster( void * parm )
+{
+	channelBenchmark_t * bench = (channelBenchmark_t *)parm;
+
+	bench->postNanoSeconds = 0.0;
+	for ( int i = 0; i < bench->numMessages; i++ )
+	{
+		// The post time goes along with the message to measure the latency.
+		const long long now = (long long)LogCpuTime::GetNanoSeconds();
+		const float value = (float)( i & 255 ) * ( 1.0f / 255.0f );
+		if ( bench->queue != NULL )
+		{
+			bench->queue->PostPrintf( "joy %f %f %f %f %lld", value, -value, value, -value, now );
+		}
+		else
+		{
+			channelMessage_t msg;
+			msg.type = CHANNEL_MESSAGE_USER;
+			msg.raw[0] = (UInt64)now;
+			msg.raw[1] = (UInt64)i;
+			bench->channel->Post( msg );
+		}
+		bench->postNanoSeconds += LogCpuTime::GetNanoSeconds() - (double)now;
+		if ( bench->intervalMicroSeconds > 0 )
+		{
+			usleep( bench->intervalMicroSeconds );
+		}
+	}
+
+	// The reader can't wait for a number of messages, because the last ones may be
+	// dropped while it is asleep, and then nothing wakes it up. Instead it stops once
+	// every thread is done and the channel is empty, and this message wakes it up
+	// to see that. If the message is dropped to make room, the message that took
+	// its place wakes the reader instead, and a channel that drops new messages
+	// gets it again until it is in.
+	bench->numDone->ExchangeAdd_Sync( 1 );
+	if ( bench->queue != NULL )
+	{
+		bench->queue->PostPrintf( "done" );
+	}
+	else
+	{
+		channelMessage_t msg;
+		msg.type = CHANNEL_MESSAGE_NONE;
+		while ( !bench->channel->Post( msg ) )
+		{
+			usleep( 100 );
+		}
+	}
+	return NULL;
+}
+
+static void RunChannelBenchmark( const char * label, MessageQueue * queue, MessageChannel * channel,
+		const int numThreads, const int numMessages, const int intervalMicroSeconds )
+{
+	static const int MAX_POSTERS = 16;
+	channelBenchmark_t benches[MAX_POSTERS];
+	pthread_t threads[MAX_POSTERS];
+
+	const int totalMessages = numThreads * numMessages;
+	int received = 0;
+	double totalLatency = 0.0;
+	double maxLatency = 0.0;
+	float sticks[4] = {};
+	AtomicInt< int > numDone( 0 );
+
+	const double start = LogCpuTime::GetNanoSeconds();
+	for ( int i = 0; i < numThreads; i++ )
+	{
+		benches[i].queue = queue;
+		benches[i].channel = channel;
+		benches[i].numMessages = numMessages;
+		benches[i].intervalMicroSeconds = intervalMicroSeconds;
+		benches[i].numDone = &numDone;
+		const int createErr = pthread_create( &threads[i], NULL, ChannelBenchmarkPoster, &benches[i] );
+		if ( createErr != 0 )
+		{
+			FAIL( "pthread_create returned %i", createErr );
+		}
+	}
+
+	// Receive on this thread the same way the VR thread does.
+	for ( ; ; )
+	{
+		// Everything was posted before the count went up, so if the channel is
+		// empty after this, there is nothing more to receive.
+		const bool allDone = ( numDone.Load_Acquire() == numThreads );
+		long long postTime = 0;
+		if ( queue != NULL )
+		{
+			const char * msg = queue->GetNextMessage();
+			if ( msg == NULL )
+			{
+				if ( allDone )
+				{
+					break;
+				}
+				queue->SleepUntilMessage();
+				continue;
+			}
+			if ( strcmp( msg, "done" ) == 0 )
+			{
+				free( (void *)msg );
+				continue;
+			}
+			sscanf( msg, "joy %f %f %f %f %lld", &sticks[0], &sticks[1], &sticks[2], &sticks[3], &postTime );
+			free( (void *)msg );
+		}
+		else
+		{
+			channelMessage_t msg;
+			if ( !channel->GetNextMessage( msg ) )
+			{
+				if ( allDone )
+				{
+					break;
+				}
+				channel->SleepUntilMessage();
+				continue;
+			}
+			if ( msg.type == CHANNEL_MESSAGE_NONE )
+			{
+				continue;
+			}
+			postTime = (long long)msg.raw[0];
+		}
+		const double latency = LogCpuTime::GetNanoSeconds() - (double)postTime;
+		totalLatency += latency;
+		maxLatency = Alg::Max( maxLatency, latency );
+		received++;
+	}
+	const double end = LogCpuTime::GetNanoSeconds();
+
+	double postNanoSeconds = 0.0;
+	for ( int i = 0; i < numThreads; i++ )
+	{
+		pthread_join( threads[i], NULL );
+		postNanoSeconds += benches[i].postNanoSeconds;
+	}
+
+	LOG( "messageChannelBenchmark: %-24s %7.2f Mmsg/s, post %6.1f ns, latency avg %8.1f us max %8.1f us, %d dropped",
+			label, totalMessages / ( end - start ) * 1e3,
+			postNanoSeconds / totalMessages,
+			totalLatency / Alg::Max( received, 1 ) * 1e-3, maxLatency * 1e-3,
+			totalMessages - received );
+}
+
+struct coalesceBenchmark_t
+{
+	MessageChannel *	channel;
+	int					numEvents;
+};
+
+// Every event posts a joystick update and a touch event, where every
+// 1024 touch events are a down, 1022 moves and an up.
+static void * CoalesceBenchmarkPoster( void * parm )
+{
+	coalesceBenchmark_t * bench = (coalesceBenchmark_t *)parm;
+	for ( int i = 0; i < bench->numEvents; i++ )
+	{
+		bench->channel->PostJoy( (float)i, 0.0f, 0.0f, 0.0f );
+		const int action = ( ( i & 1023 ) == 0 ) ? 0 : ( ( ( i & 1023 ) == 1023 ) ? 1 : 2 );
+		bench->channel->PostTouch( action, (float)i, 0.0f );
+	}
+	return NULL;
+}
+
+// Drains the channel once per simulated frame while the input is posted as
+// fast as possible, and checks that the coalesced state is never out of order.
+static void RunCoalesceBenchmark( const int numEvents )
+{
+	MessageChannel channel( 256 );
+	coalesceBenchmark_t bench;
+	bench.channel = &channel;
+	bench.numEvents = numEvents;
+
+	const int totalMessages = numEvents * 2;
+	int received = 0;
+	int frames = 0;
+	int maxPerFrame = 0;
+	int errors = 0;
+	float lastJoy = -1.0f;
+	float lastTouch = -1.0f;
+	int touchMoves = -1;	// -1 = touch is up
+
+	pthread_t thread;
+	const int createErr = pthread_create( &thread, NULL, CoalesceBenchmarkPoster, &bench );
+	if ( createErr != 0 )
+	{
+		FAIL( "pthread_create returned %i", createErr );
+	}
+
+	const double start = LogCpuTime::GetNanoSeconds();
+	while ( received + channel.GetCoalescedMessages() + channel.GetDroppedMessages() < totalMessages )
+	{
+		int perFrame = 0;
+		channelMessage_t msg;
+		while ( channel.GetNextMessage( msg ) )
+		{
+			perFrame++;
+			if ( msg.type == CHANNEL_MESSAGE_JOY )
+			{
+				errors += ( msg.joy.sticks[0][0] <= lastJoy );
+				lastJoy = msg.joy.sticks[0][0];
+			}
+			else if ( msg.type == CHANNEL_MESSAGE_TOUCH )
+			{
+				errors += ( msg.touch.x <= lastTouch );
+				lastTouch = msg.touch.x;
+				if ( msg.touch.action == 0 )
+				{
+					errors += ( touchMoves != -1 );
+					touchMoves = 0;
+				}
+				else if ( msg.touch.action == 1 )
+				{
+					errors += ( touchMoves == -1 );
+					touchMoves = -1;
+				}
+				else
+				{
+					// Only the first and the last move in between down and up can survive,
+					// unless the reader picked up a move before the next one was posted.
+					errors += ( touchMoves == -1 );
+					touchMoves++;
+				}
+			}
+		}
+		received += perFrame;
+		maxPerFrame = Alg::Max( maxPerFrame, perFrame );
+		frames++;
+		usleep( 1000 );
+	}
+	const double end = LogCpuTime::GetNanoSeconds();
+	pthread_join( thread, NULL );
+
+	errors += ( lastJoy != (float)( numEvents - 1 ) );
+	errors += ( lastTouch != (float)( numEvents - 1 ) );
+
+	LOG( "messageChannelBenchmark: coalescing %d messages in %d frames of %4.1f ms: %d processed, max %d per frame, %d coalesced, %d dropped, %d errors",
+			totalMessages, frames, ( end - start ) * 1e-6 / Alg::Max( frames, 1 ), received, maxPerFrame,
+			channel.GetCoalescedMessages(), channel.GetDroppedMessages(), errors );
+}
+
+void MessageChannelBenchmark( void * appPtr, const char * cmd )
+{
+	OVR_UNUSED( appPtr );
+
+	int numThreads = 3;
+	int numMessages = 100000;
+	sscanf( cmd, "%i %i", &numThreads, &numMessages );
+	numThreads = Alg::Clamp( numThreads, 1, 16 );
+	numMessages = Alg::Max( numMessages, 1 );
+
+	LOG( "messageChannelBenchmark: %d posting threads, %d messages each", numThreads, numMessages );
+
+	// The MessageQueue aborts on overflow, so it has to be able to hold every message,
+	// including the one each thread posts when it is done.
+	{
+		MessageQueue queue( numThreads * ( numMessages + 1 ) );
+		RunChannelBenchmark( "MessageQueue", &queue, NULL, numThreads, numMessages, 0 );
+	}
+	{
+		MessageChannel channel( numThreads * ( numMessages + 1 ) );
+		RunChannelBenchmark( "MessageChannel", NULL, &channel, numThreads, numMessages, 0 );
+	}
+	// The size the VR thread uses, where the reader can fall behind.
+	{
+		MessageChannel channel( 256, MESSAGE_CHANNEL_DROP_OLDEST );
+		RunChannelBenchmark( "MessageChannel 256 oldest", NULL, &channel, numThreads, numMessages, 0 );
+	}
+	{
+		MessageChannel channel( 256, MESSAGE_CHANNEL_DROP_NEWEST );
+		RunChannelBenchmark( "MessageChannel 256 newest", NULL, &channel, numThreads, numMessages, 0 );
+	}
+	// Input events at a realistic rate, where the reader is mostly asleep,
+	// so the latency is the time it takes to wake up the reader.
+	{
+		MessageQueue queue( 256 );
+		RunChannelBenchmark( "MessageQueue paced", &queue, NULL, 1, 2000, 250 );
+	}
+	{
+		MessageChannel channel( 256 );
+		RunChannelBenchmark( "MessageChannel paced", NULL, &channel, 1, 2000, 250 );
+	}
+
+	RunCoalesceBenchmark( numMessages );
+}
+
+}	// namespace OVR
@@ -0,0 +1,187 @@
+/************************************************************************************
+
+Filename    :   MessageChannel.h
+Content     :   Thread communication by fixed size binary messages
+Created     :   October, 2026
+
+Copyright   :   Copyright 2014 Oculus VR, LLC. All Rights reserved.
+
+*************************************************************************************/
+#ifndef OVR_MessageChannel_h
+#define OVR_MessageChannel_h
+
+#include <pthread.h>
+#include "Kernel/OVR_Types.h"
+#include "Kernel/OVR_Atomic.h"
+
+namespace OVR
+{
+
+/*
+	MessageQueue strdups every message and the receiver has to sscanf it back,
+	which is fine for the occasional lifecycle message, but not for input events
+	that arrive many times per frame.
+
+	The MessageChannel moves fixed size POD records through a lock-free ring, so
+	posting a message is a copy and a compare-and-swap, and there is no heap
+	allocation, formatting or parsing anywhere. Instead of aborting on overflow,
+	the oldest message is dropped (or optionally the new message), and the
+	number of dropped messages is counted.
+
+	High rate input like joystick axes and touch moves is posted with a
+	coalescing key. If the last message posted with the same key is still
+	waiting for the reader, it is overwritten in place, so it keeps its place
+	in the channel but carries the latest state. No matter how many of these
+	arrive, the reader only processes one per key for each drain, in between
+	the messages that end the coalescing, like touch down and up.
+*/
+
+enum ChannelMessageType
+{
+	CHANNEL_MESSAGE_NONE,
+	CHANNEL_MESSAGE_JOY,		// joy
+	CHANNEL_MESSAGE_TOUCH,		// touch
+	CHANNEL_MESSAGE_KEY,		// key
+	CHANNEL_MESSAGE_USER		// raw, free for the application
+};
+
+struct channelMessage_t
+{
+	int		type;		// ChannelMessageType
+	union
+	{
+		struct
+		{
+			float	sticks[2][2];
+		} joy;
+		struct
+		{
+			int		action;		// 0 = down, 1 = up, 2 = move
+			float	x;
+			float	y;
+		} touch;
+		struct
+		{
+			int		keyCode;
+			int		down;
+			int		repeatCount;
+		} key;
+		UInt64	raw[2];
+	};
+};
+
+// Coalescing keys are small integers, normally the message type.
+static const int MAX_COALESCING_KEYS = 8;
+
+enum MessageChannelOverflow
+{
+	MESSAGE_CHANNEL_DROP_OLDEST,	// make room by discarding the oldest message
+	MESSAGE_CHANNEL_DROP_NEWEST		// discard the message that is being posted
+};
+
+// This is a multiple-producer, single-consumer message channel.
+// All storage is allocated up front.
+class MessageChannel
+{
+public:
+					// The number of messages is rounded up to a power of two.
+					MessageChannel( int maxMessages, MessageChannelOverflow overflow = MESSAGE_CHANNEL_DROP_OLDEST );
+					~MessageChannel();
+
+	// Messages posted after shutdown are ignored.
+	void			Shutdown();
+
+	// Thread safe, callable by any thread, never blocks unless the
+	// channel is full and another thread is halfway through a post.
+	// Returns false if a message was dropped because of overflow.
+	bool			Post( const channelMessage_t & msg );
+
+	// Replaces the last message posted with the same key if the reader has not
+	// picked it up yet, otherwise this is the same as Post().
+	bool			PostCoalesced( const channelMessage_t & msg, const int key );
+
+	// The next PostCoalesced() with the key gets a message of its own, so nothing
+	// posted before this call is overwritten with state from after it.
+	// If keepFirst is set, the message after that one gets its own message as well.
+	void			EndCoalescing( const int key, const bool keepFirst );
+
+	// Only the latest stick state is kept.
+	void			PostJoy( const float lx, const float ly, const float rx, const float ry );
+	// Down, up and cancel end the coalescing, so only the first and last move
+	// in between are kept.
+	void			PostTouch( const int action, const float x, const float y );
+	void			PostKey( const int keyCode, const int down, const int repeatCount );
+
+	// The other methods are NOT thread safe, and should only be
+	// called by the thread that owns the MessageChannel.
+
+	// Returns false if there are no more messages.
+	bool			GetNextMessage( channelMessage_t & msg );
+
+	// Returns immediately if there is already a message in the channel.
+	void			SleepUntilMessage();
+
+	// Dumps all unread messages.
+	void			ClearMessages();
+
+	// Number of messages that were dropped because the channel was full.
+	int				GetDroppedMessages() const { return DroppedMessages; }
+
+	// Number of messages that were merged into a message that was already posted.
+	int				GetCoalescedMessages() const { return CoalescedMessages; }
+
+private:
+	struct slot_t
+	{
+		AtomicInt< UInt32 >	sequence;	// position this slot is ready for
+		channelMessage_t	message;
+	};
+
+	// Also used by Post() to drop the oldest message.
+	bool			ReadMessage( channelMessage_t & msg );
+	bool			HasMessage() const;
+	// Returns the position the message was posted at, or -1 if it was dropped.
+	SInt64			PostMessage( const channelMessage_t & msg );
+	void			WakeReader();
+
+	bool			IsShutdown;
+	const MessageChannelOverflow	Overflow;
+	UInt32			Mask;
+	slot_t *		Slots;
+
+	// Keeps the producers and the consumer from invalidating each other's cache line.
+	struct position_t
+	{
+		UByte				pad[64];
+		AtomicInt< UInt32 >	value;
+	};
+
+	// Post() claims Slots[Tail & Mask] by incrementing Tail, while the reader
+	// claims Slots[Head & Mask] through the slot sequence and then increments
+	// Head. The slot sequence tells whether the slot holds a message for the
+	// current lap of the ring.
+	position_t		Head;
+	position_t		Tail;
+
+	AtomicInt< int >	DroppedMessages;
+	AtomicInt< int >	CoalescedMessages;
+
+	// Position + 1 of the message that PostCoalesced() may overwrite for each
+	// key, 0 if there is none, or COALESCE_KEEP_NEXT.
+	AtomicInt< UInt32 >	CoalescePositions[MAX_COALESCING_KEYS];
+
+	// Only touched when the reader goes to sleep.
+	AtomicInt< int >	Sleeping;
+	pthread_mutex_t	Mutex;
+	pthread_cond_t	Wake;
+};
+
+// Logs the throughput and the post to receive latency of the MessageChannel
+// against the string MessageQueue with a couple of threads posting input events.
+// Registered as the "messageChannelBenchmark" console command, optional parms:
+// "<number of posting threads> <number of messages per thread>"
+void MessageChannelBenchmark( void * appPtr, const char * cmd );
+
+}	// namespace OVR
+
+#endif	// OVR_MessageChannel_h
@@ -12,13 +12,17 @@ Copyright   :   Copyright 2014 Oculus VR, LLC. All Rights reserved.
 #include "ModelFile.h"
 
 #include <math.h>
+#include <pthread.h>
 
 
 #include "Kernel/OVR_Alg.h"
 #include "Kernel/OVR_Math.h"
 #include "Kernel/OVR_Array.h"
+#include "Kernel/OVR_Atomic.h"
+#include "Kernel/OVR_Threads.h"
 #include "Kernel/OVR_String.h"
 #include "Kernel/OVR_String_Utils.h"
+#include "Kernel/OVR_Std.h"
 #include "OVR_JSON.h"
 #include "OVR_BinaryFile.h"
 #include "OVR_MappedFile.h"
@@ -27,6 +31,7 @@ Copyright   :   Copyright 2014 Oculus VR, LLC. All Rights reserved.
 #include "GlUtils.h"
 #include "GlTexture.h"
 #include "ModelRender.h"
+#include "ModelFileBinary.h"
 #include "Log.h"
 
 
@@ -139,17 +144,12 @@ Bounds3f ModelFile::GetBounds() const
 //	Model Loading
 //-----------------------------------------------------------------------------
 
-void LoadModelFileTexture( ModelFile & model, const char * textureName,
-							const char * buffer, const int size, const MaterialParms & materialParms )
+static void AddModelFileTexture( ModelFile & model, const char * textureName, const GlTexture texid )
 {
 	ModelTexture tex;
 	tex.name = textureName;
 	tex.name.StripExtension();
-    int width;
-    int height;
-	tex.texid = LoadTextureFromBuffer( textureName, MemBuffer( buffer, size ),
-			materialParms.UseSrgbTextureFormats ? TextureFlags_t( TEXTUREFLAG_USE_SRGB ) : TextureFlags_t(), 
-			width, height );
+	tex.texid = texid;
 
 	// LOG( ( tex.texid.target == GL_TEXTURE_CUBE_MAP ) ? "GL_TEXTURE_CUBE_MAP: %s" : "GL_TEXTURE_2D: %s", textureName );
 
@@ -163,6 +163,197 @@ void LoadModelFileTexture( ModelFile & model, const char * textureName,
 	model.Textures.PushBack( tex );
 }
 
+void LoadModelFileTexture( ModelFile & model, const char * textureName,
+							const char * buffer, const int size, const MaterialParms & materialParms )
+{
+    int width;
+    int height;
+	const GlTexture texid = LoadTextureFromBuffer( textureName, MemBuffer( buffer, size ),
+			materialParms.UseSrgbTextureFormats ? TextureFlags_t( TEXTUREFLAG_USE_SRGB ) : TextureFlags_t(), 
+			width, height );
+
+	AddModelFileTexture( model, textureName, texid );
+}
+
+//-----------------------------------------------------------------------------
+//	Texture decoding
+//-----------------------------------------------------------------------------
+
+/*
+	Inflating the texture files and walking their mip chains does not need GL,
+	so that is done by a pool of worker threads, after which the thread with
+	the GL context only has to upload the mip levels. The texture files are
+	uploaded in zip order, so the model textures end up in the same order as
+	when they were loaded one by one.
+
+	Deflated zip entries are inflated straight from the memory mapped zip,
+	because a single unzFile cannot be shared between threads.
+*/
+
+struct ModelTextureFile
+{
+	ModelTextureFile() :
+		compressed( NULL ),
+		compressedSize( 0 ),
+		crc( 0 ),
+		data( NULL ),
+		size( 0 ) {}
+
+	String					name;
+	const UByte *			compressed;		// raw deflate stream, NULL if the data is already available
+	int						compressedSize;
+	UInt32					crc;
+	const UByte *			data;
+	int						size;
+	Array< UByte >			inflated;		// data, if it is not referenced in place
+	TextureMipChain			mipChain;
+	MemBuffer				mipData;		// levels built for an image file, see FreeModelTextureFiles()
+};
+
+struct ModelTextureDecodeWorkers
+{
+	Array< ModelTextureFile * >	Files;
+	TextureFlags_t				Flags;
+	int							MipThreads;		// threads each worker may use to build the mip maps of an image
+	AtomicInt< int >			NextFile;
+};
+
+static bool InflateZipEntry( const UByte * compressed, const int compressedSize, const UInt32 crc,
+								UByte * data, const int size )
+{
+	z_stream stream;
+	memset( &stream, 0, sizeof( stream ) );
+	if ( inflateInit2( &stream, -MAX_WBITS ) != Z_OK )
+	{
+		return false;
+	}
+
+	stream.next_in = (Bytef *)compressed;
+	stream.avail_in = compressedSize;
+	stream.next_out = (Bytef *)data;
+	stream.avail_out = size;
+
+	const int result = inflate( &stream, Z_FINISH );
+	const int inflatedSize = (int)stream.total_out;
+	inflateEnd( &stream );
+
+	return ( result == Z_STREAM_END && inflatedSize == size && crc32( 0, data, size ) == crc );
+}
+
+static void DecodeModelTextureFile( ModelTextureFile & file, const TextureFlags_t & flags, const int mipThreads )
+{
+	if ( file.compressed != NULL )
+	{
+		file.inflated.Resize( file.size );
+		if ( !InflateZipEntry( file.compressed, file.compressedSize, file.crc, file.inflated.GetDataPtr(), file.size ) )
+		{
+			LOG( "Failed to inflate %s", file.name.ToCStr() );
+			file.inflated.ClearAndRelease();
+			file.data = NULL;
+			file.size = 0;
+			return;
+		}
+		file.data = file.inflated.GetDataPtr();
+	}
+
+	if ( !ParseTextureMipChain( file.name.ToCStr(), MemBuffer( file.data, file.size ), flags, file.mipChain ) )
+	{
+		DecodeTextureMipChain( file.name.ToCStr(), MemBuffer( file.data, file.size ), flags, mipThreads, file.mipChain, file.mipData );
+	}
+}
+
+static void * DecodeWorkerThread( void * parm )
+{
+	ModelTextureDecodeWorkers * workers = (ModelTextureDecodeWorkers *)parm;
+	for ( ; ; )
+	{
+		const int fileIndex = workers->NextFile.ExchangeAdd_Sync( 1 );
+		if ( fileIndex >= workers->Files.GetSizeI() )
+		{
+			break;
+		}
+		DecodeModelTextureFile( *workers->Files[fileIndex], workers->Flags, workers->MipThreads );
+	}
+	return NULL;
+}
+
+static bool TextureFileIsLarger( const ModelTextureFile * a, const ModelTextureFile * b )
+{
+	return a->size > b->size;
+}
+
+// Inflates and parses all texture files without making any GL calls.
+// The calling thread works on the files as well.
+static void DecodeModelTextureFiles( Array< ModelTextureFile > & textureFiles, const TextureFlags_t & flags, const int maxThreads )
+{
+	ModelTextureDecodeWorkers workers;
+	workers.Flags = flags;
+	workers.NextFile = 0;
+
+	// Start with the largest files so the work balances out.
+	for ( int i = 0; i < textureFiles.GetSizeI(); i++ )
+	{
+		workers.Files.PushBack( &textureFiles[i] );
+	}
+	Alg::QuickSort( workers.Files, TextureFileIsLarger );
+
+	const int numThreads = ( maxThreads > 0 ) ? maxThreads : Thread::GetCPUCount();
+	const int numWorkers = Alg::Min( numThreads, workers.Files.GetSizeI() ) - 1;
+
+	// Cores left over when there are fewer files than cores build the mip maps,
+	// instead of every worker starting a thread per core for them.
+	workers.MipThreads = Alg::Max( numThreads / Alg::Max( numWorkers + 1, 1 ), 1 );
+
+	Array< pthread_t > threads;
+	for ( int i = 0; i < numWorkers; i++ )
+	{
+		pthread_t thread;
+		const int createErr = pthread_create( &thread, NULL, DecodeWorkerThread, &workers );
+		if ( createErr != 0 )
+		{
+			LOG( "pthread_create returned %i", createErr );
+			break;
+		}
+		threads.PushBack( thread );
+	}
+
+	DecodeWorkerThread( &workers );
+
+	for ( int i = 0; i < threads.GetSizeI(); i++ )
+	{
+		pthread_join( threads[i], NULL );
+	}
+}
+
+static void FreeModelTextureFiles( Array< ModelTextureFile > & textureFiles )
+{
+	for ( int i = 0; i < textureFiles.GetSizeI(); i++ )
+	{
+		textureFiles[i].mipData.FreeData();
+	}
+	textureFiles.Clear();
+}
+
+// Uploads the decoded texture files, this needs the GL context.
+static void CreateModelTextures( ModelFile & model, const Array< ModelTextureFile > & textureFiles, const MaterialParms & materialParms )
+{
+	const TextureFlags_t flags = materialParms.UseSrgbTextureFormats ? TextureFlags_t( TEXTUREFLAG_USE_SRGB ) : TextureFlags_t();
+
+	for ( int i = 0; i < textureFiles.GetSizeI(); i++ )
+	{
+		const ModelTextureFile & file = textureFiles[i];
+		if ( file.mipChain.mipCount > 0 )
+		{
+			AddModelFileTexture( model, file.name.ToCStr(), CreateTextureFromMipChain( file.mipChain, flags ) );
+		}
+		else
+		{
+			// Let the regular path log the failure and create the default texture.
+			LoadModelFileTexture( model, file.name.ToCStr(), (const char *)file.data, file.size, materialParms );
+		}
+	}
+}
+
 template< typename _type_ >
 void ReadModelArray( Array< _type_ > & out, const char * string, const BinaryReader & bin, const int numElements )
 {
@@ -175,37 +366,36 @@ void ReadModelArray( Array< _type_ > & out, const char * string, const BinaryRea
 	}
 }
 
-void LoadModelFileJson( ModelFile & model,
+bool ParseModelFileJson( ModelFileSource & source, const char * fileName,
 						const char * modelsJson, const int modelsJsonLength,
-						const char * modelsBin, const int modelsBinLength,
-						const ModelGlPrograms & programs, const MaterialParms & materialParms )
+						const char * modelsBin, const int modelsBinLength )
 {
-	LOG( "parsing %s", model.FileName.ToCStr() );
+	LOG( "parsing %s", fileName );
 
 	const BinaryReader bin( (const UByte *)modelsBin, modelsBinLength );
 
 	if ( modelsBin != NULL && bin.ReadUInt32() != 0x6272766F )
 	{
-		LOG( "LoadModelFileJson: bad binary file for %s", model.FileName.ToCStr() );
-		return;
+		LOG( "ParseModelFileJson: bad binary file for %s", fileName );
+		return false;
 	}
 
 	const char * error = NULL;
-	JSON * json = JSON::Parse( modelsJson, & error );
-	if ( json == NULL )
+	JsonDocument json;
+	if ( !json.Parse( modelsJson, & error ) )
 	{
-		LOG( "LoadModelFileJson: Error loading %s : %s", model.FileName.ToCStr(), error );
-		return;
+		LOG( "ParseModelFileJson: Error loading %s : %s", fileName, error );
+		return false;
 	}
 
-	const JsonReader models( json );
+	const JsonNodeReader models( json.GetRoot() );
 	if ( models.IsObject() )
 	{
 		//
 		// Render Model
 		//
 
-		const JsonReader render_model( models.GetChildByName( "render_model" ) );
+		const JsonNodeReader render_model( models.GetChildByName( "render_model" ) );
 		if ( render_model.IsObject() )
 		{
 			LOG( "loading render model.." );
@@ -221,52 +411,21 @@ void LoadModelFileJson( ModelFile & model,
 				TEXTURE_OCCLUSION_TRANSPARENT
 			};
 
-			Array< GlTexture > glTextures;
-
-			const JsonReader texture_array( render_model.GetChildByName( "textures" ) );
+			const JsonNodeReader texture_array( render_model.GetChildByName( "textures" ) );
 			if ( texture_array.IsArray() )
 			{
 				while ( !texture_array.IsEndOfArray() )
 				{
-					const JsonReader texture( texture_array.GetNextArrayElement() );
+					const JsonNodeReader texture( texture_array.GetNextArrayElement() );
 					if ( texture.IsObject() )
 					{
-						const String name = texture.GetChildStringByName( "name" );
-
-						// Try to match the texture names with the already loaded texture
-						// and create a default texture if the texture file is missing.
-						int i = 0;
-						for ( ; i < model.Textures.GetSizeI(); i++ )
-						{
-							if ( model.Textures[i].name.CompareNoCase( name ) == 0 )
-							{
-								break;
-							}
-						}
-						if ( i == model.Textures.GetSizeI() )
-						{
-							LOG( "texture %s defaulted", name.ToCStr() );
-							// Create a default texture.
-							LoadModelFileTexture( model, name, NULL, 0, materialParms );
-						}
-						glTextures.PushBack( model.Textures[i].texid );
+						const UPInt index = source.Textures.AllocBack();
+						source.Textures[index].name = texture.GetChildStringByName( "name" );
 
 						const String usage = texture.GetChildStringByName( "usage" );
-						if ( usage == "diffuse" )
-						{
-							if ( materialParms.EnableDiffuseAniso == true )
-							{
-								MakeTextureAniso( model.Textures[i].texid, 2.0f );
-							}
-						}
-						else if ( usage == "emissive" )
-						{
-							if ( materialParms.EnableEmissiveLodClamp == true )
-							{
-								// LOD clamp lightmap textures to avoid light bleeding
-								MakeTextureLodClamped( model.Textures[i].texid, 1 );
-							}
-						}
+						source.Textures[index].usage = MODEL_TEXTURE_USAGE_NONE;
+						if ( usage == "diffuse" )			{ source.Textures[index].usage = MODEL_TEXTURE_USAGE_DIFFUSE; }
+						else if ( usage == "emissive" )		{ source.Textures[index].usage = MODEL_TEXTURE_USAGE_EMISSIVE; }
 						/*
 						const String occlusion = texture.GetChildStringByName( "occlusion" );
 
@@ -283,31 +442,31 @@ void LoadModelFileJson( ModelFile & model,
 			// Render Model Joints
 			//
 
-			const JsonReader joint_array( render_model.GetChildByName( "joints" ) );
+			const JsonNodeReader joint_array( render_model.GetChildByName( "joints" ) );
 			if ( joint_array.IsArray() )
 			{
-				model.Joints.Clear();
+				source.Joints.Clear();
 
 				while ( !joint_array.IsEndOfArray() )
 				{
-					const JsonReader joint( joint_array.GetNextArrayElement() );
+					const JsonNodeReader joint( joint_array.GetNextArrayElement() );
 					if ( joint.IsObject() )
 					{
-						const UPInt index = model.Joints.AllocBack();
-						model.Joints[index].index = index;
-						model.Joints[index].name = joint.GetChildStringByName( "name" );
-						StringUtils::StringTo( model.Joints[index].transform, joint.GetChildStringByName( "transform" ) );
-						model.Joints[index].animation = MODEL_JOINT_ANIMATION_NONE;
+						const UPInt index = source.Joints.AllocBack();
+						source.Joints[index].index = index;
+						source.Joints[index].name = joint.GetChildStringByName( "name" );
+						StringUtils::StringTo( source.Joints[index].transform, joint.GetChildStringByName( "transform" ) );
+						source.Joints[index].animation = MODEL_JOINT_ANIMATION_NONE;
 						const String animation = joint.GetChildStringByName( "animation" );
-						if ( animation == "none" )			{ model.Joints[index].animation = MODEL_JOINT_ANIMATION_NONE; }
-						else if ( animation == "rotate" )	{ model.Joints[index].animation = MODEL_JOINT_ANIMATION_ROTATE; }
-						else if ( animation == "sway" )		{ model.Joints[index].animation = MODEL_JOINT_ANIMATION_SWAY; }
-						else if ( animation == "bob" )		{ model.Joints[index].animation = MODEL_JOINT_ANIMATION_BOB; }
-						model.Joints[index].parameters.x = joint.GetChildFloatByName( "parmX" );
-						model.Joints[index].parameters.y = joint.GetChildFloatByName( "parmY" );
-						model.Joints[index].parameters.z = joint.GetChildFloatByName( "parmZ" );
-						model.Joints[index].timeOffset = joint.GetChildFloatByName( "timeOffset" );
-						model.Joints[index].timeScale = joint.GetChildFloatByName( "timeScale" );
+						if ( animation == "none" )			{ source.Joints[index].animation = MODEL_JOINT_ANIMATION_NONE; }
+						else if ( animation == "rotate" )	{ source.Joints[index].animation = MODEL_JOINT_ANIMATION_ROTATE; }
+						else if ( animation == "sway" )		{ source.Joints[index].animation = MODEL_JOINT_ANIMATION_SWAY; }
+						else if ( animation == "bob" )		{ source.Joints[index].animation = MODEL_JOINT_ANIMATION_BOB; }
+						source.Joints[index].parameters.x = joint.GetChildFloatByName( "parmX" );
+						source.Joints[index].parameters.y = joint.GetChildFloatByName( "parmY" );
+						source.Joints[index].parameters.z = joint.GetChildFloatByName( "parmZ" );
+						source.Joints[index].timeOffset = joint.GetChildFloatByName( "timeOffset" );
+						source.Joints[index].timeScale = joint.GetChildFloatByName( "timeScale" );
 					}
 				}
 			}
@@ -316,21 +475,21 @@ void LoadModelFileJson( ModelFile & model,
 			// Render Model Tags
 			//
 
-			const JsonReader tag_array( render_model.GetChildByName( "tags" ) );
+			const JsonNodeReader tag_array( render_model.GetChildByName( "tags" ) );
 			if ( tag_array.IsArray() )
 			{
-				model.Tags.Clear();
+				source.Tags.Clear();
 
 				while ( !tag_array.IsEndOfArray() )
 				{
-					const JsonReader tag( tag_array.GetNextArrayElement() );
+					const JsonNodeReader tag( tag_array.GetNextArrayElement() );
 					if ( tag.IsObject() )
 					{
-						const UPInt index = model.Tags.AllocBack();
-						model.Tags[index].name = tag.GetChildStringByName( "name" );
-						StringUtils::StringTo( model.Tags[index].matrix, 		tag.GetChildStringByName( "matrix" ) );
-						StringUtils::StringTo( model.Tags[index].jointIndices, 	tag.GetChildStringByName( "jointIndices" ) );
-						StringUtils::StringTo( model.Tags[index].jointWeights, 	tag.GetChildStringByName( "jointWeights" ) );
+						const UPInt index = source.Tags.AllocBack();
+						source.Tags[index].name = tag.GetChildStringByName( "name" );
+						StringUtils::StringTo( source.Tags[index].matrix, 		tag.GetChildStringByName( "matrix" ) );
+						StringUtils::StringTo( source.Tags[index].jointIndices, 	tag.GetChildStringByName( "jointIndices" ) );
+						StringUtils::StringTo( source.Tags[index].jointWeights, 	tag.GetChildStringByName( "jointWeights" ) );
 					}
 				}
 			}
@@ -339,83 +498,76 @@ void LoadModelFileJson( ModelFile & model,
 			// Render Model Surfaces
 			//
 
-			const JsonReader surface_array( render_model.GetChildByName( "surfaces" ) );
+			const JsonNodeReader surface_array( render_model.GetChildByName( "surfaces" ) );
 			if ( surface_array.IsArray() )
 			{
 				while ( !surface_array.IsEndOfArray() )
 				{
-					const JsonReader surface( surface_array.GetNextArrayElement() );
+					const JsonNodeReader surface( surface_array.GetNextArrayElement() );
 					if ( surface.IsObject() )
 					{
-						const UPInt index = model.Def.surfaces.AllocBack();
+						const UPInt index = source.Surfaces.AllocBack();
+						ModelSurfaceSource & surfaceSource = source.Surfaces[index];
 
 						//
 						// Source Meshes
 						//
 
-						const JsonReader source( surface.GetChildByName( "source" ) );
-						if ( source.IsArray() )
+						const JsonNodeReader sourceMeshes( surface.GetChildByName( "source" ) );
+						if ( sourceMeshes.IsArray() )
 						{
-							while ( !source.IsEndOfArray() )
+							while ( !sourceMeshes.IsEndOfArray() )
 							{
-								if ( model.Def.surfaces[index].surfaceName.GetLength() )
+								if ( surfaceSource.name.GetLength() )
 								{
-									model.Def.surfaces[index].surfaceName += ";";
+									surfaceSource.name += ";";
 								}
-								model.Def.surfaces[index].surfaceName += source.GetNextArrayString();
+								surfaceSource.name += sourceMeshes.GetNextArrayString();
 							}
 						}
 
-						LOGV( "surface %s", model.Def.surfaces[index].surfaceName.ToCStr() );
+						LOGV( "surface %s", surfaceSource.name.ToCStr() );
 
 						//
 						// Surface Material
 						//
 
-						enum
+						surfaceSource.materialType = MODEL_MATERIAL_TYPE_OPAQUE;
+						for ( int i = 0; i < MODEL_SURFACE_TEXTURE_MAX; i++ )
 						{
-							MATERIAL_TYPE_OPAQUE,
-							MATERIAL_TYPE_PERFORATED,
-							MATERIAL_TYPE_TRANSPARENT,
-							MATERIAL_TYPE_ADDITIVE
-						} materialType = MATERIAL_TYPE_OPAQUE;
-
-						int diffuseTextureIndex = -1;
-						int normalTextureIndex = -1;
-						int specularTextureIndex = -1;
-						int emissiveTextureIndex = -1;
-						int reflectionTextureIndex = -1;
-
-						const JsonReader material( surface.GetChildByName( "material" ) );
+							surfaceSource.textures[i] = -1;
+						}
+
+						const JsonNodeReader material( surface.GetChildByName( "material" ) );
 						if ( material.IsObject() )
 						{
 							const String type = material.GetChildStringByName( "type" );
 
-							if ( type == "opaque" )				{ materialType = MATERIAL_TYPE_OPAQUE; }
-							else if ( type == "perforated" )	{ materialType = MATERIAL_TYPE_PERFORATED; }
-							else if ( type == "transparent" )	{ materialType = MATERIAL_TYPE_TRANSPARENT; }
-							else if ( type == "additive" )		{ materialType = MATERIAL_TYPE_ADDITIVE; }
+							if ( type == "opaque" )				{ surfaceSource.materialType = MODEL_MATERIAL_TYPE_OPAQUE; }
+							else if ( type == "perforated" )	{ surfaceSource.materialType = MODEL_MATERIAL_TYPE_PERFORATED; }
+							else if ( type == "transparent" )	{ surfaceSource.materialType = MODEL_MATERIAL_TYPE_TRANSPARENT; }
+							else if ( type == "additive" )		{ surfaceSource.materialType = MODEL_MATERIAL_TYPE_ADDITIVE; }
 
-							diffuseTextureIndex		= material.GetChildInt32ByName( "diffuse", -1 );
-							normalTextureIndex		= material.GetChildInt32ByName( "normal", -1 );
-							specularTextureIndex	= material.GetChildInt32ByName( "specular", -1 );
-							emissiveTextureIndex	= material.GetChildInt32ByName( "emissive", -1 );
-							reflectionTextureIndex	= material.GetChildInt32ByName( "reflection", -1 );
+							surfaceSource.textures[MODEL_SURFACE_TEXTURE_DIFFUSE]		= material.GetChildInt32ByName( "diffuse", -1 );
+							surfaceSource.textures[MODEL_SURFACE_TEXTURE_NORMAL]		= material.GetChildInt32ByName( "normal", -1 );
+							surfaceSource.textures[MODEL_SURFACE_TEXTURE_SPECULAR]		= material.GetChildInt32ByName( "specular", -1 );
+							surfaceSource.textures[MODEL_SURFACE_TEXTURE_EMISSIVE]		= material.GetChildInt32ByName( "emissive", -1 );
+							surfaceSource.textures[MODEL_SURFACE_TEXTURE_REFLECTION]	= material.GetChildInt32ByName( "reflection", -1 );
 						}
 
 						//
 						// Surface Bounds
 						//
 
-						StringUtils::StringTo( model.Def.surfaces[index].cullingBounds, surface.GetChildStringByName( "bounds" ) );
+						StringUtils::StringTo( surfaceSource.bounds, surface.GetChildStringByName( "bounds" ) );
 
 						//
 						// Vertices
 						//
 
-						VertexAttribs attribs;
+						VertexAttribs & attribs = surfaceSource.attribs;
 
-						const JsonReader vertices( surface.GetChildByName( "vertices" ) );
+						const JsonNodeReader vertices( surface.GetChildByName( "vertices" ) );
 						if ( vertices.IsObject() )
 						{
 							const int vertexCount = Alg::Min( vertices.GetChildInt32ByName( "vertexCount" ), MAX_GEOMETRY_VERTICES );
@@ -436,210 +588,13 @@ void LoadModelFileJson( ModelFile & model,
 						// Triangles
 						//
 
-						Array< TriangleIndex > indices;
-
-						const JsonReader triangles( surface.GetChildByName( "triangles" ) );
+						const JsonNodeReader triangles( surface.GetChildByName( "triangles" ) );
 						if ( triangles.IsObject() )
 						{
 							const int indexCount = Alg::Min( triangles.GetChildInt32ByName( "indexCount" ), MAX_GEOMETRY_INDICES );
 							// LOG( "%5d indices", indexCount );
 
-							ReadModelArray( indices, triangles.GetChildStringByName( "indices" ), bin, indexCount );
-						}
-
-						//
-						// Setup geometry, textures and render programs now that the vertex attributes are known.
-						//
-
-						model.Def.surfaces[index].geo.Create( attribs, indices );
-
-						const char * materialTypeString = "opaque";
-						OVR_UNUSED( materialTypeString );	// we'll get warnings if the LOGV's compile out
-
-						// set up additional material flags for the surface
-						if ( materialType == MATERIAL_TYPE_PERFORATED )
-						{
-							// Just blend because alpha testing is rather expensive.
-							model.Def.surfaces[index].materialDef.gpuState.blendEnable = true;
-							model.Def.surfaces[index].materialDef.gpuState.depthMaskEnable = false;
-							model.Def.surfaces[index].materialDef.gpuState.blendSrc = GL_SRC_ALPHA;
-							model.Def.surfaces[index].materialDef.gpuState.blendDst = GL_ONE_MINUS_SRC_ALPHA;
-							materialTypeString = "perforated";
-						}
-						else if ( materialType == MATERIAL_TYPE_TRANSPARENT || materialParms.Transparent )
-						{
-							model.Def.surfaces[index].materialDef.gpuState.blendEnable = true;
-							model.Def.surfaces[index].materialDef.gpuState.depthMaskEnable = false;
-							model.Def.surfaces[index].materialDef.gpuState.blendSrc = GL_SRC_ALPHA;
-							model.Def.surfaces[index].materialDef.gpuState.blendDst = GL_ONE_MINUS_SRC_ALPHA;
-							materialTypeString = "transparent";
-						}
-						else if ( materialType == MATERIAL_TYPE_ADDITIVE )
-						{
-							model.Def.surfaces[index].materialDef.gpuState.blendEnable = true;
-							model.Def.surfaces[index].materialDef.gpuState.depthMaskEnable = false;
-							model.Def.surfaces[index].materialDef.gpuState.blendSrc = GL_ONE;
-							model.Def.surfaces[index].materialDef.gpuState.blendDst = GL_ONE;
-							materialTypeString = "additive";
-						}
-
-						const bool skinned = (	attribs.jointIndices.GetSize() == attribs.position.GetSize() &&
-												attribs.jointWeights.GetSize() == attribs.position.GetSize() );
-
-						if ( diffuseTextureIndex >= 0 && diffuseTextureIndex < glTextures.GetSizeI() )
-						{
-							model.Def.surfaces[index].materialDef.textures[0] = glTextures[diffuseTextureIndex];
-
-							if ( emissiveTextureIndex >= 0 && emissiveTextureIndex < glTextures.GetSizeI() )
-							{
-								model.Def.surfaces[index].materialDef.textures[1] = glTextures[emissiveTextureIndex];
-
-								if (	normalTextureIndex >= 0 && normalTextureIndex < glTextures.GetSizeI() &&
-										specularTextureIndex >= 0 && specularTextureIndex < glTextures.GetSizeI() &&
-										reflectionTextureIndex >= 0 && reflectionTextureIndex < glTextures.GetSizeI() )
-								{
-									// reflection mapped material;
-									model.Def.surfaces[index].materialDef.textures[2] = glTextures[normalTextureIndex];
-									model.Def.surfaces[index].materialDef.textures[3] = glTextures[specularTextureIndex];
-									model.Def.surfaces[index].materialDef.textures[4] = glTextures[reflectionTextureIndex];
-
-									model.Def.surfaces[index].materialDef.numTextures = 5;
-									if ( skinned )
-									{
-										if ( programs.ProgSkinnedReflectionMapped == NULL )
-										{
-											FAIL( "No ProgSkinnedReflectionMapped set");
-										}
-										model.Def.surfaces[index].materialDef.programObject = programs.ProgSkinnedReflectionMapped->program;
-										model.Def.surfaces[index].materialDef.uniformMvp = programs.ProgSkinnedReflectionMapped->uMvp;
-										model.Def.surfaces[index].materialDef.uniformModel = programs.ProgSkinnedReflectionMapped->uModel;
-										model.Def.surfaces[index].materialDef.uniformView = programs.ProgSkinnedReflectionMapped->uView;
-										model.Def.surfaces[index].materialDef.uniformJoints = programs.ProgSkinnedReflectionMapped->uJoints;
-										LOGV( "%s skinned reflection mapped material", materialTypeString );
-									}
-									else
-									{
-										if ( programs.ProgReflectionMapped == NULL )
-										{
-											FAIL( "No ProgReflectionMapped set");
-										}
-										model.Def.surfaces[index].materialDef.programObject = programs.ProgReflectionMapped->program;
-										model.Def.surfaces[index].materialDef.uniformMvp = programs.ProgReflectionMapped->uMvp;
-										model.Def.surfaces[index].materialDef.uniformModel = programs.ProgReflectionMapped->uModel;
-										model.Def.surfaces[index].materialDef.uniformView = programs.ProgReflectionMapped->uView;
-										LOGV( "%s reflection mapped material", materialTypeString );
-									}
-								}
-								else
-								{
-									// light mapped material
-									model.Def.surfaces[index].materialDef.numTextures = 2;
-									if ( skinned )
-									{
-										if ( programs.ProgSkinnedLightMapped == NULL )
-										{
-											FAIL( "No ProgSkinnedLightMapped set");
-										}
-										model.Def.surfaces[index].materialDef.programObject = programs.ProgSkinnedLightMapped->program;
-										model.Def.surfaces[index].materialDef.uniformMvp = programs.ProgSkinnedLightMapped->uMvp;
-										model.Def.surfaces[index].materialDef.uniformJoints = programs.ProgSkinnedLightMapped->uJoints;
-										LOGV( "%s skinned light mapped material", materialTypeString );
-									}
-									else
-									{
-										if ( programs.ProgLightMapped == NULL )
-										{
-											FAIL( "No ProgLightMapped set");
-										}
-										model.Def.surfaces[index].materialDef.programObject = programs.ProgLightMapped->program;
-										model.Def.surfaces[index].materialDef.uniformMvp = programs.ProgLightMapped->uMvp;
-										LOGV( "%s light mapped material", materialTypeString );
-									}
-								}
-							}
-							else 
-							{
-								// diffuse only material
-								model.Def.surfaces[index].materialDef.numTextures = 1;
-								if ( skinned )
-								{
-									if ( programs.ProgSkinnedSingleTexture == NULL )
-									{
-										FAIL( "No ProgSkinnedSingleTexture set");
-									}
-									model.Def.surfaces[index].materialDef.programObject = programs.ProgSkinnedSingleTexture->program;
-									model.Def.surfaces[index].materialDef.uniformMvp = programs.ProgSkinnedSingleTexture->uMvp;
-									model.Def.surfaces[index].materialDef.uniformJoints = programs.ProgSkinnedSingleTexture->uJoints;
-									LOGV( "%s skinned diffuse only material", materialTypeString );
-								}
-								else
-								{
-									if ( programs.ProgSingleTexture == NULL )
-									{
-										FAIL( "No ProgSingleTexture set");
-									}
-									model.Def.surfaces[index].materialDef.programObject = programs.ProgSingleTexture->program;
-									model.Def.surfaces[index].materialDef.uniformMvp = programs.ProgSingleTexture->uMvp;
-									LOGV( "%s diffuse only material", materialTypeString );
-								}
-							}
-						}
-						else if ( attribs.color.GetSizeI() > 0 )
-						{
-							// vertex color material
-							model.Def.surfaces[index].materialDef.numTextures = 0;
-							if ( skinned )
-							{
-								if ( programs.ProgSkinnedVertexColor == NULL )
-								{
-									FAIL( "No ProgSkinnedVertexColor set");
-								}
-								model.Def.surfaces[index].materialDef.programObject = programs.ProgSkinnedVertexColor->program;
-								model.Def.surfaces[index].materialDef.uniformMvp = programs.ProgSkinnedVertexColor->uMvp;
-								LOGV( "%s skinned vertex color material", materialTypeString );
-							}
-							else
-							{
-								if ( programs.ProgVertexColor == NULL )
-								{
-									FAIL( "No ProgVertexColor set");
-								}
-								model.Def.surfaces[index].materialDef.programObject = programs.ProgVertexColor->program;
-								model.Def.surfaces[index].materialDef.uniformMvp = programs.ProgVertexColor->uMvp;
-								LOGV( "%s vertex color material", materialTypeString );
-							}
-						}
-						else
-						{
-							// surface without texture or vertex colors
-							model.Def.surfaces[index].materialDef.textures[0] = 0;
-							model.Def.surfaces[index].materialDef.numTextures = 1;
-							if ( skinned )
-							{
-								if ( programs.ProgSkinnedSingleTexture == NULL )
-								{
-									FAIL( "No ProgSkinnedSingleTexture set");
-								}
-								model.Def.surfaces[index].materialDef.programObject = programs.ProgSkinnedSingleTexture->program;
-								model.Def.surfaces[index].materialDef.uniformMvp = programs.ProgSingleTexture->uMvp;
-								LOGV( "%s skinned default texture material", materialTypeString );
-							}
-							else
-							{
-								if ( programs.ProgSingleTexture == NULL )
-								{
-									FAIL( "No ProgSingleTexture set");
-								}
-								model.Def.surfaces[index].materialDef.programObject = programs.ProgSingleTexture->program;
-								model.Def.surfaces[index].materialDef.uniformMvp = programs.ProgSingleTexture->uMvp;
-								LOGV( "%s default texture material", materialTypeString );
-							}
-						}
-
-						if ( materialParms.PolygonOffset )
-						{
-							model.Def.surfaces[index].materialDef.gpuState.polygonOffsetEnable = true;
-							LOGV( "polygon offset material" );
+							ReadModelArray( surfaceSource.indices, triangles.GetChildStringByName( "indices" ), bin, indexCount );
 						}
 					}
 				}
@@ -650,20 +605,20 @@ void LoadModelFileJson( ModelFile & model,
 		// Collision Model
 		//
 
-		const JsonReader collision_model( models.GetChildByName( "collision_model" ) );
+		const JsonNodeReader collision_model( models.GetChildByName( "collision_model" ) );
 		if ( collision_model.IsArray() )
 		{
 			LOGV( "loading collision model.." );
 
 			while ( !collision_model.IsEndOfArray() )
 			{
-				const UPInt index = model.Collisions.Polytopes.AllocBack();
+				const UPInt index = source.Collisions.Polytopes.AllocBack();
 
-				const JsonReader polytope( collision_model.GetNextArrayElement() );
+				const JsonNodeReader polytope( collision_model.GetNextArrayElement() );
 				if ( polytope.IsObject() )
 				{
-					model.Collisions.Polytopes[index].Name = polytope.GetChildStringByName( "name" );
-					StringUtils::StringTo( model.Collisions.Polytopes[index].Planes, polytope.GetChildStringByName( "planes" ) );
+					source.Collisions.Polytopes[index].Name = polytope.GetChildStringByName( "name" );
+					StringUtils::StringTo( source.Collisions.Polytopes[index].Planes, polytope.GetChildStringByName( "planes" ) );
 				}
 			}
 		}
@@ -672,20 +627,20 @@ void LoadModelFileJson( ModelFile & model,
 		// Ground Collision Model
 		//
 
-		const JsonReader ground_collision_model( models.GetChildByName( "ground_collision_model" ) );
+		const JsonNodeReader ground_collision_model( models.GetChildByName( "ground_collision_model" ) );
 		if ( ground_collision_model.IsArray() )
 		{
 			LOGV( "loading ground collision model.." );
 
 			while ( !ground_collision_model.IsEndOfArray() )
 			{
-				const UPInt index = model.GroundCollisions.Polytopes.AllocBack();
+				const UPInt index = source.GroundCollisions.Polytopes.AllocBack();
 
-				const JsonReader polytope( ground_collision_model.GetNextArrayElement() );
+				const JsonNodeReader polytope( ground_collision_model.GetNextArrayElement() );
 				if ( polytope.IsObject() )
 				{
-					model.GroundCollisions.Polytopes[index].Name = polytope.GetChildStringByName( "name" );
-					StringUtils::StringTo( model.GroundCollisions.Polytopes[index].Planes, polytope.GetChildStringByName( "planes" ) );
+					source.GroundCollisions.Polytopes[index].Name = polytope.GetChildStringByName( "name" );
+					StringUtils::StringTo( source.GroundCollisions.Polytopes[index].Planes, polytope.GetChildStringByName( "planes" ) );
 				}
 			}
 		}
@@ -694,12 +649,12 @@ void LoadModelFileJson( ModelFile & model,
 		// Ray-Trace Model
 		//
 
-		const JsonReader raytrace_model( models.GetChildByName( "raytrace_model" ) );
+		const JsonNodeReader raytrace_model( models.GetChildByName( "raytrace_model" ) );
 		if ( raytrace_model.IsObject() )
 		{
 			LOGV( "loading ray-trace model.." );
 
-			RtTrace &traceModel = model.TraceModel;
+			RtTrace &traceModel = source.TraceModel;
 
 			traceModel.header.numVertices	= raytrace_model.GetChildInt32ByName( "numVertices" );
 			traceModel.header.numUvs		= raytrace_model.GetChildInt32ByName( "numUvs" );
@@ -716,14 +671,14 @@ void LoadModelFileJson( ModelFile & model,
 
 			if ( !bin.ReadArray( traceModel.nodes, traceModel.header.numNodes ) )
 			{
-				const JsonReader nodes_array( raytrace_model.GetChildByName( "nodes" ) );
+				const JsonNodeReader nodes_array( raytrace_model.GetChildByName( "nodes" ) );
 				if ( nodes_array.IsArray() )
 				{
 					while ( !nodes_array.IsEndOfArray() )
 					{
 						const UPInt index = traceModel.nodes.AllocBack();
 
-						const JsonReader node( nodes_array.GetNextArrayElement() );
+						const JsonNodeReader node( nodes_array.GetNextArrayElement() );
 						if ( node.IsObject() )
 						{
 							traceModel.nodes[index].data = (UInt32) node.GetChildInt64ByName( "data" );
@@ -735,14 +690,14 @@ void LoadModelFileJson( ModelFile & model,
 
 			if ( !bin.ReadArray( traceModel.leafs, traceModel.header.numLeafs ) )
 			{
-				const JsonReader leafs_array( raytrace_model.GetChildByName( "leafs" ) );
+				const JsonNodeReader leafs_array( raytrace_model.GetChildByName( "leafs" ) );
 				if ( leafs_array.IsArray() )
 				{
 					while ( !leafs_array.IsEndOfArray() )
 					{
 						const UPInt index = traceModel.leafs.AllocBack();
 
-						const JsonReader leaf( leafs_array.GetNextArrayElement() );
+						const JsonNodeReader leaf( leafs_array.GetNextArrayElement() );
 						if ( leaf.IsObject() )
 						{
 							StringUtils::StringTo( traceModel.leafs[index].triangles, RT_KDTREE_MAX_LEAF_TRIANGLES, leaf.GetChildStringByName( "triangles" ) );
@@ -756,20 +711,323 @@ void LoadModelFileJson( ModelFile & model,
 			ReadModelArray( traceModel.overflow, raytrace_model.GetChildStringByName( "overflow" ), bin, traceModel.header.numOverflow );
 		}
 	}
-	json->Release();
+	json.Clear();
 
 	if ( !bin.IsAtEnd() )
 	{
 		LOG( "failed to properly read binary file" );
 	}
+
+	return true;
 }
 
-static ModelFile * LoadModelFile( unzFile zfp, const char * fileName,
-								const char * fileData, const int fileDataLength,
-								const ModelGlPrograms & programs,
-								const MaterialParms & materialParms )
+// Looks up a texture referenced by the render model and creates a default
+// texture if the texture file is missing.
+static GlTexture SetupModelTexture( ModelFile & model, const char * name, const ModelTextureUsage usage,
+									const MaterialParms & materialParms )
 {
-	const LogCpuTime logTime( "LoadModelFile" );
+	// Try to match the texture names with the already loaded texture
+	// and create a default texture if the texture file is missing.
+	int i = 0;
+	for ( ; i < model.Textures.GetSizeI(); i++ )
+	{
+		if ( model.Textures[i].name.CompareNoCase( name ) == 0 )
+		{
+			break;
+		}
+	}
+	if ( i == model.Textures.GetSizeI() )
+	{
+		LOG( "texture %s defaulted", name );
+		// Create a default texture.
+		LoadModelFileTexture( model, name, NULL, 0, materialParms );
+	}
+
+	if ( usage == MODEL_TEXTURE_USAGE_DIFFUSE )
+	{
+		if ( materialParms.EnableDiffuseAniso == true )
+		{
+			MakeTextureAniso( model.Textures[i].texid, 2.0f );
+		}
+	}
+	else if ( usage == MODEL_TEXTURE_USAGE_EMISSIVE )
+	{
+		if ( materialParms.EnableEmissiveLodClamp == true )
+		{
+			// LOD clamp lightmap textures to avoid light bleeding
+			MakeTextureLodClamped( model.Textures[i].texid, 1 );
+		}
+	}
+
+	return model.Textures[i].texid;
+}
+
+// Sets up the textures and render program of a surface now that the vertex attributes are known.
+static void SetupSurfaceMaterial( SurfaceDef & surfaceDef, const ModelMaterialType materialType,
+								const int textures[MODEL_SURFACE_TEXTURE_MAX], const Array< GlTexture > & glTextures,
+								const bool skinned, const bool vertexColors,
+								const ModelGlPrograms & programs, const MaterialParms & materialParms )
+{
+	const int diffuseTextureIndex = textures[MODEL_SURFACE_TEXTURE_DIFFUSE];
+	const int normalTextureIndex = textures[MODEL_SURFACE_TEXTURE_NORMAL];
+	const int specularTextureIndex = textures[MODEL_SURFACE_TEXTURE_SPECULAR];
+	const int emissiveTextureIndex = textures[MODEL_SURFACE_TEXTURE_EMISSIVE];
+	const int reflectionTextureIndex = textures[MODEL_SURFACE_TEXTURE_REFLECTION];
+
+	MaterialDef & materialDef = surfaceDef.materialDef;
+
+	const char * materialTypeString = "opaque";
+	OVR_UNUSED( materialTypeString );	// we'll get warnings if the LOGV's compile out
+
+	// set up additional material flags for the surface
+	if ( materialType == MODEL_MATERIAL_TYPE_PERFORATED )
+	{
+		// Just blend because alpha testing is rather expensive.
+		materialDef.gpuState.blendEnable = true;
+		materialDef.gpuState.depthMaskEnable = false;
+		materialDef.gpuState.blendSrc = GL_SRC_ALPHA;
+		materialDef.gpuState.blendDst = GL_ONE_MINUS_SRC_ALPHA;
+		materialTypeString = "perforated";
+	}
+	else if ( materialType == MODEL_MATERIAL_TYPE_TRANSPARENT || materialParms.Transparent )
+	{
+		materialDef.gpuState.blendEnable = true;
+		materialDef.gpuState.depthMaskEnable = false;
+		materialDef.gpuState.blendSrc = GL_SRC_ALPHA;
+		materialDef.gpuState.blendDst = GL_ONE_MINUS_SRC_ALPHA;
+		materialTypeString = "transparent";
+	}
+	else if ( materialType == MODEL_MATERIAL_TYPE_ADDITIVE )
+	{
+		materialDef.gpuState.blendEnable = true;
+		materialDef.gpuState.depthMaskEnable = false;
+		materialDef.gpuState.blendSrc = GL_ONE;
+		materialDef.gpuState.blendDst = GL_ONE;
+		materialTypeString = "additive";
+	}
+
+	if ( diffuseTextureIndex >= 0 && diffuseTextureIndex < glTextures.GetSizeI() )
+	{
+		materialDef.textures[0] = glTextures[diffuseTextureIndex];
+
+		if ( emissiveTextureIndex >= 0 && emissiveTextureIndex < glTextures.GetSizeI() )
+		{
+			materialDef.textures[1] = glTextures[emissiveTextureIndex];
+
+			if (	normalTextureIndex >= 0 && normalTextureIndex < glTextures.GetSizeI() &&
+					specularTextureIndex >= 0 && specularTextureIndex < glTextures.GetSizeI() &&
+					reflectionTextureIndex >= 0 && reflectionTextureIndex < glTextures.GetSizeI() )
+			{
+				// reflection mapped material;
+				materialDef.textures[2] = glTextures[normalTextureIndex];
+				materialDef.textures[3] = glTextures[specularTextureIndex];
+				materialDef.textures[4] = glTextures[reflectionTextureIndex];
+
+				materialDef.numTextures = 5;
+				if ( skinned )
+				{
+					if ( programs.ProgSkinnedReflectionMapped == NULL )
+					{
+						FAIL( "No ProgSkinnedReflectionMapped set");
+					}
+					materialDef.programObject = programs.ProgSkinnedReflectionMapped->program;
+					materialDef.uniformMvp = programs.ProgSkinnedReflectionMapped->uMvp;
+					materialDef.uniformModel = programs.ProgSkinnedReflectionMapped->uModel;
+					materialDef.uniformView = programs.ProgSkinnedReflectionMapped->uView;
+					materialDef.uniformJoints = programs.ProgSkinnedReflectionMapped->uJoints;
+					LOGV( "%s skinned reflection mapped material", materialTypeString );
+				}
+				else
+				{
+					if ( programs.ProgReflectionMapped == NULL )
+					{
+						FAIL( "No ProgReflectionMapped set");
+					}
+					materialDef.programObject = programs.ProgReflectionMapped->program;
+					materialDef.uniformMvp = programs.ProgReflectionMapped->uMvp;
+					materialDef.uniformModel = programs.ProgReflectionMapped->uModel;
+					materialDef.uniformView = programs.ProgReflectionMapped->uView;
+					LOGV( "%s reflection mapped material", materialTypeString );
+				}
+			}
+			else
+			{
+				// light mapped material
+				materialDef.numTextures = 2;
+				if ( skinned )
+				{
+					if ( programs.ProgSkinnedLightMapped == NULL )
+					{
+						FAIL( "No ProgSkinnedLightMapped set");
+					}
+					materialDef.programObject = programs.ProgSkinnedLightMapped->program;
+					materialDef.uniformMvp = programs.ProgSkinnedLightMapped->uMvp;
+					materialDef.uniformJoints = programs.ProgSkinnedLightMapped->uJoints;
+					LOGV( "%s skinned light mapped material", materialTypeString );
+				}
+				else
+				{
+					if ( programs.ProgLightMapped == NULL )
+					{
+						FAIL( "No ProgLightMapped set");
+					}
+					materialDef.programObject = programs.ProgLightMapped->program;
+					materialDef.uniformMvp = programs.ProgLightMapped->uMvp;
+					LOGV( "%s light mapped material", materialTypeString );
+				}
+			}
+		}
+		else 
+		{
+			// diffuse only material
+			materialDef.numTextures = 1;
+			if ( skinned )
+			{
+				if ( programs.ProgSkinnedSingleTexture == NULL )
+				{
+					FAIL( "No ProgSkinnedSingleTexture set");
+				}
+				materialDef.programObject = programs.ProgSkinnedSingleTexture->program;
+				materialDef.uniformMvp = programs.ProgSkinnedSingleTexture->uMvp;
+				materialDef.uniformJoints = programs.ProgSkinnedSingleTexture->uJoints;
+				LOGV( "%s skinned diffuse only material", materialTypeString );
+			}
+			else
+			{
+				if ( programs.ProgSingleTexture == NULL )
+				{
+					FAIL( "No ProgSingleTexture set");
+				}
+				materialDef.programObject = programs.ProgSingleTexture->program;
+				materialDef.uniformMvp = programs.ProgSingleTexture->uMvp;
+				LOGV( "%s diffuse only material", materialTypeString );
+			}
+		}
+	}
+	else if ( vertexColors )
+	{
+		// vertex color material
+		materialDef.numTextures = 0;
+		if ( skinned )
+		{
+			if ( programs.ProgSkinnedVertexColor == NULL )
+			{
+				FAIL( "No ProgSkinnedVertexColor set");
+			}
+			materialDef.programObject = programs.ProgSkinnedVertexColor->program;
+			materialDef.uniformMvp = programs.ProgSkinnedVertexColor->uMvp;
+			LOGV( "%s skinned vertex color material", materialTypeString );
+		}
+		else
+		{
+			if ( programs.ProgVertexColor == NULL )
+			{
+				FAIL( "No ProgVertexColor set");
+			}
+			materialDef.programObject = programs.ProgVertexColor->program;
+			materialDef.uniformMvp = programs.ProgVertexColor->uMvp;
+			LOGV( "%s vertex color material", materialTypeString );
+		}
+	}
+	else
+	{
+		// surface without texture or vertex colors
+		materialDef.textures[0] = 0;
+		materialDef.numTextures = 1;
+		if ( skinned )
+		{
+			if ( programs.ProgSkinnedSingleTexture == NULL )
+			{
+				FAIL( "No ProgSkinnedSingleTexture set");
+			}
+			materialDef.programObject = programs.ProgSkinnedSingleTexture->program;
+			materialDef.uniformMvp = programs.ProgSingleTexture->uMvp;
+			LOGV( "%s skinned default texture material", materialTypeString );
+		}
+		else
+		{
+			if ( programs.ProgSingleTexture == NULL )
+			{
+				FAIL( "No ProgSingleTexture set");
+			}
+			materialDef.programObject = programs.ProgSingleTexture->program;
+			materialDef.uniformMvp = programs.ProgSingleTexture->uMvp;
+			LOGV( "%s default texture material", materialTypeString );
+		}
+	}
+
+	if ( materialParms.PolygonOffset )
+	{
+		materialDef.gpuState.polygonOffsetEnable = true;
+		LOGV( "polygon offset material" );
+	}
+}
+
+void LoadModelFileJson( ModelFile & model,
+						const char * modelsJson, const int modelsJsonLength,
+						const char * modelsBin, const int modelsBinLength,
+						const ModelGlPrograms & programs, const MaterialParms & materialParms )
+{
+	ModelFileSource source;
+	if ( !ParseModelFileJson( source, model.FileName.ToCStr(), modelsJson, modelsJsonLength, modelsBin, modelsBinLength ) )
+	{
+		return;
+	}
+
+	Array< GlTexture > glTextures;
+	for ( int i = 0; i < source.Textures.GetSizeI(); i++ )
+	{
+		glTextures.PushBack( SetupModelTexture( model, source.Textures[i].name.ToCStr(), source.Textures[i].usage, materialParms ) );
+	}
+
+	model.Joints = source.Joints;
+	model.Tags = source.Tags;
+
+	for ( int i = 0; i < source.Surfaces.GetSizeI(); i++ )
+	{
+		const ModelSurfaceSource & surfaceSource = source.Surfaces[i];
+		const VertexAttribs & attribs = surfaceSource.attribs;
+
+		const UPInt index = model.Def.surfaces.AllocBack();
+		SurfaceDef & surfaceDef = model.Def.surfaces[index];
+		surfaceDef.surfaceName = surfaceSource.name;
+		surfaceDef.cullingBounds = surfaceSource.bounds;
+		surfaceDef.geo.Create( attribs, surfaceSource.indices );
+
+		const bool skinned = (	attribs.jointIndices.GetSize() == attribs.position.GetSize() &&
+								attribs.jointWeights.GetSize() == attribs.position.GetSize() );
+
+		SetupSurfaceMaterial( surfaceDef, surfaceSource.materialType, surfaceSource.textures, glTextures,
+								skinned, attribs.color.GetSizeI() > 0, programs, materialParms );
+	}
+
+	BuildSurfaceBvh( model.Def );
+
+	model.Collisions = source.Collisions;
+	model.GroundCollisions = source.GroundCollisions;
+	model.TraceModel = source.TraceModel;
+}
+
+// The texture files are stored uncompressed, so the decode workers parse them in place.
+static void ReadModelBinTextureFiles( const modelBinHeader_t * header, Array< ModelTextureFile > & textureFiles )
+{
+	const modelBinTextureFile_t * binTextureFiles = ModelBinArray< modelBinTextureFile_t >( header, header->textureFiles );
+	textureFiles.Resize( header->textureFiles.count );
+	for ( UInt32 i = 0; i < header->textureFiles.count; i++ )
+	{
+		ModelTextureFile & file = textureFiles[i];
+		file.name = ModelBinString( header, binTextureFiles[i].name );
+		file.data = ModelBinArray< UByte >( header, binTextureFiles[i].data );
+		file.size = binTextureFiles[i].data.count;
+	}
+}
+
+ModelFile * LoadModelFileBinary( const char * fileName,
+		const void * buffer, int bufferLength,
+		const ModelGlPrograms & programs,
+		const MaterialParms & materialParms )
+{
+	const LogCpuTime logTime( "LoadModelFileBinary" );
 
 	ModelFile * modelPtr = new ModelFile;
 	ModelFile & model = *modelPtr;
@@ -777,19 +1035,74 @@ static ModelFile * LoadModelFile( unzFile zfp, const char * fileName,
 	model.FileName = fileName;
 	model.UsingSrgbTextures = materialParms.UseSrgbTextureFormats;
 
-	if ( !zfp )
+	const modelBinHeader_t * header = ValidateModelFileBinary( buffer, bufferLength );
+	if ( header == NULL )
 	{
 		LOG( "Error: can't load %s", fileName );
 		return modelPtr;
 	}
 
-	// load all texture files and locate the model files
+	Array< ModelTextureFile > textureFiles;
+	ReadModelBinTextureFiles( header, textureFiles );
 
-	const char * modelsJson = NULL;
-	int modelsJsonLength = 0;
+	const TextureFlags_t flags = materialParms.UseSrgbTextureFormats ? TextureFlags_t( TEXTUREFLAG_USE_SRGB ) : TextureFlags_t();
+	DecodeModelTextureFiles( textureFiles, flags, 0 );
 
-	const char * modelsBin = NULL;
-	int modelsBinLength = 0;
+	CreateModelTextures( model, textureFiles, materialParms );
+	FreeModelTextureFiles( textureFiles );
+
+	ReadModelFileBinary( model, header );
+
+	Array< GlTexture > glTextures;
+	const modelBinTexture_t * textures = ModelBinArray< modelBinTexture_t >( header, header->textures );
+	for ( UInt32 i = 0; i < header->textures.count; i++ )
+	{
+		glTextures.PushBack( SetupModelTexture( model, ModelBinString( header, textures[i].name ),
+												(ModelTextureUsage)textures[i].usage, materialParms ) );
+	}
+
+	const modelBinSurface_t * surfaces = ModelBinArray< modelBinSurface_t >( header, header->surfaces );
+	model.Def.surfaces.Resize( header->surfaces.count );
+	for ( UInt32 i = 0; i < header->surfaces.count; i++ )
+	{
+		const modelBinSurface_t & surface = surfaces[i];
+		SurfaceDef & surfaceDef = model.Def.surfaces[i];
+		surfaceDef.surfaceName = ModelBinString( header, surface.name );
+		surfaceDef.cullingBounds = surface.bounds;
+
+		PackedVertexAttribs attribs;
+		GetModelBinSurfaceVertices( header, surface, attribs );
+		surfaceDef.geo.Create( attribs, ModelBinArray< TriangleIndex >( header, surface.indices ), surface.indices.count );
+
+		int surfaceTextures[MODEL_SURFACE_TEXTURE_MAX];
+		for ( int j = 0; j < MODEL_SURFACE_TEXTURE_MAX; j++ )
+		{
+			surfaceTextures[j] = surface.textures[j];
+		}
+
+		SetupSurfaceMaterial( surfaceDef, (ModelMaterialType)surface.materialType, surfaceTextures, glTextures,
+								surface.skinned != 0, surface.vertexColors != 0, programs, materialParms );
+	}
+
+	BuildSurfaceBvh( model.Def );
+
+	return modelPtr;
+}
+
+// Locates the model files and collects the texture files. Stored and deflated
+// entries are referenced in place when the whole zip is in memory, anything
+// else is read here. Closes the zip.
+static void ReadModelZip( unzFile zfp, const char * fileName,
+							const char * fileData, const int fileDataLength,
+							Array< ModelTextureFile > & textureFiles,
+							const char * & modelsJson, int & modelsJsonLength,
+							const char * & modelsBin, int & modelsBinLength )
+{
+	modelsJson = NULL;
+	modelsJsonLength = 0;
+
+	modelsBin = NULL;
+	modelsBinLength = 0;
 
 	for ( int ret = unzGoToFirstFile( zfp ); ret == UNZ_OK; ret = unzGoToNextFile( zfp ) )
 	{
@@ -803,8 +1116,63 @@ static ModelFile * LoadModelFile( unzFile zfp, const char * fileName,
 			LOG( "Failed to open %s from %s", entryName, fileName );
 			continue;
 		}
-		
+
 		const int size = finfo.uncompressed_size;
+
+		// assume a 3 character extension
+		const size_t entryLength = strlen( entryName );
+		const char * extension = ( entryLength >= 4 ) ? &entryName[entryLength - 4] : entryName;
+
+		if (	strcasecmp( extension, ".pvr" ) == 0 ||
+				strcasecmp( extension, ".ktx" ) == 0 ||
+				strcasecmp( extension, ".png" ) == 0 ||
+				strcasecmp( extension, ".jpg" ) == 0 ||
+				strcasecmp( extension, ".tga" ) == 0 )
+		{
+			// .pvr and .ktx containers, and images that get their mip maps built by the decode workers
+			textureFiles.PushBack( ModelTextureFile() );
+			ModelTextureFile & file = textureFiles.Back();
+			file.name = entryName;
+			file.size = size;
+
+			const ZPOS64_T offset = unzGetCurrentFileZStreamPos64( zfp );
+			if ( fileData != NULL && finfo.compression_method == 0 && offset + size <= (ZPOS64_T)fileDataLength )
+			{
+				file.data = (const UByte *)fileData + offset;
+			}
+			else if ( fileData != NULL && finfo.compression_method == Z_DEFLATED && offset + finfo.compressed_size <= (ZPOS64_T)fileDataLength )
+			{
+				// inflated by the decode workers
+				file.compressed = (const UByte *)fileData + offset;
+				file.compressedSize = finfo.compressed_size;
+				file.crc = finfo.crc;
+			}
+			else
+			{
+				file.inflated.Resize( size );
+				if ( unzReadCurrentFile( zfp, file.inflated.GetDataPtr(), size ) != size )
+				{
+					LOG( "Failed to read %s from %s", entryName, fileName );
+					textureFiles.PopBack();
+					unzCloseCurrentFile( zfp );
+					continue;
+				}
+				file.data = file.inflated.GetDataPtr();
+			}
+
+			unzCloseCurrentFile( zfp );
+			continue;
+		}
+
+		if ( strcasecmp( entryName, "models.json" ) != 0 &&
+				strcasecmp( entryName, "models.bin" ) != 0 )
+		{
+			// ignore other files
+			LOG( "Ignoring %s", entryName );
+			unzCloseCurrentFile( zfp );
+			continue;
+		}
+
 		char * buffer = NULL;
 
 		if ( finfo.compression_method == 0 && fileData != NULL )
@@ -820,48 +1188,65 @@ static ModelFile * LoadModelFile( unzFile zfp, const char * fileName,
 			{
 				LOG( "Failed to read %s from %s", entryName, fileName );
 				delete [] buffer;
+				unzCloseCurrentFile( zfp );
 				continue;
 			}
 		}
 
-		// assume a 3 character extension
-		const size_t entryLength = strlen( entryName );
-		const char * extension = ( entryLength >= 4 ) ? &entryName[entryLength - 4] : entryName;
-
+		// save these for parsing
 		if ( strcasecmp( entryName, "models.json" ) == 0 )
 		{
-			// save this for parsing
 			modelsJson = (const char *)buffer;
 			modelsJsonLength = size;
-			buffer = NULL;	// don't free it now
 		}
-		else if ( strcasecmp( entryName, "models.bin" ) == 0 )
+		else
 		{
-			// save this for parsing
 			modelsBin = (const char *)buffer;
 			modelsBinLength = size;
-			buffer = NULL;	// don't free it now
-		}
-		else if (	strcasecmp( extension, ".pvr" ) == 0 ||
-					strcasecmp( extension, ".ktx" ) == 0 )
-		{
-			// only support .pvr and .ktx containers for now
-			LoadModelFileTexture( model, entryName, buffer, size, materialParms );
-		}
-		else
-		{
-			// ignore other files
-			LOG( "Ignoring %s", entryName );
-		}
-
-		if ( buffer < fileData || buffer > fileData + fileDataLength )
-		{
-			delete [] buffer;
 		}
 
 		unzCloseCurrentFile( zfp );
 	}
 	unzClose( zfp );
+}
+
+static ModelFile * LoadModelFile( unzFile zfp, const char * fileName,
+								const char * fileData, const int fileDataLength,
+								const ModelGlPrograms & programs,
+								const MaterialParms & materialParms )
+{
+	const LogCpuTime logTime( "LoadModelFile" );
+
+	ModelFile * modelPtr = new ModelFile;
+	ModelFile & model = *modelPtr;
+
+	model.FileName = fileName;
+	model.UsingSrgbTextures = materialParms.UseSrgbTextureFormats;
+
+	if ( !zfp )
+	{
+		LOG( "Error: can't load %s", fileName );
+		return modelPtr;
+	}
+
+	// locate the model files and decode all texture files on the worker threads
+
+	Array< ModelTextureFile > textureFiles;
+
+	const char * modelsJson = NULL;
+	int modelsJsonLength = 0;
+
+	const char * modelsBin = NULL;
+	int modelsBinLength = 0;
+
+	ReadModelZip( zfp, fileName, fileData, fileDataLength, textureFiles,
+					modelsJson, modelsJsonLength, modelsBin, modelsBinLength );
+
+	const TextureFlags_t flags = materialParms.UseSrgbTextureFormats ? TextureFlags_t( TEXTUREFLAG_USE_SRGB ) : TextureFlags_t();
+	DecodeModelTextureFiles( textureFiles, flags, 0 );
+
+	CreateModelTextures( model, textureFiles, materialParms );
+	FreeModelTextureFiles( textureFiles );
 
 	if ( modelsJson != NULL )
 	{
@@ -1034,6 +1419,11 @@ ModelFile * LoadModelFileFromMemory( const char * fileName,
 		const ModelGlPrograms & programs,
 		const MaterialParms & materialParms )
 {
+	if ( IsModelFileBinary( buffer, bufferLength ) )
+	{
+		return LoadModelFileBinary( fileName, buffer, bufferLength, programs, materialParms );
+	}
+
 	// Open the .ModelFile file as a zip.
 	LOG( "LoadModelFileFromMemory %s %i", fileName, bufferLength );
 
@@ -1066,6 +1456,12 @@ ModelFile * LoadModelFile( const char * fileName,
 		return new ModelFile( fileName );
 	}
 
+	// Binary model files are used in place, without unzipping anything.
+	if ( IsModelFileBinary( zlib_opaque.data, zlib_opaque.len ) )
+	{
+		return LoadModelFileBinary( fileName, zlib_opaque.data, zlib_opaque.len, programs, materialParms );
+	}
+
 	unzFile zfp = open_opaque( zlib_opaque, fileName );
 	if ( !zfp )
 	{
@@ -1075,6 +1471,228 @@ ModelFile * LoadModelFile( const char * fileName,
 	return LoadModelFile( zfp, fileName, (char *)zlib_opaque.data, zlib_opaque.len, programs, materialParms );
 }
 
+void ModelTextureDecodeBenchmark( void * appPtr, const char * cmd )
+{
+	OVR_UNUSED( appPtr );
+
+	char fileName[512];
+	int maxThreads = 0;
+	if ( sscanf( cmd, "%511s %i", fileName, &maxThreads ) < 1 )
+	{
+		LOG( "textureDecodeBenchmark: expected \"<.ovrscene or binary model file> [number of threads]\"" );
+		return;
+	}
+	if ( maxThreads <= 0 )
+	{
+		maxThreads = Thread::GetCPUCount();
+	}
+
+	zlib_mmap_opaque zlib_opaque;
+	if ( !mmap_open_opaque( fileName, zlib_opaque ) )
+	{
+		return;
+	}
+
+	const modelBinHeader_t * binHeader = NULL;
+	if ( IsModelFileBinary( zlib_opaque.data, zlib_opaque.len ) )
+	{
+		binHeader = ValidateModelFileBinary( zlib_opaque.data, zlib_opaque.len );
+		if ( binHeader == NULL )
+		{
+			return;
+		}
+	}
+
+	// Decode the same texture files with a single thread and with the worker pool.
+	double decodeTime[2] = {};
+	Array< ModelTextureFile > textureFiles[2];
+	for ( int pass = 0; pass < 2; pass++ )
+	{
+		if ( binHeader != NULL )
+		{
+			ReadModelBinTextureFiles( binHeader, textureFiles[pass] );
+
+			const double start = LogCpuTime::GetNanoSeconds();
+			DecodeModelTextureFiles( textureFiles[pass], TextureFlags_t(), ( pass == 0 ) ? 1 : maxThreads );
+			decodeTime[pass] = LogCpuTime::GetNanoSeconds() - start;
+			continue;
+		}
+
+		mem_set_opaque( zlib_opaque, zlib_opaque.data, zlib_opaque.len );
+		unzFile zfp = open_opaque( zlib_opaque, fileName );
+		if ( !zfp )
+		{
+			LOG( "textureDecodeBenchmark: %s is not a zip", fileName );
+			return;
+		}
+
+		const char * modelsJson = NULL;
+		int modelsJsonLength = 0;
+		const char * modelsBin = NULL;
+		int modelsBinLength = 0;
+		ReadModelZip( zfp, fileName, (const char *)zlib_opaque.data, zlib_opaque.len, textureFiles[pass],
+						modelsJson, modelsJsonLength, modelsBin, modelsBinLength );
+
+		const double start = LogCpuTime::GetNanoSeconds();
+		DecodeModelTextureFiles( textureFiles[pass], TextureFlags_t(), ( pass == 0 ) ? 1 : maxThreads );
+		decodeTime[pass] = LogCpuTime::GetNanoSeconds() - start;
+
+		if ( modelsJson < (const char *)zlib_opaque.data || modelsJson > (const char *)zlib_opaque.data + zlib_opaque.len )
+		{
+			delete modelsJson;
+		}
+		if ( modelsBin < (const char *)zlib_opaque.data || modelsBin > (const char *)zlib_opaque.data + zlib_opaque.len )
+		{
+			delete modelsBin;
+		}
+	}
+
+	int numFailed = 0;
+	int numMismatches = 0;
+	SInt64 inflatedBytes = 0;
+	SInt64 mipBytes = 0;
+	for ( int i = 0; i < textureFiles[0].GetSizeI(); i++ )
+	{
+		const TextureMipChain & serial = textureFiles[0][i].mipChain;
+		const TextureMipChain & parallel = textureFiles[1][i].mipChain;
+		numFailed += ( serial.mipCount == 0 );
+		bool match = ( serial.format == parallel.format && serial.width == parallel.width &&
+						serial.height == parallel.height && serial.mipCount == parallel.mipCount );
+		for ( int j = 0; match && j < serial.mipCount; j++ )
+		{
+			match = ( serial.mipSizes[j] == parallel.mipSizes[j] &&
+						memcmp( serial.mipLevels[j], parallel.mipLevels[j], serial.mipSizes[j] ) == 0 );
+			mipBytes += (SInt64)serial.mipSizes[j] * serial.faces;
+		}
+		numMismatches += !match;
+		inflatedBytes += textureFiles[0][i].inflated.GetSizeI();
+	}
+
+	LOG( "textureDecodeBenchmark: %s %d textures (%d failed), %1.1f MB inflated, %1.1f MB of mip levels",
+			fileName, textureFiles[0].GetSizeI(), numFailed, inflatedBytes / ( 1024.0 * 1024.0 ), mipBytes / ( 1024.0 * 1024.0 ) );
+	LOG( "textureDecodeBenchmark: 1 thread %1.2f ms, %d threads %1.2f ms, speedup %1.2fx, %d mismatches",
+			decodeTime[0] * 1e-6, maxThreads, decodeTime[1] * 1e-6,
+			decodeTime[0] / Alg::Max( decodeTime[1], 1.0 ), numMismatches );
+
+	FreeModelTextureFiles( textureFiles[0] );
+	FreeModelTextureFiles( textureFiles[1] );
+}
+
+void ModelLoadBenchmark( void * appPtr, const char * cmd )
+{
+	OVR_UNUSED( appPtr );
+
+	char zipFileName[512];
+	char binFileName[512];
+	const int numParms = sscanf( cmd, "%511s %511s", zipFileName, binFileName );
+	if ( numParms < 1 )
+	{
+		LOG( "modelLoadBenchmark: expected \"<.ovrscene file> [output binary model file]\"" );
+		return;
+	}
+	if ( numParms < 2 )
+	{
+		OVR_sprintf( binFileName, sizeof( binFileName ), "%s.bin", zipFileName );
+	}
+
+	if ( !ConvertModelFileToBinary( zipFileName, binFileName ) )
+	{
+		return;
+	}
+
+	// Both paths do everything LoadModelFile() does before it needs the GL context:
+	// the texture files are inflated and decoded, the joints, tags, collision and
+	// ray-trace model are read, and the surface vertices are packed. Uploading the
+	// same textures and vertices to GL costs the same for both, so it is left out.
+
+	const double zipStart = LogCpuTime::GetNanoSeconds();
+	int numZipTextures = 0;
+	int numZipSurfaces = 0;
+	{
+		zlib_mmap_opaque zlib_opaque;
+		unzFile zfp = mmap_open_opaque( zipFileName, zlib_opaque ) ? open_opaque( zlib_opaque, zipFileName ) : NULL;
+		if ( zfp )
+		{
+			Array< ModelTextureFile > textureFiles;
+			const char * modelsJson = NULL;
+			int modelsJsonLength = 0;
+			const char * modelsBin = NULL;
+			int modelsBinLength = 0;
+			ReadModelZip( zfp, zipFileName, (const char *)zlib_opaque.data, zlib_opaque.len, textureFiles,
+							modelsJson, modelsJsonLength, modelsBin, modelsBinLength );
+
+			DecodeModelTextureFiles( textureFiles, TextureFlags_t(), 0 );
+			numZipTextures = textureFiles.GetSizeI();
+			FreeModelTextureFiles( textureFiles );
+
+			ModelFileSource source;
+			if ( modelsJson != NULL && ParseModelFileJson( source, zipFileName, modelsJson, modelsJsonLength, modelsBin, modelsBinLength ) )
+			{
+				ModelFile model( zipFileName );
+				model.Joints = source.Joints;
+				model.Tags = source.Tags;
+				model.Collisions = source.Collisions;
+				model.GroundCollisions = source.GroundCollisions;
+				model.TraceModel = source.TraceModel;
+
+				Array< UByte > packedBuffer;
+				for ( int i = 0; i < source.Surfaces.GetSizeI(); i++ )
+				{
+					PackedVertexAttribs packed;
+					PackVertexAttribs( source.Surfaces[i].attribs, packedBuffer, packed );
+				}
+				numZipSurfaces = source.Surfaces.GetSizeI();
+			}
+
+			if ( modelsJson < (const char *)zlib_opaque.data || modelsJson > (const char *)zlib_opaque.data + zlib_opaque.len )
+			{
+				delete modelsJson;
+			}
+			if ( modelsBin < (const char *)zlib_opaque.data || modelsBin > (const char *)zlib_opaque.data + zlib_opaque.len )
+			{
+				delete modelsBin;
+			}
+		}
+	}
+	const double zipEnd = LogCpuTime::GetNanoSeconds();
+
+	int numBinTextures = 0;
+	int numBinSurfaces = 0;
+	{
+		zlib_mmap_opaque zlib_opaque;
+		const modelBinHeader_t * header = mmap_open_opaque( binFileName, zlib_opaque ) ?
+				ValidateModelFileBinary( zlib_opaque.data, zlib_opaque.len ) : NULL;
+		if ( header != NULL )
+		{
+			Array< ModelTextureFile > textureFiles;
+			ReadModelBinTextureFiles( header, textureFiles );
+
+			DecodeModelTextureFiles( textureFiles, TextureFlags_t(), 0 );
+			numBinTextures = textureFiles.GetSizeI();
+			FreeModelTextureFiles( textureFiles );
+
+			// The joints, tags, collision and ray-trace model are copied into the
+			// model the same way, only the surface vertices are used in place.
+			ModelFile model( binFileName );
+			ReadModelFileBinary( model, header );
+
+			const modelBinSurface_t * surfaces = ModelBinArray< modelBinSurface_t >( header, header->surfaces );
+			for ( UInt32 i = 0; i < header->surfaces.count; i++ )
+			{
+				PackedVertexAttribs packed;
+				GetModelBinSurfaceVertices( header, surfaces[i], packed );
+			}
+			numBinSurfaces = header->surfaces.count;
+		}
+	}
+	const double binEnd = LogCpuTime::GetNanoSeconds();
+
+	LOG( "modelLoadBenchmark: %s zip + JSON %1.2f ms (%d textures, %d surfaces), binary %1.2f ms (%d textures, %d surfaces), speedup %1.1fx",
+			zipFileName, ( zipEnd - zipStart ) * 1e-6, numZipTextures, numZipSurfaces,
+			( binEnd - zipEnd ) * 1e-6, numBinTextures, numBinSurfaces,
+			( zipEnd - zipStart ) / Alg::Max( binEnd - zipEnd, 1.0 ) );
+}
+
 #else	// !MEMORY_MAPPED
 
 struct mzBuffer_t
@@ -1151,6 +1769,11 @@ ModelFile * LoadModelFileFromMemory( const char * fileName,
 		const ModelGlPrograms & programs,
 		const MaterialParms & materialParms )
 {
+	if ( IsModelFileBinary( buffer, bufferLength ) )
+	{
+		return LoadModelFileBinary( fileName, buffer, bufferLength, programs, materialParms );
+	}
+
 	// Open the .ModelFile file as a zip.
 	LOG( "LoadModelFileFromMemory %s %i", fileName, bufferLength );
 
@@ -1184,6 +1807,20 @@ ModelFile * LoadModelFile( const char * fileName,
 	return LoadModelFile( zfp, fileName, NULL, 0, programs, materialParms );
 }
 
+void ModelTextureDecodeBenchmark( void * appPtr, const char * cmd )
+{
+	OVR_UNUSED( appPtr );
+	OVR_UNUSED( cmd );
+	LOG( "textureDecodeBenchmark: requires MEMORY_MAPPED" );
+}
+
+void ModelLoadBenchmark( void * appPtr, const char * cmd )
+{
+	OVR_UNUSED( appPtr );
+	OVR_UNUSED( cmd );
+	LOG( "modelLoadBenchmark: requires MEMORY_MAPPED" );
+}
+
 #endif	// MEMORY_MAPPED
 
 } // namespace OVR
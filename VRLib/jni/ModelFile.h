@@ -161,10 +161,20 @@ ModelFile * LoadModelFileFromMemory( const char * fileName,
 		const ModelGlPrograms & programs,
 		const MaterialParms & materialParms );
 
+// The file may be an .ovrscene zip or a binary model file, see ModelFileBinary.h.
+// The texture files in a zip are inflated and parsed on worker threads, only the
+// upload happens on the calling thread, which needs to have the GL context.
 ModelFile * LoadModelFile( const char * fileName,
 		const ModelGlPrograms & programs,
 		const MaterialParms & materialParms );
 
+// Inflates and parses the texture files of an .ovrscene or a binary model file without
+// making any GL calls, once on the calling thread and once with the worker threads,
+// and logs both times.
+// Registered as the "textureDecodeBenchmark" console command, parms:
+// "<.ovrscene or binary model file> [number of threads]"
+void ModelTextureDecodeBenchmark( void * appPtr, const char * cmd );
+
 } // namespace OVR
 
 #endif	// MODELFILE_H
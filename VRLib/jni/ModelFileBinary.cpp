@@ -0,0 +1,687 @@
+/************************************************************************************
+
+Filename    :   ModelFileBinary.cpp
+Content     :   Memory mappable binary model file format.
+Created     :   October, 2026
+
+Copyright   :   Copyright 2014 Oculus VR, LLC. All Rights reserved.
+
+*************************************************************************************/
+
+#include "ModelFileBinary.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include "Kernel/OVR_Array.h"
+#include "Kernel/OVR_String.h"
+
+#include "unzip.h"
+#include "MemBuffer.h"
+#include "Log.h"
+
+namespace OVR {
+
+//-----------------------------------------------------------------------------
+//	Reading
+//-----------------------------------------------------------------------------
+
+bool IsModelFileBinary( const void * buffer, const int bufferLength )
+{
+	return ( buffer != NULL && bufferLength >= (int)sizeof( UInt32 ) && *(const UInt32 *)buffer == MODEL_BINARY_MAGIC );
+}
+
+static bool ValidArray( const modelBinHeader_t * header, const modelBinArray_t & array, const UInt32 elementSize )
+{
+	if ( elementSize > 1 && ( array.offset & 3 ) != 0 )
+	{
+		return false;
+	}
+	if ( array.offset > header->fileSize || array.count > ( header->fileSize - array.offset ) / elementSize )
+	{
+		return false;
+	}
+	return true;
+}
+
+static bool ValidString( const modelBinHeader_t * header, const modelBinArray_t & array )
+{
+	return ValidArray( header, array, 1 ) && array.offset + array.count < header->fileSize &&
+			ModelBinString( header, array )[array.count] == '\0';
+}
+
+static bool ValidPolytopes( const modelBinHeader_t * header, const modelBinArray_t & array )
+{
+	if ( !ValidArray( header, array, sizeof( modelBinPolytope_t ) ) )
+	{
+		return false;
+	}
+	const modelBinPolytope_t * polytopes = ModelBinArray< modelBinPolytope_t >( header, array );
+	for ( UInt32 i = 0; i < array.count; i++ )
+	{
+		if ( !ValidString( header, polytopes[i].name ) || !ValidArray( header, polytopes[i].planes, sizeof( Planef ) ) )
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+// The packed attribute arrays have to be inside the vertex data, and the indices have
+// to reference the vertices, because both are handed to GL without looking at them.
+static bool ValidSurfaceGeometry( const modelBinHeader_t * header, const modelBinSurface_t & surface )
+{
+	// The JSON loader clamps to the same limits, so a converted file never exceeds them.
+	if ( surface.vertexCount < 0 || surface.vertexCount > MAX_GEOMETRY_VERTICES ||
+			surface.indices.count > (UInt32)MAX_GEOMETRY_INDICES )
+	{
+		return false;
+	}
+	for ( int i = 0; i < MAX_PACKED_VERTEX_ATTRIBS; i++ )
+	{
+		const SInt32 offset = surface.attribOffsets[i];
+		if ( offset == -1 )
+		{
+			continue;
+		}
+		if ( offset < 0 || (UInt64)offset + (UInt64)surface.vertexCount * PackedVertexAttribStride( i ) > surface.vertexData.count )
+		{
+			return false;
+		}
+	}
+	const TriangleIndex * indices = ModelBinArray< TriangleIndex >( header, surface.indices );
+	for ( UInt32 i = 0; i < surface.indices.count; i++ )
+	{
+		if ( indices[i] >= surface.vertexCount )
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+static bool ValidTraceTriangle( const modelBinHeader_t * header, const int triangle )
+{
+	return ( triangle >= 0 && (UInt32)triangle < header->traceIndices.count / 3 );
+}
+
+// RtTrace::Trace() walks the KD-Tree without any checks, so every node, leaf, rope,
+// triangle and overflow reference has to be inside the arrays, and the header counts
+// have to match them. Children always come after their parent, which also keeps the
+// descent to a leaf from looping. Overflow lists hold triangles up to a -1.
+static bool ValidTrace( const modelBinHeader_t * header )
+{
+	const kdtree_header_t & traceHeader = header->traceHeader;
+	if ( traceHeader.numVertices != (int)header->traceVertices.count ||
+			traceHeader.numUvs != (int)header->traceUvs.count ||
+			traceHeader.numIndices != (int)header->traceIndices.count ||
+			traceHeader.numNodes != (int)header->traceNodes.count ||
+			traceHeader.numLeafs != (int)header->traceLeafs.count ||
+			traceHeader.numOverflow != (int)header->traceOverflow.count )
+	{
+		return false;
+	}
+	if ( header->traceUvs.count != header->traceVertices.count || header->traceIndices.count % 3 != 0 )
+	{
+		return false;
+	}
+
+	const int * traceIndices = ModelBinArray< int >( header, header->traceIndices );
+	for ( UInt32 i = 0; i < header->traceIndices.count; i++ )
+	{
+		if ( traceIndices[i] < 0 || (UInt32)traceIndices[i] >= header->traceVertices.count )
+		{
+			return false;
+		}
+	}
+
+	const kdtree_node_t * nodes = ModelBinArray< kdtree_node_t >( header, header->traceNodes );
+	for ( UInt32 i = 0; i < header->traceNodes.count; i++ )
+	{
+		const UInt32 index = nodes[i].data >> 3;
+		if ( ( nodes[i].data & 1 ) != 0 )
+		{
+			if ( index >= header->traceLeafs.count )
+			{
+				return false;
+			}
+		}
+		else if ( ( ( nodes[i].data >> 1 ) & 3 ) == 3 || index <= i || index + 1 >= header->traceNodes.count )
+		{
+			return false;
+		}
+	}
+
+	const kdtree_leaf_t * leafs = ModelBinArray< kdtree_leaf_t >( header, header->traceLeafs );
+	for ( UInt32 i = 0; i < header->traceLeafs.count; i++ )
+	{
+		for ( int j = 0; j < RT_KDTREE_MAX_LEAF_TRIANGLES; j++ )
+		{
+			const int triangle = leafs[i].triangles[j];
+			if ( triangle == -1 )
+			{
+				break;
+			}
+			if ( triangle < 0 )
+			{
+				// Trace() takes the first overflow entry without checking for the end of the list.
+				const UInt32 offset = (UInt32)( triangle & 0x7FFFFFFF );
+				if ( offset >= header->traceOverflow.count || ModelBinArray< int >( header, header->traceOverflow )[offset] == -1 )
+				{
+					return false;
+				}
+				break;
+			}
+			if ( !ValidTraceTriangle( header, triangle ) )
+			{
+				return false;
+			}
+		}
+		for ( int j = 0; j < 6; j++ )
+		{
+			const int rope = leafs[i].ropes[j];
+			if ( rope != -1 && ( rope < 0 || (UInt32)rope >= header->traceNodes.count ) )
+			{
+				return false;
+			}
+		}
+	}
+
+	const int * overflow = ModelBinArray< int >( header, header->traceOverflow );
+	for ( UInt32 i = 0; i < header->traceOverflow.count; i++ )
+	{
+		if ( overflow[i] != -1 && !ValidTraceTriangle( header, overflow[i] ) )
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+const modelBinHeader_t * ValidateModelFileBinary( const void * buffer, const int bufferLength )
+{
+	if ( !IsModelFileBinary( buffer, bufferLength ) || bufferLength < (int)sizeof( modelBinHeader_t ) )
+	{
+		LOG( "ValidateModelFileBinary: not a binary model file" );
+		return NULL;
+	}
+
+	const modelBinHeader_t * header = (const modelBinHeader_t *)buffer;
+	if ( header->version != MODEL_BINARY_VERSION || header->headerSize != sizeof( modelBinHeader_t ) )
+	{
+		LOG( "ValidateModelFileBinary: version %d, expected %d", header->version, MODEL_BINARY_VERSION );
+		return NULL;
+	}
+	if ( header->fileSize != (UInt32)bufferLength )
+	{
+		LOG( "ValidateModelFileBinary: file size %d, expected %d", bufferLength, header->fileSize );
+		return NULL;
+	}
+
+	bool valid =	ValidArray( header, header->textureFiles, sizeof( modelBinTextureFile_t ) ) &&
+					ValidArray( header, header->textures, sizeof( modelBinTexture_t ) ) &&
+					ValidArray( header, header->joints, sizeof( modelBinJoint_t ) ) &&
+					ValidArray( header, header->tags, sizeof( modelBinTag_t ) ) &&
+					ValidArray( header, header->surfaces, sizeof( modelBinSurface_t ) ) &&
+					ValidPolytopes( header, header->collision ) &&
+					ValidPolytopes( header, header->groundCollision ) &&
+					ValidArray( header, header->traceVertices, sizeof( Vector3f ) ) &&
+					ValidArray( header, header->traceUvs, sizeof( Vector2f ) ) &&
+					ValidArray( header, header->traceIndices, sizeof( int ) ) &&
+					ValidArray( header, header->traceNodes, sizeof( kdtree_node_t ) ) &&
+					ValidArray( header, header->traceLeafs, sizeof( kdtree_leaf_t ) ) &&
+					ValidArray( header, header->traceOverflow, sizeof( int ) );
+
+	const modelBinTextureFile_t * textureFiles = ModelBinArray< modelBinTextureFile_t >( header, header->textureFiles );
+	for ( UInt32 i = 0; valid && i < header->textureFiles.count; i++ )
+	{
+		valid = ValidString( header, textureFiles[i].name ) && ValidArray( header, textureFiles[i].data, 1 );
+	}
+
+	const modelBinTexture_t * textures = ModelBinArray< modelBinTexture_t >( header, header->textures );
+	for ( UInt32 i = 0; valid && i < header->textures.count; i++ )
+	{
+		valid = ValidString( header, textures[i].name );
+	}
+
+	const modelBinJoint_t * joints = ModelBinArray< modelBinJoint_t >( header, header->joints );
+	for ( UInt32 i = 0; valid && i < header->joints.count; i++ )
+	{
+		valid = ValidString( header, joints[i].name );
+	}
+
+	const modelBinTag_t * tags = ModelBinArray< modelBinTag_t >( header, header->tags );
+	for ( UInt32 i = 0; valid && i < header->tags.count; i++ )
+	{
+		valid = ValidString( header, tags[i].name );
+	}
+
+	const modelBinSurface_t * surfaces = ModelBinArray< modelBinSurface_t >( header, header->surfaces );
+	for ( UInt32 i = 0; valid && i < header->surfaces.count; i++ )
+	{
+		valid = ValidString( header, surfaces[i].name ) &&
+				ValidArray( header, surfaces[i].vertexData, 1 ) &&
+				ValidArray( header, surfaces[i].indices, sizeof( TriangleIndex ) ) &&
+				ValidSurfaceGeometry( header, surfaces[i] );
+	}
+
+	valid = valid && ValidTrace( header );
+
+	if ( !valid )
+	{
+		LOG( "ValidateModelFileBinary: corrupt binary model file" );
+		return NULL;
+	}
+
+	return header;
+}
+
+static void ReadPolytopes( CollisionModel & collisionModel, const modelBinHeader_t * header, const modelBinArray_t & array )
+{
+	const modelBinPolytope_t * polytopes = ModelBinArray< modelBinPolytope_t >( header, array );
+	collisionModel.Polytopes.Resize( array.count );
+	for ( UInt32 i = 0; i < array.count; i++ )
+	{
+		CollisionPolytope & polytope = collisionModel.Polytopes[i];
+		polytope.Name = ModelBinString( header, polytopes[i].name );
+		polytope.Planes.Resize( polytopes[i].planes.count );
+		if ( polytopes[i].planes.count > 0 )
+		{
+			memcpy( &polytope.Planes[0], ModelBinArray< Planef >( header, polytopes[i].planes ), polytopes[i].planes.count * sizeof( Planef ) );
+		}
+	}
+}
+
+template< typename _type_ >
+static void ReadArray( Array< _type_ > & out, const modelBinHeader_t * header, const modelBinArray_t & array )
+{
+	out.Resize( array.count );
+	if ( array.count > 0 )
+	{
+		memcpy( &out[0], ModelBinArray< _type_ >( header, array ), array.count * sizeof( _type_ ) );
+	}
+}
+
+void ReadModelFileBinary( ModelFile & model, const modelBinHeader_t * header )
+{
+	const modelBinJoint_t * joints = ModelBinArray< modelBinJoint_t >( header, header->joints );
+	model.Joints.Resize( header->joints.count );
+	for ( UInt32 i = 0; i < header->joints.count; i++ )
+	{
+		ModelJoint & joint = model.Joints[i];
+		joint.index = i;
+		joint.name = ModelBinString( header, joints[i].name );
+		joint.transform = joints[i].transform;
+		joint.animation = (ModelJointAnimation)joints[i].animation;
+		joint.parameters = joints[i].parameters;
+		joint.timeOffset = joints[i].timeOffset;
+		joint.timeScale = joints[i].timeScale;
+	}
+
+	const modelBinTag_t * tags = ModelBinArray< modelBinTag_t >( header, header->tags );
+	model.Tags.Resize( header->tags.count );
+	for ( UInt32 i = 0; i < header->tags.count; i++ )
+	{
+		ModelTag & tag = model.Tags[i];
+		tag.name = ModelBinString( header, tags[i].name );
+		tag.matrix = tags[i].matrix;
+		tag.jointIndices = tags[i].jointIndices;
+		tag.jointWeights = tags[i].jointWeights;
+	}
+
+	ReadPolytopes( model.Collisions, header, header->collision );
+	ReadPolytopes( model.GroundCollisions, header, header->groundCollision );
+
+	RtTrace & traceModel = model.TraceModel;
+	traceModel.header = header->traceHeader;
+	ReadArray( traceModel.vertices, header, header->traceVertices );
+	ReadArray( traceModel.uvs, header, header->traceUvs );
+	ReadArray( traceModel.indices, header, header->traceIndices );
+	ReadArray( traceModel.nodes, header, header->traceNodes );
+	ReadArray( traceModel.leafs, header, header->traceLeafs );
+	ReadArray( traceModel.overflow, header, header->traceOverflow );
+}
+
+void GetModelBinSurfaceVertices( const modelBinHeader_t * header, const modelBinSurface_t & surface, PackedVertexAttribs & attribs )
+{
+	attribs.data = ModelBinArray< UByte >( header, surface.vertexData );
+	attribs.size = surface.vertexData.count;
+	attribs.vertexCount = surface.vertexCount;
+	for ( int i = 0; i < MAX_PACKED_VERTEX_ATTRIBS; i++ )
+	{
+		attribs.offsets[i] = surface.attribOffsets[i];
+	}
+}
+
+//-----------------------------------------------------------------------------
+//	Writing
+//-----------------------------------------------------------------------------
+
+class ModelBinaryWriter
+{
+public:
+	ModelBinaryWriter()
+	{
+		Buffer.Resize( sizeof( modelBinHeader_t ) );
+		memset( &Buffer[0], 0, Buffer.GetSize() );
+	}
+
+	modelBinArray_t Write( const void * data, const int elementSize, const int count )
+	{
+		const int oldSize = Buffer.GetSizeI();
+		const int offset = ( oldSize + MODEL_BINARY_ALIGNMENT - 1 ) & ~( MODEL_BINARY_ALIGNMENT - 1 );
+		const int size = elementSize * count;
+		Buffer.Resize( offset + size );
+		if ( offset > oldSize )
+		{
+			memset( &Buffer[oldSize], 0, offset - oldSize );
+		}
+		if ( size > 0 )
+		{
+			memcpy( &Buffer[offset], data, size );
+		}
+
+		modelBinArray_t array;
+		array.offset = offset;
+		array.count = count;
+		return array;
+	}
+
+	template< typename _type_ >
+	modelBinArray_t WriteArray( const Array< _type_ > & array )
+	{
+		return Write( array.GetDataPtr(), sizeof( _type_ ), array.GetSizeI() );
+	}
+
+	modelBinArray_t WriteString( const char * string )
+	{
+		const int length = (int)strlen( string );
+		modelBinArray_t array = Write( string, 1, length + 1 );
+		array.count = length;
+		return array;
+	}
+
+	// Copies the header to the front of the buffer.
+	void Finish( modelBinHeader_t & header )
+	{
+		header.magic = MODEL_BINARY_MAGIC;
+		header.version = MODEL_BINARY_VERSION;
+		header.fileSize = Buffer.GetSizeI();
+		header.headerSize = sizeof( modelBinHeader_t );
+		memcpy( &Buffer[0], &header, sizeof( header ) );
+	}
+
+	Array< UByte >	Buffer;
+};
+
+static modelBinArray_t WritePolytopes( ModelBinaryWriter & writer, const CollisionModel & collisionModel )
+{
+	Array< modelBinPolytope_t > polytopes;
+	polytopes.Resize( collisionModel.Polytopes.GetSize() );
+	for ( int i = 0; i < collisionModel.Polytopes.GetSizeI(); i++ )
+	{
+		polytopes[i].name = writer.WriteString( collisionModel.Polytopes[i].Name.ToCStr() );
+		polytopes[i].planes = writer.WriteArray( collisionModel.Polytopes[i].Planes );
+	}
+	return writer.WriteArray( polytopes );
+}
+
+struct ModelZipEntry
+{
+	String			Name;
+	Array< UByte >	Data;
+};
+
+// Reads every entry of the zip file into memory, text files are zero terminated.
+static bool ReadZipEntries( const char * zipFileName, Array< ModelZipEntry > & entries )
+{
+	unzFile zfp = unzOpen( zipFileName );
+	if ( !zfp )
+	{
+		LOG( "Error: can't open %s", zipFileName );
+		return false;
+	}
+
+	for ( int ret = unzGoToFirstFile( zfp ); ret == UNZ_OK; ret = unzGoToNextFile( zfp ) )
+	{
+		unz_file_info finfo;
+		char entryName[256];
+		unzGetCurrentFileInfo( zfp, &finfo, entryName, sizeof( entryName ), NULL, 0, NULL, 0 );
+
+		if ( unzOpenCurrentFile( zfp ) != UNZ_OK )
+		{
+			LOG( "Failed to open %s from %s", entryName, zipFileName );
+			continue;
+		}
+
+		const int size = finfo.uncompressed_size;
+		const UPInt index = entries.AllocBack();
+		entries[index].Name = entryName;
+		entries[index].Data.Resize( size + 1 );
+		entries[index].Data[size] = '\0';	// always zero terminate text files
+
+		if ( unzReadCurrentFile( zfp, &entries[index].Data[0], size ) != size )
+		{
+			LOG( "Failed to read %s from %s", entryName, zipFileName );
+			entries.RemoveAt( index );
+		}
+
+		unzCloseCurrentFile( zfp );
+	}
+	unzClose( zfp );
+
+	return true;
+}
+
+// Returns the models.json / models.bin entries and all texture files.
+static void ClassifyZipEntries( const Array< ModelZipEntry > & entries,
+								const ModelZipEntry * & modelsJson, const ModelZipEntry * & modelsBin,
+								Array< const ModelZipEntry * > & textureFiles )
+{
+	modelsJson = NULL;
+	modelsBin = NULL;
+	textureFiles.Clear();
+
+	for ( int i = 0; i < entries.GetSizeI(); i++ )
+	{
+		const char * entryName = entries[i].Name.ToCStr();
+
+		// assume a 3 character extension
+		const size_t entryLength = strlen( entryName );
+		const char * extension = ( entryLength >= 4 ) ? &entryName[entryLength - 4] : entryName;
+
+		if ( strcasecmp( entryName, "models.json" ) == 0 )
+		{
+			modelsJson = &entries[i];
+		}
+		else if ( strcasecmp( entryName, "models.bin" ) == 0 )
+		{
+			modelsBin = &entries[i];
+		}
+		else if (	strcasecmp( extension, ".pvr" ) == 0 ||
+					strcasecmp( extension, ".ktx" ) == 0 ||
+					strcasecmp( extension, ".png" ) == 0 ||
+					strcasecmp( extension, ".jpg" ) == 0 ||
+					strcasecmp( extension, ".tga" ) == 0 )
+		{
+			// the same files ReadModelZip hands to the texture decode workers
+			textureFiles.PushBack( &entries[i] );
+		}
+	}
+}
+
+static bool ParseZipEntries( const char * zipFileName, const Array< ModelZipEntry > & entries,
+							ModelFileSource & source, Array< const ModelZipEntry * > & textureFiles )
+{
+	const ModelZipEntry * modelsJson = NULL;
+	const ModelZipEntry * modelsBin = NULL;
+	ClassifyZipEntries( entries, modelsJson, modelsBin, textureFiles );
+
+	if ( modelsJson == NULL )
+	{
+		LOG( "Error: no models.json in %s", zipFileName );
+		return false;
+	}
+
+	// The entries are zero terminated, which is not part of the data.
+	return ParseModelFileJson( source, zipFileName,
+			(const char *)modelsJson->Data.GetDataPtr(), modelsJson->Data.GetSizeI() - 1,
+			modelsBin ? (const char *)modelsBin->Data.GetDataPtr() : NULL, modelsBin ? modelsBin->Data.GetSizeI() - 1 : 0 );
+}
+
+static void WriteModelFileBinary( ModelBinaryWriter & writer, const ModelFileSource & source,
+								const Array< const ModelZipEntry * > & textureFiles )
+{
+	modelBinHeader_t header;
+	memset( &header, 0, sizeof( header ) );
+
+	Array< modelBinTextureFile_t > binTextureFiles;
+	binTextureFiles.Resize( textureFiles.GetSize() );
+	for ( int i = 0; i < textureFiles.GetSizeI(); i++ )
+	{
+		binTextureFiles[i].name = writer.WriteString( textureFiles[i]->Name.ToCStr() );
+		binTextureFiles[i].data = writer.Write( textureFiles[i]->Data.GetDataPtr(), 1, textureFiles[i]->Data.GetSizeI() - 1 );
+	}
+	header.textureFiles = writer.WriteArray( binTextureFiles );
+
+	Array< modelBinTexture_t > binTextures;
+	binTextures.Resize( source.Textures.GetSize() );
+	for ( int i = 0; i < source.Textures.GetSizeI(); i++ )
+	{
+		binTextures[i].name = writer.WriteString( source.Textures[i].name.ToCStr() );
+		binTextures[i].usage = source.Textures[i].usage;
+	}
+	header.textures = writer.WriteArray( binTextures );
+
+	Array< modelBinJoint_t > binJoints;
+	binJoints.Resize( source.Joints.GetSize() );
+	for ( int i = 0; i < source.Joints.GetSizeI(); i++ )
+	{
+		const ModelJoint & joint = source.Joints[i];
+		binJoints[i].name = writer.WriteString( joint.name.ToCStr() );
+		binJoints[i].transform = joint.transform;
+		binJoints[i].animation = joint.animation;
+		binJoints[i].parameters = joint.parameters;
+		binJoints[i].timeOffset = joint.timeOffset;
+		binJoints[i].timeScale = joint.timeScale;
+	}
+	header.joints = writer.WriteArray( binJoints );
+
+	Array< modelBinTag_t > binTags;
+	binTags.Resize( source.Tags.GetSize() );
+	for ( int i = 0; i < source.Tags.GetSizeI(); i++ )
+	{
+		const ModelTag & tag = source.Tags[i];
+		binTags[i].name = writer.WriteString( tag.name.ToCStr() );
+		binTags[i].matrix = tag.matrix;
+		binTags[i].jointIndices = tag.jointIndices;
+		binTags[i].jointWeights = tag.jointWeights;
+	}
+	header.tags = writer.WriteArray( binTags );
+
+	Array< modelBinSurface_t > binSurfaces;
+	binSurfaces.Resize( source.Surfaces.GetSize() );
+	Array< UByte > packedBuffer;
+	for ( int i = 0; i < source.Surfaces.GetSizeI(); i++ )
+	{
+		const ModelSurfaceSource & surface = source.Surfaces[i];
+		const VertexAttribs & attribs = surface.attribs;
+		modelBinSurface_t & binSurface = binSurfaces[i];
+
+		PackedVertexAttribs packed;
+		PackVertexAttribs( attribs, packedBuffer, packed );
+
+		binSurface.name = writer.WriteString( surface.name.ToCStr() );
+		binSurface.bounds = surface.bounds;
+		binSurface.materialType = surface.materialType;
+		for ( int j = 0; j < MODEL_SURFACE_TEXTURE_MAX; j++ )
+		{
+			binSurface.textures[j] = surface.textures[j];
+		}
+		binSurface.skinned = (	attribs.jointIndices.GetSize() == attribs.position.GetSize() &&
+								attribs.jointWeights.GetSize() == attribs.position.GetSize() );
+		binSurface.vertexColors = ( attribs.color.GetSizeI() > 0 );
+		binSurface.vertexCount = packed.vertexCount;
+		for ( int j = 0; j < MAX_PACKED_VERTEX_ATTRIBS; j++ )
+		{
+			binSurface.attribOffsets[j] = packed.offsets[j];
+		}
+		binSurface.vertexData = writer.Write( packed.data, 1, packed.size );
+		binSurface.indices = writer.WriteArray( surface.indices );
+	}
+	header.surfaces = writer.WriteArray( binSurfaces );
+
+	header.collision = WritePolytopes( writer, source.Collisions );
+	header.groundCollision = WritePolytopes( writer, source.GroundCollisions );
+
+	const RtTrace & traceModel = source.TraceModel;
+	header.traceHeader = traceModel.header;
+	header.traceVertices = writer.WriteArray( traceModel.vertices );
+	header.traceUvs = writer.WriteArray( traceModel.uvs );
+	header.traceIndices = writer.WriteArray( traceModel.indices );
+	header.traceNodes = writer.WriteArray( traceModel.nodes );
+	header.traceLeafs = writer.WriteArray( traceModel.leafs );
+	header.traceOverflow = writer.WriteArray( traceModel.overflow );
+
+	writer.Finish( header );
+}
+
+bool ConvertModelFileToBinary( const char * zipFileName, const char * binFileName )
+{
+	LOG( "ConvertModelFileToBinary %s -> %s", zipFileName, binFileName );
+
+	Array< ModelZipEntry > entries;
+	if ( !ReadZipEntries( zipFileName, entries ) )
+	{
+		return false;
+	}
+
+	ModelFileSource source;
+	Array< const ModelZipEntry * > textureFiles;
+	if ( !ParseZipEntries( zipFileName, entries, source, textureFiles ) )
+	{
+		return false;
+	}
+
+	ModelBinaryWriter writer;
+	WriteModelFileBinary( writer, source, textureFiles );
+
+	FILE * f = fopen( binFileName, "wb" );
+	if ( f == NULL )
+	{
+		LOG( "ConvertModelFileToBinary: failed to open %s", binFileName );
+		return false;
+	}
+	const bool written = ( fwrite( writer.Buffer.GetDataPtr(), writer.Buffer.GetSize(), 1, f ) == 1 );
+	fclose( f );
+
+	if ( !written )
+	{
+		LOG( "ConvertModelFileToBinary: failed to write %s", binFileName );
+		return false;
+	}
+
+	LOG( "ConvertModelFileToBinary: wrote %d bytes, %d textures, %d surfaces",
+			writer.Buffer.GetSizeI(), textureFiles.GetSizeI(), source.Surfaces.GetSizeI() );
+	return true;
+}
+
+//-----------------------------------------------------------------------------
+//	Console commands
+//-----------------------------------------------------------------------------
+
+void ModelConvertCommand( void * appPtr, const char * cmd )
+{
+	OVR_UNUSED( appPtr );
+
+	char zipFileName[512];
+	char binFileName[512];
+	if ( sscanf( cmd, "%511s %511s", zipFileName, binFileName ) != 2 )
+	{
+		LOG( "modelConvert: expected \"<.ovrscene file> <output binary model file>\"" );
+		return;
+	}
+	ConvertModelFileToBinary( zipFileName, binFileName );
+}
+
+}	// namespace OVR
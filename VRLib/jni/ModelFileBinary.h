@@ -0,0 +1,228 @@
+/************************************************************************************
+
+Filename    :   ModelFileBinary.h
+Content     :   Memory mappable binary model file format.
+Created     :   October, 2026
+
+Copyright   :   Copyright 2014 Oculus VR, LLC. All Rights reserved.
+
+*************************************************************************************/
+
+#ifndef MODELFILEBINARY_H
+#define MODELFILEBINARY_H
+
+#include "ModelFile.h"
+
+namespace OVR {
+
+/*
+	The .ovrscene zip stores the model as models.json, optionally with the large
+	arrays in models.bin, next to the texture files. Loading it means inflating
+	every entry and parsing all of the JSON, which dominates the scene load time.
+
+	The binary model file holds exactly the same data in a flat layout that is
+	used in place after memory mapping it. Everything is referenced with offsets
+	from the start of the file, and all arrays are aligned, so the only work at
+	load time is validating the offsets and handing the data to GL. The vertex
+	data of each surface is stored pre-packed the way GlGeometry uploads it.
+
+	All values are little endian, just like the devices that load them.
+	Any change to the layout of these structures must bump the version.
+*/
+
+static const UInt32 MODEL_BINARY_MAGIC		= 0x6D72766F;	// "ovrm"
+static const UInt32 MODEL_BINARY_VERSION	= 1;
+static const int MODEL_BINARY_ALIGNMENT		= 16;
+
+enum ModelMaterialType
+{
+	MODEL_MATERIAL_TYPE_OPAQUE,
+	MODEL_MATERIAL_TYPE_PERFORATED,
+	MODEL_MATERIAL_TYPE_TRANSPARENT,
+	MODEL_MATERIAL_TYPE_ADDITIVE
+};
+
+enum ModelTextureUsage
+{
+	MODEL_TEXTURE_USAGE_NONE,
+	MODEL_TEXTURE_USAGE_DIFFUSE,
+	MODEL_TEXTURE_USAGE_EMISSIVE
+};
+
+enum ModelSurfaceTexture
+{
+	MODEL_SURFACE_TEXTURE_DIFFUSE,
+	MODEL_SURFACE_TEXTURE_NORMAL,
+	MODEL_SURFACE_TEXTURE_SPECULAR,
+	MODEL_SURFACE_TEXTURE_EMISSIVE,
+	MODEL_SURFACE_TEXTURE_REFLECTION,
+	MODEL_SURFACE_TEXTURE_MAX
+};
+
+// Strings are zero terminated, the count does not include the terminator.
+struct modelBinArray_t
+{
+	UInt32			offset;		// from the start of the file
+	UInt32			count;		// number of elements
+};
+
+// Texture file (.pvr, .ktx, .png, .jpg or .tga) as it was stored in the .ovrscene zip.
+struct modelBinTextureFile_t
+{
+	modelBinArray_t	name;
+	modelBinArray_t	data;
+};
+
+// Texture referenced by the render model.
+struct modelBinTexture_t
+{
+	modelBinArray_t	name;
+	SInt32			usage;		// ModelTextureUsage
+};
+
+struct modelBinJoint_t
+{
+	modelBinArray_t	name;
+	Matrix4f		transform;
+	SInt32			animation;	// ModelJointAnimation
+	Vector3f		parameters;
+	float			timeOffset;
+	float			timeScale;
+};
+
+struct modelBinTag_t
+{
+	modelBinArray_t	name;
+	Matrix4f		matrix;
+	Vector4i		jointIndices;
+	Vector4f		jointWeights;
+};
+
+struct modelBinSurface_t
+{
+	modelBinArray_t	name;
+	Bounds3f		bounds;
+	SInt32			materialType;		// ModelMaterialType
+	SInt32			textures[MODEL_SURFACE_TEXTURE_MAX];	// index into the render model textures or -1
+	SInt32			skinned;
+	SInt32			vertexColors;
+	SInt32			vertexCount;
+	SInt32			attribOffsets[MAX_PACKED_VERTEX_ATTRIBS];	// see PackedVertexAttribs
+	modelBinArray_t	vertexData;			// UByte
+	modelBinArray_t	indices;			// TriangleIndex
+};
+
+struct modelBinPolytope_t
+{
+	modelBinArray_t	name;
+	modelBinArray_t	planes;				// Planef
+};
+
+struct modelBinHeader_t
+{
+	UInt32			magic;
+	UInt32			version;
+	UInt32			fileSize;
+	UInt32			headerSize;
+
+	modelBinArray_t	textureFiles;		// modelBinTextureFile_t
+	modelBinArray_t	textures;			// modelBinTexture_t
+	modelBinArray_t	joints;				// modelBinJoint_t
+	modelBinArray_t	tags;				// modelBinTag_t
+	modelBinArray_t	surfaces;			// modelBinSurface_t
+	modelBinArray_t	collision;			// modelBinPolytope_t
+	modelBinArray_t	groundCollision;	// modelBinPolytope_t
+
+	kdtree_header_t	traceHeader;
+	modelBinArray_t	traceVertices;		// Vector3f
+	modelBinArray_t	traceUvs;			// Vector2f
+	modelBinArray_t	traceIndices;		// int
+	modelBinArray_t	traceNodes;			// kdtree_node_t
+	modelBinArray_t	traceLeafs;			// kdtree_leaf_t
+	modelBinArray_t	traceOverflow;		// int
+};
+
+// CPU side contents of models.json and models.bin, before anything is created in GL.
+struct ModelTextureSource
+{
+	String				name;
+	ModelTextureUsage	usage;
+};
+
+struct ModelSurfaceSource
+{
+	String				name;
+	Bounds3f			bounds;
+	ModelMaterialType	materialType;
+	int					textures[MODEL_SURFACE_TEXTURE_MAX];
+	VertexAttribs		attribs;
+	Array< TriangleIndex >	indices;
+};
+
+struct ModelFileSource
+{
+	Array< ModelTextureSource >	Textures;
+	Array< ModelJoint >			Joints;
+	Array< ModelTag >			Tags;
+	Array< ModelSurfaceSource >	Surfaces;
+	CollisionModel				Collisions;
+	CollisionModel				GroundCollisions;
+	RtTrace						TraceModel;
+};
+
+// Parses models.json, with the large arrays optionally stored in models.bin.
+// Returns false if either file is invalid.
+bool ParseModelFileJson( ModelFileSource & source, const char * fileName,
+		const char * modelsJson, const int modelsJsonLength,
+		const char * modelsBin, const int modelsBinLength );
+
+// Returns true if the buffer starts with a binary model file header.
+bool IsModelFileBinary( const void * buffer, const int bufferLength );
+
+// Checks the header and that every array is inside the buffer.
+// Returns NULL if the buffer is not a valid binary model file.
+const modelBinHeader_t * ValidateModelFileBinary( const void * buffer, const int bufferLength );
+
+// Arrays are referenced in place, the header is at the start of the file.
+template< typename _type_ >
+inline const _type_ * ModelBinArray( const modelBinHeader_t * header, const modelBinArray_t & array )
+{
+	return ( array.count > 0 ) ? (const _type_ *)( (const UByte *)header + array.offset ) : NULL;
+}
+
+inline const char * ModelBinString( const modelBinHeader_t * header, const modelBinArray_t & array )
+{
+	return (const char *)header + array.offset;
+}
+
+// Reads everything that does not need GL: joints, tags, collision and the ray-trace model.
+void ReadModelFileBinary( ModelFile & model, const modelBinHeader_t * header );
+
+// Points the packed vertex attributes at the surface vertices in the file.
+void GetModelBinSurfaceVertices( const modelBinHeader_t * header, const modelBinSurface_t & surface, PackedVertexAttribs & attribs );
+
+// Creates the model from a binary model file, which is normally memory mapped
+// by LoadModelFile(), but may be any buffer that stays valid during the call.
+ModelFile * LoadModelFileBinary( const char * fileName,
+		const void * buffer, int bufferLength,
+		const ModelGlPrograms & programs,
+		const MaterialParms & materialParms );
+
+// Converts an .ovrscene zip into a binary model file, including all textures.
+// Nothing is created in GL, so this can run on any thread.
+bool ConvertModelFileToBinary( const char * zipFileName, const char * binFileName );
+
+// Converts the given .ovrscene and logs the time it takes to get from the file
+// to data that is ready for GL with both the zip + JSON and the binary path,
+// including the texture decode. Defined in ModelFile.cpp next to the loaders.
+// Registered as the "modelLoadBenchmark" console command, parms:
+// "<.ovrscene file> [output binary model file]"
+void ModelLoadBenchmark( void * appPtr, const char * cmd );
+
+// Registered as the "modelConvert" console command, parms:
+// "<.ovrscene file> <output binary model file>"
+void ModelConvertCommand( void * appPtr, const char * cmd );
+
+}	// namespace OVR
+
+#endif	// MODELFILEBINARY_H
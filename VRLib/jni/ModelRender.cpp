@@ -12,6 +12,15 @@ Copyright   :   Copyright 2014 Oculus VR, LLC. All Rights reserved.
 #include "ModelRender.h"
 
 #include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+#if defined( OVR_CPU_SSE )
+#include <xmmintrin.h>
+#elif defined( OVR_CPU_ARM_NEON )
+#include <arm_neon.h>
+#endif
 
 #include "GlUtils.h"
 #include "GlTexture.h"
@@ -103,7 +112,7 @@ float BoundsSortCullKey( const Bounds3f & bounds, const Matrix4f & mvp ) {
 		return 0;
 	}
 
-	// Not very efficient code...
+	// Not very efficient code, BuildDrawSurfaceList() culls four bounds at a time instead.
 	for ( int i = 0; i < 8; i++ ) {
 		Vector4f world;
 		world.x = bounds.b[(i&1)].x;
@@ -178,75 +187,494 @@ float BoundsSortCullKey( const Bounds3f & bounds, const Matrix4f & mvp ) {
 	return maxW;		// couldn't cull
 }
 
-struct bsort_t
+/*
+	The surfaces are culled four at a time. Every clip plane test on the
+	transformed corners, like "x > -w", is a plane in model space: w + x is
+	linear in the corner position, so all eight corners are on the wrong side
+	exactly when the corner that maximizes w + x is. That corner follows from
+	the signs of the plane normal, so each plane test on a bounds is a single
+	dot product with the center plus one with the extents. The farthest W for
+	the sort key is found the same way, with the W row of the mvp.
+
+	For stereo, both eyes have the same projection and orientation, so the
+	clip planes of the eyes are parallel. Taking the outer plane of every
+	pair gives a frustum that contains both eye frustums, so the surfaces are
+	culled once, while the W rows of both eyes give a sort key for each eye.
+*/
+
+static const int NUM_CLIP_PLANES = 6;
+static const int MAX_CULL_VIEWS = 2;
+static const int MAX_CULL_ROWS = NUM_CLIP_PLANES + MAX_CULL_VIEWS;	// clip planes + W for each view
+
+struct cullPlanes_t
 {
-	float						key;
-	const DrawMatrices * 		matrices;
-	const Array< Matrix4f > *	joints;
-	const SurfaceDef *			surface;
-	GLuint						textureOverload;	// if 0, there's no overload
-	bool						transparent;
+	float	plane[MAX_CULL_ROWS][4];
+	float	absNormal[MAX_CULL_ROWS][3];
 };
 
-int bsortComp( const void * p1, const void * p2 )
+static void SetupAbsNormals( cullPlanes_t & planes, const int numViews )
 {
-	bsort_t const * b1 = static_cast< bsort_t const * >( p1 );
-	bsort_t const * b2 = static_cast< bsort_t const * >( p2 );
-	bool trans1 = b1->transparent;
-	bool trans2 = b2->transparent;
-	if ( trans1 == trans2 )
+	for ( int i = 0; i < NUM_CLIP_PLANES + numViews; i++ )
 	{
-		float f1 = b1->key;
-		float f2 = b2->key;
-		if ( !trans1 )
+		for ( int j = 0; j < 3; j++ )
 		{
-			// both are solid, sort front-to-back
-			if ( f1 < f2 ) 
-			{
-				return -1;
-			}
-			if ( f1 > f2 ) 
+			planes.absNormal[i][j] = fabsf( planes.plane[i][j] );
+		}
+	}
+}
+
+// Planes in the space that is transformed by the mvp, with the W row for a single view.
+static void SetupCullPlanes( cullPlanes_t & planes, const Matrix4f & mvp )
+{
+	// The mvp is OpenGL column major, see GLTransform().
+	for ( int i = 0; i < 4; i++ )
+	{
+		const float x = mvp.M[i][0];
+		const float y = mvp.M[i][1];
+		const float z = mvp.M[i][2];
+		const float w = mvp.M[i][3];
+		planes.plane[0][i] = w + x;
+		planes.plane[1][i] = w - x;
+		planes.plane[2][i] = w + y;
+		planes.plane[3][i] = w - y;
+		planes.plane[4][i] = w + z;
+		planes.plane[5][i] = w - z;
+		planes.plane[6][i] = w;
+	}
+	SetupAbsNormals( planes, 1 );
+}
+
+// World space planes that contain the frustums of both eyes, with the W row of each eye.
+// Returns false if the clip planes of the eyes are not parallel.
+static bool SetupStereoCullPlanes( cullPlanes_t & planes, const Matrix4f & vpMatrix0, const Matrix4f & vpMatrix1 )
+{
+	cullPlanes_t eyePlanes[2];
+	SetupCullPlanes( eyePlanes[0], vpMatrix0 );
+	SetupCullPlanes( eyePlanes[1], vpMatrix1 );
+
+	for ( int i = 0; i < NUM_CLIP_PLANES; i++ )
+	{
+		const float * p0 = eyePlanes[0].plane[i];
+		const float * p1 = eyePlanes[1].plane[i];
+		const Vector3f n0( p0[0], p0[1], p0[2] );
+		const Vector3f n1( p1[0], p1[1], p1[2] );
+		const float length0 = n0.Length();
+		const float length1 = n1.Length();
+		if ( length0 < Math<float>::SmallestNonDenormal || length1 < Math<float>::SmallestNonDenormal )
+		{
+			return false;
+		}
+		if ( ( n0 / length0 - n1 / length1 ).LengthSq() > 1e-6f )
+		{
+			return false;
+		}
+
+		// The plane that is farther out contains the other one.
+		const bool useFirst = ( p0[3] / length0 >= p1[3] / length1 );
+		const float * p = useFirst ? p0 : p1;
+		const float rcpLength = 1.0f / ( useFirst ? length0 : length1 );
+		for ( int j = 0; j < 4; j++ )
+		{
+			planes.plane[i][j] = p[j] * rcpLength;
+		}
+	}
+	for ( int j = 0; j < 4; j++ )
+	{
+		planes.plane[NUM_CLIP_PLANES + 0][j] = eyePlanes[0].plane[NUM_CLIP_PLANES][j];
+		planes.plane[NUM_CLIP_PLANES + 1][j] = eyePlanes[1].plane[NUM_CLIP_PLANES][j];
+	}
+	SetupAbsNormals( planes, 2 );
+	return true;
+}
+
+// Moves world space planes into the space of a model.
+// The model matrix is OpenGL column major, like DrawMatrices::Model.
+static void TransformCullPlanes( cullPlanes_t & planes, const cullPlanes_t & worldPlanes, const int numViews, const Matrix4f & model )
+{
+	for ( int r = 0; r < NUM_CLIP_PLANES + numViews; r++ )
+	{
+		const float * p = worldPlanes.plane[r];
+		for ( int i = 0; i < 4; i++ )
+		{
+			planes.plane[r][i] = p[0] * model.M[i][0] + p[1] * model.M[i][1] + p[2] * model.M[i][2] + p[3] * model.M[i][3];
+		}
+	}
+	SetupAbsNormals( planes, numViews );
+}
+
+// Same result as BoundsSortCullKey() for up to four surfaces at a time, with a key
+// for each view. Culled lanes, and lanes past numSurfaces, get a 0 key in every view.
+static void SurfaceSortCullKeys4( const cullPlanes_t & planes, const int numViews,
+									const SurfaceDef * surfaces, const int * surfaceIndices, const int numSurfaces,
+									float keys[][4] )
+{
+	float center[3][4];
+	float extents[3][4];
+	int emptyMask = 0;
+	for ( int i = 0; i < 4; i++ )
+	{
+		if ( i >= numSurfaces )
+		{
+			for ( int j = 0; j < 3; j++ )
 			{
-				return 1;
+				center[j][i] = 0.0f;
+				extents[j][i] = 0.0f;
 			}
-			return 0;
+			emptyMask |= 1 << i;
+			continue;
 		}
-		else
+		const Bounds3f & bounds = surfaces[surfaceIndices[i]].cullingBounds;
+		for ( int j = 0; j < 3; j++ )
 		{
-			// both are transparent, sort back-to-front
-			if ( f1 < f2 )
+			center[j][i] = ( bounds.b[0][j] + bounds.b[1][j] ) * 0.5f;
+			extents[j][i] = ( bounds.b[1][j] - bounds.b[0][j] ) * 0.5f;
+		}
+		// Always cull empty bounds, which can be used to disable a surface.
+		// Don't just check a single axis, or billboards would be culled.
+		if ( bounds.b[1].x == bounds.b[0].x && bounds.b[1].y == bounds.b[0].y )
+		{
+			emptyMask |= 1 << i;
+		}
+	}
+
+	const int numRows = NUM_CLIP_PLANES + numViews;
+
+#if defined( OVR_CPU_SSE )
+	const __m128 cx = _mm_loadu_ps( center[0] );
+	const __m128 cy = _mm_loadu_ps( center[1] );
+	const __m128 cz = _mm_loadu_ps( center[2] );
+	const __m128 ex = _mm_loadu_ps( extents[0] );
+	const __m128 ey = _mm_loadu_ps( extents[1] );
+	const __m128 ez = _mm_loadu_ps( extents[2] );
+
+	__m128 distance[MAX_CULL_ROWS];
+	for ( int i = 0; i < numRows; i++ )
+	{
+		const float * p = planes.plane[i];
+		const float * n = planes.absNormal[i];
+		distance[i] = _mm_add_ps(
+						_mm_add_ps( _mm_add_ps( _mm_mul_ps( cx, _mm_set1_ps( p[0] ) ), _mm_mul_ps( cy, _mm_set1_ps( p[1] ) ) ),
+									_mm_add_ps( _mm_mul_ps( cz, _mm_set1_ps( p[2] ) ), _mm_set1_ps( p[3] ) ) ),
+						_mm_add_ps( _mm_add_ps( _mm_mul_ps( ex, _mm_set1_ps( n[0] ) ), _mm_mul_ps( ey, _mm_set1_ps( n[1] ) ) ),
+									_mm_mul_ps( ez, _mm_set1_ps( n[2] ) ) ) );
+	}
+
+	const __m128 zero = _mm_setzero_ps();
+	__m128 culled = _mm_cmple_ps( distance[0], zero );
+	for ( int i = 1; i < NUM_CLIP_PLANES; i++ )
+	{
+		culled = _mm_or_ps( culled, _mm_cmple_ps( distance[i], zero ) );
+	}
+
+	// The farthest W is clamped to zero, which culls bounds that are completely behind the eye.
+	for ( int v = 0; v < numViews; v++ )
+	{
+		_mm_storeu_ps( keys[v], _mm_andnot_ps( culled, _mm_max_ps( distance[NUM_CLIP_PLANES + v], zero ) ) );
+	}
+#elif defined( OVR_CPU_ARM_NEON )
+	const float32x4_t cx = vld1q_f32( center[0] );
+	const float32x4_t cy = vld1q_f32( center[1] );
+	const float32x4_t cz = vld1q_f32( center[2] );
+	const float32x4_t ex = vld1q_f32( extents[0] );
+	const float32x4_t ey = vld1q_f32( extents[1] );
+	const float32x4_t ez = vld1q_f32( extents[2] );
+
+	float32x4_t distance[MAX_CULL_ROWS];
+	for ( int i = 0; i < numRows; i++ )
+	{
+		const float * p = planes.plane[i];
+		const float * n = planes.absNormal[i];
+		float32x4_t d = vdupq_n_f32( p[3] );
+		d = vmlaq_n_f32( d, cx, p[0] );
+		d = vmlaq_n_f32( d, cy, p[1] );
+		d = vmlaq_n_f32( d, cz, p[2] );
+		d = vmlaq_n_f32( d, ex, n[0] );
+		d = vmlaq_n_f32( d, ey, n[1] );
+		d = vmlaq_n_f32( d, ez, n[2] );
+		distance[i] = d;
+	}
+
+	const float32x4_t zero = vdupq_n_f32( 0.0f );
+	uint32x4_t culled = vcleq_f32( distance[0], zero );
+	for ( int i = 1; i < NUM_CLIP_PLANES; i++ )
+	{
+		culled = vorrq_u32( culled, vcleq_f32( distance[i], zero ) );
+	}
+
+	// The farthest W is clamped to zero, which culls bounds that are completely behind the eye.
+	for ( int v = 0; v < numViews; v++ )
+	{
+		const uint32x4_t maxW = vreinterpretq_u32_f32( vmaxq_f32( distance[NUM_CLIP_PLANES + v], zero ) );
+		vst1q_f32( keys[v], vreinterpretq_f32_u32( vbicq_u32( maxW, culled ) ) );
+	}
+#else
+	for ( int j = 0; j < 4; j++ )
+	{
+		bool culled = false;
+		for ( int i = 0; i < numRows; i++ )
+		{
+			const float * p = planes.plane[i];
+			const float * n = planes.absNormal[i];
+			const float d = center[0][j] * p[0] + center[1][j] * p[1] + center[2][j] * p[2] + p[3] +
+							extents[0][j] * n[0] + extents[1][j] * n[1] + extents[2][j] * n[2];
+			if ( i < NUM_CLIP_PLANES )
 			{
-				return 1;
+				culled |= ( d <= 0.0f );
 			}
-			if ( f1 > f2 )
+			else
 			{
-				return -1;
+				keys[i - NUM_CLIP_PLANES][j] = culled ? 0.0f : Alg::Max( d, 0.0f );
 			}
-			return 0;
 		}
 	}
-	// otherwise, one is solid and one is translucent... the solid is always rendered first
-	if ( trans1 ) 
+#endif
+
+	for ( int i = 0; i < 4; i++ )
 	{
-		return 1;
+		if ( emptyMask & ( 1 << i ) )
+		{
+			for ( int v = 0; v < numViews; v++ )
+			{
+				keys[v][i] = 0.0f;
+			}
+		}
 	}
-	return -1;
 }
 
-const DrawSurfaceList & BuildDrawSurfaceList( const OVR::Array<ModelState> & modelRenderList,
-			const Matrix4f & viewMatrix, const Matrix4f & projectionMatrix )
+// Returns true if the bounds are completely outside one of the clip planes.
+static bool BoundsCulled( const cullPlanes_t & planes, const Bounds3f & bounds )
+{
+	const Vector3f center = bounds.GetCenter();
+	const Vector3f extents = bounds.GetSize() * 0.5f;
+	for ( int i = 0; i < NUM_CLIP_PLANES; i++ )
+	{
+		const float * p = planes.plane[i];
+		const float * n = planes.absNormal[i];
+		const float d = center.x * p[0] + center.y * p[1] + center.z * p[2] + p[3] +
+						extents.x * n[0] + extents.y * n[1] + extents.z * n[2];
+		if ( d <= 0.0f )
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+/*
+	Large environment models have thousands of surfaces, most of which are
+	outside the view at any time. The surface BVH groups nearby surfaces, so
+	a single bounds test against the node rejects all of them. It is a plain
+	median split on the longest axis of the surface centers, which is cheap
+	enough to build at load time and works well for the spread out surfaces
+	of an environment. The leafs have up to four surfaces, which are culled
+	with SurfaceSortCullKeys4().
+*/
+
+static const int BVH_MIN_SURFACES = 16;
+static const int BVH_MAX_LEAF_SURFACES = 4;
+
+struct bvhSurface_t
+{
+	float	center[3];
+	int		index;
+};
+
+static bool BvhSurfaceLessX( const bvhSurface_t & a, const bvhSurface_t & b ) { return a.center[0] < b.center[0]; }
+static bool BvhSurfaceLessY( const bvhSurface_t & a, const bvhSurface_t & b ) { return a.center[1] < b.center[1]; }
+static bool BvhSurfaceLessZ( const bvhSurface_t & a, const bvhSurface_t & b ) { return a.center[2] < b.center[2]; }
+
+static void BuildSurfaceBvhNode( ModelDef & modelDef, ArrayPOD< bvhSurface_t > & bvhSurfaces, const int first, const int count )
+{
+	Bounds3f bounds( Bounds3f::Init );
+	Bounds3f centers( Bounds3f::Init );
+	for ( int i = first; i < first + count; i++ )
+	{
+		bounds = Bounds3f::Union( bounds, modelDef.surfaces[bvhSurfaces[i].index].cullingBounds );
+		centers.AddPoint( Vector3f( bvhSurfaces[i].center[0], bvhSurfaces[i].center[1], bvhSurfaces[i].center[2] ) );
+	}
+
+	// the array grows during the recursion, so only hold on to the index
+	const int nodeNum = modelDef.surfaceBvh.AllocBack();
+	modelDef.surfaceBvh[nodeNum].bounds = bounds;
+	modelDef.surfaceBvh[nodeNum].firstSurface = first;
+	modelDef.surfaceBvh[nodeNum].numSurfaces = count;
+
+	if ( count > BVH_MAX_LEAF_SURFACES )
+	{
+		const Vector3f size = centers.GetSize();
+		if ( size.x >= size.y && size.x >= size.z )
+		{
+			Alg::QuickSortSliced( bvhSurfaces, first, first + count, BvhSurfaceLessX );
+		}
+		else if ( size.y >= size.z )
+		{
+			Alg::QuickSortSliced( bvhSurfaces, first, first + count, BvhSurfaceLessY );
+		}
+		else
+		{
+			Alg::QuickSortSliced( bvhSurfaces, first, first + count, BvhSurfaceLessZ );
+		}
+
+		// Round the split to full leafs.
+		const int firstCount = Alg::Min( ( count / 2 + BVH_MAX_LEAF_SURFACES - 1 ) & ~( BVH_MAX_LEAF_SURFACES - 1 ), count - 1 );
+		BuildSurfaceBvhNode( modelDef, bvhSurfaces, first, firstCount );
+		BuildSurfaceBvhNode( modelDef, bvhSurfaces, first + firstCount, count - firstCount );
+	}
+
+	modelDef.surfaceBvh[nodeNum].skipNode = modelDef.surfaceBvh.GetSizeI();
+}
+
+void BuildSurfaceBvh( ModelDef & modelDef )
+{
+	modelDef.surfaceBvh.Clear();
+	modelDef.surfaceBvhIndices.Clear();
+
+	const int numSurfaces = modelDef.surfaces.GetSizeI();
+	if ( numSurfaces < BVH_MIN_SURFACES )
+	{
+		return;
+	}
+
+	ArrayPOD< bvhSurface_t > bvhSurfaces;
+	bvhSurfaces.Resize( numSurfaces );
+	for ( int i = 0; i < numSurfaces; i++ )
+	{
+		const Vector3f center = modelDef.surfaces[i].cullingBounds.GetCenter();
+		bvhSurfaces[i].center[0] = center.x;
+		bvhSurfaces[i].center[1] = center.y;
+		bvhSurfaces[i].center[2] = center.z;
+		bvhSurfaces[i].index = i;
+	}
+
+	// a binary tree with full leafs
+	modelDef.surfaceBvh.Reserve( 2 * ( numSurfaces + BVH_MAX_LEAF_SURFACES - 1 ) / BVH_MAX_LEAF_SURFACES );
+	BuildSurfaceBvhNode( modelDef, bvhSurfaces, 0, numSurfaces );
+
+	modelDef.surfaceBvhIndices.Resize( numSurfaces );
+	for ( int i = 0; i < numSurfaces; i++ )
+	{
+		modelDef.surfaceBvhIndices[i] = bvhSurfaces[i].index;
+	}
+}
+
+// Solid surfaces are drawn first, front to back, then the transparent
+// surfaces back to front. The farthest W is always positive, and positive
+// floats sort the same way as their bit patterns, so the key is the top bit
+// for transparency plus the remaining 31 bits of W, inverted for transparent
+// surfaces.
+static UInt32 DrawSurfaceSortKey( const float maxW, const bool transparent )
 {
-	// A mobile GPU will be in trouble if it draws more than this.
-	static const int MAX_DRAW_SURFACES = 1024;
-	bsort_t	bsort[ MAX_DRAW_SURFACES ];
-	static const int MAX_DRAW_MODELS = 128;
-	static DrawMatrices drawMatrices[MAX_DRAW_MODELS];
+	union { float f; UInt32 u; } w;
+	w.f = maxW;
+	return transparent ? ( 0x80000000 | ( ~w.u & 0x7FFFFFFF ) ) : ( w.u & 0x7FFFFFFF );
+}
 
-	const Matrix4f vpMatrix = ( projectionMatrix * viewMatrix ).Transposed();
+// Stable least significant digit radix sort on 8 bits at a time, which
+// leaves the sorted values in the input arrays. A pass is skipped when all
+// keys have the same digit, which is common for the upper bits of W.
+static void RadixSortDrawSurfaces( UInt32 * keys, int * values, UInt32 * tempKeys, int * tempValues, const int count )
+{
+	if ( count <= 1 )
+	{
+		return;
+	}
+
+	int histogram[4][256];
+	memset( histogram, 0, sizeof( histogram ) );
+	for ( int i = 0; i < count; i++ )
+	{
+		const UInt32 key = keys[i];
+		histogram[0][( key >>  0 ) & 0xFF]++;
+		histogram[1][( key >>  8 ) & 0xFF]++;
+		histogram[2][( key >> 16 ) & 0xFF]++;
+		histogram[3][( key >> 24 ) & 0xFF]++;
+	}
+
+	UInt32 * srcKeys = keys;
+	int * srcValues = values;
+	UInt32 * dstKeys = tempKeys;
+	int * dstValues = tempValues;
+
+	for ( int pass = 0; pass < 4; pass++ )
+	{
+		const int shift = pass * 8;
+		int * counts = histogram[pass];
+		if ( counts[( srcKeys[0] >> shift ) & 0xFF] == count )
+		{
+			continue;
+		}
+
+		int offset = 0;
+		for ( int i = 0; i < 256; i++ )
+		{
+			const int c = counts[i];
+			counts[i] = offset;
+			offset += c;
+		}
+
+		for ( int i = 0; i < count; i++ )
+		{
+			const UInt32 key = srcKeys[i];
+			const int index = counts[( key >> shift ) & 0xFF]++;
+			dstKeys[index] = key;
+			dstValues[index] = srcValues[i];
+		}
+
+		Alg::Swap( srcKeys, dstKeys );
+		Alg::Swap( srcValues, dstValues );
+	}
+
+	if ( srcKeys != keys )
+	{
+		memcpy( keys, srcKeys, count * sizeof( keys[0] ) );
+		memcpy( values, srcValues, count * sizeof( values[0] ) );
+	}
+}
+
+// Builds a list for every view, with the surfaces culled by the given world space
+// planes, or for a single view by the clip planes of the view when these are NULL.
+static void BuildDrawSurfaceLists( const int numViews, DrawSurfaceList * surfaceLists, DrawSurfaceArena * arenas,
+			const OVR::Array<ModelState> & modelRenderList,
+			const Matrix4f * viewMatrices, const Matrix4f * projectionMatrices,
+			const cullPlanes_t * worldPlanes )
+{
+	OVR_ASSERT( numViews >= 1 && numViews <= MAX_CULL_VIEWS );
+	OVR_ASSERT( numViews == 1 || worldPlanes != NULL );
+
+	// Size everything up front, the draw surfaces point at the matrices.
+	int maxSurfaces = 0;
+	for ( int modelNum = 0; modelNum < modelRenderList.GetSizeI(); modelNum++ )
+	{
+		if ( !modelRenderList[ modelNum ].Flags.Hide )
+		{
+			maxSurfaces += modelRenderList[ modelNum ].modelDef->surfaces.GetSizeI();
+		}
+	}
+
+	Matrix4f vpMatrix[MAX_CULL_VIEWS];
+	DrawMatrices * drawMatrices[MAX_CULL_VIEWS];
+	DrawSurface * unsortedSurfaces[MAX_CULL_VIEWS];
+	UInt32 * sortKeys[MAX_CULL_VIEWS];
+	int * sortIndices[MAX_CULL_VIEWS];
+	for ( int v = 0; v < numViews; v++ )
+	{
+		DrawSurfaceArena & arena = arenas[v];
+		arena.matrices.Resize( modelRenderList.GetSize() );
+		arena.unsortedSurfaces.Resize( maxSurfaces );
+		arena.sortKeys.Resize( maxSurfaces );
+		arena.sortIndices.Resize( maxSurfaces );
+
+		vpMatrix[v] = ( projectionMatrices[v] * viewMatrices[v] ).Transposed();
+		drawMatrices[v] = arena.matrices.GetDataPtr();
+		unsortedSurfaces[v] = arena.unsortedSurfaces.GetDataPtr();
+		sortKeys[v] = arena.sortKeys.GetDataPtr();
+		sortIndices[v] = arena.sortIndices.GetDataPtr();
+	}
 
 	int	numSurfaces = 0;
 	int	numDrawMatrices = 0;
 	int	cullCount = 0;
+	int	cullNodeCount = 0;
 
 	// Loop through all the models
 	for ( int modelNum = 0; modelNum < modelRenderList.GetSizeI(); modelNum++ )
@@ -273,68 +701,161 @@ const DrawSurfaceList & BuildDrawSurfaceList( const OVR::Array<ModelState> & mod
 			surfaceOverloads[overload.SurfaceIndex] = overload.TextureId;
 		}
 
-		if ( numDrawMatrices == MAX_DRAW_MODELS ) 
+		DrawMatrices * matrices[MAX_CULL_VIEWS];
+		for ( int v = 0; v < numViews; v++ )
 		{
-			break;
+			matrices[v] = &drawMatrices[v][numDrawMatrices];
+			matrices[v]->Model = modelState.modelMatrix.Transposed();
+			matrices[v]->Mvp = matrices[v]->Model * vpMatrix[v];
 		}
+		numDrawMatrices++;
 
-		DrawMatrices & matrices = drawMatrices[numDrawMatrices++];
-
-		matrices.Model = modelState.modelMatrix.Transposed();
-		matrices.Mvp = matrices.Model * vpMatrix;
+		cullPlanes_t cullPlanes;
+		if ( worldPlanes != NULL )
+		{
+			TransformCullPlanes( cullPlanes, *worldPlanes, numViews, matrices[0]->Model );
+		}
+		else
+		{
+			SetupCullPlanes( cullPlanes, matrices[0]->Mvp );
+		}
 
-		for ( int surfaceNum = 0; surfaceNum < modelDef.surfaces.GetSizeI(); surfaceNum++ ) {
-			const SurfaceDef & surfaceDef = modelDef.surfaces[ surfaceNum ];
-			const float sort = BoundsSortCullKey( surfaceDef.cullingBounds, matrices.Mvp );
-			if ( sort == 0 ) 
+		const int numModelSurfaces = modelDef.surfaces.GetSizeI();
+		const bool useBvh = ( modelDef.surfaceBvh.GetSizeI() > 0 && modelDef.surfaceBvhIndices.GetSizeI() == numModelSurfaces );
+		const int numNodes = useBvh ? modelDef.surfaceBvh.GetSizeI() : 0;
+		int nodeNum = 0;
+		int surfaceBase = 0;
+		for ( ; ; )
+		{
+			// Walk the BVH for the next leaf that is not culled, or take the next four surfaces.
+			int flatIndices[4];
+			const int * batchIndices = flatIndices;
+			int numLanes = 0;
+			if ( useBvh )
 			{
-				cullCount++;
-				continue;
+				if ( nodeNum >= numNodes )
+				{
+					break;
+				}
+				const SurfaceBvhNode & node = modelDef.surfaceBvh[nodeNum];
+				cullNodeCount++;
+				if ( BoundsCulled( cullPlanes, node.bounds ) )
+				{
+					cullCount += node.numSurfaces;
+					nodeNum = node.skipNode;
+					continue;
+				}
+				if ( node.skipNode != nodeNum + 1 )
+				{
+					nodeNum++;
+					continue;
+				}
+				batchIndices = &modelDef.surfaceBvhIndices[node.firstSurface];
+				numLanes = node.numSurfaces;
+				nodeNum++;
 			}
-
-			if ( numSurfaces == MAX_DRAW_SURFACES ) 
+			else
 			{
-				break;
+				if ( surfaceBase >= numModelSurfaces )
+				{
+					break;
+				}
+				numLanes = Alg::Min( 4, numModelSurfaces - surfaceBase );
+				for ( int lane = 0; lane < numLanes; lane++ )
+				{
+					flatIndices[lane] = surfaceBase + lane;
+				}
+				surfaceBase += 4;
 			}
 
-			bsort[ numSurfaces ].key = sort;
-			bsort[ numSurfaces ].matrices = &matrices;
-			bsort[ numSurfaces ].joints = &modelState.Joints;
-			bsort[ numSurfaces ].surface = &surfaceDef;
-			bsort[ numSurfaces ].textureOverload = surfaceNum < MAX_TEXTURE_OVERLOADS_PER_MODEL ? surfaceOverloads[surfaceNum] : 0;
-			bsort[ numSurfaces ].transparent = surfaceDef.materialDef.gpuState.blendEnable;
-			if ( bsort[ numSurfaces ].textureOverload > 0 )
+			float sort[MAX_CULL_VIEWS][4];
+			SurfaceSortCullKeys4( cullPlanes, numViews, modelDef.surfaces.GetDataPtr(), batchIndices, numLanes, sort );
+
+			for ( int lane = 0; lane < numLanes; lane++ )
 			{
-				LOG( "surfaceNum = %i, surfaceOverloads[surfaceNum] = %i, bsort[%i].textureOverload = %u", surfaceNum, surfaceOverloads[surfaceNum], numSurfaces, bsort[ numSurfaces ].textureOverload );
+				bool visible = false;
+				for ( int v = 0; v < numViews; v++ )
+				{
+					visible |= ( sort[v][lane] != 0 );
+				}
+				if ( !visible ) 
+				{
+					cullCount++;
+					continue;
+				}
+
+				const int surfaceNum = batchIndices[lane];
+				const SurfaceDef & surfaceDef = modelDef.surfaces[ surfaceNum ];
+				const GLuint textureOverload = surfaceNum < MAX_TEXTURE_OVERLOADS_PER_MODEL ? surfaceOverloads[surfaceNum] : 0;
+
+				for ( int v = 0; v < numViews; v++ )
+				{
+					DrawSurface & drawSurface = unsortedSurfaces[v][ numSurfaces ];
+					drawSurface.matrices = matrices[v];
+					drawSurface.joints = &modelState.Joints;
+					drawSurface.surface = &surfaceDef;
+					drawSurface.textureOverload = textureOverload;
+
+					sortKeys[v][ numSurfaces ] = DrawSurfaceSortKey( sort[v][lane], surfaceDef.materialDef.gpuState.blendEnable );
+					sortIndices[v][ numSurfaces ] = numSurfaces;
+				}
+				numSurfaces++;
 			}
-			numSurfaces++;
 		}
 	}
 
-	// sort by the far W
-	qsort( bsort, numSurfaces, sizeof( bsort[0] ), bsortComp );
-
-	// extract the drawSurface_t info
-	static DrawSurface drawSurfaces[ MAX_DRAW_SURFACES ];
-	for ( int i = 0; i < numSurfaces; i++ ) 
+	for ( int v = 0; v < numViews; v++ )
 	{
-		drawSurfaces[i].matrices = bsort[i].matrices;
-		drawSurfaces[i].joints = bsort[i].joints;
-		drawSurfaces[i].surface = bsort[i].surface;
-		drawSurfaces[i].textureOverload = bsort[i].textureOverload;
-	}
+		DrawSurfaceArena & arena = arenas[v];
+
+		// sort by the far W
+		arena.tempKeys.Resize( numSurfaces );
+		arena.tempIndices.Resize( numSurfaces );
+		RadixSortDrawSurfaces( sortKeys[v], sortIndices[v], arena.tempKeys.GetDataPtr(), arena.tempIndices.GetDataPtr(), numSurfaces );
+
+		arena.drawSurfaces.Resize( numSurfaces );
+		DrawSurface * drawSurfaces = arena.drawSurfaces.GetDataPtr();
+		for ( int i = 0; i < numSurfaces; i++ ) 
+		{
+			drawSurfaces[i] = unsortedSurfaces[v][ sortIndices[v][i] ];
+		}
 
-//	LOG( "Culled %i, draw %i", cullCount, numSurfaces );
-	static DrawSurfaceList surfaceList;
-	surfaceList.viewMatrix = viewMatrix.Transposed();
-	surfaceList.projectionMatrix = projectionMatrix.Transposed();
-	surfaceList.numDrawSurfaces = numSurfaces;
-	surfaceList.drawSurfaces = drawSurfaces;
-	surfaceList.numCulledSurfaces = cullCount;
+//		LOG( "Culled %i, draw %i", cullCount, numSurfaces );
+		DrawSurfaceList & surfaceList = surfaceLists[v];
+		surfaceList.viewMatrix = viewMatrices[v].Transposed();
+		surfaceList.projectionMatrix = projectionMatrices[v].Transposed();
+		surfaceList.numDrawSurfaces = numSurfaces;
+		surfaceList.drawSurfaces = drawSurfaces;
+		surfaceList.numCullNodesVisited = cullNodeCount;
+		surfaceList.numCulledSurfaces = cullCount;
+	}
+}
 
-	return surfaceList;
+void BuildDrawSurfaceList( DrawSurfaceList & surfaceList, DrawSurfaceArena & arena,
+			const OVR::Array<ModelState> & modelRenderList,
+			const Matrix4f & viewMatrix, const Matrix4f & projectionMatrix )
+{
+	BuildDrawSurfaceLists( 1, &surfaceList, &arena, modelRenderList, &viewMatrix, &projectionMatrix, NULL );
 }
 
+void BuildStereoDrawSurfaceLists( DrawSurfaceList surfaceLists[2], DrawSurfaceArena arenas[2],
+			const OVR::Array<ModelState> & modelRenderList,
+			const Matrix4f viewMatrices[2], const Matrix4f projectionMatrices[2] )
+{
+	cullPlanes_t worldPlanes;
+	if ( !SetupStereoCullPlanes( worldPlanes,
+			( projectionMatrices[0] * viewMatrices[0] ).Transposed(),
+			( projectionMatrices[1] * viewMatrices[1] ).Transposed() ) )
+	{
+		// The eyes do not share a frustum, so cull them separately.
+		for ( int eye = 0; eye < 2; eye++ )
+		{
+			BuildDrawSurfaceLists( 1, &surfaceLists[eye], &arenas[eye], modelRenderList, &viewMatrices[eye], &projectionMatrices[eye], NULL );
+		}
+		return;
+	}
+	BuildDrawSurfaceLists( 2, surfaceLists, arenas, modelRenderList, viewMatrices, projectionMatrices, &worldPlanes );
+}
 
 // Renders a list of pointers to models in order.
 DrawCounters RenderSurfaceList( const DrawSurfaceList & drawSurfaceList ) {
@@ -350,6 +871,8 @@ DrawCounters RenderSurfaceList( const DrawSurfaceList & drawSurfaceList ) {
 
 	// counters
 	DrawCounters counters;
+	counters.numCullNodesVisited = drawSurfaceList.numCullNodesVisited;
+	counters.numCulledSurfaces = drawSurfaceList.numCulledSurfaces;
 
 	// Loop through all the surfaces
 	for ( int surfaceNum = 0; surfaceNum < drawSurfaceList.numDrawSurfaces; surfaceNum++ ) 
@@ -492,4 +1015,382 @@ void ModelState::ClearSurfaceTextureOverload( const int surfaceIndex )
 	}
 }
 
+//-----------------------------------------------------------------------------
+//	Culling benchmark
+//-----------------------------------------------------------------------------
+
+// The culling and sorting as it was done before the four wide culling and the
+// radix sort, kept to compare the results and the cost per frame.
+
+struct bsort_t
+{
+	float						key;
+	const DrawMatrices * 		matrices;
+	const Array< Matrix4f > *	joints;
+	const SurfaceDef *			surface;
+	GLuint						textureOverload;	// if 0, there's no overload
+	bool						transparent;
+};
+
+static int bsortComp( const void * p1, const void * p2 )
+{
+	bsort_t const * b1 = static_cast< bsort_t const * >( p1 );
+	bsort_t const * b2 = static_cast< bsort_t const * >( p2 );
+	bool trans1 = b1->transparent;
+	bool trans2 = b2->transparent;
+	if ( trans1 == trans2 )
+	{
+		float f1 = b1->key;
+		float f2 = b2->key;
+		if ( !trans1 )
+		{
+			// both are solid, sort front-to-back
+			if ( f1 < f2 ) 
+			{
+				return -1;
+			}
+			if ( f1 > f2 ) 
+			{
+				return 1;
+			}
+			return 0;
+		}
+		else
+		{
+			// both are transparent, sort back-to-front
+			if ( f1 < f2 )
+			{
+				return 1;
+			}
+			if ( f1 > f2 )
+			{
+				return -1;
+			}
+			return 0;
+		}
+	}
+	// otherwise, one is solid and one is translucent... the solid is always rendered first
+	if ( trans1 ) 
+	{
+		return 1;
+	}
+	return -1;
+}
+
+static int BuildDrawSurfaceListReference( const Array< ModelState > & modelRenderList, const Matrix4f & vpMatrix,
+											Array< DrawMatrices > & drawMatrices, Array< bsort_t > & bsort,
+											DrawSurface * drawSurfaces, int & cullCount )
+{
+	drawMatrices.Resize( modelRenderList.GetSizeI() );
+	bsort.Resize( 0 );
+	cullCount = 0;
+
+	for ( int modelNum = 0; modelNum < modelRenderList.GetSizeI(); modelNum++ )
+	{
+		const ModelState & modelState = modelRenderList[ modelNum ];
+		const ModelDef & modelDef = *modelState.modelDef;
+
+		DrawMatrices & matrices = drawMatrices[modelNum];
+		matrices.Model = modelState.modelMatrix.Transposed();
+		matrices.Mvp = matrices.Model * vpMatrix;
+
+		for ( int surfaceNum = 0; surfaceNum < modelDef.surfaces.GetSizeI(); surfaceNum++ )
+		{
+			const SurfaceDef & surfaceDef = modelDef.surfaces[ surfaceNum ];
+			const float sort = BoundsSortCullKey( surfaceDef.cullingBounds, matrices.Mvp );
+			if ( sort == 0 )
+			{
+				cullCount++;
+				continue;
+			}
+
+			bsort_t & b = bsort[bsort.AllocBack()];
+			b.key = sort;
+			b.matrices = &matrices;
+			b.joints = &modelState.Joints;
+			b.surface = &surfaceDef;
+			b.textureOverload = 0;
+			b.transparent = surfaceDef.materialDef.gpuState.blendEnable;
+		}
+	}
+
+	qsort( bsort.GetDataPtr(), bsort.GetSizeI(), sizeof( bsort[0] ), bsortComp );
+
+	for ( int i = 0; i < bsort.GetSizeI(); i++ )
+	{
+		drawSurfaces[i].matrices = bsort[i].matrices;
+		drawSurfaces[i].joints = bsort[i].joints;
+		drawSurfaces[i].surface = bsort[i].surface;
+		drawSurfaces[i].textureOverload = bsort[i].textureOverload;
+	}
+	return bsort.GetSizeI();
+}
+
+struct cullRandom
+{
+	cullRandom( UInt32 seed ) : State( seed ) {}
+
+	float Next()
+	{
+		State = State * 1664525u + 1013904223u;
+		return ( State >> 8 ) * ( 1.0f / 16777216.0f );
+	}
+
+	UInt32 State;
+};
+
+void DrawSurfaceCullBenchmark( void * appPtr, const char * cmd )
+{
+	OVR_UNUSED( appPtr );
+
+	int numSurfaces = 1024;
+	int numFrames = 1000;
+	sscanf( cmd, "%i %i", &numSurfaces, &numFrames );
+	numFrames = Alg::Max( numFrames, 1 );
+
+	static const int SURFACES_PER_MODEL = 16;
+	numSurfaces = Alg::Max( numSurfaces, SURFACES_PER_MODEL );
+	const int numModels = numSurfaces / SURFACES_PER_MODEL;
+	numSurfaces = numModels * SURFACES_PER_MODEL;
+
+	// Models scattered around the viewer, made up of boxes of different sizes,
+	// a quarter of them transparent and a few of them empty.
+	cullRandom random( 9876 );
+	Array< ModelDef > modelDefs;
+	modelDefs.Resize( numModels );
+	Array< ModelState > modelRenderList;
+	for ( int i = 0; i < numModels; i++ )
+	{
+		ModelDef & modelDef = modelDefs[i];
+		modelDef.surfaces.Resize( SURFACES_PER_MODEL );
+		for ( int j = 0; j < SURFACES_PER_MODEL; j++ )
+		{
+			SurfaceDef & surfaceDef = modelDef.surfaces[j];
+			const Vector3f center( random.Next() * 4.0f - 2.0f, random.Next() * 4.0f - 2.0f, random.Next() * 4.0f - 2.0f );
+			const Vector3f size( random.Next() + 0.01f, random.Next() + 0.01f, random.Next() + 0.01f );
+			surfaceDef.cullingBounds = Bounds3f( center - size, center + size );
+			if ( random.Next() < 0.02f )
+			{
+				surfaceDef.cullingBounds = Bounds3f( center, center );
+			}
+			surfaceDef.materialDef.gpuState.blendEnable = ( random.Next() < 0.25f );
+		}
+
+		ModelState modelState( modelDef );
+		modelState.modelMatrix = Matrix4f::Translation( random.Next() * 80.0f - 40.0f, random.Next() * 10.0f - 5.0f, random.Next() * 80.0f - 40.0f ) *
+									Matrix4f::RotationY( random.Next() * 6.28f );
+		modelRenderList.PushBack( modelState );
+	}
+
+	const Matrix4f projectionMatrix = Matrix4f::PerspectiveRH( DegreeToRad( 90.0f ), 1.0f, 0.01f, 2000.0f );
+
+	Array< DrawMatrices > refMatrices;
+	Array< bsort_t > refSort;
+	Array< DrawSurface > refSurfaces;
+	refSurfaces.Resize( numSurfaces );
+
+	DrawSurfaceArena arena;
+	DrawSurfaceList surfaceList;
+
+	double referenceTime = 0.0;
+	double buildTime = 0.0;
+	int numDrawn = 0;
+	int numCullMismatches = 0;
+	int numOrderMismatches = 0;
+
+	for ( int frame = 0; frame < numFrames; frame++ )
+	{
+		// Look around, so the visible set keeps changing.
+		const Matrix4f viewMatrix = Matrix4f::RotationY( frame * 0.05f ).Inverted();
+		const Matrix4f vpMatrix = ( projectionMatrix * viewMatrix ).Transposed();
+
+		const double start = LogCpuTime::GetNanoSeconds();
+		int refCulled = 0;
+		const int refDrawn = BuildDrawSurfaceListReference( modelRenderList, vpMatrix, refMatrices, refSort, refSurfaces.GetDataPtr(), refCulled );
+		const double middle = LogCpuTime::GetNanoSeconds();
+		BuildDrawSurfaceList( surfaceList, arena, modelRenderList, viewMatrix, projectionMatrix );
+		const double end = LogCpuTime::GetNanoSeconds();
+
+		referenceTime += middle - start;
+		buildTime += end - middle;
+		numDrawn += surfaceList.numDrawSurfaces;
+
+		numCullMismatches += abs( surfaceList.numDrawSurfaces - refDrawn ) + abs( surfaceList.numCulledSurfaces - refCulled );
+		if ( surfaceList.numDrawSurfaces == refDrawn )
+		{
+			for ( int i = 0; i < refDrawn; i++ )
+			{
+				numOrderMismatches += ( surfaceList.drawSurfaces[i].surface != refSurfaces[i].surface );
+			}
+		}
+	}
+
+	LOG( "cullBenchmark: %d models, %d surfaces, %1.1f drawn on average",
+			numModels, numSurfaces, (double)numDrawn / numFrames );
+	LOG( "cullBenchmark: corners + qsort %1.3f ms/frame, four wide + radix sort %1.3f ms/frame, speedup %1.2fx",
+			referenceTime * 1e-6 / numFrames, buildTime * 1e-6 / numFrames, referenceTime / Alg::Max( buildTime, 1.0 ) );
+	LOG( "cullBenchmark: %d cull mismatches, %d order differences (nearly equal W) over %d frames",
+			numCullMismatches, numOrderMismatches, numFrames );
+
+	// Both eyes, culled separately and with the shared frustum.
+	DrawSurfaceArena monoArenas[2];
+	DrawSurfaceList monoLists[2];
+	DrawSurfaceArena stereoArenas[2];
+	DrawSurfaceList stereoLists[2];
+	Array< const SurfaceDef * > monoSurfaces;
+	Array< const SurfaceDef * > stereoSurfaces;
+
+	double monoTime = 0.0;
+	double stereoTime = 0.0;
+	int numMonoDrawn = 0;
+	int numStereoDrawn = 0;
+	int numMissing = 0;
+
+	const float eyeOffset = 0.5f * 0.064f;
+	const Matrix4f projectionMatrices[2] = { projectionMatrix, projectionMatrix };
+	for ( int frame = 0; frame < numFrames; frame++ )
+	{
+		const Matrix4f viewMatrix = Matrix4f::RotationY( frame * 0.05f ).Inverted();
+		const Matrix4f viewMatrices[2] =
+		{
+			Matrix4f::Translation( eyeOffset, 0.0f, 0.0f ) * viewMatrix,
+			Matrix4f::Translation( -eyeOffset, 0.0f, 0.0f ) * viewMatrix
+		};
+
+		const double start = LogCpuTime::GetNanoSeconds();
+		for ( int eye = 0; eye < 2; eye++ )
+		{
+			BuildDrawSurfaceList( monoLists[eye], monoArenas[eye], modelRenderList, viewMatrices[eye], projectionMatrices[eye] );
+		}
+		const double middle = LogCpuTime::GetNanoSeconds();
+		BuildStereoDrawSurfaceLists( stereoLists, stereoArenas, modelRenderList, viewMatrices, projectionMatrices );
+		const double end = LogCpuTime::GetNanoSeconds();
+
+		monoTime += middle - start;
+		stereoTime += end - middle;
+
+		// Every surface that is visible to an eye must be in the stereo list of that eye.
+		for ( int eye = 0; eye < 2; eye++ )
+		{
+			numMonoDrawn += monoLists[eye].numDrawSurfaces;
+			numStereoDrawn += stereoLists[eye].numDrawSurfaces;
+
+			monoSurfaces.Resize( monoLists[eye].numDrawSurfaces );
+			for ( int i = 0; i < monoLists[eye].numDrawSurfaces; i++ )
+			{
+				monoSurfaces[i] = monoLists[eye].drawSurfaces[i].surface;
+			}
+			stereoSurfaces.Resize( stereoLists[eye].numDrawSurfaces );
+			for ( int i = 0; i < stereoLists[eye].numDrawSurfaces; i++ )
+			{
+				stereoSurfaces[i] = stereoLists[eye].drawSurfaces[i].surface;
+			}
+			Alg::QuickSort( monoSurfaces );
+			Alg::QuickSort( stereoSurfaces );
+
+			int j = 0;
+			for ( int i = 0; i < monoSurfaces.GetSizeI(); i++ )
+			{
+				while ( j < stereoSurfaces.GetSizeI() && stereoSurfaces[j] < monoSurfaces[i] )
+				{
+					j++;
+				}
+				if ( j >= stereoSurfaces.GetSizeI() || stereoSurfaces[j] != monoSurfaces[i] )
+				{
+					numMissing++;
+				}
+			}
+		}
+	}
+
+	LOG( "cullBenchmark: stereo, two builds %1.3f ms/frame, shared frustum %1.3f ms/frame, speedup %1.2fx",
+			monoTime * 1e-6 / numFrames, stereoTime * 1e-6 / numFrames, monoTime / Alg::Max( stereoTime, 1.0 ) );
+	LOG( "cullBenchmark: stereo, %1.1f drawn per eye separately, %1.1f with the shared frustum, %d missing over %d frames",
+			numMonoDrawn * 0.5 / numFrames, numStereoDrawn * 0.5 / numFrames, numMissing, numFrames );
+
+	// A single city block model with all the surfaces, culled with and without the BVH.
+	ModelDef flatModelDef;
+	flatModelDef.surfaces.Resize( numSurfaces );
+	for ( int i = 0; i < numSurfaces; i++ )
+	{
+		SurfaceDef & surfaceDef = flatModelDef.surfaces[i];
+		const Vector3f center( random.Next() * 400.0f - 200.0f, random.Next() * 20.0f, random.Next() * 400.0f - 200.0f );
+		const Vector3f size( random.Next() * 5.0f + 0.5f, random.Next() * 10.0f + 0.5f, random.Next() * 5.0f + 0.5f );
+		surfaceDef.cullingBounds = Bounds3f( center - size, center + size );
+		surfaceDef.materialDef.gpuState.blendEnable = ( random.Next() < 0.1f );
+	}
+	ModelDef bvhModelDef = flatModelDef;
+	const double bvhStart = LogCpuTime::GetNanoSeconds();
+	BuildSurfaceBvh( bvhModelDef );
+	const double bvhEnd = LogCpuTime::GetNanoSeconds();
+
+	Array< ModelState > flatRenderList;
+	flatRenderList.PushBack( ModelState( flatModelDef ) );
+	Array< ModelState > bvhRenderList;
+	bvhRenderList.PushBack( ModelState( bvhModelDef ) );
+
+	DrawSurfaceList flatList;
+	DrawSurfaceList bvhList;
+	Array< int > flatIndices;
+	Array< int > bvhIndices;
+
+	double flatTime = 0.0;
+	double bvhTime = 0.0;
+	int numCityDrawn = 0;
+	int numNodesVisited = 0;
+	int numCityCulled = 0;
+	int numCityMismatches = 0;
+
+	for ( int frame = 0; frame < numFrames; frame++ )
+	{
+		const Matrix4f viewMatrix = ( Matrix4f::Translation( 0.0f, 2.0f, 0.0f ) * Matrix4f::RotationY( frame * 0.05f ) ).Inverted();
+
+		const double start = LogCpuTime::GetNanoSeconds();
+		BuildDrawSurfaceList( flatList, arena, flatRenderList, viewMatrix, projectionMatrix );
+		const double middle = LogCpuTime::GetNanoSeconds();
+		BuildDrawSurfaceList( bvhList, monoArenas[0], bvhRenderList, viewMatrix, projectionMatrix );
+		const double end = LogCpuTime::GetNanoSeconds();
+
+		flatTime += middle - start;
+		bvhTime += end - middle;
+		numCityDrawn += bvhList.numDrawSurfaces;
+		numNodesVisited += bvhList.numCullNodesVisited;
+		numCityCulled += bvhList.numCulledSurfaces;
+
+		// The surfaces are added in a different order, so compare the sets.
+		flatIndices.Resize( flatList.numDrawSurfaces );
+		for ( int i = 0; i < flatList.numDrawSurfaces; i++ )
+		{
+			flatIndices[i] = (int)( flatList.drawSurfaces[i].surface - flatModelDef.surfaces.GetDataPtr() );
+		}
+		bvhIndices.Resize( bvhList.numDrawSurfaces );
+		for ( int i = 0; i < bvhList.numDrawSurfaces; i++ )
+		{
+			bvhIndices[i] = (int)( bvhList.drawSurfaces[i].surface - bvhModelDef.surfaces.GetDataPtr() );
+		}
+		Alg::QuickSort( flatIndices );
+		Alg::QuickSort( bvhIndices );
+		if ( flatIndices.GetSize() != bvhIndices.GetSize() || flatList.numCulledSurfaces != bvhList.numCulledSurfaces )
+		{
+			numCityMismatches++;
+			continue;
+		}
+		for ( int i = 0; i < flatIndices.GetSizeI(); i++ )
+		{
+			if ( flatIndices[i] != bvhIndices[i] )
+			{
+				numCityMismatches++;
+				break;
+			}
+		}
+	}
+
+	LOG( "cullBenchmark: BVH, %d surfaces, %d nodes built in %1.3f ms, %1.1f drawn on average",
+			numSurfaces, bvhModelDef.surfaceBvh.GetSizeI(), ( bvhEnd - bvhStart ) * 1e-6, (double)numCityDrawn / numFrames );
+	LOG( "cullBenchmark: BVH, flat %1.3f ms/frame, BVH %1.3f ms/frame, speedup %1.2fx",
+			flatTime * 1e-6 / numFrames, bvhTime * 1e-6 / numFrames, flatTime / Alg::Max( bvhTime, 1.0 ) );
+	LOG( "cullBenchmark: BVH, %1.1f nodes visited for %1.1f surfaces culled per frame, %d mismatched frames over %d frames",
+			(double)numNodesVisited / numFrames, (double)numCityCulled / numFrames, numCityMismatches, numFrames );
+}
+
 }	// namespace OVR
@@ -125,6 +125,19 @@ struct SurfaceDef
 	MaterialDef		materialDef;
 };
 
+// Node of the bounding volume hierarchy over the surfaces of a ModelDef.
+// The nodes are stored depth first, so the children of a node follow it and
+// skipNode is the first node after its subtree. A node is a leaf when
+// skipNode is the next node, and a leaf has at most four surfaces.
+// The surfaces of any subtree are a contiguous range of surfaceBvhIndices.
+struct SurfaceBvhNode
+{
+	Bounds3f	bounds;
+	int			firstSurface;
+	int			numSurfaces;
+	int			skipNode;
+};
+
 // This data is constant after model load, and can be referenced by
 // multiple ModelState instances.
 struct ModelDef
@@ -132,8 +145,19 @@ struct ModelDef
 	ModelDef() {};
 
 	OVR::Array<SurfaceDef>	surfaces;
+
+	// Built by BuildSurfaceBvh(), the surfaces are culled one at a time
+	// if this is empty or out of date with the number of surfaces.
+	OVR::Array<SurfaceBvhNode>	surfaceBvh;
+	OVR::ArrayPOD<int>			surfaceBvhIndices;
 };
 
+// Builds the bounding volume hierarchy that lets BuildDrawSurfaceList() reject
+// whole groups of surfaces at once. Only worthwhile for models with many surfaces,
+// nothing is built for small models. Needs to be called again after adding
+// surfaces or growing their culling bounds.
+void BuildSurfaceBvh( ModelDef & modelDef );
+
 struct SurfaceTextureOverload
 {
 	SurfaceTextureOverload() : SurfaceIndex( 0 ), TextureId( 0 ) { }
@@ -177,13 +201,16 @@ struct ModelState
 
 struct DrawCounters
 {
-	DrawCounters() : numElements( 0 ), numDrawCalls( 0 ), numProgramBinds( 0 ), numParameterUpdates( 0 ), numTextureBinds( 0 ) {}
+	DrawCounters() : numElements( 0 ), numDrawCalls( 0 ), numProgramBinds( 0 ), numParameterUpdates( 0 ), numTextureBinds( 0 ),
+		numCullNodesVisited( 0 ), numCulledSurfaces( 0 ) {}
 
 	int		numElements;
 	int		numDrawCalls;
 	int		numProgramBinds;
 	int		numParameterUpdates;		// MVP, etc
 	int		numTextureBinds;
+	int		numCullNodesVisited;		// surface BVH nodes tested while building the list
+	int		numCulledSurfaces;			// from the list
 };
 
 struct DrawMatrices
@@ -207,25 +234,65 @@ struct DrawSurface
 
 struct DrawSurfaceList
 {
+	DrawSurfaceList() : numCullNodesVisited( 0 ), numCulledSurfaces( 0 ), numDrawSurfaces( 0 ), drawSurfaces( NULL ) {}
+
 	Matrix4f				viewMatrix;				// OpenGL column major
 	Matrix4f				projectionMatrix;		// OpenGL column major
+	int						numCullNodesVisited;	// just for developer feedback
 	int						numCulledSurfaces;		// just for developer feedback
 	int						numDrawSurfaces;
 	const DrawSurface *		drawSurfaces;
 };
 
+// The arrays only ever grow, so once they are large enough for the scene
+// building a list does not allocate anything.
+typedef ArrayConstPolicy< 0, 16, true > DrawSurfaceArenaPolicy;
+
+// Storage for building a DrawSurfaceList, owned by the caller. Every view
+// that is built at the same time, like the two eyes or a shadow view,
+// needs its own arena. A list points into its arena, so it stays valid
+// until the arena is used for the next build.
+struct DrawSurfaceArena
+{
+	ArrayPOD< DrawMatrices, DrawSurfaceArenaPolicy >	matrices;
+	ArrayPOD< DrawSurface, DrawSurfaceArenaPolicy >		drawSurfaces;
+	ArrayPOD< DrawSurface, DrawSurfaceArenaPolicy >		unsortedSurfaces;
+	ArrayPOD< UInt32, DrawSurfaceArenaPolicy >			sortKeys;
+	ArrayPOD< UInt32, DrawSurfaceArenaPolicy >			tempKeys;
+	ArrayPOD< int, DrawSurfaceArenaPolicy >				sortIndices;
+	ArrayPOD< int, DrawSurfaceArenaPolicy >				tempIndices;
+};
 
 // Culls the surfaces in the model list to the MVP matrix and sorts front to back.
-// Not thread safe, uses a static buffer for the surfaces.
+// There is no limit on the number of models or surfaces. Thread safe as long as
+// every thread uses its own arena, so the eye views can be built in parallel.
 // Additional, application specific culling or surface insertion can be done on the
 // results of this call before calling DrawSurfaceList.
-const DrawSurfaceList & BuildDrawSurfaceList( const OVR::Array<ModelState> & modelRenderList,
+void BuildDrawSurfaceList( DrawSurfaceList & surfaceList, DrawSurfaceArena & arena,
+							const OVR::Array<ModelState> & modelRenderList,
 							const Matrix4f & viewMatrix, const Matrix4f & projectionMatrix );
 
+// Builds the lists for both eyes in a single pass. When the clip planes of the eyes
+// are parallel, which is the case for the same projection and orientation with an
+// eye offset, the surfaces are culled once against a frustum that contains both
+// eyes and each eye gets its own sort order. Otherwise this is two separate builds.
+// Each eye list points into the arena of that eye.
+void BuildStereoDrawSurfaceLists( DrawSurfaceList surfaceLists[2], DrawSurfaceArena arenas[2],
+							const OVR::Array<ModelState> & modelRenderList,
+							const Matrix4f viewMatrices[2], const Matrix4f projectionMatrices[2] );
+
 // Draws a list of surfaces in order.
 // Any sorting or culling should be performed before calling.
 DrawCounters RenderSurfaceList( const DrawSurfaceList & drawSurfaceList );
 
+// Builds draw surface lists for synthetic models while looking around, and logs
+// the CPU time per frame against culling all bounds corners and sorting with qsort,
+// of a stereo build against building both eyes separately, and of culling a
+// single large model with and without the surface BVH.
+// Registered as the "cullBenchmark" console command, optional parms:
+// "<number of surfaces> <number of frames>"
+void DrawSurfaceCullBenchmark( void * appPtr, const char * cmd );
+
 } // namespace OVR
 
 #endif	// OVR_ModelRender_h
@@ -11,6 +11,7 @@ Copyright   :   Copyright 2014 Oculus VR, LLC. All Rights reserved.
 
 #include "ModelView.h"
 
+#include <string.h>		// memcmp
 
 #include "Input.h"		// VrFrame, etc
 #include "BitmapFont.h"
@@ -82,6 +83,7 @@ const Vector3f	ForwardVector( 0.0f, 0.0f, -1.0f );
 const Vector3f	RightVector( 1.0f, 0.0f, 0.0f );
 
 OvrSceneView::OvrSceneView() :
+	StereoSurfaceListValid( false ),
 	FreeWorldModelOnChange( false ),
 	SceneId( 0 ),
 	LoadedPrograms( false ),
@@ -250,8 +252,28 @@ Matrix4f OvrSceneView::DrawEyeView( const int eye, const float fovDegrees ) cons
 	const Matrix4f projectionMatrix = ProjectionMatrixForEye( eye, fovDegrees );
 	const Matrix4f viewMatrix = ViewMatrixForEye( eye );
 
-	const DrawSurfaceList & surfs = BuildDrawSurfaceList( RenderModels, viewMatrix, projectionMatrix );
-	(void)RenderSurfaceList( surfs );
+	if ( eye == 0 )
+	{
+		// Cull once for both eyes, the right eye list is kept for the next call.
+		const Matrix4f viewMatrices[2] = { viewMatrix, ViewMatrixForEye( 1 ) };
+		const Matrix4f projectionMatrices[2] = { projectionMatrix, ProjectionMatrixForEye( 1, fovDegrees ) };
+		BuildStereoDrawSurfaceLists( EyeSurfaceLists, EyeSurfaceArenas, RenderModels, viewMatrices, projectionMatrices );
+		StereoViewMatrix = viewMatrices[1];
+		StereoProjectionMatrix = projectionMatrices[1];
+		StereoSurfaceListValid = true;
+	}
+	else if ( !StereoSurfaceListValid || eye != 1 ||
+			memcmp( &StereoViewMatrix, &viewMatrix, sizeof( viewMatrix ) ) != 0 ||
+			memcmp( &StereoProjectionMatrix, &projectionMatrix, sizeof( projectionMatrix ) ) != 0 )
+	{
+		BuildDrawSurfaceList( EyeSurfaceLists[eye & 1], EyeSurfaceArenas[eye & 1], RenderModels, viewMatrix, projectionMatrix );
+	}
+	if ( eye != 0 )
+	{
+		StereoSurfaceListValid = false;
+	}
+
+	(void)RenderSurfaceList( EyeSurfaceLists[eye & 1] );
 
 	return ( projectionMatrix * viewMatrix );
 }
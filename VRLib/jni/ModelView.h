@@ -102,6 +102,17 @@ public:
 	// rendering both eyes
 	Array<ModelState>		RenderModels;
 
+	// One per eye, so the eye views can be built independently.
+	// Mutable because DrawEyeView() is const.
+	mutable DrawSurfaceArena	EyeSurfaceArenas[2];
+
+	// Both eye lists are built when drawing the left eye, the right eye list
+	// is used if the right eye is drawn with the same matrices.
+	mutable DrawSurfaceList		EyeSurfaceLists[2];
+	mutable Matrix4f			StereoViewMatrix;
+	mutable Matrix4f			StereoProjectionMatrix;
+	mutable bool				StereoSurfaceListValid;
+
 	// The only ModelInScene that OvrSceneView actually owns.
 	bool					FreeWorldModelOnChange;
 	ModelInScene			WorldModel;
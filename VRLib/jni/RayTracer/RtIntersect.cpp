@@ -17,8 +17,94 @@ Copyright   :   Copyright 2014 Oculus VR, LLC. All Rights reserved.
 #include "Kernel/OVR_Math.h"
 #include "Kernel/OVR_Alg.h"
 
+#if defined( OVR_CPU_SSE )
+#include <xmmintrin.h>
+#elif defined( OVR_CPU_ARM_NEON )
+#include <arm_neon.h>
+#endif
+
 using namespace OVR;
 
+/*
+	Minimal four-wide float operations for the packet intersection routines.
+*/
+
+#if defined( OVR_CPU_SSE )
+
+typedef __m128 rtFloat4;
+typedef __m128 rtMask4;
+
+static inline rtFloat4	rtLoad( const float * p ) { return _mm_loadu_ps( p ); }
+static inline void		rtStore( float * p, const rtFloat4 a ) { _mm_storeu_ps( p, a ); }
+static inline rtFloat4	rtSplat( const float f ) { return _mm_set1_ps( f ); }
+static inline rtFloat4	rtAdd( const rtFloat4 a, const rtFloat4 b ) { return _mm_add_ps( a, b ); }
+static inline rtFloat4	rtSub( const rtFloat4 a, const rtFloat4 b ) { return _mm_sub_ps( a, b ); }
+static inline rtFloat4	rtMul( const rtFloat4 a, const rtFloat4 b ) { return _mm_mul_ps( a, b ); }
+static inline rtFloat4	rtDiv( const rtFloat4 a, const rtFloat4 b ) { return _mm_div_ps( a, b ); }
+static inline rtFloat4	rtMin( const rtFloat4 a, const rtFloat4 b ) { return _mm_min_ps( a, b ); }
+static inline rtFloat4	rtMax( const rtFloat4 a, const rtFloat4 b ) { return _mm_max_ps( a, b ); }
+static inline rtMask4	rtLess( const rtFloat4 a, const rtFloat4 b ) { return _mm_cmplt_ps( a, b ); }
+static inline rtMask4	rtLessEqual( const rtFloat4 a, const rtFloat4 b ) { return _mm_cmple_ps( a, b ); }
+static inline rtMask4	rtAnd( const rtMask4 a, const rtMask4 b ) { return _mm_and_ps( a, b ); }
+static inline int		rtMaskBits( const rtMask4 a ) { return _mm_movemask_ps( a ); }
+
+#elif defined( OVR_CPU_ARM_NEON )
+
+typedef float32x4_t rtFloat4;
+typedef uint32x4_t rtMask4;
+
+static inline rtFloat4	rtLoad( const float * p ) { return vld1q_f32( p ); }
+static inline void		rtStore( float * p, const rtFloat4 a ) { vst1q_f32( p, a ); }
+static inline rtFloat4	rtSplat( const float f ) { return vdupq_n_f32( f ); }
+static inline rtFloat4	rtAdd( const rtFloat4 a, const rtFloat4 b ) { return vaddq_f32( a, b ); }
+static inline rtFloat4	rtSub( const rtFloat4 a, const rtFloat4 b ) { return vsubq_f32( a, b ); }
+static inline rtFloat4	rtMul( const rtFloat4 a, const rtFloat4 b ) { return vmulq_f32( a, b ); }
+static inline rtFloat4	rtMin( const rtFloat4 a, const rtFloat4 b ) { return vminq_f32( a, b ); }
+static inline rtFloat4	rtMax( const rtFloat4 a, const rtFloat4 b ) { return vmaxq_f32( a, b ); }
+static inline rtMask4	rtLess( const rtFloat4 a, const rtFloat4 b ) { return vcltq_f32( a, b ); }
+static inline rtMask4	rtLessEqual( const rtFloat4 a, const rtFloat4 b ) { return vcleq_f32( a, b ); }
+static inline rtMask4	rtAnd( const rtMask4 a, const rtMask4 b ) { return vandq_u32( a, b ); }
+
+// There is no divide on ARMv7 NEON, so refine the reciprocal estimate with two
+// Newton-Raphson steps. That is not the correctly rounded divide, but the
+// reciprocal is within 2 ulp of it, see MaxReciprocal4UlpError().
+static inline rtFloat4 rtDiv( const rtFloat4 a, const rtFloat4 b )
+{
+	rtFloat4 r = vrecpeq_f32( b );
+	r = vmulq_f32( vrecpsq_f32( b, r ), r );
+	r = vmulq_f32( vrecpsq_f32( b, r ), r );
+	return vmulq_f32( a, r );
+}
+
+static inline int rtMaskBits( const rtMask4 a )
+{
+	static const uint32_t bits[4] = { 1, 2, 4, 8 };
+	const uint32x4_t m = vandq_u32( a, vld1q_u32( bits ) );
+	const uint32x2_t r = vorr_u32( vget_low_u32( m ), vget_high_u32( m ) );
+	return (int)( vget_lane_u32( r, 0 ) | vget_lane_u32( r, 1 ) );
+}
+
+#else
+
+struct rtFloat4 { float v[4]; };
+typedef int rtMask4;
+
+static inline rtFloat4	rtLoad( const float * p ) { rtFloat4 r; for ( int i = 0; i < 4; i++ ) { r.v[i] = p[i]; } return r; }
+static inline void		rtStore( float * p, const rtFloat4 a ) { for ( int i = 0; i < 4; i++ ) { p[i] = a.v[i]; } }
+static inline rtFloat4	rtSplat( const float f ) { rtFloat4 r; for ( int i = 0; i < 4; i++ ) { r.v[i] = f; } return r; }
+static inline rtFloat4	rtAdd( const rtFloat4 a, const rtFloat4 b ) { rtFloat4 r; for ( int i = 0; i < 4; i++ ) { r.v[i] = a.v[i] + b.v[i]; } return r; }
+static inline rtFloat4	rtSub( const rtFloat4 a, const rtFloat4 b ) { rtFloat4 r; for ( int i = 0; i < 4; i++ ) { r.v[i] = a.v[i] - b.v[i]; } return r; }
+static inline rtFloat4	rtMul( const rtFloat4 a, const rtFloat4 b ) { rtFloat4 r; for ( int i = 0; i < 4; i++ ) { r.v[i] = a.v[i] * b.v[i]; } return r; }
+static inline rtFloat4	rtDiv( const rtFloat4 a, const rtFloat4 b ) { rtFloat4 r; for ( int i = 0; i < 4; i++ ) { r.v[i] = a.v[i] / b.v[i]; } return r; }
+static inline rtFloat4	rtMin( const rtFloat4 a, const rtFloat4 b ) { rtFloat4 r; for ( int i = 0; i < 4; i++ ) { r.v[i] = Alg::Min( a.v[i], b.v[i] ); } return r; }
+static inline rtFloat4	rtMax( const rtFloat4 a, const rtFloat4 b ) { rtFloat4 r; for ( int i = 0; i < 4; i++ ) { r.v[i] = Alg::Max( a.v[i], b.v[i] ); } return r; }
+static inline rtMask4	rtLess( const rtFloat4 a, const rtFloat4 b ) { rtMask4 r = 0; for ( int i = 0; i < 4; i++ ) { r |= ( a.v[i] < b.v[i] ) << i; } return r; }
+static inline rtMask4	rtLessEqual( const rtFloat4 a, const rtFloat4 b ) { rtMask4 r = 0; for ( int i = 0; i < 4; i++ ) { r |= ( a.v[i] <= b.v[i] ) << i; } return r; }
+static inline rtMask4	rtAnd( const rtMask4 a, const rtMask4 b ) { return a & b; }
+static inline int		rtMaskBits( const rtMask4 a ) { return a; }
+
+#endif
+
 bool RtIntersect::RayBounds( const Vector3f & rayStart, const Vector3f & rayDir,
 							const Vector3f & mins, const Vector3f & maxs,
 							float & t0, float & t1 )
@@ -98,3 +184,148 @@ bool RtIntersect::RayTriangle( const Vector3f & rayStart, const Vector3f & rayDi
 
 	return false;
 }
+
+void RtIntersect::SetPacketRay( RayPacket4 & rays, const int lane, const Vector3f & rayStart, const Vector3f & rayDir )
+{
+	for ( int i = 0; i < 3; i++ )
+	{
+		rays.start[i][lane] = rayStart[i];
+		rays.dir[i][lane] = rayDir[i];
+		rays.rcpDir[i][lane] = ( fabsf( rayDir[i] ) > Math<float>::SmallestNonDenormal ) ? ( 1.0f / rayDir[i] ) : Math<float>::HugeNumber;
+	}
+}
+
+int RtIntersect::RayBounds4( const RayPacket4 & rays,
+							const Vector3f & mins, const Vector3f & maxs,
+							float t0[4], float t1[4], int exitPlanes[4] )
+{
+	rtFloat4 lo[3];
+	rtFloat4 hi[3];
+	int maxsSide[3];
+
+	for ( int i = 0; i < 3; i++ )
+	{
+		const rtFloat4 start = rtLoad( rays.start[i] );
+		const rtFloat4 rcpDir = rtLoad( rays.rcpDir[i] );
+		const rtFloat4 s = rtMul( rtSub( rtSplat( mins[i] ), start ), rcpDir );
+		const rtFloat4 t = rtMul( rtSub( rtSplat( maxs[i] ), start ), rcpDir );
+		lo[i] = rtMin( s, t );
+		hi[i] = rtMax( s, t );
+		maxsSide[i] = rtMaskBits( rtLess( s, t ) );
+	}
+
+	const rtFloat4 near = rtMax( lo[0], rtMax( lo[1], lo[2] ) );
+	const rtFloat4 far = rtMin( hi[0], rtMin( hi[1], hi[2] ) );
+
+	rtStore( t0, near );
+	rtStore( t1, far );
+
+	if ( exitPlanes != NULL )
+	{
+		float h[3][4];
+		rtStore( h[0], hi[0] );
+		rtStore( h[1], hi[1] );
+		rtStore( h[2], hi[2] );
+
+		for ( int lane = 0; lane < 4; lane++ )
+		{
+			const int exitX = ( 0 << 1 ) | ( ( maxsSide[0] >> lane ) & 1 );
+			const int exitY = ( 1 << 1 ) | ( ( maxsSide[1] >> lane ) & 1 );
+			const int exitZ = ( 2 << 1 ) | ( ( maxsSide[2] >> lane ) & 1 );
+			exitPlanes[lane] = ( h[0][lane] < h[1][lane] ) ? ( h[0][lane] < h[2][lane] ? exitX : exitZ ) : ( h[1][lane] < h[2][lane] ? exitY : exitZ );
+		}
+	}
+
+	return rtMaskBits( rtLessEqual( near, far ) );
+}
+
+int RtIntersect::MaxReciprocal4UlpError()
+{
+	union float4_t
+	{
+		float	f[4];
+		UInt32	u[4];
+	};
+
+	// A power of two only changes the exponent of the reciprocal,
+	// so the floats in [1,2) cover all of the normal range.
+	const rtFloat4 one = rtSplat( 1.0f );
+	int maxUlp = 0;
+	for ( UInt32 bits = 0x3F800000; bits < 0x40000000; bits += 4 )
+	{
+		float4_t x;
+		float4_t r;
+		for ( int i = 0; i < 4; i++ )
+		{
+			x.u[i] = bits + i;
+		}
+		rtStore( r.f, rtDiv( one, rtLoad( x.f ) ) );
+		for ( int i = 0; i < 4; i++ )
+		{
+			float4_t d;
+			d.f[0] = 1.0f / x.f[i];
+			maxUlp = Alg::Max( maxUlp, Alg::Abs( (int)( r.u[i] - d.u[0] ) ) );
+		}
+	}
+	return maxUlp;
+}
+
+int RtIntersect::RayTriangle4( const RayPacket4 & rays,
+							const Vector3f & v0, const Vector3f & v1, const Vector3f & v2,
+							float t0[4], float u[4], float v[4] )
+{
+	const Vector3f edge1 = v1 - v0;
+	const Vector3f edge2 = v2 - v0;
+
+	const rtFloat4 e1x = rtSplat( edge1.x );
+	const rtFloat4 e1y = rtSplat( edge1.y );
+	const rtFloat4 e1z = rtSplat( edge1.z );
+	const rtFloat4 e2x = rtSplat( edge2.x );
+	const rtFloat4 e2y = rtSplat( edge2.y );
+	const rtFloat4 e2z = rtSplat( edge2.z );
+
+	const rtFloat4 dx = rtLoad( rays.dir[0] );
+	const rtFloat4 dy = rtLoad( rays.dir[1] );
+	const rtFloat4 dz = rtLoad( rays.dir[2] );
+
+	const rtFloat4 tvx = rtSub( rtLoad( rays.start[0] ), rtSplat( v0.x ) );
+	const rtFloat4 tvy = rtSub( rtLoad( rays.start[1] ), rtSplat( v0.y ) );
+	const rtFloat4 tvz = rtSub( rtLoad( rays.start[2] ), rtSplat( v0.z ) );
+
+	// pv = rayDir.Cross( edge2 )
+	const rtFloat4 pvx = rtSub( rtMul( dy, e2z ), rtMul( dz, e2y ) );
+	const rtFloat4 pvy = rtSub( rtMul( dz, e2x ), rtMul( dx, e2z ) );
+	const rtFloat4 pvz = rtSub( rtMul( dx, e2y ), rtMul( dy, e2x ) );
+
+	// qv = tv.Cross( edge1 )
+	const rtFloat4 qvx = rtSub( rtMul( tvy, e1z ), rtMul( tvz, e1y ) );
+	const rtFloat4 qvy = rtSub( rtMul( tvz, e1x ), rtMul( tvx, e1z ) );
+	const rtFloat4 qvz = rtSub( rtMul( tvx, e1y ), rtMul( tvy, e1x ) );
+
+	const rtFloat4 det = rtAdd( rtAdd( rtMul( e1x, pvx ), rtMul( e1y, pvy ) ), rtMul( e1z, pvz ) );
+	const rtFloat4 s = rtAdd( rtAdd( rtMul( tvx, pvx ), rtMul( tvy, pvy ) ), rtMul( tvz, pvz ) );
+	const rtFloat4 t = rtAdd( rtAdd( rtMul( dx, qvx ), rtMul( dy, qvy ) ), rtMul( dz, qvz ) );
+
+	// Same tests as RayTriangle(), back facing triangles are culled.
+	const rtFloat4 zero = rtSplat( 0.0f );
+	rtMask4 hit = rtLess( rtSplat( Math<float>::SmallestNonDenormal ), det );
+	hit = rtAnd( hit, rtLessEqual( zero, s ) );
+	hit = rtAnd( hit, rtLessEqual( s, det ) );
+	hit = rtAnd( hit, rtLessEqual( zero, t ) );
+	hit = rtAnd( hit, rtLessEqual( rtAdd( s, t ), det ) );
+
+	const int mask = rtMaskBits( hit );
+	if ( mask == 0 )
+	{
+		return 0;
+	}
+
+	const rtFloat4 rcpDet = rtDiv( rtSplat( 1.0f ), det );
+	const rtFloat4 dist = rtAdd( rtAdd( rtMul( e2x, qvx ), rtMul( e2y, qvy ) ), rtMul( e2z, qvz ) );
+
+	rtStore( t0, rtMul( dist, rcpDet ) );
+	rtStore( u, rtMul( s, rcpDet ) );
+	rtStore( v, rtMul( t, rcpDet ) );
+
+	return mask;
+}
@@ -44,6 +44,45 @@ namespace RtIntersect
 	bool RayTriangle( const OVR::Vector3f & rayStart, const OVR::Vector3f & rayDir,
 					const OVR::Vector3f & v0, const OVR::Vector3f & v1, const OVR::Vector3f & v2,
 					float & t0, float & u, float & v );
+
+	/*
+		Four rays stored as a structure of arrays for the packet versions below.
+		The lanes are processed with SSE or NEON when available.
+	*/
+	struct RayPacket4
+	{
+		float	start[3][4];
+		float	dir[3][4];
+		float	rcpDir[3][4];
+	};
+
+	// Sets one lane of the packet. The direction must be normalized.
+	void SetPacketRay( RayPacket4 & rays, const int lane, const OVR::Vector3f & rayStart, const OVR::Vector3f & rayDir );
+
+	/*
+		Same as RayBounds() for four rays at a time.
+		Returns a bit mask of the rays that intersect the bounds.
+		If 'exitPlanes' is not NULL, it is set to the face through which each ray
+		leaves the bounds: ( axis << 1 ) | ( 1 if the ray leaves through the maxs ).
+	*/
+	int RayBounds4( const RayPacket4 & rays,
+					const OVR::Vector3f & mins, const OVR::Vector3f & maxs,
+					float t0[4], float t1[4], int exitPlanes[4] );
+
+	/*
+		Same as RayTriangle() for four rays at a time.
+		Returns a bit mask of the rays that intersect the triangle.
+	*/
+	int RayTriangle4( const RayPacket4 & rays,
+					const OVR::Vector3f & v0, const OVR::Vector3f & v1, const OVR::Vector3f & v2,
+					float t0[4], float u[4], float v[4] );
+
+	/*
+		Returns the largest difference in ulp between the reciprocal the packet
+		versions use and the scalar 1.0f / x, over every float in [1,2).
+		This is 0 with SSE, and at most 2 with NEON, which has no divide.
+	*/
+	int MaxReciprocal4UlpError();
 }
 
 #endif // !__RTINTERSECT_H__
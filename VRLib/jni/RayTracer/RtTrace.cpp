@@ -31,68 +31,52 @@ using namespace OVR;
 
 const int RT_KDTREE_MAX_ITERATIONS	= 128;
 
-traceResult_t RtTrace::Trace( const Vector3f & start, const Vector3f & end ) const
+// Calculates the distance to the exit point of the leaf and the plane through which the ray leaves.
+static inline float LeafExit( const kdtree_leaf_t * leaf, const Vector3f & start, const Vector3f & rcpRayDir, int & exitPlane )
 {
-	traceResult_t result;
-	result.triangleIndex = -1;
-	result.fraction = 1.0f;
-	result.uv = Vector2f( 0.0f );
-	result.normal = Vector3f( 0.0f );
-
-	const Vector3f rayDelta = end - start;
-	const float rayLengthSqr = rayDelta.LengthSq();
-	const float rayLengthRcp = RcpSqrt( rayLengthSqr );
-	const float rayLength = rayLengthSqr * rayLengthRcp;
-	const Vector3f rayDir = rayDelta * rayLengthRcp;
-
-	const float rcpRayDirX = ( fabsf( rayDir.x ) > Math<float>::SmallestNonDenormal ) ? ( 1.0f / rayDir.x ) : Math<float>::HugeNumber;
-	const float rcpRayDirY = ( fabsf( rayDir.y ) > Math<float>::SmallestNonDenormal ) ? ( 1.0f / rayDir.y ) : Math<float>::HugeNumber;
-	const float rcpRayDirZ = ( fabsf( rayDir.z ) > Math<float>::SmallestNonDenormal ) ? ( 1.0f / rayDir.z ) : Math<float>::HugeNumber;
-
-	const float sX = ( header.bounds.GetMins()[0] - start.x ) * rcpRayDirX;
-	const float sY = ( header.bounds.GetMins()[1] - start.y ) * rcpRayDirY;
-	const float sZ = ( header.bounds.GetMins()[2] - start.z ) * rcpRayDirZ;
+	const float sX = ( leaf->bounds.GetMins()[0] - start.x ) * rcpRayDir.x;
+	const float sY = ( leaf->bounds.GetMins()[1] - start.y ) * rcpRayDir.y;
+	const float sZ = ( leaf->bounds.GetMins()[2] - start.z ) * rcpRayDir.z;
 
-	const float tX = ( header.bounds.GetMaxs()[0] - start.x ) * rcpRayDirX;
-	const float tY = ( header.bounds.GetMaxs()[1] - start.y ) * rcpRayDirY;
-	const float tZ = ( header.bounds.GetMaxs()[2] - start.z ) * rcpRayDirZ;
-
-	const float minX = Alg::Min( sX, tX );
-	const float minY = Alg::Min( sY, tY );
-	const float minZ = Alg::Min( sZ, tZ );
+	const float tX = ( leaf->bounds.GetMaxs()[0] - start.x ) * rcpRayDir.x;
+	const float tY = ( leaf->bounds.GetMaxs()[1] - start.y ) * rcpRayDir.y;
+	const float tZ = ( leaf->bounds.GetMaxs()[2] - start.z ) * rcpRayDir.z;
 
 	const float maxX = Alg::Max( sX, tX );
 	const float maxY = Alg::Max( sY, tY );
 	const float maxZ = Alg::Max( sZ, tZ );
 
-	const float t0 = Alg::Max( minX, Alg::Max( minY, minZ ) );
-	const float t1 = Alg::Min( maxX, Alg::Min( maxY, maxZ ) );
+	const int exitX = ( 0 << 1 ) | ( ( sX < tX ) ? 1 : 0 );
+	const int exitY = ( 1 << 1 ) | ( ( sY < tY ) ? 1 : 0 );
+	const int exitZ = ( 2 << 1 ) | ( ( sZ < tZ ) ? 1 : 0 );
+	exitPlane = ( maxX < maxY ) ? ( maxX < maxZ ? exitX : exitZ ) : ( maxY < maxZ ? exitY : exitZ );
 
-	if ( t0 >= t1 )
-	{
-		return result;
-	}
+	return Alg::Min( maxX, Alg::Min( maxY, maxZ ) );
+}
 
-	float entryDistance = Alg::Max( t0, 0.0f );
-	float bestDistance = Alg::Min( t1 + 0.00001f, rayLength );
-	Vector2f uv;
-	
-	const kdtree_node_t * currentNode = &nodes[0];
-	
-	for ( int i = 0; i < RT_KDTREE_MAX_ITERATIONS; i++ )
+// Select the child node based on whether the entry point is left or right of the split plane.
+// If the entry point is directly at the split plane then choose the side based on the ray direction.
+static inline int SelectChild( const kdtree_node_t * node, const float entryPoint, const float rayDir )
+{
+	const float d = entryPoint - node->dist;
+	if ( d < 0.00001f ) return 0;
+	if ( d > 0.00001f ) return 1;
+	return ( rayDir > 0.0f );
+}
+
+void RtTrace::TraceLeafs( const Vector3f & start, const Vector3f & rayDir, const Vector3f & rcpRayDir,
+						const kdtree_node_t * currentNode, float entryDistance, float & bestDistance,
+						int & triangleIndex, Vector2f & uv, const int maxIterations ) const
+{
+	for ( int i = 0; i < maxIterations; i++ )
 	{
 		const Vector3f rayEntryPoint = start + rayDir * entryDistance;
 
 		// Step down the tree until a leaf node is found.
 		while ( ( currentNode->data & 1 ) == 0 )
 		{
-			// Select the child node based on whether the entry point is left or right of the split plane.
-			// If the entry point is directly at the split plane then choose the side based on the ray direction.
 			const int nodePlane = ( ( currentNode->data >> 1 ) & 3 );
-			int child;
-			if ( rayEntryPoint[nodePlane] - currentNode->dist < 0.00001f ) child = 0;
-			else if ( rayEntryPoint[nodePlane] - currentNode->dist > 0.00001f ) child = 1;
-			else child = ( rayDelta[nodePlane] > 0.0f );
+			const int child = SelectChild( currentNode, rayEntryPoint[nodePlane], rayDir[nodePlane] );
 			currentNode = &nodes[( currentNode->data >> 3 ) + child];
 		}
 
@@ -130,7 +114,7 @@ traceResult_t RtTrace::Trace( const Vector3f & start, const Vector3f & end ) con
 				{
 					bestDistance = distance;
 
-					result.triangleIndex = currentTriangle * 3;
+					triangleIndex = currentTriangle * 3;
 					uv.x = u;
 					uv.y = v;
 				}
@@ -138,30 +122,13 @@ traceResult_t RtTrace::Trace( const Vector3f & start, const Vector3f & end ) con
 		}
 
 		// Calculate the distance along the ray where the next leaf is entered.
-		const float sX = ( currentLeaf->bounds.GetMins()[0] - start.x ) * rcpRayDirX;
-		const float sY = ( currentLeaf->bounds.GetMins()[1] - start.y ) * rcpRayDirY;
-		const float sZ = ( currentLeaf->bounds.GetMins()[2] - start.z ) * rcpRayDirZ;
-
-		const float tX = ( currentLeaf->bounds.GetMaxs()[0] - start.x ) * rcpRayDirX;
-		const float tY = ( currentLeaf->bounds.GetMaxs()[1] - start.y ) * rcpRayDirY;
-		const float tZ = ( currentLeaf->bounds.GetMaxs()[2] - start.z ) * rcpRayDirZ;
-
-		const float maxX = Alg::Max( sX, tX );
-		const float maxY = Alg::Max( sY, tY );
-		const float maxZ = Alg::Max( sZ, tZ );
-
-		entryDistance = Alg::Min( maxX, Alg::Min( maxY, maxZ ) );
+		int exitPlane;
+		entryDistance = LeafExit( currentLeaf, start, rcpRayDir, exitPlane );
 		if ( entryDistance >= bestDistance )
 		{
 			break;
 		}
 
-		// Calculate the exit plane.
-		const int exitX = ( 0 << 1 ) | ( ( sX < tX ) ? 1 : 0 );
-		const int exitY = ( 1 << 1 ) | ( ( sY < tY ) ? 1 : 0 );
-		const int exitZ = ( 2 << 1 ) | ( ( sZ < tZ ) ? 1 : 0 );
-		const int exitPlane = ( maxX < maxY ) ? ( maxX < maxZ ? exitX : exitZ ) : ( maxY < maxZ ? exitY : exitZ );
-
 		// Use a rope to enter the adjacent leaf.
 		const int exitNodeIndex = currentLeaf->ropes[exitPlane];
 		if ( exitNodeIndex == -1 )
@@ -171,6 +138,16 @@ traceResult_t RtTrace::Trace( const Vector3f & start, const Vector3f & end ) con
 
 		currentNode = &nodes[exitNodeIndex];
 	}
+}
+
+traceResult_t RtTrace::GetResult( const int triangleIndex, const float bestDistance,
+								const float rayLengthRcp, const Vector2f & uv ) const
+{
+	traceResult_t result;
+	result.triangleIndex = triangleIndex;
+	result.fraction = 1.0f;
+	result.uv = Vector2f( 0.0f );
+	result.normal = Vector3f( 0.0f );
 
 	if ( result.triangleIndex != -1 )
 	{
@@ -186,6 +163,247 @@ traceResult_t RtTrace::Trace( const Vector3f & start, const Vector3f & end ) con
 	return result;
 }
 
+traceResult_t RtTrace::Trace( const Vector3f & start, const Vector3f & end ) const
+{
+	const Vector3f rayDelta = end - start;
+	const float rayLengthSqr = rayDelta.LengthSq();
+	const float rayLengthRcp = RcpSqrt( rayLengthSqr );
+	const float rayLength = rayLengthSqr * rayLengthRcp;
+	const Vector3f rayDir = rayDelta * rayLengthRcp;
+
+	const Vector3f rcpRayDir(
+		( fabsf( rayDir.x ) > Math<float>::SmallestNonDenormal ) ? ( 1.0f / rayDir.x ) : Math<float>::HugeNumber,
+		( fabsf( rayDir.y ) > Math<float>::SmallestNonDenormal ) ? ( 1.0f / rayDir.y ) : Math<float>::HugeNumber,
+		( fabsf( rayDir.z ) > Math<float>::SmallestNonDenormal ) ? ( 1.0f / rayDir.z ) : Math<float>::HugeNumber );
+
+	const float sX = ( header.bounds.GetMins()[0] - start.x ) * rcpRayDir.x;
+	const float sY = ( header.bounds.GetMins()[1] - start.y ) * rcpRayDir.y;
+	const float sZ = ( header.bounds.GetMins()[2] - start.z ) * rcpRayDir.z;
+
+	const float tX = ( header.bounds.GetMaxs()[0] - start.x ) * rcpRayDir.x;
+	const float tY = ( header.bounds.GetMaxs()[1] - start.y ) * rcpRayDir.y;
+	const float tZ = ( header.bounds.GetMaxs()[2] - start.z ) * rcpRayDir.z;
+
+	const float minX = Alg::Min( sX, tX );
+	const float minY = Alg::Min( sY, tY );
+	const float minZ = Alg::Min( sZ, tZ );
+
+	const float maxX = Alg::Max( sX, tX );
+	const float maxY = Alg::Max( sY, tY );
+	const float maxZ = Alg::Max( sZ, tZ );
+
+	const float t0 = Alg::Max( minX, Alg::Max( minY, minZ ) );
+	const float t1 = Alg::Min( maxX, Alg::Min( maxY, maxZ ) );
+
+	if ( t0 >= t1 )
+	{
+		return GetResult( -1, 0.0f, 0.0f, Vector2f( 0.0f ) );
+	}
+
+	float entryDistance = Alg::Max( t0, 0.0f );
+	float bestDistance = Alg::Min( t1 + 0.00001f, rayLength );
+	int triangleIndex = -1;
+	Vector2f uv;
+
+	TraceLeafs( start, rayDir, rcpRayDir, &nodes[0], entryDistance, bestDistance, triangleIndex, uv, RT_KDTREE_MAX_ITERATIONS );
+
+	return GetResult( triangleIndex, bestDistance, rayLengthRcp, uv );
+}
+
+void RtTrace::TraceLanes( const RtIntersect::RayPacket4 & rays, const int laneMask, const kdtree_node_t * currentNode,
+						float entryDistance[4], float bestDistance[4], int triangleIndex[4], Vector2f uv[4],
+						const int maxIterations ) const
+{
+	for ( int lane = 0; lane < 4; lane++ )
+	{
+		if ( laneMask & ( 1 << lane ) )
+		{
+			const Vector3f start( rays.start[0][lane], rays.start[1][lane], rays.start[2][lane] );
+			const Vector3f rayDir( rays.dir[0][lane], rays.dir[1][lane], rays.dir[2][lane] );
+			const Vector3f rcpRayDir( rays.rcpDir[0][lane], rays.rcpDir[1][lane], rays.rcpDir[2][lane] );
+			TraceLeafs( start, rayDir, rcpRayDir, currentNode, entryDistance[lane], bestDistance[lane],
+						triangleIndex[lane], uv[lane], maxIterations );
+		}
+	}
+}
+
+void RtTrace::TracePacket( const RtIntersect::RayPacket4 & rays, int activeMask, float entryDistance[4],
+						float bestDistance[4], int triangleIndex[4], Vector2f uv[4] ) const
+{
+	static const int bitCount[16] = { 0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4 };
+
+	const kdtree_node_t * currentNode = &nodes[0];
+
+	for ( int i = 0; i < RT_KDTREE_MAX_ITERATIONS; i++ )
+	{
+		// Step down the tree until a leaf node is found. The packet follows the
+		// child selected by most rays, the other rays are traced on their own.
+		while ( ( currentNode->data & 1 ) == 0 )
+		{
+			const int nodePlane = ( ( currentNode->data >> 1 ) & 3 );
+			int rightMask = 0;
+			for ( int lane = 0; lane < 4; lane++ )
+			{
+				if ( activeMask & ( 1 << lane ) )
+				{
+					const float entryPoint = rays.start[nodePlane][lane] + rays.dir[nodePlane][lane] * entryDistance[lane];
+					rightMask |= SelectChild( currentNode, entryPoint, rays.dir[nodePlane][lane] ) << lane;
+				}
+			}
+			const int leftMask = activeMask & ~rightMask;
+			const int child = ( bitCount[rightMask] > bitCount[leftMask] );
+			const int splitMask = child ? leftMask : rightMask;
+			if ( splitMask != 0 )
+			{
+				TraceLanes( rays, splitMask, &nodes[( currentNode->data >> 3 ) + ( child ^ 1 )],
+							entryDistance, bestDistance, triangleIndex, uv, RT_KDTREE_MAX_ITERATIONS - i );
+				activeMask &= ~splitMask;
+			}
+			currentNode = &nodes[( currentNode->data >> 3 ) + child];
+		}
+
+		// Test all rays against each triangle in this leaf.
+		const kdtree_leaf_t * currentLeaf = &leafs[( currentNode->data >> 3 )];
+		const int * leafTriangles = currentLeaf->triangles;
+		int leafTriangleCount = RT_KDTREE_MAX_LEAF_TRIANGLES;
+		for ( int j = 0; j < leafTriangleCount; j++ )
+		{
+			int currentTriangle = leafTriangles[j];
+			if ( currentTriangle < 0 )
+			{
+				if ( currentTriangle == -1 )
+				{
+					break;
+				}
+
+				const int offset = ( currentTriangle & 0x7FFFFFFF );
+				leafTriangles = &overflow[offset];
+				leafTriangleCount = header.numOverflow - offset;
+				j = 0;
+				currentTriangle = leafTriangles[0];
+			}
+
+			float distance[4];
+			float u[4];
+			float v[4];
+
+			const int hitMask = activeMask & RtIntersect::RayTriangle4( rays,
+											vertices[indices[currentTriangle * 3 + 0]],
+											vertices[indices[currentTriangle * 3 + 1]],
+											vertices[indices[currentTriangle * 3 + 2]], distance, u, v );
+			for ( int lane = 0; ( hitMask >> lane ) != 0; lane++ )
+			{
+				if ( ( hitMask & ( 1 << lane ) ) && distance[lane] >= 0.0f && distance[lane] < bestDistance[lane] )
+				{
+					bestDistance[lane] = distance[lane];
+
+					triangleIndex[lane] = currentTriangle * 3;
+					uv[lane].x = u[lane];
+					uv[lane].y = v[lane];
+				}
+			}
+		}
+
+		// Calculate the distance along each ray where the next leaf is entered.
+		float t0[4];
+		float t1[4];
+		int exitPlanes[4];
+		RtIntersect::RayBounds4( rays, currentLeaf->bounds.GetMins(), currentLeaf->bounds.GetMaxs(), t0, t1, exitPlanes );
+
+		// The packet follows the rope of the first ray, the other rays are traced on their own.
+		int exitNodeIndex = -1;
+		for ( int lane = 0; lane < 4; lane++ )
+		{
+			if ( ( activeMask & ( 1 << lane ) ) == 0 )
+			{
+				continue;
+			}
+			entryDistance[lane] = t1[lane];
+			const int laneExitNodeIndex = currentLeaf->ropes[exitPlanes[lane]];
+			if ( entryDistance[lane] >= bestDistance[lane] || laneExitNodeIndex == -1 )
+			{
+				activeMask &= ~( 1 << lane );
+			}
+			else if ( exitNodeIndex == -1 )
+			{
+				exitNodeIndex = laneExitNodeIndex;
+			}
+			else if ( laneExitNodeIndex != exitNodeIndex )
+			{
+				TraceLanes( rays, 1 << lane, &nodes[laneExitNodeIndex],
+							entryDistance, bestDistance, triangleIndex, uv, RT_KDTREE_MAX_ITERATIONS - i - 1 );
+				activeMask &= ~( 1 << lane );
+			}
+		}
+
+		if ( activeMask == 0 )
+		{
+			break;
+		}
+
+		// A single ray is faster on its own.
+		if ( bitCount[activeMask] == 1 )
+		{
+			TraceLanes( rays, activeMask, &nodes[exitNodeIndex],
+						entryDistance, bestDistance, triangleIndex, uv, RT_KDTREE_MAX_ITERATIONS - i - 1 );
+			break;
+		}
+
+		currentNode = &nodes[exitNodeIndex];
+	}
+}
+
+void RtTrace::TraceBatch( const Vector3f * starts, const Vector3f * ends, traceResult_t * results, const int count ) const
+{
+	for ( int base = 0; base < count; base += 4 )
+	{
+		const int numRays = Alg::Min( count - base, 4 );
+
+		RtIntersect::RayPacket4 rays;
+		float rayLengthRcp[4];
+		float rayLength[4];
+
+		// Unused lanes duplicate the last ray and stay inactive.
+		for ( int lane = 0; lane < 4; lane++ )
+		{
+			const int index = base + Alg::Min( lane, numRays - 1 );
+			const Vector3f rayDelta = ends[index] - starts[index];
+			const float rayLengthSqr = rayDelta.LengthSq();
+			rayLengthRcp[lane] = RcpSqrt( rayLengthSqr );
+			rayLength[lane] = rayLengthSqr * rayLengthRcp[lane];
+			RtIntersect::SetPacketRay( rays, lane, starts[index], rayDelta * rayLengthRcp[lane] );
+		}
+
+		float t0[4];
+		float t1[4];
+		RtIntersect::RayBounds4( rays, header.bounds.GetMins(), header.bounds.GetMaxs(), t0, t1, NULL );
+
+		float entryDistance[4];
+		float bestDistance[4];
+		int triangleIndex[4];
+		Vector2f uv[4];
+		int activeMask = 0;
+
+		for ( int lane = 0; lane < numRays; lane++ )
+		{
+			entryDistance[lane] = Alg::Max( t0[lane], 0.0f );
+			bestDistance[lane] = Alg::Min( t1[lane] + 0.00001f, rayLength[lane] );
+			triangleIndex[lane] = -1;
+			activeMask |= ( t0[lane] < t1[lane] ) << lane;
+		}
+
+		if ( activeMask != 0 )
+		{
+			TracePacket( rays, activeMask, entryDistance, bestDistance, triangleIndex, uv );
+		}
+
+		for ( int lane = 0; lane < numRays; lane++ )
+		{
+			results[base + lane] = GetResult( triangleIndex[lane], bestDistance[lane], rayLengthRcp[lane], uv[lane] );
+		}
+	}
+}
+
 traceResult_t RtTrace::Trace_Exhaustive( const Vector3f & start, const Vector3f & end ) const
 {
 	traceResult_t result;
@@ -14,6 +14,11 @@ Copyright   :   Copyright 2014 Oculus VR, LLC. All Rights reserved.
 #include "../LibOVR/Src/Kernel/OVR_Math.h"
 #include "../LibOVR/Src/Kernel/OVR_Array.h"
 
+namespace RtIntersect
+{
+	struct RayPacket4;
+}
+
 namespace OVR
 {
 
@@ -63,6 +68,24 @@ public:
 	traceResult_t			Trace( const Vector3f & start, const Vector3f & end ) const;
 	traceResult_t			Trace_Exhaustive( const Vector3f & start, const Vector3f & end ) const;
 
+	// Traces 'count' rays, four at a time. Coherent rays, like rays through
+	// neighboring pixels, walk the KD-Tree together and test each triangle
+	// against all four rays at once. Rays that diverge are finished one by one.
+	void					TraceBatch( const Vector3f * starts, const Vector3f * ends,
+										traceResult_t * results, const int count ) const;
+
+private:
+	void					TraceLeafs( const Vector3f & start, const Vector3f & rayDir, const Vector3f & rcpRayDir,
+										const kdtree_node_t * currentNode, float entryDistance, float & bestDistance,
+										int & triangleIndex, Vector2f & uv, const int maxIterations ) const;
+	void					TraceLanes( const RtIntersect::RayPacket4 & rays, const int laneMask, const kdtree_node_t * currentNode,
+										float entryDistance[4], float bestDistance[4], int triangleIndex[4], Vector2f uv[4],
+										const int maxIterations ) const;
+	void					TracePacket( const RtIntersect::RayPacket4 & rays, int activeMask, float entryDistance[4],
+										float bestDistance[4], int triangleIndex[4], Vector2f uv[4] ) const;
+	traceResult_t			GetResult( const int triangleIndex, const float bestDistance,
+										const float rayLengthRcp, const Vector2f & uv ) const;
+
 public:
 	kdtree_header_t			header;
 	Array< Vector3f >		vertices;
@@ -0,0 +1,736 @@
+/************************************************************************************
+
+Filename    :   RtTraceBuilder.cpp
+Content     :   Builds the KD-Tree used by RtTrace.
+Created     :   October, 2026
+
+Copyright   :   Copyright 2014 Oculus VR, LLC. All Rights reserved.
+
+*************************************************************************************/
+
+#include "RtTraceBuilder.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <pthread.h>
+
+#include "Kernel/OVR_Alg.h"
+#include "Kernel/OVR_Array.h"
+#include "Kernel/OVR_Atomic.h"
+#include "Kernel/OVR_Threads.h"
+
+#include "../Log.h"
+#include "RtIntersect.h"
+
+using namespace OVR;
+
+/*
+
+	On building fast kd-Trees for Ray Tracing, and on doing that in O(N log N)
+	Ingo Wald, Vlastimil Havran
+	IEEE Symposium on Interactive Ray Tracing, 2006
+
+	Stackless KD-Tree Traversal for High Performance GPU Ray Tracing
+	Stefan Popov, Johannes Gunther, Hans-Peter Seidel, Philipp Slusallek
+	Eurographics, Volume 26, Number 3, 2007
+
+	The split candidates are the clipped triangle bounds on each axis. Triangles
+	that only touch a split plane are not duplicated into the other child, because
+	Trace() does not clip the triangle hits to the leaf bounds. The ropes
+	of a leaf point at the node on the other side of each face of the leaf, which
+	is the sibling subtree for faces created by a split, or the rope inherited from
+	the parent for all other faces. Trace() descends from the rope node using the
+	ray entry point, so the rope does not need to point at a leaf.
+
+*/
+
+namespace OVR
+{
+
+// Subtrees that are built on a worker thread use local node indices
+// for ropes that point inside the subtree until they are stitched in.
+static const int RT_ROPE_LOCAL				= 0x40000000;
+
+static const int RT_OVERFLOW_BIT			= (int)0x80000000;
+static const int RT_MAX_BAD_REFINES			= 3;
+static const int RT_MIN_JOB_TRIANGLES		= 256;
+
+struct rtBuildJob;
+
+struct rtBuildState
+{
+	rtBuildState() :
+		RopeTag( 0 ),
+		DeferDepth( 0x7FFFFFFF ) {}
+
+	Array< kdtree_node_t >	nodes;
+	Array< kdtree_leaf_t >	leafs;
+	Array< int >			overflow;
+
+	int						RopeTag;		// RT_ROPE_LOCAL when building a subtree on a worker thread
+	int						DeferDepth;		// subtrees at this depth are handed off to the worker threads
+	Array< rtBuildJob * >	Jobs;
+};
+
+struct rtBuildJob
+{
+	int						NodeIndex;		// node reserved in the final tree for the root of this subtree
+	Bounds3f				Bounds;
+	Array< int >			Triangles;
+	int						Ropes[6];
+	int						Depth;
+	int						BadRefines;
+	rtBuildState			State;
+};
+
+struct rtBuildGeometry
+{
+	const Array< Vector3f > *	vertices;
+	const Array< int > *		indices;
+	Array< Bounds3f >			triangleBounds;
+	RtTraceBuildParms			parms;
+};
+
+struct rtBuildWorkers
+{
+	const rtBuildGeometry *		Geometry;
+	Array< rtBuildJob * > *		Jobs;
+	AtomicInt< int >			NextJob;
+};
+
+static float SurfaceArea( const Bounds3f & bounds )
+{
+	const Vector3f size = bounds.GetSize();
+	return 2.0f * ( size.x * size.y + size.y * size.z + size.z * size.x );
+}
+
+static bool FindSplit( const rtBuildGeometry & geo, const Bounds3f & bounds, const Array< int > & triangles,
+						int & bestAxis, float & bestDist, float & bestCost )
+{
+	const int numTriangles = triangles.GetSizeI();
+	const float rcpArea = 1.0f / Alg::Max( SurfaceArea( bounds ), Math<float>::SmallestNonDenormal );
+
+	Array< float > mins;
+	Array< float > maxs;
+	mins.Resize( numTriangles );
+	maxs.Resize( numTriangles );
+
+	bool found = false;
+	bestCost = Math<float>::MaxValue;
+
+	for ( int axis = 0; axis < 3; axis++ )
+	{
+		const float cellMin = bounds.b[0][axis];
+		const float cellMax = bounds.b[1][axis];
+		if ( cellMax <= cellMin )
+		{
+			continue;
+		}
+
+		for ( int i = 0; i < numTriangles; i++ )
+		{
+			const Bounds3f & tb = geo.triangleBounds[triangles[i]];
+			mins[i] = Alg::Max( tb.b[0][axis], cellMin );
+			maxs[i] = Alg::Min( tb.b[1][axis], cellMax );
+		}
+
+		Alg::QuickSort( mins );
+		Alg::QuickSort( maxs );
+
+		// Sweep the sorted triangle start and end positions.
+		int numStarted = 0;		// triangles with mins < plane
+		int numEnded = 0;		// triangles with maxs <= plane
+		int i = 0;
+		int j = 0;
+		float lastPlane = cellMin;
+		while ( i < numTriangles || j < numTriangles )
+		{
+			const float plane = ( j >= numTriangles || ( i < numTriangles && mins[i] <= maxs[j] ) ) ? mins[i++] : maxs[j++];
+			if ( plane <= lastPlane || plane >= cellMax )
+			{
+				continue;
+			}
+			lastPlane = plane;
+
+			while ( numStarted < numTriangles && mins[numStarted] < plane )
+			{
+				numStarted++;
+			}
+			while ( numEnded < numTriangles && maxs[numEnded] <= plane )
+			{
+				numEnded++;
+			}
+
+			const int numLeft = numStarted;
+			const int numRight = numTriangles - numEnded;
+
+			Bounds3f left = bounds;
+			Bounds3f right = bounds;
+			left.b[1][axis] = plane;
+			right.b[0][axis] = plane;
+
+			const float bonus = ( numLeft == 0 || numRight == 0 ) ? ( 1.0f - geo.parms.EmptyBonus ) : 1.0f;
+			const float cost = geo.parms.TraversalCost + geo.parms.IntersectCost * bonus *
+								( SurfaceArea( left ) * rcpArea * numLeft + SurfaceArea( right ) * rcpArea * numRight );
+
+			if ( cost < bestCost )
+			{
+				bestCost = cost;
+				bestAxis = axis;
+				bestDist = plane;
+				found = true;
+			}
+		}
+	}
+
+	return found;
+}
+
+static void EmitLeaf( rtBuildState & state, const int nodeIndex, const Bounds3f & bounds,
+						const Array< int > & triangles, const int ropes[6] )
+{
+	const int leafIndex = state.leafs.GetSizeI();
+	state.leafs.Resize( leafIndex + 1 );
+	kdtree_leaf_t & leaf = state.leafs[leafIndex];
+
+	const int numTriangles = triangles.GetSizeI();
+	if ( numTriangles <= RT_KDTREE_MAX_LEAF_TRIANGLES )
+	{
+		for ( int i = 0; i < RT_KDTREE_MAX_LEAF_TRIANGLES; i++ )
+		{
+			leaf.triangles[i] = ( i < numTriangles ) ? triangles[i] : -1;
+		}
+	}
+	else
+	{
+		// The last slot references the remaining triangles in the overflow array.
+		for ( int i = 0; i < RT_KDTREE_MAX_LEAF_TRIANGLES - 1; i++ )
+		{
+			leaf.triangles[i] = triangles[i];
+		}
+		leaf.triangles[RT_KDTREE_MAX_LEAF_TRIANGLES - 1] = RT_OVERFLOW_BIT | state.overflow.GetSizeI();
+		for ( int i = RT_KDTREE_MAX_LEAF_TRIANGLES - 1; i < numTriangles; i++ )
+		{
+			state.overflow.PushBack( triangles[i] );
+		}
+		state.overflow.PushBack( -1 );
+	}
+
+	for ( int i = 0; i < 6; i++ )
+	{
+		leaf.ropes[i] = ropes[i];
+	}
+	leaf.bounds = bounds;
+
+	state.nodes[nodeIndex].data = ( (UInt32)leafIndex << 3 ) | 1;
+	state.nodes[nodeIndex].dist = 0.0f;
+}
+
+static void BuildNode( const rtBuildGeometry & geo, rtBuildState & state, const int nodeIndex,
+						const Bounds3f & bounds, Array< int > & triangles, const int ropes[6],
+						const int depth, int badRefines )
+{
+	const int numTriangles = triangles.GetSizeI();
+
+	if ( depth >= state.DeferDepth && numTriangles >= RT_MIN_JOB_TRIANGLES )
+	{
+		rtBuildJob * job = new rtBuildJob;
+		job->NodeIndex = nodeIndex;
+		job->Bounds = bounds;
+		job->Triangles = triangles;
+		for ( int i = 0; i < 6; i++ )
+		{
+			job->Ropes[i] = ropes[i];
+		}
+		job->Depth = depth;
+		job->BadRefines = badRefines;
+		state.Jobs.PushBack( job );
+		return;
+	}
+
+	int axis = 0;
+	float dist = 0.0f;
+	float cost = 0.0f;
+	const float leafCost = geo.parms.IntersectCost * numTriangles;
+
+	if ( numTriangles == 0 || depth >= geo.parms.MaxDepth || !FindSplit( geo, bounds, triangles, axis, dist, cost ) )
+	{
+		EmitLeaf( state, nodeIndex, bounds, triangles, ropes );
+		return;
+	}
+
+	if ( cost >= leafCost )
+	{
+		// Allow a few refinements that do not pay off right away because the
+		// children may still find good splits. Small leafs are left alone.
+		if ( numTriangles <= RT_KDTREE_MAX_LEAF_TRIANGLES || ++badRefines > RT_MAX_BAD_REFINES )
+		{
+			EmitLeaf( state, nodeIndex, bounds, triangles, ropes );
+			return;
+		}
+	}
+
+	Array< int > leftTriangles;
+	Array< int > rightTriangles;
+	leftTriangles.Reserve( numTriangles );
+	rightTriangles.Reserve( numTriangles );
+	for ( int i = 0; i < numTriangles; i++ )
+	{
+		// Triangles in the split plane go to the left child, which is where
+		// Trace() goes when the ray enters right at the split plane.
+		const Bounds3f & tb = geo.triangleBounds[triangles[i]];
+		if ( tb.b[0][axis] < dist || tb.b[1][axis] <= dist )
+		{
+			leftTriangles.PushBack( triangles[i] );
+		}
+		if ( tb.b[1][axis] > dist )
+		{
+			rightTriangles.PushBack( triangles[i] );
+		}
+	}
+
+	if ( leftTriangles.GetSizeI() == numTriangles && rightTriangles.GetSizeI() == numTriangles )
+	{
+		// Every triangle straddles the plane, splitting would only duplicate them.
+		EmitLeaf( state, nodeIndex, bounds, triangles, ropes );
+		return;
+	}
+
+	// Free the parent list before recursing to keep the peak memory down.
+	triangles.ClearAndRelease();
+
+	// The children are always stored next to each other.
+	const int childIndex = state.nodes.GetSizeI();
+	state.nodes.Resize( childIndex + 2 );
+	state.nodes[nodeIndex].data = ( (UInt32)childIndex << 3 ) | ( axis << 1 );
+	state.nodes[nodeIndex].dist = dist;
+
+	Bounds3f leftBounds = bounds;
+	Bounds3f rightBounds = bounds;
+	leftBounds.b[1][axis] = dist;
+	rightBounds.b[0][axis] = dist;
+
+	int leftRopes[6];
+	int rightRopes[6];
+	for ( int i = 0; i < 6; i++ )
+	{
+		leftRopes[i] = ropes[i];
+		rightRopes[i] = ropes[i];
+	}
+	leftRopes[axis * 2 + 1] = ( childIndex + 1 ) | state.RopeTag;
+	rightRopes[axis * 2 + 0] = ( childIndex + 0 ) | state.RopeTag;
+
+	BuildNode( geo, state, childIndex + 0, leftBounds, leftTriangles, leftRopes, depth + 1, badRefines );
+	BuildNode( geo, state, childIndex + 1, rightBounds, rightTriangles, rightRopes, depth + 1, badRefines );
+}
+
+static void BuildJob( const rtBuildGeometry & geo, rtBuildJob & job )
+{
+	job.State.RopeTag = RT_ROPE_LOCAL;
+	job.State.nodes.Resize( 1 );
+	BuildNode( geo, job.State, 0, job.Bounds, job.Triangles, job.Ropes, job.Depth, job.BadRefines );
+}
+
+static void * BuildWorkerThread( void * parm )
+{
+	rtBuildWorkers * workers = (rtBuildWorkers *)parm;
+	for ( ; ; )
+	{
+		const int jobIndex = workers->NextJob.ExchangeAdd_Sync( 1 );
+		if ( jobIndex >= workers->Jobs->GetSizeI() )
+		{
+			break;
+		}
+		BuildJob( *workers->Geometry, *workers->Jobs->At( jobIndex ) );
+	}
+	return NULL;
+}
+
+// Appends a subtree that was built with local indices to the final tree.
+static void StitchJob( rtBuildState & state, const rtBuildJob & job )
+{
+	const int nodeBase = state.nodes.GetSizeI() - 1;	// local node 0 goes into the reserved node
+	const int leafBase = state.leafs.GetSizeI();
+	const int overflowBase = state.overflow.GetSizeI();
+
+	const rtBuildState & local = job.State;
+
+	state.nodes.Resize( nodeBase + local.nodes.GetSizeI() );
+	for ( int i = 0; i < local.nodes.GetSizeI(); i++ )
+	{
+		kdtree_node_t node = local.nodes[i];
+		const int index = node.data >> 3;
+		if ( node.data & 1 )
+		{
+			node.data = ( (UInt32)( index + leafBase ) << 3 ) | 1;
+		}
+		else
+		{
+			node.data = ( (UInt32)( index + nodeBase ) << 3 ) | ( node.data & 7 );
+		}
+		state.nodes[( i == 0 ) ? job.NodeIndex : nodeBase + i] = node;
+	}
+
+	for ( int i = 0; i < local.leafs.GetSizeI(); i++ )
+	{
+		kdtree_leaf_t leaf = local.leafs[i];
+		for ( int j = 0; j < RT_KDTREE_MAX_LEAF_TRIANGLES; j++ )
+		{
+			if ( leaf.triangles[j] < -1 )
+			{
+				leaf.triangles[j] = RT_OVERFLOW_BIT | ( ( leaf.triangles[j] & 0x7FFFFFFF ) + overflowBase );
+			}
+		}
+		for ( int j = 0; j < 6; j++ )
+		{
+			if ( leaf.ropes[j] >= 0 && ( leaf.ropes[j] & RT_ROPE_LOCAL ) != 0 )
+			{
+				// Ropes never point at the root of the subtree itself.
+				OVR_ASSERT( ( leaf.ropes[j] & ~RT_ROPE_LOCAL ) > 0 );
+				leaf.ropes[j] = ( leaf.ropes[j] & ~RT_ROPE_LOCAL ) + nodeBase;
+			}
+		}
+		state.leafs.PushBack( leaf );
+	}
+
+	state.overflow.Append( local.overflow );
+}
+
+static bool JobIsLarger( const rtBuildJob * a, const rtBuildJob * b )
+{
+	return a->Triangles.GetSizeI() > b->Triangles.GetSizeI();
+}
+
+void RtTraceBuilder::Build( RtTrace & trace,
+							const Array< Vector3f > & vertices,
+							const Array< Vector2f > & uvs,
+							const Array< int > & indices,
+							const RtTraceBuildParms & parms ) const
+{
+	const int numTriangles = indices.GetSizeI() / 3;
+
+	rtBuildGeometry geo;
+	geo.vertices = &vertices;
+	geo.indices = &indices;
+	geo.parms = parms;
+	if ( geo.parms.MaxDepth <= 0 )
+	{
+		geo.parms.MaxDepth = (int)( 8.0f + 1.3f * logf( (float)Alg::Max( numTriangles, 1 ) ) / logf( 2.0f ) );
+	}
+
+	Bounds3f bounds( Bounds3f::Init );
+	geo.triangleBounds.Resize( numTriangles );
+	for ( int i = 0; i < numTriangles; i++ )
+	{
+		Bounds3f & tb = geo.triangleBounds[i];
+		tb.Clear();
+		tb.AddPoint( vertices[indices[i * 3 + 0]] );
+		tb.AddPoint( vertices[indices[i * 3 + 1]] );
+		tb.AddPoint( vertices[indices[i * 3 + 2]] );
+		bounds = Bounds3f::Union( bounds, tb );
+	}
+	if ( numTriangles == 0 )
+	{
+		bounds = Bounds3f( Vector3f( 0.0f ), Vector3f( 0.0f ) );
+	}
+
+	int numThreads = ( parms.MaxThreads > 0 ) ? parms.MaxThreads : Thread::GetCPUCount();
+	numThreads = Alg::Max( numThreads, 1 );
+
+	rtBuildState state;
+	if ( numThreads > 1 )
+	{
+		// Hand off roughly four subtrees per thread so the work balances out.
+		int deferDepth = 2;
+		while ( ( 1 << deferDepth ) < numThreads * 4 )
+		{
+			deferDepth++;
+		}
+		state.DeferDepth = deferDepth;
+	}
+
+	Array< int > triangles;
+	triangles.Resize( numTriangles );
+	for ( int i = 0; i < numTriangles; i++ )
+	{
+		triangles[i] = i;
+	}
+
+	const int noRopes[6] = { -1, -1, -1, -1, -1, -1 };
+	state.nodes.Resize( 1 );
+	BuildNode( geo, state, 0, bounds, triangles, noRopes, 0, 0 );
+
+	if ( state.Jobs.GetSizeI() > 0 )
+	{
+		Alg::QuickSort( state.Jobs, JobIsLarger );
+
+		rtBuildWorkers workers;
+		workers.Geometry = &geo;
+		workers.Jobs = &state.Jobs;
+		workers.NextJob = 0;
+
+		// The calling thread works on the jobs as well.
+		const int numWorkers = Alg::Min( numThreads, state.Jobs.GetSizeI() ) - 1;
+		Array< pthread_t > threads;
+		for ( int i = 0; i < numWorkers; i++ )
+		{
+			pthread_t thread;
+			const int createErr = pthread_create( &thread, NULL, BuildWorkerThread, &workers );
+			if ( createErr != 0 )
+			{
+				LOG( "pthread_create returned %i", createErr );
+				break;
+			}
+			threads.PushBack( thread );
+		}
+
+		BuildWorkerThread( &workers );
+
+		for ( int i = 0; i < threads.GetSizeI(); i++ )
+		{
+			pthread_join( threads[i], NULL );
+		}
+
+		for ( int i = 0; i < state.Jobs.GetSizeI(); i++ )
+		{
+			StitchJob( state, *state.Jobs[i] );
+			delete state.Jobs[i];
+		}
+		state.Jobs.Clear();
+	}
+
+	trace.vertices = vertices;
+	trace.indices = indices;
+	trace.uvs = uvs;
+	if ( trace.uvs.GetSizeI() != vertices.GetSizeI() )
+	{
+		// Trace() looks up a uv for every hit vertex.
+		trace.uvs.Resize( vertices.GetSizeI() );
+		for ( int i = uvs.GetSizeI(); i < vertices.GetSizeI(); i++ )
+		{
+			trace.uvs[i] = Vector2f( 0.0f );
+		}
+	}
+	trace.nodes = state.nodes;
+	trace.leafs = state.leafs;
+	trace.overflow = state.overflow;
+
+	trace.header.numVertices = trace.vertices.GetSizeI();
+	trace.header.numUvs = trace.uvs.GetSizeI();
+	trace.header.numIndices = trace.indices.GetSizeI();
+	trace.header.numNodes = trace.nodes.GetSizeI();
+	trace.header.numLeafs = trace.leafs.GetSizeI();
+	trace.header.numOverflow = trace.overflow.GetSizeI();
+	trace.header.bounds = bounds;
+}
+
+//-----------------------------------------------------------------------------
+//	Benchmark
+//-----------------------------------------------------------------------------
+
+struct rtRandom
+{
+	rtRandom( UInt32 seed ) : State( seed ) {}
+
+	float Next()
+	{
+		State = State * 1664525u + 1013904223u;
+		return ( State >> 8 ) * ( 1.0f / 16777216.0f );
+	}
+
+	UInt32 State;
+};
+
+// Rolling terrain, which has a lot of coherent, well behaved triangles.
+static void GenerateTerrain( const int numTriangles, Array< Vector3f > & vertices, Array< int > & indices )
+{
+	const int gridSize = Alg::Max( 2, (int)sqrtf( numTriangles * 0.5f ) );
+	vertices.Clear();
+	indices.Clear();
+	for ( int y = 0; y <= gridSize; y++ )
+	{
+		for ( int x = 0; x <= gridSize; x++ )
+		{
+			const float fx = (float)x / gridSize;
+			const float fy = (float)y / gridSize;
+			const float height = 0.1f * sinf( fx * 17.0f ) * cosf( fy * 13.0f ) + 0.05f * sinf( ( fx + fy ) * 41.0f );
+			vertices.PushBack( Vector3f( fx, height, fy ) );
+		}
+	}
+	for ( int y = 0; y < gridSize; y++ )
+	{
+		for ( int x = 0; x < gridSize; x++ )
+		{
+			const int v = y * ( gridSize + 1 ) + x;
+			indices.PushBack( v );
+			indices.PushBack( v + gridSize + 1 );
+			indices.PushBack( v + 1 );
+			indices.PushBack( v + 1 );
+			indices.PushBack( v + gridSize + 1 );
+			indices.PushBack( v + gridSize + 2 );
+		}
+	}
+}
+
+// Randomly placed and oriented triangles, which is close to a worst case.
+static void GenerateSoup( const int numTriangles, Array< Vector3f > & vertices, Array< int > & indices )
+{
+	rtRandom random( 12345 );
+	const float size = 2.0f / sqrtf( (float)numTriangles );
+	vertices.Clear();
+	indices.Clear();
+	for ( int i = 0; i < numTriangles; i++ )
+	{
+		const Vector3f center( random.Next(), random.Next(), random.Next() );
+		for ( int j = 0; j < 3; j++ )
+		{
+			indices.PushBack( vertices.GetSizeI() );
+			vertices.PushBack( center + Vector3f( random.Next() - 0.5f, random.Next() - 0.5f, random.Next() - 0.5f ) * size );
+		}
+	}
+}
+
+// Compares RtTrace::TraceBatch() against RtTrace::Trace() on the same rays.
+static void BenchmarkBatch( const char * name, const char * rayType, const RtTrace & trace,
+							const Array< Vector3f > & starts, const Array< Vector3f > & ends )
+{
+	const int numRays = starts.GetSizeI();
+	Array< traceResult_t > single;
+	Array< traceResult_t > batch;
+	single.Resize( numRays );
+	batch.Resize( numRays );
+
+	const double singleStart = LogCpuTime::GetNanoSeconds();
+	for ( int i = 0; i < numRays; i++ )
+	{
+		single[i] = trace.Trace( starts[i], ends[i] );
+	}
+	const double singleEnd = LogCpuTime::GetNanoSeconds();
+	trace.TraceBatch( &starts[0], &ends[0], &batch[0], numRays );
+	const double batchEnd = LogCpuTime::GetNanoSeconds();
+
+	int numMismatches = 0;
+	for ( int i = 0; i < numRays; i++ )
+	{
+		if ( single[i].triangleIndex != batch[i].triangleIndex && fabsf( single[i].fraction - batch[i].fraction ) > 1e-4f )
+		{
+			numMismatches++;
+		}
+	}
+
+	const double singleRaysPerSecond = numRays / Alg::Max( ( singleEnd - singleStart ) * 1e-9, 1e-9 );
+	const double batchRaysPerSecond = numRays / Alg::Max( ( batchEnd - singleEnd ) * 1e-9, 1e-9 );
+
+	LOG( "%s: %s rays, Trace %1.0f rays/sec, TraceBatch %1.0f rays/sec, speedup %1.2fx, %d of %d rays disagree",
+			name, rayType, singleRaysPerSecond, batchRaysPerSecond,
+			batchRaysPerSecond / singleRaysPerSecond, numMismatches, numRays );
+}
+
+static void BenchmarkMesh( const char * name, const Array< Vector3f > & vertices, const Array< int > & indices, const int numRays )
+{
+	const Array< Vector2f > uvs;
+	RtTrace trace;
+	RtTraceBuilder builder;
+
+	RtTraceBuildParms singleThread;
+	singleThread.MaxThreads = 1;
+
+	const double buildStart = LogCpuTime::GetNanoSeconds();
+	builder.Build( trace, vertices, uvs, indices, singleThread );
+	const double buildMiddle = LogCpuTime::GetNanoSeconds();
+	builder.Build( trace, vertices, uvs, indices );
+	const double buildEnd = LogCpuTime::GetNanoSeconds();
+
+	LOG( "%s: %d triangles, %d nodes, %d leafs, %d overflow, build %1.1f ms single threaded, %1.1f ms on %d cores",
+			name, indices.GetSizeI() / 3, trace.header.numNodes, trace.header.numLeafs, trace.header.numOverflow,
+			( buildMiddle - buildStart ) * 1e-6, ( buildEnd - buildMiddle ) * 1e-6, Thread::GetCPUCount() );
+
+	Array< Vector3f > starts;
+	Array< Vector3f > ends;
+	starts.Resize( numRays );
+	ends.Resize( numRays );
+	rtRandom random( 54321 );
+	const Vector3f mins = trace.header.bounds.GetMins();
+	const Vector3f size = trace.header.bounds.GetSize();
+	for ( int i = 0; i < numRays; i++ )
+	{
+		starts[i] = mins + Vector3f( random.Next() * 2.0f - 0.5f, random.Next() * 2.0f - 0.5f, random.Next() * 2.0f - 0.5f ).EntrywiseMultiply( size );
+		ends[i] = mins + Vector3f( random.Next(), random.Next(), random.Next() ).EntrywiseMultiply( size );
+	}
+
+	int numHits = 0;
+	const double kdStart = LogCpuTime::GetNanoSeconds();
+	for ( int i = 0; i < numRays; i++ )
+	{
+		numHits += ( trace.Trace( starts[i], ends[i] ).triangleIndex >= 0 );
+	}
+	const double kdEnd = LogCpuTime::GetNanoSeconds();
+
+	// The exhaustive trace is painfully slow on large meshes, so only run a subset.
+	const int numExhaustiveRays = Alg::Min( numRays, 1 + 4000000 / Alg::Max( indices.GetSizeI(), 1 ) );
+	int numMismatches = 0;
+	const double exStart = LogCpuTime::GetNanoSeconds();
+	for ( int i = 0; i < numExhaustiveRays; i++ )
+	{
+		const traceResult_t ex = trace.Trace_Exhaustive( starts[i], ends[i] );
+		const traceResult_t kd = trace.Trace( starts[i], ends[i] );
+		if ( ex.triangleIndex != kd.triangleIndex && fabsf( ex.fraction - kd.fraction ) > 1e-4f )
+		{
+			numMismatches++;
+		}
+	}
+	const double exEnd = LogCpuTime::GetNanoSeconds();
+
+	const double kdRaysPerSecond = numRays / ( ( kdEnd - kdStart ) * 1e-9 );
+	// The timed loop above also runs Trace(), so subtract the known cost.
+	const double exSeconds = Alg::Max( ( exEnd - exStart ) * 1e-9 - numExhaustiveRays / kdRaysPerSecond, 1e-9 );
+	const double exRaysPerSecond = numExhaustiveRays / exSeconds;
+
+	LOG( "%s: Trace %1.0f rays/sec (%d%% hit), Trace_Exhaustive %1.0f rays/sec, speedup %1.1fx, %d of %d rays disagree",
+			name, kdRaysPerSecond, numHits * 100 / Alg::Max( numRays, 1 ), exRaysPerSecond,
+			kdRaysPerSecond / exRaysPerSecond, numMismatches, numExhaustiveRays );
+
+	BenchmarkBatch( name, "random", trace, starts, ends );
+
+	// Coherent rays from a camera above the mesh through a grid of pixels,
+	// ordered in 2x2 pixel quads so each packet covers a small footprint.
+	const int gridSize = Alg::Max( (int)sqrtf( (float)numRays ) & ~1, 2 );
+	starts.Resize( gridSize * gridSize );
+	ends.Resize( gridSize * gridSize );
+	const Vector3f eye = mins + size.EntrywiseMultiply( Vector3f( 0.5f, 2.0f, 0.5f ) );
+	for ( int y = 0; y < gridSize; y++ )
+	{
+		for ( int x = 0; x < gridSize; x++ )
+		{
+			const int index = ( ( y >> 1 ) * ( gridSize >> 1 ) + ( x >> 1 ) ) * 4 + ( y & 1 ) * 2 + ( x & 1 );
+			starts[index] = eye;
+			ends[index] = mins + size.EntrywiseMultiply( Vector3f( (float)x / ( gridSize - 1 ), -0.5f, (float)y / ( gridSize - 1 ) ) );
+		}
+	}
+
+	BenchmarkBatch( name, "coherent", trace, starts, ends );
+}
+
+void RtTraceBenchmark( void * appPtr, const char * cmd )
+{
+	int numTriangles = 100000;
+	int numRays = 100000;
+	sscanf( cmd, "%i %i", &numTriangles, &numRays );
+	numTriangles = Alg::Max( numTriangles, 2 );
+	numRays = Alg::Max( numRays, 1 );
+
+	// TraceBatch() can only agree with Trace() within the precision of this reciprocal.
+	const int reciprocalUlp = RtIntersect::MaxReciprocal4UlpError();
+	LOG( "rtBenchmark: packet reciprocal within %d ulp of the divide: %s", reciprocalUlp, reciprocalUlp <= 2 ? "passed" : "FAILED" );
+
+	Array< Vector3f > vertices;
+	Array< int > indices;
+
+	GenerateTerrain( numTriangles, vertices, indices );
+	BenchmarkMesh( "terrain", vertices, indices, numRays );
+
+	GenerateSoup( numTriangles, vertices, indices );
+	BenchmarkMesh( "soup", vertices, indices, numRays );
+}
+
+}	// namespace OVR
@@ -0,0 +1,66 @@
+/************************************************************************************
+
+Filename    :   RtTraceBuilder.h
+Content     :   Builds the KD-Tree used by RtTrace.
+Created     :   October, 2026
+
+Copyright   :   Copyright 2014 Oculus VR, LLC. All Rights reserved.
+
+*************************************************************************************/
+#ifndef __RTTRACEBUILDER_H__
+#define __RTTRACEBUILDER_H__
+
+#include "RtTrace.h"
+
+namespace OVR
+{
+
+struct RtTraceBuildParms
+{
+	RtTraceBuildParms() :
+		TraversalCost( 1.0f ),
+		IntersectCost( 1.5f ),
+		EmptyBonus( 0.2f ),
+		MaxDepth( 0 ),
+		MaxThreads( 0 ) {}
+
+	float	TraversalCost;		// relative cost of stepping through a node
+	float	IntersectCost;		// relative cost of a ray-triangle intersection
+	float	EmptyBonus;			// cost reduction for splits that cut off empty space
+	int		MaxDepth;			// 0 = derive from the triangle count
+	int		MaxThreads;			// 0 = one thread per CPU core, 1 = build on the calling thread
+};
+
+// Builds a surface area heuristic KD-Tree with ropes for arbitrary triangle soup
+// into an RtTrace, with the same node and leaf layout that is loaded from a
+// "raytrace_model", so procedurally generated or imported geometry can use
+// RtTrace::Trace() instead of falling back to RtTrace::Trace_Exhaustive().
+// The tree only lives in memory, nothing is written to a file.
+//
+// The uvs are per vertex, just like the vertices, and may be empty.
+// The top of the tree is built on the calling thread, after which the
+// remaining subtrees are built in parallel and stitched together.
+class RtTraceBuilder
+{
+public:
+							RtTraceBuilder() {}
+							~RtTraceBuilder() {}
+
+	void					Build( RtTrace & trace,
+									const Array< Vector3f > & vertices,
+									const Array< Vector2f > & uvs,
+									const Array< int > & indices,
+									const RtTraceBuildParms & parms = RtTraceBuildParms() ) const;
+};
+
+// Builds KD-Trees for a couple of generated meshes and logs the throughput of
+// RtTrace::Trace() against RtTrace::Trace_Exhaustive() and RtTrace::TraceBatch()
+// on random and coherent rays, plus any disagreement, and checks the precision
+// of the packet reciprocal.
+// Registered as the "rtBenchmark" console command, optional parms:
+// "<number of triangles> <number of rays>"
+void RtTraceBenchmark( void * appPtr, const char * cmd );
+
+}	// namespace OVR
+
+#endif // !__RTTRACEBUILDER_H__
@@ -523,6 +523,21 @@ public:
 
 	int CurrentPanelIndex() const { return static_cast< int >( ScrollMgr.GetPosition() ); }
 
+	// Number of panels between a panel and the one in the center of the folder
+	int GetPanelOffset( const int panelIndex ) const
+	{
+		return abs( panelIndex - static_cast< int >( nearbyintf( ScrollMgr.GetPosition() ) ) );
+	}
+
+	// Angle around the up axis between a panel and the gaze, both in menu space,
+	// where a yaw of 0 is straight at the center of the menu
+	float GetPanelGazeAngle( const int panelIndex, const float gazeYaw ) const
+	{
+		const float panelYaw = ( ScrollMgr.GetPosition() - panelIndex ) * ( Mathf::TwoPi / FolderBrowser.GetCircumferencePanelSlots() );
+		const float angle = fmodf( fabsf( panelYaw - gazeYaw ), Mathf::TwoPi );
+		return ( angle > Mathf::Pi ) ? Mathf::TwoPi - angle : angle;
+	}
+
 private:
     virtual eMsgStatus Frame( App * app, VrFrame const & vrFrame, OvrVRMenuMgr & menuMgr, VRMenuObject * self, VRMenuEvent const & event )
     {
@@ -1418,7 +1433,8 @@ OvrFolderBrowser::OvrFolderBrowser(
 		float radius_,
 		unsigned numSwipePanels, 
 		unsigned thumbWidth,
-		unsigned thumbHeight )
+		unsigned thumbHeight,
+		int numThumbnailWorkers )
 	: VRMenu( MENU_NAME )
 	, AppPtr( app )
 	, SearchPaths( searchPaths )
@@ -1431,8 +1447,7 @@ OvrFolderBrowser::OvrFolderBrowser(
 	, NoMedia( false )
 	, AllowPanelTouchUp( false )
 	, ScrollHintShown( false )
-	, TextureCommands( 10000 )
-	, BackgroundCommands( 10000 )
+	, ThumbnailScheduler( NULL )
 {
 	//  Load up thumbnail alpha from panel.tga
 	if ( ThumbPanelBG == NULL )
@@ -1460,19 +1475,8 @@ OvrFolderBrowser::OvrFolderBrowser(
 		OVR_ASSERT( ThumbPanelBG != 0 && panelW == ThumbWidth && panelH == ThumbHeight );
 	}
 
-	// spawn the thumbnail loading thread with the command list
-	pthread_attr_t loadingThreadAttr;
-	pthread_attr_init( &loadingThreadAttr );
-	sched_param sparam;
-	sparam.sched_priority = Thread::GetOSPriority( Thread::BelowNormalPriority );
-	pthread_attr_setschedparam( &loadingThreadAttr, &sparam );
-
-	pthread_t loadingThread;
-	const int createErr = pthread_create( &loadingThread, &loadingThreadAttr, &ThumbnailThread, this );
-	if ( createErr != 0 )
-	{
-		LOG( "pthread_create returned %i", createErr );
-	}
+	// spawn the thumbnail workers
+	ThumbnailScheduler = new OvrThumbnailScheduler( &LoadThumbnailRequest, this, numThumbnailWorkers );
 
 	PanelWidth = panelWidth * VRMenuObject::DEFAULT_TEXEL_SCALE;
 	PanelHeight = panelHeight * VRMenuObject::DEFAULT_TEXEL_SCALE;
@@ -1489,6 +1493,10 @@ OvrFolderBrowser::OvrFolderBrowser(
 
 OvrFolderBrowser::~OvrFolderBrowser()
 {
+	// the workers use ThumbPanelBG
+	delete ThumbnailScheduler;
+	ThumbnailScheduler = NULL;
+
 	if ( ThumbPanelBG != NULL )
 	{
 		free( ThumbPanelBG );
@@ -1509,18 +1517,13 @@ OvrFolderBrowser::~OvrFolderBrowser()
 void OvrFolderBrowser::Frame_Impl( App * app, VrFrame const & vrFrame, OvrVRMenuMgr & menuMgr, BitmapFont const & font,
 	BitmapFontSurface & fontSurface, gazeCursorUserId_t const gazeUserId )
 {
+	UpdateThumbnailRequests();
+
 	// Check for thumbnail loads
-	while ( 1 )
+	OvrThumbnailResult result;
+	while ( ThumbnailScheduler->GetNextResult( result ) )
 	{
-		const char * cmd = TextureCommands.GetNextMessage();
-		if ( !cmd )
-		{
-			break;
-		}
-
-		//LOG( "TextureCommands: %s", cmd );
-		LoadThumbnailToTexture( cmd );
-		free( ( void * )cmd );
+		LoadThumbnailToTexture( result );
 	}
 }
 
@@ -1573,11 +1576,6 @@ void OvrFolderBrowser::BuildMenu()
 		folderObject->SetLocalPosition( ( DOWN * PanelHeight * folderIndex ) + folderObject->GetLocalPosition() );
 	}
 
-	// Process any thumb creation commands
-	char cmd[ 1024 ];
-	sprintf( cmd, "processCreates %p", &ThumbCreateAndLoadCommands );
-	BackgroundCommands.PostString( cmd );
-
 	// Show no media menu if no media found
 	if ( mediaCount == 0 )
 	{
@@ -1992,6 +1990,7 @@ void OvrFolderBrowser::RebuildFolder( const int folderIndex, const Array< OvrMet
 		VRMenuObject * swipeObject = menuManager.ToObject( folder.SwipeHandle );
 		OVR_ASSERT( swipeObject );
 
+		ThumbnailScheduler->Cancel( folderIndex, -1 );
 		swipeObject->FreeChildren( menuManager );
 		folder.Panels.Clear();
 
@@ -2059,124 +2058,131 @@ void OvrFolderBrowser::UpdateFolderTitle( const int folderIndex )
 	folderTitleObject->SetFlags( flags );
 }
 
-void * OvrFolderBrowser::ThumbnailThread( void * v )
+// Called on the thumbnail workers
+unsigned char * OvrFolderBrowser::LoadThumbnailRequest( void * userData, OvrThumbnailRequest const & request, int & width, int & height )
 {
-	int result = pthread_setname_np( pthread_self(), "FolderBrowser" );
-	if ( result != 0 )
+	OvrFolderBrowser * folderBrowser = static_cast< OvrFolderBrowser * >( userData );
+	if ( request.SourcePath.IsEmpty() )
 	{
-		LOG( "FolderBrowser: pthread_setname_np failed %s", strerror( result ) );
+		return folderBrowser->LoadThumbAndApplyAA( request.Path, width, height );
 	}
 
-	sched_param sparam;
-	sparam.sched_priority = Thread::GetOSPriority( Thread::BelowNormalPriority );
+	width = 0;
+	height = 0;
+	unsigned char * data = folderBrowser->CreateThumbnail( request.SourcePath, width, height );
 
-	int setSchedparamResult = pthread_setschedparam( pthread_self(), SCHED_NORMAL, &sparam );
-	if ( setSchedparamResult != 0 )
+	// Should we write out a trivial thumbnail if the create failed?
+	if ( data == NULL )
 	{
-		LOG( "FolderBrowser: pthread_setschedparam failed %s", strerror( setSchedparamResult ) );
+		return NULL;
 	}
 
-	OvrFolderBrowser * folderBrowser = ( OvrFolderBrowser * )v;
-	for ( ;; )
+	LOG( "thumb create - writjpeg %s %p %dx%d", request.Path.ToCStr(), data, width, height );
+	// write it out
+	WriteJpeg( request.Path, data, width, height );
+
+	// Perform the load
+	const unsigned ThumbWidth = folderBrowser->GetThumbWidth();
+	const unsigned ThumbHeight = folderBrowser->GetThumbHeight();
+
+	const int numBytes = width * height * 4;
+	const int thumbPanelBytes = ThumbWidth * ThumbHeight * 4;
+	if ( numBytes != thumbPanelBytes )
 	{
-		folderBrowser->BackgroundCommands.SleepUntilMessage();
-		const char * msg = folderBrowser->BackgroundCommands.GetNextMessage();
-		//LOG( "BackgroundCommands: %s", msg );
-		if ( MatchesHead( "load ", msg ) )
-		{
-			int folderId;
-			int panelId;
+		LOG( "Thumbnail image '%s' is the wrong size! Regenerate thumbnails!", request.Path.ToCStr() );
+		free( data );
+		return NULL;
+	}
 
-			sscanf( msg, "load %i %i", &folderId, &panelId );
-			const char * fileName = strstr( msg, ":" ) + 1;
+	// Apply alpha from vrlib/res/raw to alpha channel for anti-aliasing
+	for ( int i = 3; i < thumbPanelBytes; i += 4 )
+	{
+		data[ i ] = ThumbPanelBG[ i ];
+	}
+	return data;
+}
 
-			const String fullPath( fileName );
+// Requests the thumbnails of the panels around the view, closest to the gaze first,
+// and cancels the requests of panels that left it
+void OvrFolderBrowser::UpdateThumbnailRequests()
+{
+	if ( Folders.GetSizeI() == 0 )
+	{
+		return;
+	}
 
-			int		width;
-			int		height;
-			unsigned char * data = folderBrowser->LoadThumbAndApplyAA( fullPath, width, height );
-			if ( data != NULL )
-			{
-				folderBrowser->TextureCommands.PostPrintf( "thumb %i %i %p %i %i",
-					folderId, panelId, data, width, height );
-			}
+	// gaze in menu space
+	const Matrix4f & view = AppPtr->GetLastViewMatrix();
+	Vector3f gazeDir = GetMenuPose().Orientation.Inverted().Rotate( Vector3f( -view.M[ 2 ][ 0 ], -view.M[ 2 ][ 1 ], -view.M[ 2 ][ 2 ] ) );
+	gazeDir.Normalize();
+	const float gazeYaw = atan2f( -gazeDir.x, -gazeDir.z );
+	const float gazePitch = asinf( Alg::Clamp( gazeDir.y, -1.0f, 1.0f ) );
 
-			free( ( void * )msg );
-		}
-		else if ( MatchesHead( "processCreates ", msg ) )
+	OvrVRMenuMgr & menuManager = AppPtr->GetVRMenuMgr();
+	const int activeFolderIndex = GetActiveFolderIndex();
+	const int extraPanels = NumSwipePanels / 2;
+	const int prefetchPanels = extraPanels + NumSwipePanels;
+	for ( int folderIndex = 0; folderIndex < Folders.GetSizeI(); ++folderIndex )
+	{
+		Folder & folder = *Folders[ folderIndex ];
+		VRMenuObject * swipeObject = menuManager.ToObject( folder.SwipeHandle );
+		OvrFolderBrowserSwipeComponent * swipeComp = ( swipeObject != NULL ) ? 
+				swipeObject->GetComponentById< OvrFolderBrowserSwipeComponent >() : NULL;
+		if ( swipeComp == NULL )
 		{
-			Array< OvrCreateThumbCmd > * ThumbCreateAndLoadCommands;
+			continue;
+		}
 
-			sscanf( msg, "processCreates %p", &ThumbCreateAndLoadCommands );
+		// only the folders right above and below the active one are in view
+		const bool folderInView = abs( folderIndex - activeFolderIndex ) <= 1;
+		const float pitchAngle = fabsf( gazePitch + ( folderIndex - activeFolderIndex ) * PanelHeight / Radius );
 
-			for ( int i = 0; i < ThumbCreateAndLoadCommands->GetSizeI(); ++i )
+		for ( int panelIndex = 0; panelIndex < folder.Panels.GetSizeI(); ++panelIndex )
+		{
+			Panel & panel = folder.Panels[ panelIndex ];
+			if ( panel.ThumbState != THUMBNAIL_WAITING && panel.ThumbState != THUMBNAIL_REQUESTED )
 			{
-				const OvrCreateThumbCmd & cmd = ThumbCreateAndLoadCommands->At( i );
-				int	width = 0;
-				int height = 0;
-				unsigned char * data = folderBrowser->CreateThumbnail( cmd.SourceImagePath, width, height );
+				continue;
+			}
 
-				// Should we write out a trivial thumbnail if the create failed?
-				if ( data != NULL )
+			const int offset = swipeComp->GetPanelOffset( panelIndex );
+			if ( folderInView && offset <= prefetchPanels )
+			{
+				const float yawAngle = swipeComp->GetPanelGazeAngle( panelIndex, gazeYaw );
+				const float priority = sqrtf( yawAngle * yawAngle + pitchAngle * pitchAngle );
+				const bool visible = offset <= extraPanels;
+				if ( panel.ThumbState == THUMBNAIL_REQUESTED )
 				{
-					LOG( "thumb create - writjpeg %s %p %dx%d", cmd.ThumbDestination.ToCStr(), data, width, height );
-					// write it out
-					WriteJpeg( cmd.ThumbDestination, data, width, height );
-					
-					// Perform the load
-					const unsigned ThumbWidth = folderBrowser->GetThumbWidth();
-					const unsigned ThumbHeight = folderBrowser->GetThumbHeight();
-
-					const int numBytes = width * height * 4;
-					const int thumbPanelBytes = ThumbWidth * ThumbHeight * 4;
-					if ( numBytes != thumbPanelBytes )
-					{
-						LOG( "Thumbnail image '%s' is the wrong size! Regenerate thumbnails!", cmd.ThumbDestination.ToCStr() );
-						free( data );
-					}
-					else
-					{
-						// Apply alpha from vrlib/res/raw to alpha channel for anti-aliasing
-						for ( int i = 3; i < thumbPanelBytes; i += 4 )
-						{
-							data[ i ] = ThumbPanelBG[ i ];
-						}
-
-						int folderId;
-						int panelId;
-
-						sscanf( cmd.LoadCmd, "load %i %i", &folderId, &panelId );
-
-						folderBrowser->TextureCommands.PostPrintf( "thumb %i %i %p %i %i",
-							folderId, panelId, data, width, height );
-					}
+					ThumbnailScheduler->SetPriority( folderIndex, panel.Id, priority, visible );
+				}
+				else
+				{
+					OvrThumbnailRequest request;
+					request.FolderId = folderIndex;
+					request.PanelId = panel.Id;
+					request.Path = panel.ThumbPath;
+					request.SourcePath = panel.ThumbSourcePath;
+					ThumbnailScheduler->Request( request, priority, visible );
+					panel.ThumbState = THUMBNAIL_REQUESTED;
 				}
 			}
-			ThumbCreateAndLoadCommands->Clear();
-
-			free( ( void * )msg );
-		}
-		else
-		{
-			LOG( "OvrFolderBrowser::ThumbnailThread received unhandled message: %s", msg );
-			OVR_ASSERT( false );
-			free( ( void * )msg );
+			else if ( panel.ThumbState == THUMBNAIL_REQUESTED )
+			{
+				ThumbnailScheduler->Cancel( folderIndex, panel.Id );
+				panel.ThumbState = THUMBNAIL_WAITING;
+			}
 		}
 	}
-
-	return NULL;
 }
 
-void OvrFolderBrowser::LoadThumbnailToTexture( const char * thumbnailCommand )
+void OvrFolderBrowser::LoadThumbnailToTexture( OvrThumbnailResult const & result )
 {	
-	int folderId;
-	int panelId;
-	unsigned char * data;
-	int width;
-	int height;
+	const int folderId = result.FolderId;
+	const int panelId = result.PanelId;
+	unsigned char * data = result.Data;
+	const int width = result.Width;
+	const int height = result.Height;
 
-	sscanf( thumbnailCommand, "thumb %i %i %p %i %i", &folderId, &panelId, &data, &width, &height );
-	
 	Folder * folder = &GetFolder( folderId );
 	OVR_ASSERT( folder );
 
@@ -2203,6 +2209,12 @@ void OvrFolderBrowser::LoadThumbnailToTexture( const char * thumbnailCommand )
 		return;
 	}
 
+	panel->ThumbState = THUMBNAIL_LOADED;
+	if ( data == NULL )
+	{
+		return;
+	}
+
 	const int max = Alg::Max( width, height );
 
 	// Grab the Panel from VRMenu
@@ -2383,23 +2395,20 @@ void OvrFolderBrowser::AddPanelToFolder( OvrMetaDatum * const panoData, const in
 				{
 					if ( FileExists( panoData->Url ) && HasPermission( finalThumb, W_OK ) )
 					{
-						OvrCreateThumbCmd createCmd;
-						createCmd.SourceImagePath = panoUrl;
-						createCmd.ThumbDestination = finalThumb;
-						char loadCmd[ 1024 ];
-						sprintf( loadCmd, "load %i %i:%s", folderIndex, panel.Id, finalThumb.ToCStr() );
-						createCmd.LoadCmd = loadCmd;
-						ThumbCreateAndLoadCommands.PushBack( createCmd );
+						Panel & addedPanel = folder.Panels.Back();
+						addedPanel.ThumbState = THUMBNAIL_WAITING;
+						addedPanel.ThumbPath = finalThumb;
+						addedPanel.ThumbSourcePath = panoUrl;
 					}
 					return;
 				}
 			}
 		}
 	}
-	char cmd[ 1024 ];
-	sprintf( cmd, "load %i %i:%s", folderIndex, panel.Id, finalThumb.ToCStr() );
-	//LOG( "Thumb cmd: %s", cmd );
-	BackgroundCommands.PostString( cmd );
+	// requested by UpdateThumbnailRequests() once the panel is close to the view
+	Panel & addedPanel = folder.Panels.Back();
+	addedPanel.ThumbState = THUMBNAIL_WAITING;
+	addedPanel.ThumbPath = finalThumb;
 }
 
 unsigned char * OvrFolderBrowser::LoadThumbAndApplyAA( const String & fileName, int & width, int & height )
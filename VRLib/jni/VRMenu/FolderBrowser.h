@@ -14,7 +14,7 @@ Copyright   :   Copyright 2014 Oculus VR, LLC. All Rights reserved.
 #define OVR_FolderBrowser_h
 
 #include "VRMenu.h"
-#include "MessageQueue.h"
+#include "ThumbnailScheduler.h"
 #include "Kernel/OVR_StringHash.h"
 
 namespace OVR {
@@ -127,15 +127,27 @@ private:
 class OvrFolderBrowser : public VRMenu
 {
 public:
+	enum ThumbnailState
+	{
+		THUMBNAIL_NONE,			// No thumbnail and it can't be created
+		THUMBNAIL_WAITING,		// Not requested, or cancelled because the panel is too far from view
+		THUMBNAIL_REQUESTED,
+		THUMBNAIL_LOADED		// Or failed to load
+	};
+
 	struct Panel
 	{
 		Panel() 
 			: Id( -1 )
+			, ThumbState( THUMBNAIL_NONE )
 		{}
 
 		menuHandle_t			Handle;				// Handle to the panel		
 		int						Id;					// Unique id for thumbnail loading
 		Vector2f				Size;				// Thumbnail texture size
+		ThumbnailState			ThumbState;
+		String					ThumbPath;			// Thumbnail to load
+		String					ThumbSourcePath;	// Image to create the thumbnail from if it doesn't exist yet
 	};
 
 	struct Folder
@@ -208,6 +220,9 @@ public:
 
 	OvrFolderBrowserSwipeComponent * 	GetSwipeComponentForActiveFolder();
 
+	// Time it takes thumbnails to show up once their panels are in view
+	OvrThumbnailStats					GetThumbnailStats() const				{ return ThumbnailScheduler->GetStats(); }
+
 	void						SetScrollHintVisible( const bool visible );
 
 protected:
@@ -220,7 +235,8 @@ protected:
 				float radius,
 				unsigned numSwipePanels,
 				unsigned thumbWidth, 
-				unsigned thumbHeight );
+				unsigned thumbHeight,
+				int numThumbnailWorkers = 2 );
 
     virtual ~OvrFolderBrowser();
 
@@ -230,12 +246,12 @@ protected:
 	// Called when a panel is activated
 	virtual void				OnPanelActivated( OvrMetaDatum * panelData ) = 0;
 
-	// Called on a background thread
+	// Called on a thumbnail worker thread, on several at once if there is more than one worker
 	// The returned memory buffer will be free()'d after writing the thumbnail.
 	// Return NULL if the thumbnail couldn't be created.
 	virtual unsigned char *		CreateThumbnail( const char * filename, int & width, int & height ) = 0;
 
-	// Called on a background thread to load thumbnail
+	// Called on a thumbnail worker thread to load thumbnail
 	virtual	unsigned char *		LoadThumbnail( const char * filename, int & width, int & height ) = 0;
 
 	// Adds thumbnail extension to a file to find/create its thumbnail
@@ -271,8 +287,9 @@ protected:
 
 private:
 
-	static void *		ThumbnailThread( void * v );
-	void				LoadThumbnailToTexture( const char * thumbnailCommand );
+	static unsigned char *	LoadThumbnailRequest( void * userData, OvrThumbnailRequest const & request, int & width, int & height );
+	void				UpdateThumbnailRequests();
+	void				LoadThumbnailToTexture( OvrThumbnailResult const & result );
 
 	friend class OvrPanel_OnUp;
 	void				OnPanelUp( OvrMetaDatum * const data );
@@ -314,18 +331,8 @@ private:
 
 	RootDirection		OnEnterMenuRootAdjust;
 	
-	// Checked at Frame() time for commands from the thumbnail/create thread
-	MessageQueue		TextureCommands;
-
-	// Create / load thumbnails by background thread
-	struct OvrCreateThumbCmd
-	{
-		String SourceImagePath;
-		String ThumbDestination;
-		String LoadCmd;
-	};
-	Array< OvrCreateThumbCmd > ThumbCreateAndLoadCommands;
-	MessageQueue		BackgroundCommands;
+	// Create / load thumbnails on worker threads, closest to the gaze first
+	OvrThumbnailScheduler *	ThumbnailScheduler;
 	Array< String >		ThumbSearchPaths;
 
 	// Keep a reference to Panel texture used for AA alpha when creating thumbnails
@@ -0,0 +1,796 @@
+/************************************************************************************
+
+Filename    :   ThumbnailScheduler.cpp
+Content     :   Prioritized loading of folder browser thumbnails on worker threads
+Created     :   October, 2026
+
+Copyright   :   Copyright 2014 Oculus VR, LLC. All Rights reserved.
+
+*************************************************************************************/
+
+#include "ThumbnailScheduler.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <math.h>
+#include <sys/stat.h>
+#include "Kernel/OVR_Alg.h"
+#include "Kernel/OVR_Timer.h"
+#include "Kernel/OVR_Threads.h"
+#include "../VrCommon.h"
+#include "../ImageData.h"
+#include "../Log.h"
+
+namespace OVR {
+
+// A folderId or panelId of -1 matches any.
+static bool PanelMatches( int const entryFolderId, int const entryPanelId, int const folderId, int const panelId )
+{
+	return ( folderId < 0 || entryFolderId == folderId ) && ( panelId < 0 || entryPanelId == panelId );
+}
+
+static bool SameRequest( OvrThumbnailRequest const & a, OvrThumbnailRequest const & b )
+{
+	return a.FolderId == b.FolderId && a.PanelId == b.PanelId && a.Path == b.Path && a.SourcePath == b.SourcePath;
+}
+
+//==============================
+// OvrThumbnailScheduler::OvrThumbnailScheduler
+OvrThumbnailScheduler::OvrThumbnailScheduler( thumbnailLoadFunc_t loadFunc, void * userData, int const numWorkers )
+	: LoadFunc( loadFunc )
+	, UserData( userData )
+	, Shutdown( false )
+	, NextSequence( 0 )
+	, FirstVisibleTime( 0.0 )
+{
+	pthread_mutex_init( &Mutex, NULL );
+	pthread_cond_init( &Wake, NULL );
+
+	pthread_attr_t workerAttr;
+	pthread_attr_init( &workerAttr );
+	sched_param sparam;
+	sparam.sched_priority = Thread::GetOSPriority( Thread::BelowNormalPriority );
+	pthread_attr_setschedparam( &workerAttr, &sparam );
+
+	for ( int i = 0; i < Alg::Max( numWorkers, 1 ); i++ )
+	{
+		pthread_t worker;
+		const int createErr = pthread_create( &worker, &workerAttr, &WorkerThread, this );
+		if ( createErr != 0 )
+		{
+			LOG( "pthread_create returned %i", createErr );
+			continue;
+		}
+		Workers.PushBack( worker );
+	}
+	pthread_attr_destroy( &workerAttr );
+}
+
+//==============================
+// OvrThumbnailScheduler::~OvrThumbnailScheduler
+OvrThumbnailScheduler::~OvrThumbnailScheduler()
+{
+	pthread_mutex_lock( &Mutex );
+	Shutdown = true;
+	pthread_cond_broadcast( &Wake );
+	pthread_mutex_unlock( &Mutex );
+
+	for ( int i = 0; i < Workers.GetSizeI(); i++ )
+	{
+		pthread_join( Workers[i], NULL );
+	}
+
+	for ( int i = 0; i < Completed.GetSizeI(); i++ )
+	{
+		free( Completed[i].Result.Data );
+	}
+
+	pthread_cond_destroy( &Wake );
+	pthread_mutex_destroy( &Mutex );
+}
+
+//==============================
+// OvrThumbnailScheduler::WorkerThread
+void * OvrThumbnailScheduler::WorkerThread( void * parm )
+{
+	int result = pthread_setname_np( pthread_self(), "Thumbnails" );
+	if ( result != 0 )
+	{
+		LOG( "OvrThumbnailScheduler: pthread_setname_np failed %s", strerror( result ) );
+	}
+
+	sched_param sparam;
+	sparam.sched_priority = Thread::GetOSPriority( Thread::BelowNormalPriority );
+
+	int setSchedparamResult = pthread_setschedparam( pthread_self(), SCHED_NORMAL, &sparam );
+	if ( setSchedparamResult != 0 )
+	{
+		LOG( "OvrThumbnailScheduler: pthread_setschedparam failed %s", strerror( setSchedparamResult ) );
+	}
+
+	OvrThumbnailScheduler * scheduler = static_cast< OvrThumbnailScheduler * >( parm );
+
+	pthread_mutex_lock( &scheduler->Mutex );
+	for ( ;; )
+	{
+		while ( !scheduler->Shutdown && scheduler->Pending.GetSizeI() == 0 )
+		{
+			pthread_cond_wait( &scheduler->Wake, &scheduler->Mutex );
+		}
+		if ( scheduler->Shutdown )
+		{
+			break;
+		}
+
+		// take the request with the lowest priority, the oldest one if there is a tie
+		int best = 0;
+		for ( int i = 1; i < scheduler->Pending.GetSizeI(); i++ )
+		{
+			if ( scheduler->Pending[i].Priority < scheduler->Pending[best].Priority )
+			{
+				best = i;
+			}
+		}
+		scheduler->Loading.PushBack( scheduler->Pending[best] );
+		scheduler->Pending.RemoveAt( best );
+		OvrThumbnailRequest const request = scheduler->Loading.Back().Request;
+		int const sequence = scheduler->Loading.Back().Sequence;
+
+		pthread_mutex_unlock( &scheduler->Mutex );
+
+		double const loadStart = Timer::GetSeconds();
+		int width = 0;
+		int height = 0;
+		unsigned char * data = scheduler->LoadFunc( scheduler->UserData, request, width, height );
+		double const loadEnd = Timer::GetSeconds();
+
+		pthread_mutex_lock( &scheduler->Mutex );
+
+		scheduler->Stats.LoadSeconds += loadEnd - loadStart;
+		for ( int i = 0; i < scheduler->Loading.GetSizeI(); i++ )
+		{
+			entry_t const & entry = scheduler->Loading[i];
+			if ( entry.Sequence != sequence )
+			{
+				continue;
+			}
+			if ( entry.Cancelled )
+			{
+				free( data );
+				scheduler->Stats.NumDiscarded++;
+			}
+			else
+			{
+				completed_t completed;
+				completed.Request = request;
+				completed.Result.FolderId = request.FolderId;
+				completed.Result.PanelId = request.PanelId;
+				completed.Result.Data = data;
+				completed.Result.Width = width;
+				completed.Result.Height = height;
+				completed.Visible = entry.Visible;
+				completed.VisibleTime = entry.VisibleTime;
+				scheduler->Completed.PushBack( completed );
+				if ( data != NULL )
+				{
+					scheduler->Stats.NumLoaded++;
+				}
+				else
+				{
+					scheduler->Stats.NumFailed++;
+				}
+			}
+			scheduler->Loading.RemoveAtUnordered( i );
+			break;
+		}
+	}
+	pthread_mutex_unlock( &scheduler->Mutex );
+
+	return NULL;
+}
+
+//==============================
+// OvrThumbnailScheduler::AnyVisibleOutstanding
+bool OvrThumbnailScheduler::AnyVisibleOutstanding() const
+{
+	for ( int i = 0; i < Pending.GetSizeI(); i++ )
+	{
+		if ( Pending[i].Visible )
+		{
+			return true;
+		}
+	}
+	for ( int i = 0; i < Loading.GetSizeI(); i++ )
+	{
+		if ( Loading[i].Visible )
+		{
+			return true;
+		}
+	}
+	for ( int i = 0; i < Completed.GetSizeI(); i++ )
+	{
+		if ( Completed[i].Visible )
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+//==============================
+// OvrThumbnailScheduler::UpdateVisible
+// Starts the clocks when a panel becomes visible.
+void OvrThumbnailScheduler::UpdateVisible( bool & visible, double & visibleTime, bool const nowVisible, double const now )
+{
+	if ( nowVisible && !visible )
+	{
+		if ( !AnyVisibleOutstanding() )
+		{
+			FirstVisibleTime = now;
+		}
+		visibleTime = now;
+	}
+	else if ( !nowVisible )
+	{
+		visibleTime = 0.0;
+	}
+	visible = nowVisible;
+
+	if ( !nowVisible && FirstVisibleTime > 0.0 && !AnyVisibleOutstanding() )
+	{
+		// everything that was waiting in view has left it
+		FirstVisibleTime = 0.0;
+	}
+}
+
+//==============================
+// OvrThumbnailScheduler::UpdateLocked
+// Updates the outstanding request for the panel, returns false if there is none.
+bool OvrThumbnailScheduler::UpdateLocked( int const folderId, int const panelId, float const priority, bool const visible, double const now )
+{
+	for ( int i = 0; i < Pending.GetSizeI(); i++ )
+	{
+		entry_t & entry = Pending[i];
+		if ( entry.Request.FolderId == folderId && entry.Request.PanelId == panelId )
+		{
+			entry.Priority = priority;
+			UpdateVisible( entry.Visible, entry.VisibleTime, visible, now );
+			return true;
+		}
+	}
+	for ( int i = 0; i < Loading.GetSizeI(); i++ )
+	{
+		entry_t & entry = Loading[i];
+		if ( !entry.Cancelled && entry.Request.FolderId == folderId && entry.Request.PanelId == panelId )
+		{
+			UpdateVisible( entry.Visible, entry.VisibleTime, visible, now );
+			return true;
+		}
+	}
+	for ( int i = 0; i < Completed.GetSizeI(); i++ )
+	{
+		completed_t & completed = Completed[i];
+		if ( completed.Result.FolderId == folderId && completed.Result.PanelId == panelId )
+		{
+			UpdateVisible( completed.Visible, completed.VisibleTime, visible, now );
+			return true;
+		}
+	}
+	return false;
+}
+
+//==============================
+// OvrThumbnailScheduler::Request
+void OvrThumbnailScheduler::Request( OvrThumbnailRequest const & request, float const priority, bool const visible )
+{
+	double const now = Timer::GetSeconds();
+
+	pthread_mutex_lock( &Mutex );
+
+	Stats.NumRequested++;
+
+	// the panel may have been given a different image, e.g. after the folder was rebuilt
+	CancelLocked( request.FolderId, request.PanelId, &request );
+
+	// a request that was cancelled while loading is delivered after all
+	for ( int i = 0; i < Loading.GetSizeI(); i++ )
+	{
+		entry_t & entry = Loading[i];
+		if ( entry.Cancelled && SameRequest( entry.Request, request ) )
+		{
+			entry.Cancelled = false;
+			UpdateVisible( entry.Visible, entry.VisibleTime, visible, now );
+			pthread_mutex_unlock( &Mutex );
+			return;
+		}
+	}
+
+	if ( !UpdateLocked( request.FolderId, request.PanelId, priority, visible, now ) )
+	{
+		entry_t entry;
+		entry.Request = request;
+		entry.Priority = priority;
+		entry.Visible = false;
+		entry.Cancelled = false;
+		entry.VisibleTime = 0.0;
+		entry.Sequence = NextSequence++;
+		UpdateVisible( entry.Visible, entry.VisibleTime, visible, now );
+		Pending.PushBack( entry );
+		pthread_cond_signal( &Wake );
+	}
+
+	pthread_mutex_unlock( &Mutex );
+}
+
+//==============================
+// OvrThumbnailScheduler::SetPriority
+bool OvrThumbnailScheduler::SetPriority( int const folderId, int const panelId, float const priority, bool const visible )
+{
+	double const now = Timer::GetSeconds();
+
+	pthread_mutex_lock( &Mutex );
+	bool const found = UpdateLocked( folderId, panelId, priority, visible, now );
+	pthread_mutex_unlock( &Mutex );
+
+	return found;
+}
+
+//==============================
+// OvrThumbnailScheduler::CancelLocked
+// Cancels the matching requests, except for the ones identical to keep if it is not NULL.
+void OvrThumbnailScheduler::CancelLocked( int const folderId, int const panelId, OvrThumbnailRequest const * keep )
+{
+	for ( int i = Pending.GetSizeI() - 1; i >= 0; i-- )
+	{
+		if ( PanelMatches( Pending[i].Request.FolderId, Pending[i].Request.PanelId, folderId, panelId ) &&
+				( keep == NULL || !SameRequest( Pending[i].Request, *keep ) ) )
+		{
+			Pending.RemoveAt( i );
+			Stats.NumCancelled++;
+		}
+	}
+	for ( int i = 0; i < Loading.GetSizeI(); i++ )
+	{
+		// the worker throws the result away when it is done
+		if ( !Loading[i].Cancelled && PanelMatches( Loading[i].Request.FolderId, Loading[i].Request.PanelId, folderId, panelId ) &&
+				( keep == NULL || !SameRequest( Loading[i].Request, *keep ) ) )
+		{
+			Loading[i].Cancelled = true;
+			Loading[i].Visible = false;
+		}
+	}
+	for ( int i = Completed.GetSizeI() - 1; i >= 0; i-- )
+	{
+		OvrThumbnailResult const & result = Completed[i].Result;
+		if ( PanelMatches( result.FolderId, result.PanelId, folderId, panelId ) &&
+				( keep == NULL || !SameRequest( Completed[i].Request, *keep ) ) )
+		{
+			free( result.Data );
+			Completed.RemoveAt( i );
+			Stats.NumDiscarded++;
+		}
+	}
+
+	if ( FirstVisibleTime > 0.0 && !AnyVisibleOutstanding() )
+	{
+		FirstVisibleTime = 0.0;
+	}
+}
+
+//==============================
+// OvrThumbnailScheduler::Cancel
+void OvrThumbnailScheduler::Cancel( int const folderId, int const panelId )
+{
+	pthread_mutex_lock( &Mutex );
+	CancelLocked( folderId, panelId, NULL );
+	pthread_mutex_unlock( &Mutex );
+}
+
+//==============================
+// OvrThumbnailScheduler::CancelAll
+void OvrThumbnailScheduler::CancelAll()
+{
+	Cancel( -1, -1 );
+}
+
+//==============================
+// OvrThumbnailScheduler::GetNextResult
+bool OvrThumbnailScheduler::GetNextResult( OvrThumbnailResult & result )
+{
+	pthread_mutex_lock( &Mutex );
+
+	if ( Completed.GetSizeI() == 0 )
+	{
+		pthread_mutex_unlock( &Mutex );
+		return false;
+	}
+
+	completed_t const completed = Completed[0];
+	Completed.RemoveAt( 0 );
+	result = completed.Result;
+
+	if ( completed.Visible )
+	{
+		double const now = Timer::GetSeconds();
+		double const visibleSeconds = now - completed.VisibleTime;
+		Stats.NumVisible++;
+		Stats.VisibleSeconds += visibleSeconds;
+		Stats.MaxVisibleSeconds = Alg::Max( Stats.MaxVisibleSeconds, visibleSeconds );
+
+		if ( FirstVisibleTime > 0.0 )
+		{
+			double const firstVisibleSeconds = now - FirstVisibleTime;
+			Stats.NumFirstVisible++;
+			Stats.FirstVisibleSeconds += firstVisibleSeconds;
+			Stats.MaxFirstVisibleSeconds = Alg::Max( Stats.MaxFirstVisibleSeconds, firstVisibleSeconds );
+			FirstVisibleTime = 0.0;
+		}
+	}
+
+	pthread_mutex_unlock( &Mutex );
+	return true;
+}
+
+//==============================
+// OvrThumbnailScheduler::GetStats
+OvrThumbnailStats OvrThumbnailScheduler::GetStats() const
+{
+	pthread_mutex_lock( &Mutex );
+	OvrThumbnailStats const stats = Stats;
+	pthread_mutex_unlock( &Mutex );
+	return stats;
+}
+
+//==============================
+// OvrThumbnailScheduler::ResetStats
+void OvrThumbnailScheduler::ResetStats()
+{
+	pthread_mutex_lock( &Mutex );
+	Stats = OvrThumbnailStats();
+	pthread_mutex_unlock( &Mutex );
+}
+
+//==============================================================
+// ThumbnailSchedulerBenchmark
+
+static const int BENCHMARK_SOURCE_WIDTH = 1024;
+static const int BENCHMARK_SOURCE_HEIGHT = 512;
+static const int BENCHMARK_THUMB_WIDTH = 256;
+static const int BENCHMARK_THUMB_HEIGHT = 128;
+static const int BENCHMARK_SWIPE_PANELS = 5;		// like the folder browsers, 2 on each side of the center panel
+static const double BENCHMARK_HOLD_SECONDS = 1.0;
+
+// Creates the thumbnail from the full size image, like the folder browsers do for
+// images that do not have a thumbnail yet.
+static unsigned char * LoadBenchmarkThumbnail( void * userData, OvrThumbnailRequest const & request, int & width, int & height )
+{
+	OVR_UNUSED( userData );
+
+	int sourceWidth = 0;
+	int sourceHeight = 0;
+	unsigned char * source = TurboJpegLoadFromFile( request.Path.ToCStr(), &sourceWidth, &sourceHeight );
+	if ( source == NULL )
+	{
+		return NULL;
+	}
+	width = BENCHMARK_THUMB_WIDTH;
+	height = BENCHMARK_THUMB_HEIGHT;
+	// This runs on one of the scheduler workers, which already keep the cores busy.
+	unsigned char * thumb = ScaleImageRGBA( source, sourceWidth, sourceHeight, width, height, IMAGE_FILTER_LINEAR, 1 );
+	free( source );
+	return thumb;
+}
+
+static String BenchmarkImagePath( String const & directory, int const panel )
+{
+	char name[64];
+	OVR_sprintf( name, sizeof( name ), "thumbnail_benchmark_%03i.jpg", panel );
+	return directory + name;
+}
+
+void ThumbnailSchedulerBenchmark( void * appPtr, const char * cmd )
+{
+	OVR_UNUSED( appPtr );
+
+	char directoryName[256] = "/sdcard/Oculus/ThumbnailBenchmark/";
+	int numWorkers = Alg::Max( Thread::GetCPUCount() - 1, 2 );
+	int numPanels = 60;
+	float panelsPerSecond = 5.0f;
+	sscanf( cmd, "%255s %i %i %f", directoryName, &numWorkers, &numPanels, &panelsPerSecond );
+	numWorkers = Alg::Max( numWorkers, 1 );
+	numPanels = Alg::Max( numPanels, BENCHMARK_SWIPE_PANELS * 4 );
+	panelsPerSecond = Alg::Max( panelsPerSecond, 0.1f );
+
+	String directory( directoryName );
+	if ( directory.GetLengthI() == 0 || directory.ToCStr()[directory.GetLengthI() - 1] != '/' )
+	{
+		directory += "/";
+	}
+	MakePath( directory, S_IRWXU );
+
+	// every image different, with some noise so decoding is not trivial
+	unsigned char * image = ( unsigned char * )malloc( BENCHMARK_SOURCE_WIDTH * BENCHMARK_SOURCE_HEIGHT * 4 );
+	UInt32 noise = 12345;
+	for ( int panel = 0; panel < numPanels; panel++ )
+	{
+		for ( int y = 0; y < BENCHMARK_SOURCE_HEIGHT; y++ )
+		{
+			for ( int x = 0; x < BENCHMARK_SOURCE_WIDTH; x++ )
+			{
+				noise = noise * 1664525 + 1013904223;
+				unsigned char * texel = image + ( y * BENCHMARK_SOURCE_WIDTH + x ) * 4;
+				texel[0] = ( unsigned char )( x + panel * 37 + ( ( noise >> 24 ) & 31 ) );
+				texel[1] = ( unsigned char )( y * 2 + panel * 11 + ( ( noise >> 16 ) & 31 ) );
+				texel[2] = ( unsigned char )( ( x ^ y ) + panel );
+				texel[3] = 255;
+			}
+		}
+		WriteJpeg( BenchmarkImagePath( directory, panel ), image, BENCHMARK_SOURCE_WIDTH, BENCHMARK_SOURCE_HEIGHT );
+	}
+	free( image );
+
+	LOG( "ThumbnailSchedulerBenchmark: %i %ix%i images in %s, scrolling at %.1f panels per second",
+			numPanels, BENCHMARK_SOURCE_WIDTH, BENCHMARK_SOURCE_HEIGHT, directory.ToCStr(), panelsPerSecond );
+
+	// Jump to the middle of the category, stay there for a moment, scroll to the end and stay there again.
+	int const extraPanels = BENCHMARK_SWIPE_PANELS / 2;
+	int const prefetchPanels = BENCHMARK_SWIPE_PANELS;
+	float const startPosition = static_cast< float >( numPanels / 2 );
+	float const endPosition = static_cast< float >( numPanels - 1 - extraPanels );
+	double const scrollSeconds = ( endPosition - startPosition ) / panelsPerSecond;
+
+	static const char * modeNames[] = { "in order", "by distance", "by distance" };
+	for ( int mode = 0; mode < 3; mode++ )
+	{
+		bool const inOrder = ( mode == 0 );
+		OvrThumbnailScheduler scheduler( LoadBenchmarkThumbnail, NULL, ( mode == 2 ) ? numWorkers : 1 );
+
+		// 0 = not requested, 1 = requested, 2 = loaded
+		Array< UByte > panelState;
+		panelState.Resize( numPanels );
+		for ( int panel = 0; panel < numPanels; panel++ )
+		{
+			panelState[panel] = 0;
+		}
+
+		if ( inOrder )
+		{
+			// the old thumbnail thread was handed every panel when the folder was built
+			for ( int panel = 0; panel < numPanels; panel++ )
+			{
+				OvrThumbnailRequest request;
+				request.FolderId = 0;
+				request.PanelId = panel;
+				request.Path = BenchmarkImagePath( directory, panel );
+				scheduler.Request( request, static_cast< float >( panel ), false );
+				panelState[panel] = 1;
+			}
+		}
+
+		int numVisibleFrames = 0;
+		int numBlankFrames = 0;
+		double firstVisibleSeconds = -1.0;
+		double const start = Timer::GetSeconds();
+		for ( ;; )
+		{
+			double const frameStart = Timer::GetSeconds();
+			double const t = frameStart - start;
+			if ( t > BENCHMARK_HOLD_SECONDS * 2.0 + scrollSeconds )
+			{
+				break;
+			}
+			float const position = ( t < BENCHMARK_HOLD_SECONDS ) ? startPosition :
+					Alg::Min( startPosition + static_cast< float >( t - BENCHMARK_HOLD_SECONDS ) * panelsPerSecond, endPosition );
+			int const centerPanel = static_cast< int >( floorf( position + 0.5f ) );
+
+			for ( int panel = 0; panel < numPanels; panel++ )
+			{
+				int const offset = abs( panel - centerPanel );
+				bool const visible = ( offset <= extraPanels );
+				if ( visible )
+				{
+					numVisibleFrames++;
+					numBlankFrames += ( panelState[panel] != 2 ) ? 1 : 0;
+				}
+				if ( panelState[panel] == 2 )
+				{
+					continue;
+				}
+
+				float const distance = fabsf( panel - position );
+				if ( inOrder )
+				{
+					scheduler.SetPriority( 0, panel, static_cast< float >( panel ), visible );
+				}
+				else if ( offset <= extraPanels + prefetchPanels )
+				{
+					if ( panelState[panel] == 0 )
+					{
+						OvrThumbnailRequest request;
+						request.FolderId = 0;
+						request.PanelId = panel;
+						request.Path = BenchmarkImagePath( directory, panel );
+						scheduler.Request( request, distance, visible );
+						panelState[panel] = 1;
+					}
+					else
+					{
+						scheduler.SetPriority( 0, panel, distance, visible );
+					}
+				}
+				else if ( panelState[panel] == 1 )
+				{
+					scheduler.Cancel( 0, panel );
+					panelState[panel] = 0;
+				}
+			}
+
+			OvrThumbnailResult result;
+			while ( scheduler.GetNextResult( result ) )
+			{
+				panelState[result.PanelId] = 2;
+				free( result.Data );
+				if ( firstVisibleSeconds < 0.0 && abs( result.PanelId - centerPanel ) <= extraPanels )
+				{
+					firstVisibleSeconds = Timer::GetSeconds() - start;
+				}
+			}
+
+			double const frameSeconds = Timer::GetSeconds() - frameStart;
+			if ( frameSeconds < 1.0 / 60.0 )
+			{
+				usleep( static_cast< useconds_t >( ( 1.0 / 60.0 - frameSeconds ) * 1e6 ) );
+			}
+		}
+
+		OvrThumbnailStats const stats = scheduler.GetStats();
+		LOG( "ThumbnailSchedulerBenchmark: %s, %i worker(s): visible panels blank %.1f%% of the time",
+				modeNames[mode], scheduler.GetNumWorkers(), numVisibleFrames > 0 ? numBlankFrames * 100.0 / numVisibleFrames : 0.0 );
+		if ( firstVisibleSeconds >= 0.0 )
+		{
+			LOG( "ThumbnailSchedulerBenchmark: first thumbnail in view after %.0f ms", firstVisibleSeconds * 1000.0 );
+		}
+		else
+		{
+			LOG( "ThumbnailSchedulerBenchmark: no thumbnail was ever delivered in view" );
+		}
+		LOG( "ThumbnailSchedulerBenchmark: %i loaded, %i failed, %i cancelled, %i discarded, %.1f ms per load",
+				stats.NumLoaded, stats.NumFailed, stats.NumCancelled, stats.NumDiscarded,
+				stats.LoadSeconds * 1000.0 / Alg::Max( stats.NumLoaded + stats.NumFailed + stats.NumDiscarded, 1 ) );
+		LOG( "ThumbnailSchedulerBenchmark: visible to delivered %.0f ms mean, %.0f ms max, first of a burst %.0f ms mean, %.0f ms max",
+				stats.VisibleSeconds * 1000.0 / Alg::Max( stats.NumVisible, 1 ), stats.MaxVisibleSeconds * 1000.0,
+				stats.FirstVisibleSeconds * 1000.0 / Alg::Max( stats.NumFirstVisible, 1 ), stats.MaxFirstVisibleSeconds * 1000.0 );
+	}
+
+	for ( int panel = 0; panel < numPanels; panel++ )
+	{
+		unlink( BenchmarkImagePath( directory, panel ).ToCStr() );
+	}
+}
+
+//==============================================================
+// ThumbnailSchedulerTest
+
+// Holds every load until the test releases them.
+struct thumbnailTestGate_t
+{
+	pthread_mutex_t		Mutex;
+	pthread_cond_t		Changed;
+	int					NumStarted;
+	bool				Released;
+};
+
+// The single texel of the image is the first character of the path.
+static unsigned char * LoadTestThumbnail( void * userData, OvrThumbnailRequest const & request, int & width, int & height )
+{
+	thumbnailTestGate_t * gate = static_cast< thumbnailTestGate_t * >( userData );
+
+	pthread_mutex_lock( &gate->Mutex );
+	gate->NumStarted++;
+	pthread_cond_broadcast( &gate->Changed );
+	while ( !gate->Released )
+	{
+		pthread_cond_wait( &gate->Changed, &gate->Mutex );
+	}
+	pthread_mutex_unlock( &gate->Mutex );
+
+	width = 1;
+	height = 1;
+	unsigned char * data = ( unsigned char * )malloc( 4 );
+	data[0] = data[1] = data[2] = data[3] = static_cast< unsigned char >( request.Path.ToCStr()[0] );
+	return data;
+}
+
+static OvrThumbnailRequest TestRequest( int const panelId, const char * path )
+{
+	OvrThumbnailRequest request;
+	request.FolderId = 0;
+	request.PanelId = panelId;
+	request.Path = path;
+	return request;
+}
+
+// Requests "a" for panel 0 and waits until it is loading. Then either cancels the
+// folder like OvrFolderBrowser::RebuildFolder and requests secondPath again for the
+// same panel id, or requests secondPath without cancelling. Returns true if panel 0
+// receives only the image of secondPath.
+static bool TestInFlightRequest( const char * name, bool const cancelFolder, const char * secondPath )
+{
+	thumbnailTestGate_t gate;
+	pthread_mutex_init( &gate.Mutex, NULL );
+	pthread_cond_init( &gate.Changed, NULL );
+	gate.NumStarted = 0;
+	gate.Released = false;
+
+	int numResults = 0;
+	int numWrong = 0;
+	{
+		OvrThumbnailScheduler scheduler( LoadTestThumbnail, &gate, 1 );
+
+		scheduler.Request( TestRequest( 0, "a" ), 0.0f, true );
+
+		pthread_mutex_lock( &gate.Mutex );
+		while ( gate.NumStarted == 0 )
+		{
+			pthread_cond_wait( &gate.Changed, &gate.Mutex );
+		}
+		pthread_mutex_unlock( &gate.Mutex );
+
+		if ( cancelFolder )
+		{
+			scheduler.Cancel( 0, -1 );
+		}
+		scheduler.Request( TestRequest( 0, secondPath ), 0.0f, true );
+
+		pthread_mutex_lock( &gate.Mutex );
+		gate.Released = true;
+		pthread_cond_broadcast( &gate.Changed );
+		pthread_mutex_unlock( &gate.Mutex );
+
+		// Every load is done once the last request was delivered, but keep
+		// looking a little longer for a stale result after it.
+		double const start = Timer::GetSeconds();
+		double lastResult = 0.0;
+		while ( Timer::GetSeconds() - start < 5.0 && ( lastResult == 0.0 || Timer::GetSeconds() - lastResult < 0.1 ) )
+		{
+			OvrThumbnailResult result;
+			while ( scheduler.GetNextResult( result ) )
+			{
+				numResults++;
+				if ( result.PanelId != 0 || result.Data == NULL || result.Data[0] != static_cast< unsigned char >( secondPath[0] ) )
+				{
+					numWrong++;
+				}
+				free( result.Data );
+				lastResult = Timer::GetSeconds();
+			}
+			usleep( 1000 );
+		}
+	}
+
+	pthread_cond_destroy( &gate.Changed );
+	pthread_mutex_destroy( &gate.Mutex );
+
+	bool const passed = ( numResults == 1 && numWrong == 0 );
+	LOG( "thumbnailSchedulerTest: %-28s %i load(s), %i result(s), %i wrong%s",
+			name, gate.NumStarted, numResults, numWrong, passed ? "" : " FAILED" );
+	return passed;
+}
+
+void ThumbnailSchedulerTest( void * appPtr, const char * cmd )
+{
+	OVR_UNUSED( appPtr );
+	OVR_UNUSED( cmd );
+
+	int numFailed = 0;
+	numFailed += !TestInFlightRequest( "rebuilt with a new image", true, "b" );
+	numFailed += !TestInFlightRequest( "rebuilt with the same image", true, "a" );
+	numFailed += !TestInFlightRequest( "new image without cancel", false, "b" );
+	numFailed += !TestInFlightRequest( "same image without cancel", false, "a" );
+
+	LOG( "thumbnailSchedulerTest: %s", numFailed == 0 ? "passed" : "FAILED" );
+}
+
+} // namespace OVR
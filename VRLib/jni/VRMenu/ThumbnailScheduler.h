@@ -0,0 +1,203 @@
+/************************************************************************************
+
+Filename    :   ThumbnailScheduler.h
+Content     :   Prioritized loading of folder browser thumbnails on worker threads
+Created     :   October, 2026
+
+Copyright   :   Copyright 2014 Oculus VR, LLC. All Rights reserved.
+
+*************************************************************************************/
+
+#if !defined( OVR_ThumbnailScheduler_h )
+#define OVR_ThumbnailScheduler_h
+
+#include <pthread.h>
+#include "Kernel/OVR_Array.h"
+#include "Kernel/OVR_String.h"
+
+namespace OVR {
+
+/*
+	Scrolling through a long category used to load thumbnails strictly in
+	the order the panels were added, so the panels in view waited for every
+	panel before them, including the ones already swiped past.
+
+	The scheduler keeps the outstanding requests in a list that the owner
+	re-prioritizes every frame, usually with the angle between the gaze and
+	the panel. Workers always take the request with the lowest priority.
+	Requests for panels that leave the window around the view are cancelled,
+	and the results of cancelled requests that were already loading are
+	thrown away instead of being delivered.
+
+	Panel ids are reused when a folder is rebuilt, so a request only picks up
+	an earlier one for the same panel if it is for the same image. Workers
+	find their entry again by a sequence number that is never reused.
+
+	There are rarely more than a few dozen requests outstanding, so the
+	workers simply scan the list for the best one.
+*/
+
+struct OvrThumbnailRequest
+{
+	OvrThumbnailRequest()
+		: FolderId( -1 )
+		, PanelId( -1 )
+	{
+	}
+
+	int			FolderId;
+	int			PanelId;
+	String		Path;			// thumbnail to load
+	String		SourcePath;		// if not empty, the thumbnail is created from this image and written to Path
+};
+
+struct OvrThumbnailResult
+{
+	OvrThumbnailResult()
+		: FolderId( -1 )
+		, PanelId( -1 )
+		, Data( NULL )
+		, Width( 0 )
+		, Height( 0 )
+	{
+	}
+
+	int				FolderId;
+	int				PanelId;
+	unsigned char *	Data;		// RGBA, free()'d by the receiver, NULL if the load failed
+	int				Width;
+	int				Height;
+};
+
+struct OvrThumbnailStats
+{
+	OvrThumbnailStats()
+		: NumRequested( 0 )
+		, NumLoaded( 0 )
+		, NumFailed( 0 )
+		, NumCancelled( 0 )
+		, NumDiscarded( 0 )
+		, LoadSeconds( 0.0 )
+		, NumVisible( 0 )
+		, VisibleSeconds( 0.0 )
+		, MaxVisibleSeconds( 0.0 )
+		, NumFirstVisible( 0 )
+		, FirstVisibleSeconds( 0.0 )
+		, MaxFirstVisibleSeconds( 0.0 )
+	{
+	}
+
+	int			NumRequested;
+	int			NumLoaded;
+	int			NumFailed;
+	int			NumCancelled;			// cancelled before a worker got to them
+	int			NumDiscarded;			// cancelled after the work was started or done
+	double		LoadSeconds;			// total time the workers spent loading
+
+	// Time from a panel becoming visible without a thumbnail to the thumbnail being delivered.
+	int			NumVisible;
+	double		VisibleSeconds;
+	double		MaxVisibleSeconds;
+
+	// Time from the first visible panel waiting for a thumbnail, when none were
+	// waiting before, to the first visible thumbnail being delivered.
+	int			NumFirstVisible;
+	double		FirstVisibleSeconds;
+	double		MaxFirstVisibleSeconds;
+};
+
+// Called on a worker thread. Returns a malloc()'ed RGBA image, or NULL if the thumbnail
+// could not be loaded or created.
+typedef unsigned char * ( *thumbnailLoadFunc_t )( void * userData, OvrThumbnailRequest const & request, int & width, int & height );
+
+// All methods except the load function are called by the thread that owns the scheduler.
+class OvrThumbnailScheduler
+{
+public:
+							OvrThumbnailScheduler( thumbnailLoadFunc_t loadFunc, void * userData, int const numWorkers );
+							// Waits for the workers to finish their current load.
+							~OvrThumbnailScheduler();
+
+	// Queues a request. Requests with a lower priority are loaded first. If the
+	// panel is visible, the time until its thumbnail is delivered is tracked.
+	// An outstanding request for the same panel with a different Path or
+	// SourcePath is cancelled.
+	void					Request( OvrThumbnailRequest const & request, float const priority, bool const visible );
+
+	// Updates the priority of a request that was queued with Request().
+	// Returns false if there is no outstanding request for the panel.
+	bool					SetPriority( int const folderId, int const panelId, float const priority, bool const visible );
+
+	// Drops the request for a panel, or all requests of a folder if panelId is -1.
+	// Once cancelled, no result is delivered for the request, even if it was already loading.
+	void					Cancel( int const folderId, int const panelId );
+	void					CancelAll();
+
+	// Returns false if there are no more results.
+	bool					GetNextResult( OvrThumbnailResult & result );
+
+	int						GetNumWorkers() const { return Workers.GetSizeI(); }
+	OvrThumbnailStats		GetStats() const;
+	void					ResetStats();
+
+private:
+	struct entry_t
+	{
+		OvrThumbnailRequest	Request;
+		float				Priority;
+		bool				Visible;
+		bool				Cancelled;		// only used while loading
+		double				VisibleTime;	// when the panel became visible, 0 if it is not
+		int					Sequence;		// identifies the entry to the worker loading it
+	};
+
+	struct completed_t
+	{
+		OvrThumbnailRequest	Request;
+		OvrThumbnailResult	Result;
+		bool				Visible;
+		double				VisibleTime;
+	};
+
+	thumbnailLoadFunc_t		LoadFunc;
+	void *					UserData;
+	Array< pthread_t >		Workers;
+
+	mutable pthread_mutex_t	Mutex;
+	pthread_cond_t			Wake;
+	bool					Shutdown;
+
+	// All protected by Mutex. A panel has at most one entry in the three lists together,
+	// not counting cancelled entries in Loading.
+	Array< entry_t >		Pending;		// in request order
+	Array< entry_t >		Loading;
+	int						NextSequence;
+	Array< completed_t >	Completed;
+	double					FirstVisibleTime;	// when the oldest waiting visible panel became visible, 0 if none are waiting
+	OvrThumbnailStats		Stats;
+
+	static void *			WorkerThread( void * parm );
+	void					UpdateVisible( bool & visible, double & visibleTime, bool const nowVisible, double const now );
+	bool					AnyVisibleOutstanding() const;
+	bool					UpdateLocked( int const folderId, int const panelId, float const priority, bool const visible, double const now );
+	void					CancelLocked( int const folderId, int const panelId, OvrThumbnailRequest const * keep );
+};
+
+// Generates JPEGs in a directory and loads thumbnails from them through the scheduler
+// while simulating a folder browser that jumps to the middle of a category and then
+// scrolls to its end. Logs how long the panels in view stay without a thumbnail,
+// first strictly in order with one worker like the old thumbnail thread, then by
+// distance to the view with one and with several workers.
+// Registered as the "thumbnailSchedulerBenchmark" console command, optional parms:
+// "<directory> <workers> <panels> <panels per second>"
+void ThumbnailSchedulerBenchmark( void * appPtr, const char * cmd );
+
+// Cancels and re-requests panels while their loads are held in flight, the way
+// the folder browser does when it rebuilds a folder, and checks that every panel
+// receives exactly the image that was last requested for it. Needs no files.
+// Registered as the "thumbnailSchedulerTest" console command.
+void ThumbnailSchedulerTest( void * appPtr, const char * cmd );
+
+} // namespace OVR
+
+#endif // OVR_ThumbnailScheduler_h
@@ -20,7 +20,10 @@ Copyright   :   Copyright 2014 Oculus VR, LLC. All Rights reserved.
 #include "DebugLines.h"
 #include "BitmapFont.h"
 #include "VRMenu/VRMenuObjectLocal.h"
+#include "../RayTracer/RtIntersect.h"
+#include "Kernel/OVR_Timer.h"
 
+#include <stdio.h>
 
 
 namespace OVR {
@@ -226,6 +229,7 @@ class VRMenuMgrLocal : public OvrVRMenuMgr
 {
 public:
 	static int const	MAX_SUBMITTED	= 256;
+	static int const	OBJECTS_PER_SLAB	= 64;
 
 	VRMenuMgrLocal();
 	virtual	~VRMenuMgrLocal();
@@ -254,6 +258,18 @@ public:
                                         BitmapFontSurface & fontSurface, menuHandle_t const handle, 
                                         Posef const & worldPose, VRMenuRenderFlags_t const & flags );
 
+	// Drops every text layout on a font surface that is about to be freed.
+	virtual void				ForgetFontSurface( BitmapFontSurface const & fontSurface );
+
+	virtual Array< VRMenuWorldTransform > const &	UpdateWorldTransforms( menuHandle_t const root, Posef const & worldPose );
+
+	virtual menuHandle_t		HitTest( BitmapFont const & font, menuHandle_t const root, Posef const & worldPose, 
+										Vector3f const & rayStart, Vector3f const & rayDir, ContentFlags_t const testContents, 
+										HitTestResult & result );
+	virtual void				HitTestRays( BitmapFont const & font, menuHandle_t const root, Posef const & worldPose, 
+										VRMenuRay const * rays, int const numRays, ContentFlags_t const testContents, 
+										HitTestResult * results );
+
 	// Call once per frame before rendering to sort surfaces.
 	virtual void				Finish( Matrix4f const & viewMatrix );
 
@@ -263,24 +279,106 @@ public:
     virtual GlProgram const *   GetGUIGlProgram( eGUIProgramType const programType ) const;
 
 private:
+	friend void VRMenuTransformBenchmark( void * appPtr, const char * cmd );
+	friend void VRMenuHitTestBenchmark( void * appPtr, const char * cmd );
+	friend void VRMenuObjectChurnBenchmark( void * appPtr, const char * cmd );
+
+	struct worldTransforms_t;
+
 	//--------------------------------------------------------------
 	// private methods
 	//--------------------------------------------------------------
-	void						CondenseList();
-	void						SubmitForRenderingRecursive( OvrDebugLines & debugLines, BitmapFont const & font, 
-                                        BitmapFontSurface & fontSurface, VRMenuRenderFlags_t const & flags, 
-                                        VRMenuObjectLocal const * obj, Posef const & parentModelPose, 
-										Vector4f const & parentColor, Vector3f const & parentScale, Bounds3f & cullBounds,
-                                        SubmittedMenuObject * submitted, int const maxIndices, int & curIndex ) const;
+	void						AllocSlab();
+	worldTransforms_t *			UpdateTree( menuHandle_t const root, Posef const & worldPose );
+	void						UpdateHitBounds( BitmapFont const & font, worldTransforms_t & tree ) const;
+	void						BuildHitNodes_r( worldTransforms_t & tree, Array< Vector3f > const & centers, 
+										int const nodeIndex, int const first, int const count ) const;
+	void						HitTestRay( BitmapFont const & font, worldTransforms_t const & tree, 
+										VRMenuRay const & ray, Vector3f const & rootStart, Vector3f const & rootDir, 
+										ContentFlags_t const testContents, HitTestResult & result );
+	void						FlattenTree_r( Array< VRMenuWorldTransform > & transforms, 
+										VRMenuObjectLocal const * obj, int const parent ) const;
+	void						SubmitObject( BitmapFont const & font, BitmapFontSurface & fontSurface, 
+										VRMenuRenderFlags_t const & flags, VRMenuWorldTransform const & transform, 
+										Vector3f const & parentScale, Vector4f const & parentColor, 
+										SubmittedMenuObject * submitted, int const maxIndices, int & curIndex ) const;
 
 	//--------------------------------------------------------------
 	// private members
 	//--------------------------------------------------------------
 	UInt32						CurrentId;		// ever-incrementing object ID (well... up to 4 billion or so :)
-	Array< VRMenuObject* >		ObjectList;		// list of all menu objects
+	Array< VRMenuObject* >		ObjectList;		// list of all menu objects, NULL for free slots
 	Array< int >				FreeList;		// list of free slots in the array
+
+	// Objects are constructed in place in slabs of OBJECTS_PER_SLAB, slot i in Slabs[i / OBJECTS_PER_SLAB].
+	// Slabs are only freed with the manager, so once there are enough slots for the most objects
+	// that were alive at once, creating and freeing objects never allocates memory for them, and
+	// objects that were created together are next to each other in memory.
+	Array< UByte * >			Slabs;
 	bool						Initialized;	// true if Init has been called
 
+	// The text layouts of freed objects, freed the next time their font surface is submitted to,
+	// because the surface is not known when an object is freed, or dropped by ForgetFontSurface().
+	// The surface is kept by id, so a surface that is later created at the address of a freed
+	// one does not free them.
+	struct freedTextLayout_t
+	{
+		UInt32					SurfaceId;
+		fontLayoutHandle_t		Layout;
+	};
+	Array< freedTextLayout_t >	FreedTextLayouts;
+
+	// The bounds an object can be hit in, for the bounding volume hierarchy. They are relative
+	// to the world pose of the root, so moving the whole menu does not change them.
+	struct hitBounds_t
+	{
+		Bounds3f		Bounds;			// cleared if the object or one of its parents cannot be hit
+		UInt32			BoundsVersion;	// BoundsVersion of the object when the bounds were computed
+		bool			Hittable;
+		bool			Moved;			// moved relative to the root on the last update
+		bool			Dirty;			// moved relative to the root since the bounds were computed
+	};
+
+	// A node of the bounding volume hierarchy. The children of a node are next to each other
+	// and after their parent.
+	struct hitNode_t
+	{
+		Bounds3f		Bounds;
+		int				Left;			// first child node, -1 for a leaf
+		int				First;			// first index into HitEntries of a leaf
+		int				Count;			// number of entries in a leaf
+	};
+
+	// The flattened world transforms of each root they were updated for. A tree is flattened
+	// again when objects were added to or removed from it, or any object was freed, so the
+	// transforms never point to a freed object.
+	struct worldTransforms_t
+	{
+		menuHandle_t					Root;
+		Posef							WorldPose;
+		UInt32							NumFreed;		// NumFreed when the tree was flattened
+		Array< VRMenuWorldTransform >	Transforms;
+
+		// Built on the first hit test after the tree was flattened and refit after that.
+		Array< hitBounds_t >			HitBounds;		// one for each transform
+		Array< int >					HitEntries;		// transform indices, in leaf order
+		Array< hitNode_t >				HitNodes;		// empty if the hierarchy needs to be built
+		int								HitRefits;		// leaves refit since the hierarchy was built
+	};
+	Array< worldTransforms_t * >	WorldTransforms;
+	Array< VRMenuWorldTransform >	NoTransforms;	// always empty
+	UInt32							NumFreed;		// number of objects freed
+
+	// scratch space to accumulate the cull bounds of a submitted tree
+	struct submittedBounds_t
+	{
+		Bounds3f	CullBounds;
+		bool		Submitted;
+	};
+	ArrayPOD< submittedBounds_t, ArrayConstPolicy< 0, 16, true > >	SubmittedBounds;
+
+	ArrayPOD< int, ArrayConstPolicy< 0, 16, true > >	HitNodeStack;	// scratch space for the ray traversal
+
 	SubmittedMenuObject			Submitted[MAX_SUBMITTED];	// all objects that have been submitted for rendering on the current frame
 	Array< SurfSort >			SortKeys;					// sort key consisting of distance from view and submission index
 	int							NumSubmitted;				// number of currently submitted menu objects
@@ -299,6 +397,7 @@ private:
 VRMenuMgrLocal::VRMenuMgrLocal() :
 	CurrentId( 0 ),
 	Initialized( false ),
+	NumFreed( 0 ),
 	NumSubmitted( 0 )
 {
 }
@@ -307,6 +406,26 @@ VRMenuMgrLocal::VRMenuMgrLocal() :
 // VRMenuMgrLocal::~VRMenuMgrLocal
 VRMenuMgrLocal::~VRMenuMgrLocal()
 {
+	for ( int i = 0; i < WorldTransforms.GetSizeI(); ++i )
+	{
+		delete WorldTransforms[i];
+	}
+	WorldTransforms.Clear();
+
+	// the storage of objects that were never freed goes away with the slabs
+	for ( int i = 0; i < ObjectList.GetSizeI(); ++i )
+	{
+		if ( ObjectList[i] != NULL )
+		{
+			static_cast< VRMenuObjectLocal * >( ObjectList[i] )->~VRMenuObjectLocal();
+			ObjectList[i] = NULL;
+		}
+	}
+	for ( int i = 0; i < Slabs.GetSizeI(); ++i )
+	{
+		delete [] Slabs[i];
+	}
+	Slabs.Clear();
 }
 
 //==================================
@@ -389,46 +508,44 @@ menuHandle_t VRMenuMgrLocal::CreateObject( VRMenuObjectParms const & parms )
 	}
 
 	// create the handle first so we can enforce setting it be requiring it to be passed to the constructor
-	int index = -1;
-	if ( FreeList.GetSizeI() > 0 )
-	{
-		index = FreeList.Back();
-		FreeList.PopBack();
-	}
-	else
+	if ( FreeList.GetSizeI() == 0 )
 	{
-		index = ObjectList.GetSizeI();
+		AllocSlab();
 	}
+	int const index = FreeList.Back();
+	FreeList.PopBack();
 
 	UInt32 id = ++CurrentId;
 	menuHandle_t handle = ComposeHandle( index, id );
 	//LOG( "VRMenuMgrLocal::CreateObject - handle is %llu", handle.Get() );
 
-	VRMenuObject * obj = new VRMenuObjectLocal( parms, handle );
-	if ( obj == NULL )
-	{
-		LOG( "VRMenuMgrLocal::CreateObject - failed to allocate menu object!" );
-		OVR_ASSERT( obj != NULL );	// this would be bad -- but we're likely just going to explode elsewhere
-		return menuHandle_t();
-	}
+	UByte * slot = Slabs[index / OBJECTS_PER_SLAB] + ( index % OBJECTS_PER_SLAB ) * sizeof( VRMenuObjectLocal );
+	VRMenuObject * obj = ::new ( slot ) VRMenuObjectLocal( parms, handle );
 	
 	obj->Init( parms );
 
-	if ( index == ObjectList.GetSizeI() )
-	{
-		// we have to grow the array
-		ObjectList.PushBack( obj );
-	}
-	else
-	{
-		// insert in existing slot
-		OVR_ASSERT( ObjectList[index] == NULL );
-		ObjectList[index ] = obj;
-	}
+	// insert in the slot
+	OVR_ASSERT( ObjectList[index] == NULL );
+	ObjectList[index] = obj;
 
 	return handle;
 }
 
+//==================================
+// VRMenuMgrLocal::AllocSlab
+// Adds the slots of a new slab to the free list, lowest slot last so it is used first.
+void VRMenuMgrLocal::AllocSlab()
+{
+	int const firstIndex = ObjectList.GetSizeI();
+	Slabs.PushBack( new UByte[OBJECTS_PER_SLAB * sizeof( VRMenuObjectLocal )] );
+	ObjectList.Resize( firstIndex + OBJECTS_PER_SLAB );
+	for ( int i = OBJECTS_PER_SLAB - 1; i >= 0; --i )
+	{
+		ObjectList[firstIndex + i] = NULL;
+		FreeList.PushBack( firstIndex + i );
+	}
+}
+
 //==================================
 // VRMenuMgrLocal::FreeObject
 // Frees a menu object.  If the object is a child of a parent object, this will
@@ -438,11 +555,11 @@ void VRMenuMgrLocal::FreeObject( menuHandle_t const handle )
 	int index;
 	UInt32 id;
 	DecomposeHandle( handle, index, id );
-	if ( !HandleComponentsAreValid( index, id ) )
+	if ( !HandleComponentsAreValid( index, id ) || index >= ObjectList.GetSizeI() )
 	{
 		return;
 	}
-	if ( ObjectList[index] == NULL )
+	if ( ObjectList[index] == NULL || ObjectList[index]->GetHandle() != handle )
 	{
 		// already freed
 		return;
@@ -462,44 +579,33 @@ void VRMenuMgrLocal::FreeObject( menuHandle_t const handle )
     // free all of this object's children
     obj->FreeChildren( *this );
 
-	delete obj;
-
-	// empty the slot
-	ObjectList[index] = NULL;
-	// add the index to the free list
-	FreeList.PushBack( index );
-	
-	CondenseList();
-}
-
-//==================================
-// VRMenuMgrLocal::CondenseList
-// keeps the free list from growing too large when items are removed
-void VRMenuMgrLocal::CondenseList()
-{
-	// we can only condense the array if we have a significant number of items at the end of the array buffer
-	// that are empty (because we cannot move an existing object around without changing its handle, too, which
-	// would invalidate any existing references to it).  
-	// This is the difference between the current size and the array capacity.
-	int const MIN_FREE = 64;	// very arbitray number
-	if ( ObjectList.GetCapacityI() - ObjectList.GetSizeI() < MIN_FREE )
+	VRMenuObjectLocal const * localObj = static_cast< VRMenuObjectLocal const * >( obj );
+	if ( localObj->TextLayoutSurfaceId != 0 )
 	{
-		return;
+		freedTextLayout_t freed;
+		freed.SurfaceId = localObj->TextLayoutSurfaceId;
+		freed.Layout = localObj->TextLayout;
+		FreedTextLayouts.PushBack( freed );
 	}
 
-	// shrink to current size
-	ObjectList.Resize( ObjectList.GetSizeI() );	
+	static_cast< VRMenuObjectLocal * >( obj )->~VRMenuObjectLocal();
+	NumFreed++;
 
-	// create a new free list of just indices < the new size
-	Array< int > newFreeList;
-	for ( int i = 0; i < FreeList.GetSizeI(); ++i ) 
+	// drop the transforms if this was the root of a tree
+	for ( int i = 0; i < WorldTransforms.GetSizeI(); ++i )
 	{
-		if ( FreeList[i] <= ObjectList.GetSizeI() )
+		if ( WorldTransforms[i]->Root == handle )
 		{
-			newFreeList.PushBack( FreeList[i] );
+			delete WorldTransforms[i];
+			WorldTransforms.RemoveAtUnordered( i );
+			break;
 		}
 	}
-	FreeList = newFreeList;
+
+	// empty the slot
+	ObjectList[index] = NULL;
+	// add the index to the free list
+	FreeList.PushBack( index );
 }
 
 //==================================
@@ -567,59 +673,473 @@ static void LogBounds( const char * name, char const * prefix, Bounds3f const &
 */
 
 //==============================
-// VRMenuMgrLocal::SubmitForRenderingRecursive
-void VRMenuMgrLocal::SubmitForRenderingRecursive( OvrDebugLines & debugLines, BitmapFont const & font, 
-        BitmapFontSurface & fontSurface, VRMenuRenderFlags_t const & flags, VRMenuObjectLocal const * obj, 
-        Posef const & parentModelPose, Vector4f const & parentColor, Vector3f const & parentScale, 
-        Bounds3f & cullBounds, SubmittedMenuObject * submitted, int const maxIndices, int & curIndex ) const
+// VRMenuMgrLocal::FlattenTree_r
+void VRMenuMgrLocal::FlattenTree_r( Array< VRMenuWorldTransform > & transforms, VRMenuObjectLocal const * obj, 
+		int const parent ) const
 {
-	if ( curIndex >= maxIndices )
+	int const index = transforms.GetSizeI();
+
+	VRMenuWorldTransform transform;
+	transform.Object = obj;
+	transform.Parent = parent;
+	transform.SubtreeEnd = index + 1;
+	transform.TransformVersion = obj->TransformVersion;
+	transform.ChildrenVersion = obj->ChildrenVersion;
+	transform.Changed = true;
+	transforms.PushBack( transform );
+
+	for ( int i = 0; i < obj->Children.GetSizeI(); ++i )
+	{
+		VRMenuObjectLocal const * child = static_cast< VRMenuObjectLocal const * >( ToObject( obj->Children[i] ) );
+		if ( child == NULL )
+		{
+			continue;
+		}
+		FlattenTree_r( transforms, child, index );
+	}
+
+	transforms[index].SubtreeEnd = transforms.GetSizeI();
+}
+
+//==============================
+// ComposeWorldTransform
+static void ComposeWorldTransform( VRMenuWorldTransform & transform, VRMenuObjectLocal const * obj, 
+		Posef const & parentModelPose, Posef const & parentRenderPose, Vector3f const & parentScale, 
+		Vector4f const & parentColor )
+{
+	Posef const & localPose = obj->GetLocalPose();
+	Vector3f const localPosition = parentScale.EntrywiseMultiply( localPose.Position );
+
+	transform.ModelPose.Position = parentModelPose.Position + ( parentModelPose.Orientation * localPosition );
+	transform.ModelPose.Orientation = localPose.Orientation * parentModelPose.Orientation;
+
+	Posef curModelPose;
+	curModelPose.Position = parentRenderPose.Position + ( parentRenderPose.Orientation * localPosition );
+	curModelPose.Orientation = localPose.Orientation * parentRenderPose.Orientation;
+	if ( obj->GetType() != VRMENU_CONTAINER )
+	{
+		// children like the slider bar caret use our hilight offset so they don't end up clipping behind us
+        Posef const & hilightPose = obj->GetHilightPose();
+        curModelPose = Posef( curModelPose.Orientation * hilightPose.Orientation,
+                        curModelPose.Position + ( curModelPose.Orientation * parentScale.EntrywiseMultiply( hilightPose.Position ) ) );
+	}
+	transform.RenderPose = curModelPose;
+
+	transform.Scale = parentScale.EntrywiseMultiply( obj->GetLocalScale() );
+	transform.Color = parentColor * obj->GetColor();
+}
+
+//==============================
+// VRMenuMgrLocal::UpdateTree
+VRMenuMgrLocal::worldTransforms_t * VRMenuMgrLocal::UpdateTree( menuHandle_t const root, Posef const & worldPose )
+{
+	VRMenuObjectLocal const * rootObj = static_cast< VRMenuObjectLocal const * >( ToObject( root ) );
+	if ( rootObj == NULL )
+	{
+		return NULL;
+	}
+
+	worldTransforms_t * tree = NULL;
+	for ( int i = 0; i < WorldTransforms.GetSizeI(); ++i )
+	{
+		if ( WorldTransforms[i]->Root == root )
+		{
+			tree = WorldTransforms[i];
+			break;
+		}
+	}
+	if ( tree == NULL )
+	{
+		tree = new worldTransforms_t;
+		tree->Root = root;
+		tree->NumFreed = NumFreed;
+		tree->HitRefits = 0;
+		WorldTransforms.PushBack( tree );
+	}
+
+	bool flatten = tree->Transforms.GetSizeI() == 0 || tree->NumFreed != NumFreed;
+	bool const rootMoved = !( tree->WorldPose.Position == worldPose.Position && 
+			tree->WorldPose.Orientation == worldPose.Orientation );
+	tree->WorldPose = worldPose;
+
+	for ( ; ; )
+	{
+		if ( flatten )
+		{
+			tree->Transforms.Clear();
+			FlattenTree_r( tree->Transforms, rootObj, -1 );
+			tree->NumFreed = NumFreed;
+			// The indices of the objects change when the tree is flattened again, so none of
+			// the old hit bounds can be kept, and Resize() leaves new entries uninitialized.
+			tree->HitBounds.Resize( tree->Transforms.GetSizeI() );
+			for ( int i = 0; i < tree->HitBounds.GetSizeI(); ++i )
+			{
+				hitBounds_t & hitBounds = tree->HitBounds[i];
+				hitBounds.Bounds.Clear();
+				hitBounds.BoundsVersion = 0;
+				hitBounds.Hittable = false;
+				hitBounds.Moved = false;
+				hitBounds.Dirty = true;
+			}
+			tree->HitNodes.Clear();
+		}
+
+		// Parents are composed before their children, and an object is only composed again if
+		// it or one of its parents changed.
+		bool childrenChanged = false;
+		int const numTransforms = tree->Transforms.GetSizeI();
+		for ( int i = 0; i < numTransforms; ++i )
+		{
+			VRMenuWorldTransform & transform = tree->Transforms[i];
+			VRMenuObjectLocal const * obj = static_cast< VRMenuObjectLocal const * >( transform.Object );
+			if ( obj->ChildrenVersion != transform.ChildrenVersion )
+			{
+				childrenChanged = true;
+				break;
+			}
+
+			bool const parentChanged = ( transform.Parent >= 0 ) ? tree->Transforms[transform.Parent].Changed : rootMoved;
+			bool const parentMoved = ( transform.Parent >= 0 ) && tree->HitBounds[transform.Parent].Moved;
+			bool const moved = flatten || parentMoved || obj->TransformVersion != transform.TransformVersion;
+			tree->HitBounds[i].Moved = moved;
+			tree->HitBounds[i].Dirty |= moved;
+			transform.Changed = moved || parentChanged;
+			if ( !transform.Changed )
+			{
+				continue;
+			}
+			transform.TransformVersion = obj->TransformVersion;
+			if ( transform.Parent >= 0 )
+			{
+				VRMenuWorldTransform const & parent = tree->Transforms[transform.Parent];
+				ComposeWorldTransform( transform, obj, parent.ModelPose, parent.RenderPose, parent.Scale, parent.Color );
+			}
+			else
+			{
+				ComposeWorldTransform( transform, obj, worldPose, worldPose, Vector3f( 1.0f ), Vector4f( 1.0f ) );
+			}
+		}
+		if ( !childrenChanged )
+		{
+			break;
+		}
+		flatten = true;
+	}
+
+	return tree;
+}
+
+//==============================
+// VRMenuMgrLocal::UpdateWorldTransforms
+Array< VRMenuWorldTransform > const & VRMenuMgrLocal::UpdateWorldTransforms( menuHandle_t const root, 
+		Posef const & worldPose )
+{
+	worldTransforms_t const * tree = UpdateTree( root, worldPose );
+	return ( tree != NULL ) ? tree->Transforms : NoTransforms;
+}
+
+//==============================
+// HitNodeLess
+// Orders transform indices by the center of their hit bounds along an axis.
+class HitNodeLess
+{
+public:
+	HitNodeLess( Array< Vector3f > const & centers, int const axis ) :
+		Centers( centers ),
+		Axis( axis )
+	{
+	}
+
+	bool operator()( int const a, int const b ) const
+	{
+		return Centers[a][Axis] < Centers[b][Axis];
+	}
+
+private:
+	Array< Vector3f > const &	Centers;
+	int							Axis;
+};
+
+//==============================
+// VRMenuMgrLocal::BuildHitNodes_r
+void VRMenuMgrLocal::BuildHitNodes_r( worldTransforms_t & tree, Array< Vector3f > const & centers, 
+		int const nodeIndex, int const first, int const count ) const
+{
+	int const MAX_LEAF_ENTRIES = 4;
+
+	Bounds3f bounds( Bounds3f::Init );
+	Bounds3f centerBounds( Bounds3f::Init );
+	for ( int i = first; i < first + count; ++i )
+	{
+		int const index = tree.HitEntries[i];
+		bounds = Bounds3f::Union( bounds, tree.HitBounds[index].Bounds );
+		centerBounds.AddPoint( centers[index] );
+	}
+	tree.HitNodes[nodeIndex].Bounds = bounds;
+	tree.HitNodes[nodeIndex].Left = -1;
+	tree.HitNodes[nodeIndex].First = first;
+	tree.HitNodes[nodeIndex].Count = count;
+	if ( count <= MAX_LEAF_ENTRIES )
 	{
-		// If this happens we're probably not correctly clearing the submitted surfaces each frame
-		// OR we've got a LOT of surfaces.
-		LOG( "maxIndices = %i, curIndex = %i", maxIndices, curIndex );
-		DROID_ASSERT( curIndex < maxIndices, "VrMenu" );
 		return;
 	}
 
-	// check if this object is hidden
-	if ( obj->GetFlags() & VRMENUOBJECT_DONT_RENDER )
+	// split at the median along the axis the centers are spread the most
+	Vector3f const size = centerBounds.GetSize();
+	int const axis = ( size.x >= size.y && size.x >= size.z ) ? 0 : ( ( size.y >= size.z ) ? 1 : 2 );
+	Alg::QuickSortSliced( tree.HitEntries, first, first + count, HitNodeLess( centers, axis ) );
+
+	int const left = tree.HitNodes.GetSizeI();
+	tree.HitNodes.Resize( left + 2 );
+	tree.HitNodes[nodeIndex].Left = left;
+	tree.HitNodes[nodeIndex].First = 0;
+	tree.HitNodes[nodeIndex].Count = 0;
+
+	int const half = count / 2;
+	BuildHitNodes_r( tree, centers, left, first, half );
+	BuildHitNodes_r( tree, centers, left + 1, first + half, count - half );
+}
+
+//==============================
+// VRMenuMgrLocal::UpdateHitBounds
+void VRMenuMgrLocal::UpdateHitBounds( BitmapFont const & font, worldTransforms_t & tree ) const
+{
+	// IntersectRayBounds() reports a hit when the ray starts within 0.1 of the local bounds, so
+	// the world bounds are expanded by more than that rotated into world space.
+	float const START_EXPAND = 0.2f;
+
+	// Only the objects that moved relative to the root, changed their bounds or became hittable
+	// or not have their bounds computed again.
+	Quatf const rootInverse = tree.WorldPose.Orientation.Inverted();
+	int numChanged = 0;
+	int const numTransforms = tree.Transforms.GetSizeI();
+	for ( int i = 0; i < numTransforms; ++i )
+	{
+		VRMenuWorldTransform const & transform = tree.Transforms[i];
+		VRMenuObjectLocal const * obj = static_cast< VRMenuObjectLocal const * >( transform.Object );
+		hitBounds_t & hitBounds = tree.HitBounds[i];
+
+		VRMenuObjectFlags_t const & flags = obj->Flags;
+		bool const parentHittable = ( transform.Parent >= 0 ) ? tree.HitBounds[transform.Parent].Hittable : true;
+		bool const hittable = parentHittable && !( flags & VRMENUOBJECT_DONT_RENDER ) && !( flags & VRMENUOBJECT_DONT_HIT_ALL );
+		if ( !hitBounds.Dirty && hitBounds.BoundsVersion == obj->BoundsVersion && hitBounds.Hittable == hittable )
+		{
+			continue;
+		}
+		hitBounds.Dirty = false;
+		hitBounds.BoundsVersion = obj->BoundsVersion;
+		hitBounds.Hittable = hittable;
+		if ( hittable )
+		{
+			Vector3f const parentScale = ( transform.Parent >= 0 ) ? tree.Transforms[transform.Parent].Scale : Vector3f( 1.0f );
+			Bounds3f const localBounds = obj->GetLocalBounds( font ) * parentScale;
+			Posef const rootPose( rootInverse * transform.ModelPose.Orientation, 
+					rootInverse.Rotate( transform.ModelPose.Position - tree.WorldPose.Position ) );
+			hitBounds.Bounds = Bounds3f::Expand( Bounds3f::Transform( rootPose, localBounds ), 
+					Vector3f( -START_EXPAND ), Vector3f( START_EXPAND ) );
+		}
+		else
+		{
+			hitBounds.Bounds.Clear();
+		}
+		numChanged++;
+	}
+
+	// Build the hierarchy again when it was never built, or when so many leaves were refit that
+	// the nodes likely overlap a lot more than they did.
+	tree.HitRefits += numChanged;
+	if ( tree.HitNodes.GetSizeI() == 0 || tree.HitRefits > numTransforms / 2 + 1 )
+	{
+		tree.HitEntries.Resize( numTransforms );
+		for ( int i = 0; i < numTransforms; ++i )
+		{
+			tree.HitEntries[i] = i;
+		}
+		// objects that cannot be hit right now sort by the origin, they only need to be somewhere
+		Array< Vector3f > centers;
+		centers.Resize( numTransforms );
+		for ( int i = 0; i < numTransforms; ++i )
+		{
+			Bounds3f const & bounds = tree.HitBounds[i].Bounds;
+			centers[i] = bounds.IsInverted() ? Vector3f( 0.0f ) : bounds.GetCenter();
+		}
+		tree.HitNodes.Resize( 1 );
+		BuildHitNodes_r( tree, centers, 0, 0, numTransforms );
+		tree.HitRefits = 0;
+		return;
+	}
+	if ( numChanged == 0 )
 	{
 		return;
 	}
 
-	Posef const & localPose = obj->GetLocalPose();
+	// children are after their parents
+	for ( int i = tree.HitNodes.GetSizeI() - 1; i >= 0; --i )
+	{
+		hitNode_t & node = tree.HitNodes[i];
+		if ( node.Left >= 0 )
+		{
+			node.Bounds = Bounds3f::Union( tree.HitNodes[node.Left].Bounds, tree.HitNodes[node.Left + 1].Bounds );
+			continue;
+		}
+		node.Bounds.Clear();
+		for ( int j = node.First; j < node.First + node.Count; ++j )
+		{
+			node.Bounds = Bounds3f::Union( node.Bounds, tree.HitBounds[tree.HitEntries[j]].Bounds );
+		}
+	}
+}
 
-	Posef curModelPose;
-	curModelPose.Position = parentModelPose.Position + ( parentModelPose.Orientation * parentScale.EntrywiseMultiply( localPose.Position ) );
-	curModelPose.Orientation = localPose.Orientation * parentModelPose.Orientation;
+//==============================
+// RayHitsBounds
+// Returns the distance at which the ray enters the bounds, 0 if it starts inside.
+static bool RayHitsBounds( VRMenuRay const & ray, Bounds3f const & bounds, float & t )
+{
+	if ( bounds.IsInverted() )
+	{
+		return false;
+	}
+	if ( bounds.Contains( ray.Start ) )
+	{
+		t = 0.0f;
+		return true;
+	}
+	float t0;
+	float t1;
+	RtIntersect::RayBounds( ray.Start, ray.Dir, bounds.GetMins(), bounds.GetMaxs(), t0, t1 );
+	t = t0;
+	return t0 >= 0.0f && t1 >= t0;
+}
 
-	Vector4f curColor = parentColor * obj->GetColor();
-	Vector3f const & localScale = obj->GetLocalScale();
-	Vector3f scale = parentScale.EntrywiseMultiply( localScale );
+//==============================
+// VRMenuMgrLocal::HitTestRay
+void VRMenuMgrLocal::HitTestRay( BitmapFont const & font, worldTransforms_t const & tree, VRMenuRay const & ray, 
+		Vector3f const & rootStart, Vector3f const & rootDir, ContentFlags_t const testContents, HitTestResult & result )
+{
+	// the nodes are relative to the root, the objects are tested in world space
+	VRMenuRay rootRay;
+	rootRay.Start = rootStart;
+	rootRay.Dir = rootDir;
+
+	// Objects are tested nearest node first, and nodes that are entered beyond the nearest hit
+	// so far are skipped. On equal distances the object first in the tree wins, which is the
+	// object that was hit first when the tree was walked recursively.
+	int resultIndex = -1;
+	HitNodeStack.Resize( 0 );
+	HitNodeStack.PushBack( 0 );
+	while ( HitNodeStack.GetSizeI() > 0 )
+	{
+		hitNode_t const & node = tree.HitNodes[HitNodeStack.Back()];
+		HitNodeStack.PopBack();
 
-	OVR_ASSERT( obj != NULL );
+		float nodeT;
+		if ( !RayHitsBounds( rootRay, node.Bounds, nodeT ) || nodeT > result.t )
+		{
+			continue;
+		}
 
-/*
-	VRMenuObject const * parent = ToObject( obj->GetParentHandle() );
-	if ( parent != NULL )
+		if ( node.Left >= 0 )
+		{
+			float leftT;
+			float rightT;
+			bool const hitLeft = RayHitsBounds( rootRay, tree.HitNodes[node.Left].Bounds, leftT );
+			bool const hitRight = RayHitsBounds( rootRay, tree.HitNodes[node.Left + 1].Bounds, rightT );
+			int const nearNode = ( hitLeft && ( !hitRight || leftT <= rightT ) ) ? node.Left : node.Left + 1;
+			int const farNode = ( nearNode == node.Left ) ? node.Left + 1 : node.Left;
+			HitNodeStack.PushBack( farNode );
+			HitNodeStack.PushBack( nearNode );
+			continue;
+		}
+
+		for ( int i = node.First; i < node.First + node.Count; ++i )
+		{
+			int const index = tree.HitEntries[i];
+			if ( !tree.HitBounds[index].Hittable )
+			{
+				continue;
+			}
+			float entryT;
+			if ( !RayHitsBounds( rootRay, tree.HitBounds[index].Bounds, entryT ) || entryT > result.t )
+			{
+				continue;
+			}
+			VRMenuWorldTransform const & transform = tree.Transforms[index];
+			VRMenuObjectLocal const * obj = static_cast< VRMenuObjectLocal const * >( transform.Object );
+			Vector3f const parentScale = ( transform.Parent >= 0 ) ? tree.Transforms[transform.Parent].Scale : Vector3f( 1.0f );
+
+			HitTestResult objResult;
+			if ( !obj->HitTestSelf( font, transform.ModelPose, parentScale, ray.Start, ray.Dir, testContents, objResult ) )
+			{
+				continue;
+			}
+			if ( objResult.t < result.t || ( objResult.t == result.t && resultIndex >= 0 && index < resultIndex ) )
+			{
+				result = objResult;
+				resultIndex = index;
+			}
+		}
+	}
+}
+
+//==============================
+// VRMenuMgrLocal::HitTestRays
+void VRMenuMgrLocal::HitTestRays( BitmapFont const & font, menuHandle_t const root, Posef const & worldPose, 
+		VRMenuRay const * rays, int const numRays, ContentFlags_t const testContents, HitTestResult * results )
+{
+	worldTransforms_t * tree = UpdateTree( root, worldPose );
+	if ( tree == NULL )
 	{
-		fontParms_t fontParms;
-		Vector3f itemUp = curModelPose.Orientation * Vector3f( 0.0f, 1.0f, 0.0f );
-		Vector3f itemNormal = curModelPose.Orientation * Vector3f( 0.0f, 0.0f, 1.0f );
-		fontSurface.DrawText3D( font, fontParms, curModelPose.Position, itemNormal, itemUp, 
-				1.0f, Vector4f( 1.0f, 0.0f, 1.0f, 1.0f ), parent->GetText().ToCStr() );
+		return;
 	}
-*/
+	UpdateHitBounds( font, *tree );
+
+	Quatf const rootInverse = worldPose.Orientation.Inverted();
+	for ( int i = 0; i < numRays; ++i )
+	{
+		HitTestRay( font, *tree, rays[i], rootInverse.Rotate( rays[i].Start - worldPose.Position ), 
+				rootInverse.Rotate( rays[i].Dir ), testContents, results[i] );
+	}
+}
+
+//==============================
+// VRMenuMgrLocal::HitTest
+menuHandle_t VRMenuMgrLocal::HitTest( BitmapFont const & font, menuHandle_t const root, Posef const & worldPose, 
+		Vector3f const & rayStart, Vector3f const & rayDir, ContentFlags_t const testContents, HitTestResult & result )
+{
+	VRMenuRay ray;
+	ray.Start = rayStart;
+	ray.Dir = rayDir;
+	HitTestRays( font, root, worldPose, &ray, 1, testContents, &result );
+	return result.HitHandle;
+}
+
+//==============================
+// VRMenuMgrLocal::SubmitObject
+void VRMenuMgrLocal::SubmitObject( BitmapFont const & font, BitmapFontSurface & fontSurface, 
+		VRMenuRenderFlags_t const & flags, VRMenuWorldTransform const & transform, 
+		Vector3f const & parentScale, Vector4f const & parentColor, 
+		SubmittedMenuObject * submitted, int const maxIndices, int & curIndex ) const
+{
+	if ( curIndex >= maxIndices )
+	{
+		// If this happens we're probably not correctly clearing the submitted surfaces each frame
+		// OR we've got a LOT of surfaces.
+		LOG( "maxIndices = %i, curIndex = %i", maxIndices, curIndex );
+		DROID_ASSERT( curIndex < maxIndices, "VrMenu" );
+		return;
+	}
+
+	VRMenuObjectLocal const * obj = static_cast< VRMenuObjectLocal const * >( transform.Object );
+	OVR_ASSERT( obj != NULL );
+
 	if ( obj->GetType() != VRMENU_CONTAINER )	// containers never render, but their children may
 	{
-        Posef const & hilightPose = obj->GetHilightPose();
-        Posef itemPose( curModelPose.Orientation * hilightPose.Orientation,
-                        curModelPose.Position + ( curModelPose.Orientation * parentScale.EntrywiseMultiply( hilightPose.Position ) ) );
+		Posef const & itemPose = transform.RenderPose;
+		Vector3f const & scale = transform.Scale;
+		Vector4f const & curColor = transform.Color;
 		Matrix4f poseMat( itemPose.Orientation );
 		Vector3f itemUp = poseMat.GetYBasis();
 		Vector3f itemNormal = poseMat.GetZBasis();
-		curModelPose = itemPose;	// so children like the slider bar caret use our hilight offset and don't end up clipping behind us!
 		VRMenuRenderFlags_t rFlags = flags;
 		VRMenuObjectFlags_t oFlags = obj->GetFlags();
 		if ( oFlags & VRMENUOBJECT_FLAG_POLYGON_OFFSET )
@@ -633,7 +1153,7 @@ void VRMenuMgrLocal::SubmitForRenderingRecursive( OvrDebugLines & debugLines, Bi
 
 		// the menu object may have zero or more renderable surfaces (if 0, it may draw only text)
 		Array< VRMenuSurface > const & surfaces = obj->GetSurfaces();
-		for ( int i = 0; i < surfaces.GetSizeI(); ++i )
+		for ( int i = 0; i < surfaces.GetSizeI() && curIndex < maxIndices; ++i )
 		{
 			VRMenuSurface const & surf = surfaces[i];
 			if ( surf.IsRenderable() )
@@ -680,68 +1200,48 @@ void VRMenuMgrLocal::SubmitForRenderingRecursive( OvrDebugLines & debugLines, Bi
 			fontParms.ColorCenter = fp.ColorCenter;
 			fontParms.AlphaCenter = fp.AlphaCenter;
 
-			fontSurface.DrawText3D( font, fontParms, position, itemNormal, itemUp, 
-					textScale.x * fp.Scale, textColor, text.ToCStr() );
-#if 0
-			// this shows a ruler for the wrap width when rendering text
-			float const wrapw = obj->GetWrapWidth();
-			Vector3f pos = position + Vector3f( 0.0f, 0.0f, -0.1f );
-			debugLines.AddLine( pos - wrapw * 0.5f * scale, pos + wrapw * 0.5f * scale,
-				Vector4f( 0.0f, 1.0f, 0.0f, 1.0f ), Vector4f( 1.0f, 0.0f, 0.0f, 1.0f ), 0, false );
-#endif
+			// The glyphs of the text are laid out once and kept in the font surface until something
+			// changes. Objects only ever use the surface they were first submitted to for that.
+			if ( obj->TextLayoutSurfaceId == 0 )
+			{
+				obj->TextLayoutSurfaceId = fontSurface.GetId();
+				obj->TextLayout = fontSurface.CreateTextLayout();
+			}
+			if ( obj->TextLayoutSurfaceId == fontSurface.GetId() )
+			{
+				fontSurface.SetTextLayout( obj->TextLayout, font, fontParms, textScale.x * fp.Scale, textColor, text.ToCStr() );
+				fontSurface.DrawTextLayout3D( obj->TextLayout, position, itemNormal, itemUp );
+			}
+			else
+			{
+				fontSurface.DrawText3D( font, fontParms, position, itemNormal, itemUp, 
+						textScale.x * fp.Scale, textColor, text.ToCStr() );
+			}
 		}
-        //DROIDLOG( "Spam", "AddPoint for '%s'", text.ToCStr() );
-		//GetDebugLines().AddPoint( curModelPose.Position, 0.05f, 1, true );
 	}
+}
 
-    cullBounds = obj->GetLocalBounds( font ) * parentScale;
-
-	// submit all children
-    if ( obj->Children.GetSizeI() > 0 )
-    {
-	    for ( int i = 0; i < obj->Children.GetSizeI(); ++i )
-	    {
-		    menuHandle_t childHandle = obj->Children[i];
-		    VRMenuObjectLocal const * child = static_cast< VRMenuObjectLocal const * >( ToObject( childHandle ) );
-		    if ( child == NULL )
-		    {
-			    continue;
-		    }
-
-            Bounds3f childCullBounds;
-		    SubmitForRenderingRecursive( debugLines, font, fontSurface, flags, child, curModelPose, curColor, scale, 
-                    childCullBounds, submitted, maxIndices, curIndex );
-
-		    Posef pose = child->GetLocalPose();
-		    pose.Position = pose.Position * scale;
-            childCullBounds = Bounds3f::Transform( pose, childCullBounds );
-            cullBounds = Bounds3f::Union( cullBounds, childCullBounds );
-	    }
-    }
-
-    obj->SetCullBounds( cullBounds );
-
-#if 0
-	OvrCollisionPrimitive const * cp = obj->GetCollisionPrimitive();
-	if ( cp != NULL )
+//==============================
+// VRMenuMgrLocal::ForgetFontSurface
+void VRMenuMgrLocal::ForgetFontSurface( BitmapFontSurface const & fontSurface )
+{
+	// The layouts are freed with the surface itself.
+	for ( int i = FreedTextLayouts.GetSizeI() - 1; i >= 0; i-- )
 	{
-		cp->DebugRender( debugLines, curModelPose );
+		if ( FreedTextLayouts[i].SurfaceId == fontSurface.GetId() )
+		{
+			FreedTextLayouts.RemoveAtUnordered( i );
+		}
+	}
+	for ( int i = 0; i < ObjectList.GetSizeI(); i++ )
+	{
+		VRMenuObjectLocal const * obj = static_cast< VRMenuObjectLocal const * >( ObjectList[i] );
+		if ( obj != NULL && obj->TextLayoutSurfaceId == fontSurface.GetId() )
+		{
+			obj->TextLayoutSurfaceId = 0;
+			obj->TextLayout = fontLayoutHandle_t();
+		}
 	}
-    {
-        // for debug drawing, put the cull bounds in world space
-        //LogBounds( obj->GetText().ToCStr(), "Transformed CullBounds", myCullBounds );
-        debugLines.AddBounds( curModelPose, obj->GetCullBounds(), Vector4f( 0.0f, 1.0f, 1.0f, 1.0f ) );
-    }
-    {
-        Bounds3f localBounds = obj->GetLocalBounds( font ) * parentScale;
-        //LogBounds( obj->GetText().ToCStr(), "localBounds", localBounds );
-    	debugLines.AddBounds( curModelPose, localBounds, Vector4f( 1.0f, 0.0f, 0.0f, 1.0f ) );
-        Bounds3f textLocalBounds = obj->GetTextLocalBounds( font );
-        Posef hilightPose = obj->GetHilightPose();
-        textLocalBounds = Bounds3f::Transform( Posef( hilightPose.Orientation, hilightPose.Position * scale ), textLocalBounds );
-    	debugLines.AddBounds( curModelPose, textLocalBounds * parentScale, Vector4f( 1.0f, 1.0f, 0.0f, 1.0f ) );
-    }
-#endif
 }
 
 //==============================
@@ -752,20 +1252,80 @@ void VRMenuMgrLocal::SubmitForRendering( OvrDebugLines & debugLines, BitmapFont
         VRMenuRenderFlags_t const & flags )
 {
 	//LOG( "VRMenuMgrLocal::SubmitForRendering" );
+	for ( int i = FreedTextLayouts.GetSizeI() - 1; i >= 0; i-- )
+	{
+		if ( FreedTextLayouts[i].SurfaceId == fontSurface.GetId() )
+		{
+			fontSurface.FreeTextLayout( FreedTextLayouts[i].Layout );
+			FreedTextLayouts.RemoveAtUnordered( i );
+		}
+	}
+
 	if ( NumSubmitted >= MAX_SUBMITTED )
 	{
 		LOG( "Too many menu objects submitted!" );
 		return;
 	}
-	VRMenuObjectLocal * obj = static_cast< VRMenuObjectLocal* >( ToObject( handle ) );
-	if ( obj == NULL )
+	Array< VRMenuWorldTransform > const & transforms = UpdateWorldTransforms( handle, worldPose );
+	int const numTransforms = transforms.GetSizeI();
+	SubmittedBounds.Resize( numTransforms );
+
+	// submit parents before their children, skipping hidden objects and their children
+	for ( int i = 0; i < numTransforms; )
 	{
-		return;
+		VRMenuWorldTransform const & transform = transforms[i];
+		VRMenuObjectLocal const * obj = static_cast< VRMenuObjectLocal const * >( transform.Object );
+		if ( obj->GetFlags() & VRMENUOBJECT_DONT_RENDER )
+		{
+			int const subtreeEnd = transform.SubtreeEnd;
+			for ( ; i < subtreeEnd; ++i )
+			{
+				SubmittedBounds[i].Submitted = false;
+			}
+			continue;
+		}
+
+		Vector3f const parentScale = ( transform.Parent >= 0 ) ? transforms[transform.Parent].Scale : Vector3f( 1.0f );
+		Vector4f const parentColor = ( transform.Parent >= 0 ) ? transforms[transform.Parent].Color : Vector4f( 1.0f );
+		SubmitObject( font, fontSurface, flags, transform, parentScale, parentColor, Submitted, MAX_SUBMITTED, NumSubmitted );
+
+		SubmittedBounds[i].CullBounds = obj->GetLocalBounds( font ) * parentScale;
+		SubmittedBounds[i].Submitted = true;
+		++i;
 	}
 
-    Bounds3f cullBounds;
-	SubmitForRenderingRecursive( debugLines, font, fontSurface, flags, obj, worldPose, Vector4f( 1.0f ), 
-			Vector3f( 1.0f ), cullBounds, Submitted, MAX_SUBMITTED, NumSubmitted );
+	// children are after their parents, so going backwards the cull bounds of all children
+	// have been added to an object by the time it is reached
+	for ( int i = numTransforms - 1; i >= 0; --i )
+	{
+		if ( !SubmittedBounds[i].Submitted )
+		{
+			continue;
+		}
+		VRMenuWorldTransform const & transform = transforms[i];
+		VRMenuObjectLocal const * obj = static_cast< VRMenuObjectLocal const * >( transform.Object );
+		obj->SetCullBounds( SubmittedBounds[i].CullBounds );
+
+		if ( transform.Parent >= 0 )
+		{
+		    Posef pose = obj->GetLocalPose();
+		    pose.Position = pose.Position * transforms[transform.Parent].Scale;
+			Bounds3f & parentCullBounds = SubmittedBounds[transform.Parent].CullBounds;
+            parentCullBounds = Bounds3f::Union( parentCullBounds, Bounds3f::Transform( pose, SubmittedBounds[i].CullBounds ) );
+		}
+
+#if 0
+		OvrCollisionPrimitive const * cp = obj->GetCollisionPrimitive();
+		if ( cp != NULL )
+		{
+			cp->DebugRender( debugLines, transform.RenderPose );
+		}
+		{
+			// for debug drawing, put the cull bounds in world space
+			debugLines.AddBounds( transform.RenderPose, obj->GetCullBounds(), Vector4f( 0.0f, 1.0f, 1.0f, 1.0f ) );
+		}
+#endif
+	}
 }
 
 //==============================
@@ -923,4 +1483,309 @@ void OvrVRMenuMgr::Free( OvrVRMenuMgr * & mgr )
     }
 }
 
+//==============================
+// AddBenchmarkObject
+static menuHandle_t AddBenchmarkObject( OvrVRMenuMgr & menuMgr, menuHandle_t const parentHandle, 
+		eVRMenuObjectType const type, Vector3f const & position, float const extent )
+{
+	Array< VRMenuComponent* > comps;
+	VRMenuSurfaceParms surfParms;
+	VRMenuObjectFlags_t const objectFlags = ( type == VRMENU_BUTTON ) ? 
+			VRMenuObjectFlags_t( VRMENUOBJECT_HIT_ONLY_BOUNDS ) : VRMenuObjectFlags_t();
+	VRMenuObjectParms parms( type, comps, surfParms, "", Posef( Quatf(), position ), Vector3f( 1.0f ), 
+			VRMenuFontParms(), VRMenuId_t(), objectFlags, VRMenuObjectInitFlags_t() );
+	menuHandle_t const handle = menuMgr.CreateObject( parms );
+	VRMenuObject * obj = menuMgr.ToObject( handle );
+	obj->SetLocalBoundsExpand( Vector3f( -extent, -extent, -0.01f ), Vector3f( extent, extent, 0.01f ) );
+	if ( parentHandle.IsValid() )
+	{
+		menuMgr.ToObject( parentHandle )->AddChild( menuMgr, handle );
+	}
+	return handle;
+}
+
+//==============================
+// CreateBenchmarkMenu
+// Creates panels of 10 rows of 9 buttons in a circle around the viewer, with about numObjects
+// objects in total. Returns the root.
+static menuHandle_t CreateBenchmarkMenu( OvrVRMenuMgr & menuMgr, int & numObjects, Array< menuHandle_t > & buttons )
+{
+	int const numRows = 10;
+	int const numButtons = 9;
+	int const objectsPerPanel = 1 + numRows * ( 1 + numButtons );
+	int const numPanels = Alg::Clamp( ( numObjects + objectsPerPanel - 2 ) / objectsPerPanel, 1, 1000 );
+	numObjects = 1 + numPanels * objectsPerPanel;
+
+	menuHandle_t const rootHandle = AddBenchmarkObject( menuMgr, menuHandle_t(), VRMENU_CONTAINER, Vector3f( 0.0f ), 0.0f );
+	for ( int p = 0; p < numPanels; p++ )
+	{
+		float const yaw = p * Mathf::TwoPi / numPanels;
+		menuHandle_t const panel = AddBenchmarkObject( menuMgr, rootHandle, VRMENU_CONTAINER, 
+				Vector3f( sinf( yaw ) * 3.0f, 0.0f, -cosf( yaw ) * 3.0f ), 0.0f );
+		for ( int r = 0; r < numRows; r++ )
+		{
+			menuHandle_t const row = AddBenchmarkObject( menuMgr, panel, VRMENU_CONTAINER, 
+					Vector3f( 0.0f, r * 0.12f - 0.6f, 0.0f ), 0.0f );
+			for ( int b = 0; b < numButtons; b++ )
+			{
+				buttons.PushBack( AddBenchmarkObject( menuMgr, row, VRMENU_BUTTON, 
+						Vector3f( b * 0.12f - 0.5f, 0.0f, 0.0f ), 0.05f ) );
+			}
+		}
+	}
+	return rootHandle;
+}
+
+//==============================
+// MoveBenchmarkButtons
+// Moves 20 of the buttons back and forth.
+static void MoveBenchmarkButtons( OvrVRMenuMgr & menuMgr, Array< menuHandle_t > const & buttons, int const frame )
+{
+	for ( int i = 0; i < 20; i++ )
+	{
+		VRMenuObject * button = menuMgr.ToObject( buttons[( frame * 37 + i * 101 ) % buttons.GetSizeI()] );
+		Vector3f position = button->GetLocalPosition();
+		position.z = ( frame & 1 ) ? 0.01f : 0.0f;
+		button->SetLocalPosition( position );
+	}
+}
+
+//==============================
+// VRMenuTransformBenchmark
+void VRMenuTransformBenchmark( void * appPtr, const char * cmd )
+{
+	OVR_UNUSED( appPtr );
+
+	int numObjects = 5000;
+	int numFrames = 200;
+	sscanf( cmd, "%i %i", &numObjects, &numFrames );
+	numFrames = Alg::Max( numFrames, 1 );
+
+	// A menu manager of its own, so the app's menus are not disturbed. Nothing in here needs GL.
+	VRMenuMgrLocal menuMgr;
+	menuMgr.Initialized = true;
+	BitmapFont * font = BitmapFont::Create();
+	BitmapFontSurface * fontSurface = BitmapFontSurface::Create();
+	OvrDebugLines * debugLines = OvrDebugLines::Create();
+
+	Array< menuHandle_t > buttons;
+	menuHandle_t const rootHandle = CreateBenchmarkMenu( menuMgr, numObjects, buttons );
+	VRMenuObject * root = menuMgr.ToObject( rootHandle );
+
+	LOG( "VRMenuTransformBenchmark: %i objects, %i frames", numObjects, numFrames );
+
+	static const char * modeNames[] = { "static menu", "20 buttons moving", "menu moving" };
+	for ( int mode = 0; mode < 3; mode++ )
+	{
+		Posef menuPose;
+		int numHits = 0;
+		double const start = Timer::GetSeconds();
+		for ( int frame = 0; frame < numFrames; frame++ )
+		{
+			if ( mode == 1 )
+			{
+				MoveBenchmarkButtons( menuMgr, buttons, frame );
+			}
+			else if ( mode == 2 )
+			{
+				menuPose.Position.y = ( frame & 1 ) * 0.001f;
+			}
+
+			// sweep the gaze around the viewer
+			menuMgr.BeginFrame();
+			float const yaw = frame * 0.01f;
+			HitTestResult result;
+			menuHandle_t const hitHandle = root->HitTest( NULL, menuMgr, *font, menuPose, Vector3f( 0.0f ), 
+					Vector3f( sinf( yaw ), 0.0f, -cosf( yaw ) ), ContentFlags_t( CONTENT_SOLID ), result );
+			numHits += hitHandle.IsValid() ? 1 : 0;
+			menuMgr.SubmitForRendering( *debugLines, *font, *fontSurface, rootHandle, menuPose, VRMenuRenderFlags_t() );
+		}
+		double const seconds = Timer::GetSeconds() - start;
+		LOG( "VRMenuTransformBenchmark: %-18s %7.3f ms per frame, %i hits", modeNames[mode], 
+				seconds * 1000.0 / numFrames, numHits );
+	}
+
+	menuMgr.FreeObject( rootHandle );
+	OvrDebugLines::Free( debugLines );
+	menuMgr.ForgetFontSurface( *fontSurface );
+	BitmapFontSurface::Free( fontSurface );
+	BitmapFont::Free( font );
+}
+
+//==============================
+// VRMenuHitTestBenchmark
+void VRMenuHitTestBenchmark( void * appPtr, const char * cmd )
+{
+	OVR_UNUSED( appPtr );
+
+	int numObjects = 5000;
+	int numFrames = 200;
+	int numRays = 2;
+	sscanf( cmd, "%i %i %i", &numObjects, &numFrames, &numRays );
+	numFrames = Alg::Max( numFrames, 1 );
+	numRays = Alg::Clamp( numRays, 1, 64 );
+
+	VRMenuMgrLocal menuMgr;
+	menuMgr.Initialized = true;
+	BitmapFont * font = BitmapFont::Create();
+
+	Array< menuHandle_t > buttons;
+	menuHandle_t const rootHandle = CreateBenchmarkMenu( menuMgr, numObjects, buttons );
+	// a few text labels, so text bounds are part of the tests, and every tenth panel hidden
+	for ( int i = 0; i < buttons.GetSizeI(); i += 7 )
+	{
+		menuMgr.ToObject( buttons[i] )->SetText( "Label" );
+	}
+	for ( int i = 0; i < buttons.GetSizeI(); i += 900 )
+	{
+		VRMenuObject * row = menuMgr.ToObject( menuMgr.ToObject( buttons[i] )->GetParentHandle() );
+		menuMgr.ToObject( row->GetParentHandle() )->AddFlags( VRMenuObjectFlags_t( VRMENUOBJECT_DONT_RENDER ) );
+	}
+
+	LOG( "VRMenuHitTestBenchmark: %i objects, %i frames, %i rays", numObjects, numFrames, numRays );
+
+	Array< VRMenuRay > rays;
+	rays.Resize( numRays );
+	Array< HitTestResult > results;
+	results.Resize( numRays );
+	Array< menuHandle_t > bruteForceHits;
+	bruteForceHits.Resize( numRays );
+	Posef const menuPose;
+
+	static const char * modeNames[] = { "static menu", "20 buttons moving" };
+	for ( int mode = 0; mode < 2; mode++ )
+	{
+		double bruteForceSeconds = 0.0;
+		double hierarchySeconds = 0.0;
+		int numHits = 0;
+		int mismatches = 0;
+		for ( int frame = 0; frame < numFrames; frame++ )
+		{
+			if ( mode == 1 )
+			{
+				MoveBenchmarkButtons( menuMgr, buttons, frame );
+			}
+
+			// the gaze and controller rays sweep around the viewer at different heights
+			for ( int r = 0; r < numRays; r++ )
+			{
+				float const yaw = frame * 0.01f + r * 0.37f;
+				float const pitch = ( r % 5 ) * 0.05f - 0.1f;
+				rays[r].Start = Vector3f( 0.0f, r * 0.01f, 0.0f );
+				rays[r].Dir = Vector3f( sinf( yaw ) * cosf( pitch ), sinf( pitch ), -cosf( yaw ) * cosf( pitch ) );
+			}
+
+			// every object in the tree, in the order they used to be tested
+			double const bruteForceStart = Timer::GetSeconds();
+			Array< VRMenuWorldTransform > const & transforms = menuMgr.UpdateWorldTransforms( rootHandle, menuPose );
+			for ( int r = 0; r < numRays; r++ )
+			{
+				HitTestResult result;
+				for ( int i = 0; i < transforms.GetSizeI(); ++i )
+				{
+					VRMenuWorldTransform const & transform = transforms[i];
+					VRMenuObjectLocal const * obj = static_cast< VRMenuObjectLocal const * >( transform.Object );
+					if ( ( obj->GetFlags() & VRMENUOBJECT_DONT_RENDER ) || ( obj->GetFlags() & VRMENUOBJECT_DONT_HIT_ALL ) )
+					{
+						i = transform.SubtreeEnd - 1;
+						continue;
+					}
+					Vector3f const parentScale = ( transform.Parent >= 0 ) ? transforms[transform.Parent].Scale : Vector3f( 1.0f );
+					HitTestResult objResult;
+					if ( obj->HitTestSelf( *font, transform.ModelPose, parentScale, rays[r].Start, rays[r].Dir, 
+							ContentFlags_t( CONTENT_SOLID ), objResult ) && objResult.t < result.t )
+					{
+						result = objResult;
+					}
+				}
+				bruteForceHits[r] = result.HitHandle;
+			}
+			bruteForceSeconds += Timer::GetSeconds() - bruteForceStart;
+
+			double const hierarchyStart = Timer::GetSeconds();
+			for ( int r = 0; r < numRays; r++ )
+			{
+				results[r] = HitTestResult();
+			}
+			menuMgr.HitTestRays( *font, rootHandle, menuPose, &rays[0], numRays, ContentFlags_t( CONTENT_SOLID ), &results[0] );
+			hierarchySeconds += Timer::GetSeconds() - hierarchyStart;
+
+			for ( int r = 0; r < numRays; r++ )
+			{
+				numHits += results[r].HitHandle.IsValid() ? 1 : 0;
+				mismatches += ( results[r].HitHandle != bruteForceHits[r] ) ? 1 : 0;
+			}
+		}
+		LOG( "VRMenuHitTestBenchmark: %-18s all objects %7.3f ms, hierarchy %7.3f ms per frame, %i hits, %i differ", 
+				modeNames[mode], bruteForceSeconds * 1000.0 / numFrames, hierarchySeconds * 1000.0 / numFrames, 
+				numHits, mismatches );
+	}
+
+	menuMgr.FreeObject( rootHandle );
+	BitmapFont::Free( font );
+}
+
+//==============================
+// VRMenuObjectChurnBenchmark
+void VRMenuObjectChurnBenchmark( void * appPtr, const char * cmd )
+{
+	OVR_UNUSED( appPtr );
+
+	int numObjects = 1000;
+	int numIterations = 100;
+	sscanf( cmd, "%i %i", &numObjects, &numIterations );
+	numObjects = Alg::Max( numObjects, 4 );
+	numIterations = Alg::Max( numIterations, 1 );
+
+	VRMenuMgrLocal menuMgr;
+	menuMgr.Initialized = true;
+	menuHandle_t const rootHandle = AddBenchmarkObject( menuMgr, menuHandle_t(), VRMENU_CONTAINER, Vector3f( 0.0f ), 0.0f );
+	VRMenuObject * root = menuMgr.ToObject( rootHandle );
+
+	// Like the folder browser changing categories: panels of a container with an icon and a
+	// label are created, walked for a while and freed again.
+	double createSeconds = 0.0;
+	double updateSeconds = 0.0;
+	double freeSeconds = 0.0;
+	int const numPanels = numObjects / 4;
+	int numStaleHandles = 0;
+	menuHandle_t staleHandle;
+	for ( int iteration = 0; iteration < numIterations; iteration++ )
+	{
+		double const createStart = Timer::GetSeconds();
+		for ( int p = 0; p < numPanels; p++ )
+		{
+			Vector3f const position( ( p % 10 ) * 0.5f, ( p / 10 ) * 0.5f, -3.0f );
+			menuHandle_t const panel = AddBenchmarkObject( menuMgr, rootHandle, VRMENU_CONTAINER, position, 0.0f );
+			AddBenchmarkObject( menuMgr, panel, VRMENU_BUTTON, Vector3f( 0.0f ), 0.2f );
+			AddBenchmarkObject( menuMgr, panel, VRMENU_STATIC, Vector3f( 0.0f, -0.2f, 0.0f ), 0.1f );
+			AddBenchmarkObject( menuMgr, panel, VRMENU_STATIC, Vector3f( 0.0f, 0.2f, 0.0f ), 0.1f );
+		}
+		createSeconds += Timer::GetSeconds() - createStart;
+
+		double const updateStart = Timer::GetSeconds();
+		for ( int frame = 0; frame < 10; frame++ )
+		{
+			menuMgr.UpdateWorldTransforms( rootHandle, Posef( Quatf(), Vector3f( 0.0f, frame * 0.001f, 0.0f ) ) );
+		}
+		updateSeconds += Timer::GetSeconds() - updateStart;
+
+		// a handle from the previous iteration must not resolve to an object in its reused slot
+		numStaleHandles += ( staleHandle.IsValid() && menuMgr.ToObject( staleHandle ) != NULL ) ? 1 : 0;
+		staleHandle = root->GetChildHandleForIndex( 0 );
+
+		double const freeStart = Timer::GetSeconds();
+		root->FreeChildren( menuMgr );
+		freeSeconds += Timer::GetSeconds() - freeStart;
+	}
+
+	LOG( "VRMenuObjectChurnBenchmark: %i objects, %i iterations, %i slabs", numPanels * 4, numIterations, menuMgr.Slabs.GetSizeI() );
+	LOG( "VRMenuObjectChurnBenchmark: create %7.3f ms, 10 updates %7.3f ms, free %7.3f ms per iteration", 
+			createSeconds * 1000.0 / numIterations, updateSeconds * 1000.0 / numIterations, 
+			freeSeconds * 1000.0 / numIterations );
+	LOG( "VRMenuObjectChurnBenchmark: %i stale handles resolved", numStaleHandles );
+
+	menuMgr.FreeObject( rootHandle );
+}
+
 } // namespace OVR
@@ -33,6 +33,33 @@ enum eGUIProgramType
 	PROGRAM_MAX							// some other combo not supported, or no texture maps at all
 };
 
+//==============================================================
+// VRMenuWorldTransform
+// The world transform of a menu object. The menu manager flattens the tree of objects
+// under a root into an array of these, parents before their children, so submitting and
+// hit testing a menu walks an array instead of resolving the children's handles recursively.
+struct VRMenuWorldTransform
+{
+	VRMenuObject const *	Object;
+	int						Parent;				// index of the parent, -1 for the root
+	int						SubtreeEnd;			// index after the last descendant, to skip the subtree
+	UInt32					TransformVersion;	// versions of the object when this was updated
+	UInt32					ChildrenVersion;
+	bool					Changed;			// true if composed again on the last update
+	Posef					ModelPose;			// parent's model pose with the local pose applied
+	Posef					RenderPose;			// the same for the parent's render pose, plus the hilight pose if this is not a container
+	Vector3f				Scale;				// parent's scale times the local scale
+	Vector4f				Color;				// parent's color times the color
+};
+
+//==============================================================
+// VRMenuRay
+struct VRMenuRay
+{
+	Vector3f				Start;				// world space
+	Vector3f				Dir;				// normalized
+};
+
 //==============================================================
 // OvrVRMenuMgr
 class OvrVRMenuMgr
@@ -67,6 +94,29 @@ public:
                                         BitmapFontSurface & fontSurface, menuHandle_t const handle, 
                                         Posef const & worldPose, VRMenuRenderFlags_t const & flags ) = 0;
 
+	// Must be called before a font surface that objects were submitted to is freed, so the
+	// text layouts of freed objects on it are dropped instead of kept forever, and live
+	// objects lay out their text again on the next surface they are submitted to.
+	virtual void				ForgetFontSurface( BitmapFontSurface const & fontSurface ) = 0;
+
+	// Returns the world transforms of the root object and all of its descendants, flattened.
+	// Only the objects whose pose, scale or color changed since the last update for the root,
+	// and their descendants, are composed again. The array remains valid until the next update
+	// for the same root.
+	virtual Array< VRMenuWorldTransform > const &	UpdateWorldTransforms( menuHandle_t const root, Posef const & worldPose ) = 0;
+
+	// Tests the ray against the root object and all of its descendants and returns the nearest
+	// object hit, or an invalid handle. result is only replaced by a nearer hit. The world bounds
+	// of the objects are kept in a bounding volume hierarchy per root that is refit when objects
+	// move, so only the objects near the ray are tested.
+	virtual menuHandle_t		HitTest( BitmapFont const & font, menuHandle_t const root, Posef const & worldPose, 
+										Vector3f const & rayStart, Vector3f const & rayDir, ContentFlags_t const testContents, 
+										HitTestResult & result ) = 0;
+	// The same for any number of rays at once, like the gaze and a controller.
+	virtual void				HitTestRays( BitmapFont const & font, menuHandle_t const root, Posef const & worldPose, 
+										VRMenuRay const * rays, int const numRays, ContentFlags_t const testContents, 
+										HitTestResult * results ) = 0;
+
 	// Call once per frame before rendering to sort surfaces.
 	virtual void				Finish( Matrix4f const & viewMatrix ) = 0;
 
@@ -76,6 +126,23 @@ public:
     virtual GlProgram const *   GetGUIGlProgram( eGUIProgramType const programType ) const = 0;
 };
 
+// Logs the time per frame it takes to hit test and submit a menu of buttons on panels
+// around the viewer, while the menu is static, while some buttons move and while the
+// whole menu moves. Registered as the "menuTransformBenchmark" console command,
+// optional parms: "<objects> <frames>"
+void VRMenuTransformBenchmark( void * appPtr, const char * cmd );
+
+// Logs the time per frame it takes to hit test a number of rays against a menu of buttons on
+// panels around the viewer by testing every object, and through the bounding volume hierarchy,
+// and how many of the hits differ. Registered as the "menuHitTestBenchmark" console command,
+// optional parms: "<objects> <frames> <rays>"
+void VRMenuHitTestBenchmark( void * appPtr, const char * cmd );
+
+// Logs the time it takes to create, update and free panels of menu objects over and over,
+// like a folder browser changing categories. Registered as the "menuObjectChurnBenchmark"
+// console command, optional parms: "<objects> <iterations>"
+void VRMenuObjectChurnBenchmark( void * appPtr, const char * cmd );
+
 } // namespace OVR
 
 #endif // OVR_VRMenuMgr_h
@@ -657,6 +657,12 @@ VRMenuObjectLocal::VRMenuObjectLocal( VRMenuObjectParms const & parms,
 	MinsBoundsExpand( 0.0f ),
 	MaxsBoundsExpand( 0.0f ),
 	TextMetrics(),
+	TextBoundsDirty( true ),
+	TextLayoutSurfaceId( 0 ),
+	TextLayout(),
+	TransformVersion( 0 ),
+	ChildrenVersion( 0 ),
+	BoundsVersion( 0 ),
 	WrapWidth( 0.0f )
 {
 	CullBounds.Clear();
@@ -707,11 +713,18 @@ void VRMenuObjectLocal::Init( VRMenuObjectParms const & parms )
 // VRMenuObjectLocal::FreeChildren
 void VRMenuObjectLocal::FreeChildren( OvrVRMenuMgr & menuMgr )
 {
-	for ( int i = 0; i < Children.GetSizeI(); ++i ) 
+	// FreeObject removes the child from this list with RemoveAtUnordered, so walk it
+	// from the back or every other child would be skipped and leaked.
+	for ( int i = Children.GetSizeI() - 1; i >= 0; --i ) 
 	{
+		if ( i >= Children.GetSizeI() )
+		{
+			continue;
+		}
 		menuMgr.FreeObject( Children[i] );
 	}
 	Children.Resize( 0 );
+	ChildrenVersion++;
     // NOTE! bounds will be incorrect now until submitted for rendering
 }
 
@@ -748,6 +761,7 @@ bool VRMenuObjectLocal::IsDescendant( OvrVRMenuMgr & menuMgr, menuHandle_t const
 void VRMenuObjectLocal::AddChild( OvrVRMenuMgr & menuMgr, menuHandle_t const handle )
 {
 	Children.PushBack( handle );
+	ChildrenVersion++;
 
 	VRMenuObject * child = menuMgr.ToObject( handle );
 	if ( child != NULL )
@@ -766,6 +780,7 @@ void VRMenuObjectLocal::RemoveChild( OvrVRMenuMgr & menuMgr, menuHandle_t const
 		if ( Children[i] == handle )
 		{
 			Children.RemoveAtUnordered( i );
+			ChildrenVersion++;
 			return;
 		}
 	}
@@ -781,6 +796,7 @@ void VRMenuObjectLocal::FreeChild( OvrVRMenuMgr & menuMgr, menuHandle_t const ha
 		if ( childHandle == handle )
 		{
 			Children.RemoveAtUnordered( i );
+			ChildrenVersion++;
 			menuMgr.FreeObject( childHandle );
 			return;
 		}
@@ -878,57 +894,14 @@ bool VRMenuObjectLocal::IntersectRay( Vector3f const & localStart, Vector3f cons
 }
 
 //==============================
-// VRMenuObjectLocal::HitTest_r
-bool VRMenuObjectLocal::HitTest_r( App * app, OvrVRMenuMgr & menuMgr, BitmapFont const & font, 
-		Posef const & parentPose, Vector3f const & parentScale, Vector3f const & rayStart, Vector3f const & rayDir,
+// VRMenuObjectLocal::HitTestSelf
+bool VRMenuObjectLocal::HitTestSelf( BitmapFont const & font, Posef const & modelPose,
+		Vector3f const & parentScale, Vector3f const & rayStart, Vector3f const & rayDir,
 		ContentFlags_t const testContents, HitTestResult & result ) const
 {
-	if ( Flags & VRMENUOBJECT_DONT_RENDER )
-	{
-		return false;
-	}
-
-	if ( Flags & VRMENUOBJECT_DONT_HIT_ALL )
-	{
-		return false;
-	}
-
 	// transform ray into local space
-	Vector3f const & localScale = GetLocalScale();
-	Vector3f scale = parentScale.EntrywiseMultiply( localScale );
-	Posef modelPose;
-	modelPose.Position = parentPose.Position + ( parentPose.Orientation * parentScale.EntrywiseMultiply( LocalPose.Position ) );
-	modelPose.Orientation = LocalPose.Orientation * parentPose.Orientation;
 	Vector3f localStart = modelPose.Orientation.Inverted().Rotate( rayStart - modelPose.Position );
 	Vector3f localDir = modelPose.Orientation.Inverted().Rotate( rayDir );
-/*
-    DROIDLOG( "Spam", "Hit test vs '%s', start: (%.2f, %.2f, %.2f ) cull bounds( %.2f, %.2f, %.2f ) -> ( %.2f, %.2f, %.2f )", GetText().ToCStr(),
-            localStart.x, localStart.y, localStart.z,
-            CullBounds.b[0].x, CullBounds.b[0].y, CullBounds.b[0].z,
-            CullBounds.b[1].x, CullBounds.b[1].y, CullBounds.b[1].z );
-*/
-    // test against cull bounds if we have children  ... otherwise cullBounds == localBounds
-    if ( Children.GetSizeI() > 0 )  
-    {
-        if ( CullBounds.IsInverted() )
-        {
-            DROIDLOG( "Spam", "CullBounds are inverted!!" );
-            return false;
-        }
-	    float cullT0;
-	    float cullT1;
-		// any contents will hit cull bounds
-		ContentFlags_t allContents( ALL_BITS );
-	    bool hitCullBounds = IntersectRayBounds( localStart, localDir, CullBounds.GetMins(), CullBounds.GetMaxs(), 
-									allContents, cullT0, cullT1 );
-
-//        DROIDLOG( "Spam", "Cull hit = %s, t0 = %.2f t1 = %.2f", hitCullBounds ? "true" : "false", cullT0, cullT1 );
-
-	    if ( !hitCullBounds )
-	    {
-            return false;
-        }
-    }
 
 	// test against self first, if not a container
     if ( GetContents() & testContents )
@@ -980,20 +953,6 @@ bool VRMenuObjectLocal::HitTest_r( App * app, OvrVRMenuMgr & menuMgr, BitmapFont
         }
     }
 
-	// test against children
-	for ( int i = 0; i < Children.GetSizeI(); ++i )
-	{
-		VRMenuObjectLocal * child = static_cast< VRMenuObjectLocal* >( menuMgr.ToObject( Children[i] ) );
-		if ( child != NULL )
-		{
-			HitTestResult childResult;
-			bool intersected = child->HitTest_r( app, menuMgr, font, modelPose, scale, rayStart, rayDir, testContents, childResult );
-			if ( intersected && childResult.t < result.t )
-			{
-				result = childResult;
-			}
-		}
-    }
 	return result.HitHandle.IsValid();
 }
 
@@ -1002,9 +961,7 @@ bool VRMenuObjectLocal::HitTest_r( App * app, OvrVRMenuMgr & menuMgr, BitmapFont
 menuHandle_t VRMenuObjectLocal::HitTest( App * app, OvrVRMenuMgr & menuMgr, BitmapFont const & font, Posef const & worldPose, 
         Vector3f const & rayStart, Vector3f const & rayDir, ContentFlags_t const testContents, HitTestResult & result ) const
 {
-	HitTest_r( app, menuMgr, font, worldPose, Vector3f( 1.0f ), rayStart, rayDir, testContents, result );
-
-	return result.HitHandle;
+	return menuMgr.HitTest( font, Handle, worldPose, rayStart, rayDir, testContents, result );
 }
 
 //==============================
@@ -1060,6 +1017,12 @@ Bounds3f VRMenuObjectLocal::GetLocalBounds( BitmapFont const & font ) const {
 // VRMenuObjectLocal::GetTextLocalBounds
 Bounds3f VRMenuObjectLocal::GetTextLocalBounds( BitmapFont const & font ) const
 {
+	if ( !TextDirty && !TextBoundsDirty )
+	{
+		return TextLocalBounds;
+	}
+	TextBoundsDirty = false;
+
     if ( TextDirty )
     {
 		TextDirty = false;
@@ -1104,6 +1067,7 @@ Bounds3f VRMenuObjectLocal::GetTextLocalBounds( BitmapFont const & font ) const
 	// transform by hilightpose here since surfaces are transformed by it before unioning the bounds
 	textLocalBounds = Bounds3f::Transform( HilightPose, textLocalBounds );
 
+	TextLocalBounds = textLocalBounds;
 	return textLocalBounds;
 }
 
@@ -1226,6 +1190,7 @@ Vector4f const & VRMenuObjectLocal::GetColor() const
 void VRMenuObjectLocal::SetColor( Vector4f const & c )
 {
 	Color = c;
+	TransformVersion++;
 }
 
 void VRMenuObjectLocal::SetVisible( bool visible )
@@ -1292,6 +1257,7 @@ void  VRMenuObjectLocal::SetSurfaceTexture( int const surfaceIndex, int const te
         return;
     }
     Surfaces[surfaceIndex].LoadTexture( textureIndex, type, texId, width, height );
+    BoundsChanged();
 }
 
 //==============================
@@ -1307,6 +1273,7 @@ void  VRMenuObjectLocal::SetSurfaceTextureTakeOwnership( int const surfaceIndex,
 	}
 	Surfaces[ surfaceIndex ].LoadTexture( textureIndex, type, texId, width, height );
 	Surfaces[ surfaceIndex ].SetOwnership( textureIndex, true );
+	BoundsChanged();
 }
 
 //==============================
@@ -1320,6 +1287,7 @@ void VRMenuObjectLocal::RegenerateSurfaceGeometry( int const surfaceIndex )
 	}
 
 	Surfaces[ surfaceIndex ].RegenerateSurfaceGeometry();
+	BoundsChanged();
 }
 
 //==============================
@@ -1346,6 +1314,7 @@ void VRMenuObjectLocal::SetSurfaceDims( int const surfaceIndex, Vector2f const &
 	}
 
 	Surfaces[ surfaceIndex ].SetDims( dims );
+	BoundsChanged();
 }
 
 //==============================
@@ -1372,6 +1341,7 @@ void VRMenuObjectLocal::SetSurfaceBorder( int const surfaceIndex, Vector4f const
 	}
 
 	Surfaces[ surfaceIndex ].SetBorder( border );
+	BoundsChanged();
 }
 
 
@@ -1381,6 +1351,7 @@ void VRMenuObjectLocal::SetLocalBoundsExpand( Vector3f const mins, Vector3f cons
 {
 	MinsBoundsExpand = mins;
 	MaxsBoundsExpand = maxs;
+	BoundsChanged();
 }
 
 //==============================
@@ -1392,6 +1363,7 @@ void VRMenuObjectLocal::SetCollisionPrimitive( OvrCollisionPrimitive * c )
 		delete CollisionPrimitive;
 	}
 	CollisionPrimitive = c;
+	BoundsChanged();
 }
 
 //==============================
@@ -1470,6 +1442,7 @@ int VRMenuObjectLocal::NumSurfaces() const
 // VRMenuObjectLocal::AllocSurface
 int VRMenuObjectLocal::AllocSurface()
 {
+	BoundsChanged();
 	return Surfaces.AllocBack();
 }
 
@@ -1480,6 +1453,7 @@ void VRMenuObjectLocal::CreateFromSurfaceParms( int const surfaceIndex, VRMenuSu
 {
 	VRMenuSurface & surf = Surfaces[surfaceIndex];
 	surf.CreateFromSurfaceParms( parms );
+	BoundsChanged();
 }
 
 //==============================
@@ -216,6 +216,12 @@ public:
                                         Vector3f const & rayStart, Vector3f const & rayDir, ContentFlags_t const testContents, 
 										HitTestResult & result ) const;
 
+	// Test the world space ray against this object only, ignoring its children.
+	// Returns true if the object was hit.
+	bool						HitTestSelf( BitmapFont const & font, Posef const & modelPose, 
+										Vector3f const & parentScale, Vector3f const & rayStart, Vector3f const & rayDir,
+										ContentFlags_t const testContents, HitTestResult & result ) const;
+
 	//--------------------------------------------------------------
 	// components
 	//--------------------------------------------------------------
@@ -241,7 +247,7 @@ public:
 	virtual	void				RemoveFlags( VRMenuObjectFlags_t const & flags ) { Flags &= ~flags; }
 
 	virtual OVR::String const &	GetText() const { return Text; }
-	virtual void				SetText( char const * text ) { Text = text; TextDirty = true; }
+	virtual void				SetText( char const * text ) { Text = text; TextDirty = true; BoundsChanged(); }
 	virtual void				SetTextWordWrapped( char const * text, class BitmapFont const & font, float const widthInMeters );
 
 	virtual bool				IsHilighted() const { return Hilighted; }
@@ -252,27 +258,27 @@ public:
 	virtual menuHandle_t		GetChildHandleForIndex( int const index ) const { return Children[index]; }
 
 	virtual Posef const &		GetLocalPose() const { return LocalPose; }
-	virtual void				SetLocalPose( Posef const & pose ) { LocalPose = pose; }
+	virtual void				SetLocalPose( Posef const & pose ) { LocalPose = pose; TransformVersion++; }
 	virtual Vector3f const &	GetLocalPosition() const { return LocalPose.Position; }
-	virtual void				SetLocalPosition( Vector3f const & pos ) { LocalPose.Position = pos; }
+	virtual void				SetLocalPosition( Vector3f const & pos ) { LocalPose.Position = pos; TransformVersion++; }
 	virtual Quatf const &		GetLocalRotation() const { return LocalPose.Orientation; }
-	virtual void				SetLocalRotation( Quatf const & rot ) { LocalPose.Orientation = rot; }
+	virtual void				SetLocalRotation( Quatf const & rot ) { LocalPose.Orientation = rot; TransformVersion++; }
 	virtual Vector3f            GetLocalScale() const;
-	virtual void				SetLocalScale( Vector3f const & scale ) { LocalScale = scale; }
+	virtual void				SetLocalScale( Vector3f const & scale ) { LocalScale = scale; TransformVersion++; BoundsChanged(); }
 
     virtual Posef const &       GetHilightPose() const { return HilightPose; }
-    virtual void                SetHilightPose( Posef const & pose ) { HilightPose = pose; }
+    virtual void                SetHilightPose( Posef const & pose ) { HilightPose = pose; TransformVersion++; BoundsChanged(); }
     virtual float               GetHilightScale() const { return HilightScale; }
-    virtual void                SetHilightScale( float const s ) { HilightScale = s; }
+    virtual void                SetHilightScale( float const s ) { HilightScale = s; TransformVersion++; BoundsChanged(); }
 
-    virtual void                SetTextLocalPose( Posef const & pose ) { TextLocalPose = pose; }
+    virtual void                SetTextLocalPose( Posef const & pose ) { TextLocalPose = pose; BoundsChanged(); }
     virtual Posef const &       GetTextLocalPose() const { return TextLocalPose; }
-    virtual void                SetTextLocalPosition( Vector3f const & pos ) { TextLocalPose.Position = pos; }
+    virtual void                SetTextLocalPosition( Vector3f const & pos ) { TextLocalPose.Position = pos; BoundsChanged(); }
     virtual Vector3f const &    GetTextLocalPosition() const { return TextLocalPose.Position; }
-    virtual void                SetTextLocalRotation( Quatf const & rot ) { TextLocalPose.Orientation = rot; }
+    virtual void                SetTextLocalRotation( Quatf const & rot ) { TextLocalPose.Orientation = rot; BoundsChanged(); }
     virtual Quatf const &       GetTextLocalRotation() const { return TextLocalPose.Orientation; }
     virtual Vector3f            GetTextLocalScale() const;
-    virtual void                SetTextLocalScale( Vector3f const & scale ) { TextLocalScale = scale; }
+    virtual void                SetTextLocalScale( Vector3f const & scale ) { TextLocalScale = scale; BoundsChanged(); }
 
 	virtual	void				SetLocalBoundsExpand( Vector3f const mins, Vector3f const & maxs );
 
@@ -294,7 +300,7 @@ public:
 	virtual VRMenuId_t			GetId() const { return Id; }
 	virtual menuHandle_t		ChildHandleForId( OvrVRMenuMgr & menuMgr, VRMenuId_t const id ) const;
 
-	virtual void				SetFontParms( VRMenuFontParms const & fontParms ) { FontParms = fontParms; }
+	virtual void				SetFontParms( VRMenuFontParms const & fontParms ) { FontParms = fontParms; BoundsChanged(); }
 	virtual VRMenuFontParms const & GetFontParms() const { return FontParms; }
 
 	virtual	Vector3f const &	GetFadeDirection() const { return FadeDirection;  }
@@ -343,6 +349,8 @@ public:
 	// surfaces (non-virtual)
 	//--------------------------------------------------------------
 	VRMenuSurface const &			GetSurface( int const s ) const { return Surfaces[s]; }
+	// Does not invalidate the cached bounds. Change the geometry of a surface through the
+	// SetSurface* and RegenerateSurfaceGeometry methods, which do.
 	VRMenuSurface &					GetSurface( int const s ) { return Surfaces[s]; }
 	Array< VRMenuSurface > const &	GetSurfaces() const { return Surfaces; }
 
@@ -384,6 +392,16 @@ private:
 	Vector3f					MaxsBoundsExpand;	// amount to expand local bounds maxs
 	mutable Bounds3f			CullBounds;			// bounds of this object and all its children in the local space of its parent
     mutable textMetrics_t       TextMetrics;		// cached metrics for the text
+	mutable bool				TextBoundsDirty;	// if true, recalculate TextLocalBounds
+	mutable Bounds3f			TextLocalBounds;	// cached result of GetTextLocalBounds()
+	mutable UInt32				TextLayoutSurfaceId;	// id of the font surface the text layout was created on, 0 if none
+	mutable fontLayoutHandle_t	TextLayout;			// cached glyphs for the text
+
+	// incremented when something that changes the world transforms of this object or its
+	// descendants changes, so the menu manager knows what to update
+	UInt32						TransformVersion;	// local pose, scale, hilight pose or color
+	UInt32						ChildrenVersion;	// children added or removed
+	UInt32						BoundsVersion;		// anything else the local bounds depend on
 
 	float						WrapWidth;
 
@@ -400,12 +418,7 @@ private:
 										Vector3f const & mins, Vector3f const & maxs,
 										ContentFlags_t const testContents, float & t0, float & t1 ) const;
 
-	// Test the ray against this object and all child objects, returning the first object that was 
-	// hit by the ray. The ray should be in parent-local space - for the current root menu this is 
-	// always world space.
-	virtual bool				HitTest_r( App * app, OvrVRMenuMgr & menuMgr, BitmapFont const & font, Posef const & parentPose, Vector3f const & parentScale,
-                                        Vector3f const & rayStart, Vector3f const & rayDir,  ContentFlags_t const testContents, 
-                                        HitTestResult & result ) const;
+	void						BoundsChanged() { BoundsVersion++; TextBoundsDirty = true; }
 
 	int							GetComponentIndex( VRMenuComponent * component ) const;
 };
@@ -11,6 +11,22 @@ Copyright   :   Copyright 2014 Oculus VR, LLC. All Rights reserved.
 
 #include "Distortion.h"
 
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include "Kernel/OVR_Alg.h"
+#include "Kernel/OVR_Array.h"
+#include "Kernel/OVR_Atomic.h"
+#include "Kernel/OVR_Threads.h"
+#include "Kernel/OVR_Std.h"
+#include "Log.h"
+
+#if defined( OVR_CPU_SSE )
+#include <xmmintrin.h>
+#elif defined( OVR_CPU_ARM_NEON )
+#include <arm_neon.h>
+#endif
+
 
 namespace OVR
 {
@@ -114,8 +130,914 @@ static void WarpTexCoordChroma( const hmdInfoInternal_t & hmdInfo, const float i
 }
 
 
+/*
+ * Every distortion equation is a cubic polynomial in rsq per segment, so the
+ * segments are expanded to power basis coefficients up front, and the
+ * distortion function is evaluated four vertices at a time with a table
+ * lookup and a Horner evaluation, instead of branching through
+ * DistortionFnScaleRadiusSquared for every vertex.
+ */
+struct distortionFn_t
+{
+	bool	spline;				// rsq is scaled to segments, otherwise a single polynomial in rsq
+	bool	reciprocal;			// the scale is one over the polynomial
+	float	segmentsPerRsq;
+	int		maxSegment;
+	float	coefficients[LensConfig::MaxCoefficients][4];	// c0 + t * ( c1 + t * ( c2 + t * c3 ) )
+};
+
+static void InitDistortionFn( distortionFn_t & fn, const LensConfig & lens )
+{
+	memset( &fn, 0, sizeof( fn ) );
+
+	if ( lens.Eqn == Distortion_Poly4 || lens.Eqn == Distortion_RecipPoly4 )
+	{
+		fn.reciprocal = ( lens.Eqn == Distortion_RecipPoly4 );
+		for ( int i = 0; i < 4; i++ )
+		{
+			fn.coefficients[0][i] = lens.K[i];
+		}
+		return;
+	}
+
+	// Same segments as EvalCatmullRomSpline().
+	const int numSegments = ( lens.Eqn == Distortion_CatmullRom20 ) ? 21 : 11;
+	const float * K = lens.K;
+	fn.spline = true;
+	fn.segmentsPerRsq = (float)( numSegments - 1 ) / ( lens.MaxR * lens.MaxR );
+	fn.maxSegment = numSegments - 1;
+	for ( int k = 0; k < numSegments; k++ )
+	{
+		float p0, m0, p1, m1;
+		if ( k == 0 )
+		{
+			p0 = K[0];
+			m0 = K[1] - K[0];
+			p1 = K[1];
+			m1 = 0.5f * ( K[2] - K[0] );
+		}
+		else if ( k < numSegments - 2 )
+		{
+			p0 = K[k];
+			m0 = 0.5f * ( K[k+1] - K[k-1] );
+			p1 = K[k+1];
+			m1 = 0.5f * ( K[k+2] - K[k] );
+		}
+		else if ( k == numSegments - 2 )
+		{
+			p0 = K[numSegments-2];
+			m0 = 0.5f * ( K[numSegments-1] - K[numSegments-2] );
+			p1 = K[numSegments-1];
+			m1 = K[numSegments-1] - K[numSegments-2];
+		}
+		else
+		{
+			p0 = K[numSegments-1];
+			m0 = K[numSegments-1] - K[numSegments-2];
+			p1 = p0 + m0;
+			m1 = m0;
+		}
+		// Hermite basis to power basis.
+		fn.coefficients[k][0] = p0;
+		fn.coefficients[k][1] = m0;
+		fn.coefficients[k][2] = -3.0f * p0 - 2.0f * m0 + 3.0f * p1 - m1;
+		fn.coefficients[k][3] = 2.0f * p0 + m0 - 2.0f * p1 + m1;
+		if ( k == numSegments - 1 )
+		{
+			// Beyond the last segment t is not limited to [0,1], so the
+			// rounding error in the terms that should be zero would blow up.
+			fn.coefficients[k][2] = 0.0f;
+			fn.coefficients[k][3] = 0.0f;
+		}
+	}
+}
+
+// Same result as lens.DistortionFnScaleRadiusSquared() for four values of rsq.
+static void DistortionFnScaleRadiusSquared4( const distortionFn_t & fn, const float rsq[4], float scale[4] )
+{
+	int segment[4] = { 0, 0, 0, 0 };
+	float t[4] = { rsq[0], rsq[1], rsq[2], rsq[3] };
+	if ( fn.spline )
+	{
+		for ( int i = 0; i < 4; i++ )
+		{
+			const float scaled = rsq[i] * fn.segmentsPerRsq;
+			segment[i] = Alg::Min( (int)scaled, fn.maxSegment );
+			t[i] = scaled - (float)segment[i];
+		}
+	}
+	const float * c0 = fn.coefficients[segment[0]];
+	const float * c1 = fn.coefficients[segment[1]];
+	const float * c2 = fn.coefficients[segment[2]];
+	const float * c3 = fn.coefficients[segment[3]];
+
+#if defined( OVR_CPU_SSE )
+	// Transpose the coefficients of the four segments, so each register holds one power.
+	__m128 a = _mm_loadu_ps( c0 );
+	__m128 b = _mm_loadu_ps( c1 );
+	__m128 c = _mm_loadu_ps( c2 );
+	__m128 d = _mm_loadu_ps( c3 );
+	_MM_TRANSPOSE4_PS( a, b, c, d );
+	const __m128 tt = _mm_loadu_ps( t );
+	__m128 s = _mm_add_ps( a, _mm_mul_ps( tt, _mm_add_ps( b, _mm_mul_ps( tt, _mm_add_ps( c, _mm_mul_ps( tt, d ) ) ) ) ) );
+	if ( fn.reciprocal )
+	{
+		s = _mm_div_ps( _mm_set1_ps( 1.0f ), s );
+	}
+	_mm_storeu_ps( scale, s );
+#elif defined( OVR_CPU_ARM_NEON )
+	// Transpose the coefficients of the four segments, so each register holds one power.
+	const float32x4x2_t ab = vtrnq_f32( vld1q_f32( c0 ), vld1q_f32( c1 ) );
+	const float32x4x2_t cd = vtrnq_f32( vld1q_f32( c2 ), vld1q_f32( c3 ) );
+	const float32x4_t a = vcombine_f32( vget_low_f32( ab.val[0] ), vget_low_f32( cd.val[0] ) );
+	const float32x4_t b = vcombine_f32( vget_low_f32( ab.val[1] ), vget_low_f32( cd.val[1] ) );
+	const float32x4_t c = vcombine_f32( vget_high_f32( ab.val[0] ), vget_high_f32( cd.val[0] ) );
+	const float32x4_t d = vcombine_f32( vget_high_f32( ab.val[1] ), vget_high_f32( cd.val[1] ) );
+	const float32x4_t tt = vld1q_f32( t );
+	float32x4_t s = vmlaq_f32( a, tt, vmlaq_f32( b, tt, vmlaq_f32( c, tt, d ) ) );
+	if ( fn.reciprocal )
+	{
+		// There is no divide, so refine the reciprocal estimate with two Newton-Raphson
+		// steps, which gets within 2 ulp of 1.0f / s, see MaxReciprocalUlpError().
+		float32x4_t r = vrecpeq_f32( s );
+		r = vmulq_f32( r, vrecpsq_f32( s, r ) );
+		r = vmulq_f32( r, vrecpsq_f32( s, r ) );
+		s = r;
+	}
+	vst1q_f32( scale, s );
+#else
+	const float * coefficients[4] = { c0, c1, c2, c3 };
+	for ( int i = 0; i < 4; i++ )
+	{
+		const float * k = coefficients[i];
+		const float p = k[0] + t[i] * ( k[1] + t[i] * ( k[2] + t[i] * k[3] ) );
+		scale[i] = fn.reciprocal ? 1.0f / p : p;
+	}
+#endif
+}
+
+struct distortionRows_t
+{
+	const hmdInfoInternal_t *	hmdInfo;
+	distortionFn_t		fn;
+	int					eyeBlocksWide;
+	int					eyeBlocksHigh;
+	float				aspect;
+	float				horizontalShiftView;
+	float *				tanAngles;
+	int					numRows;		// both eyes
+	AtomicInt< int >	nextRow;
+};
+
+// Same as WarpTexCoordChroma() for all the verts of one row of one eye.
+static void BuildDistortionRow( const distortionRows_t & rows, const int row )
+{
+	const hmdInfoInternal_t & hmdInfo = *rows.hmdInfo;
+	const int eye = row & 1;
+	const int y = row >> 1;
+	const int eyeBlocksWide = rows.eyeBlocksWide;
+	const float yf = (float)y / (float)rows.eyeBlocksHigh;
+
+	for ( int x = 0; x <= eyeBlocksWide; x += 4 )
+	{
+		float theta[4][2];
+		float rsq[4];
+		for ( int i = 0; i < 4; i++ )
+		{
+			// The last group repeats the last vert.
+			const float xf = (float)Alg::Min( x + i, eyeBlocksWide ) / (float)eyeBlocksWide;
+			const float inTex[2] = { ( eye ? -rows.horizontalShiftView : rows.horizontalShiftView ) +
+					xf * rows.aspect + ( 1.0f - rows.aspect ) * 0.5f, yf };
+			for ( int j = 0; j < 2; j++ )
+			{
+				const float ndc = 2.0f * ( inTex[j] - 0.5f );
+				const float pixels = ndc * hmdInfo.heightPixels * 0.5f;
+				const float meters = pixels * hmdInfo.widthMeters / hmdInfo.widthPixels;
+				theta[i][j] = meters / hmdInfo.lens.MetersPerTanAngleAtCenter;
+			}
+			rsq[i] = theta[i][0] * theta[i][0] + theta[i][1] * theta[i][1];
+		}
+
+		float scale[4];
+		DistortionFnScaleRadiusSquared4( rows.fn, rsq, scale );
+
+		const float * chroma = hmdInfo.lens.ChromaticAberration;
+		const int count = Alg::Min( 4, eyeBlocksWide + 1 - x );
+		for ( int i = 0; i < count; i++ )
+		{
+			const int vertNum = y * ( eyeBlocksWide + 1 ) * 2 + eye * ( eyeBlocksWide + 1 ) + x + i;
+			float * v = &rows.tanAngles[vertNum * 6];
+			const float red = scale[i] * ( 1.0f + chroma[0] + rsq[i] * chroma[1] );
+			const float blue = scale[i] * ( 1.0f + chroma[2] + rsq[i] * chroma[3] );
+			v[0] = red * theta[i][0];
+			v[1] = red * theta[i][1];
+			v[2] = scale[i] * theta[i][0];
+			v[3] = scale[i] * theta[i][1];
+			v[4] = blue * theta[i][0];
+			v[5] = blue * theta[i][1];
+		}
+	}
+}
+
+static void * DistortionRowWorkerThread( void * parm )
+{
+	distortionRows_t * rows = (distortionRows_t *)parm;
+	for ( ; ; )
+	{
+		const int row = rows->nextRow.ExchangeAdd_Sync( 1 );
+		if ( row >= rows->numRows )
+		{
+			break;
+		}
+		BuildDistortionRow( *rows, row );
+	}
+	return NULL;
+}
+
+// Below this number of verts it is not worth starting threads.
+static const int DISTORTION_MIN_THREADED_VERTS = 4096;
+
+static MemBuffer BuildDistortionBuffer( const hmdInfoInternal_t & hmdInfo,
+		int eyeBlocksWide, int eyeBlocksHigh, const int maxThreads )
+{
+	const int vertexCount = 2 * ( eyeBlocksWide + 1 ) * ( eyeBlocksHigh + 1 );
+	MemBuffer	buf( 12 + 4 * vertexCount * 6 );
+	((int *)buf.Buffer)[0] = DISTORTION_BUFFER_MAGIC;
+	((int *)buf.Buffer)[1] = eyeBlocksWide;
+	((int *)buf.Buffer)[2] = eyeBlocksHigh;
+
+	distortionRows_t rows;
+	rows.hmdInfo = &hmdInfo;
+	InitDistortionFn( rows.fn, hmdInfo.lens );
+	rows.eyeBlocksWide = eyeBlocksWide;
+	rows.eyeBlocksHigh = eyeBlocksHigh;
+
+	// the centers are offset horizontal in each eye
+	rows.aspect = hmdInfo.widthPixels * 0.5 / hmdInfo.heightPixels;
+
+	const float	horizontalShiftMeters =  ( hmdInfo.lensSeparation / 2 ) - ( hmdInfo.widthMeters / 4 );
+	rows.horizontalShiftView = 2 * rows.aspect * horizontalShiftMeters / hmdInfo.widthMeters;
+
+	rows.tanAngles = (float *)buf.Buffer + 3;
+	rows.numRows = 2 * ( eyeBlocksHigh + 1 );
+	rows.nextRow = 0;
+
+	// The calling thread builds rows as well.
+	const int numThreads = ( vertexCount >= DISTORTION_MIN_THREADED_VERTS ) ? maxThreads : 1;
+	Array< pthread_t > threads;
+	for ( int i = 1; i < numThreads; i++ )
+	{
+		pthread_t thread;
+		const int createErr = pthread_create( &thread, NULL, DistortionRowWorkerThread, &rows );
+		if ( createErr != 0 )
+		{
+			LOG( "pthread_create returned %i", createErr );
+			break;
+		}
+		threads.PushBack( thread );
+	}
+
+	DistortionRowWorkerThread( &rows );
+
+	for ( int i = 0; i < threads.GetSizeI(); i++ )
+	{
+		pthread_join( threads[i], NULL );
+	}
+	return buf;
+}
+
 MemBuffer BuildDistortionBuffer( const hmdInfoInternal_t & hmdInfo,
 		int eyeBlocksWide, int eyeBlocksHigh )
+{
+	return BuildDistortionBuffer( hmdInfo, eyeBlocksWide, eyeBlocksHigh, Thread::GetCPUCount() );
+}
+
+//=============================================================================================
+// Distortion buffer cache
+//=============================================================================================
+
+// Bump this whenever the generated mesh changes, so old cache files are ignored.
+static const int DISTORTION_CACHE_VERSION = 1;
+
+static UInt64 HashBytes( UInt64 hash, const void * data, const int length )
+{
+	const UByte * bytes = (const UByte *)data;
+	for ( int i = 0; i < length; i++ )
+	{
+		hash = ( hash ^ bytes[i] ) * 0x100000001B3ULL;		// FNV-1a
+	}
+	return hash;
+}
+
+UInt64 DistortionBufferHash( const hmdInfoInternal_t & hmdInfo, int eyeBlocksWide, int eyeBlocksHigh )
+{
+	// hmdInfoInternal_t only holds 32 bit values, so there is no padding to worry about.
+	const int parms[3] = { DISTORTION_CACHE_VERSION, eyeBlocksWide, eyeBlocksHigh };
+	UInt64 hash = 0xCBF29CE484222325ULL;
+	hash = HashBytes( hash, &hmdInfo, sizeof( hmdInfo ) );
+	hash = HashBytes( hash, parms, sizeof( parms ) );
+	return hash;
+}
+
+static bool IsValidDistortionBuffer( const MemBuffer & buf, int eyeBlocksWide, int eyeBlocksHigh )
+{
+	const int vertexCount = 2 * ( eyeBlocksWide + 1 ) * ( eyeBlocksHigh + 1 );
+	if ( buf.Buffer == NULL || buf.Length != 12 + 4 * vertexCount * 6 )
+	{
+		return false;
+	}
+	const int * header = (const int *)buf.Buffer;
+	return header[0] == DISTORTION_BUFFER_MAGIC && header[1] == eyeBlocksWide && header[2] == eyeBlocksHigh;
+}
+
+MemBuffer LoadCachedDistortionBuffer( const hmdInfoInternal_t & hmdInfo,
+		int eyeBlocksWide, int eyeBlocksHigh, const char * cacheDirectory )
+{
+	if ( cacheDirectory == NULL || cacheDirectory[0] == '\0' )
+	{
+		return BuildDistortionBuffer( hmdInfo, eyeBlocksWide, eyeBlocksHigh );
+	}
+
+	const UInt64 hash = DistortionBufferHash( hmdInfo, eyeBlocksWide, eyeBlocksHigh );
+	char fileName[1024];
+	OVR_sprintf( fileName, sizeof( fileName ), "%sdistortion_%08x%08x.bin", cacheDirectory,
+			(UInt32)( hash >> 32 ), (UInt32)hash );
+
+	FILE * f = fopen( fileName, "rb" );
+	if ( f != NULL )
+	{
+		fclose( f );
+		MemBufferFile cached( fileName );
+		if ( IsValidDistortionBuffer( cached, eyeBlocksWide, eyeBlocksHigh ) )
+		{
+			return cached.ToMemBuffer();
+		}
+		LOG( "Ignoring invalid distortion cache file %s", fileName );
+	}
+
+	MemBuffer buf = BuildDistortionBuffer( hmdInfo, eyeBlocksWide, eyeBlocksHigh );
+
+	// Write to a temporary file first, so an interrupted write never leaves
+	// a truncated cache file behind.
+	char tempFileName[1024];
+	OVR_sprintf( tempFileName, sizeof( tempFileName ), "%s.tmp", fileName );
+	f = fopen( tempFileName, "wb" );
+	if ( f == NULL )
+	{
+		LOG( "Couldn't write distortion cache file %s", tempFileName );
+		return buf;
+	}
+	const bool written = ( fwrite( buf.Buffer, buf.Length, 1, f ) == 1 );
+	if ( fclose( f ) == 0 && written && rename( tempFileName, fileName ) == 0 )
+	{
+		LOG( "Wrote distortion cache file %s", fileName );
+	}
+	else
+	{
+		LOG( "Couldn't write distortion cache file %s", fileName );
+		remove( tempFileName );
+	}
+	return buf;
+}
+
+//=============================================================================================
+// Adaptive distortion mesh
+//=============================================================================================
+
+/*
+ * The distortion is nearly linear around the center of the lens, so a uniform
+ * grid spends most of its verts where they are not needed. The adaptive mesh
+ * is a quadtree over each eye that only splits a block when the two triangles
+ * that would cover it interpolate the distortion with more than the allowed
+ * error. The quadtree is balanced to at most one level of difference between
+ * neighbors, and a block next to a finer block is drawn as a fan around its
+ * center that includes the edge midpoints, so there are no T-junctions.
+ *
+ * The right eye mirrors the left eye, so the tree is only built once.
+ */
+
+// Blocks are in units of the finest level, the lattice has twice that resolution
+// so the block centers are on it as well.
+struct distortionBlock_t
+{
+	UInt16	x;
+	UInt16	y;
+	UInt16	depth;
+	UInt16	size;
+};
+
+// Close to the raster order of the display, like the uniform grid.
+static bool LeftEyeBlockOrder( const distortionBlock_t & a, const distortionBlock_t & b )
+{
+	return ( a.x != b.x ) ? ( a.x < b.x ) : ( a.y < b.y );
+}
+
+// The right eye is mirrored, so columns go from the right edge of the block.
+static bool RightEyeBlockOrder( const distortionBlock_t & a, const distortionBlock_t & b )
+{
+	return ( a.x + a.size != b.x + b.size ) ? ( a.x + a.size > b.x + b.size ) : ( a.y < b.y );
+}
+
+struct distortionTessellator_t
+{
+	const hmdInfoInternal_t *	hmdInfo;
+	float				aspect;
+	float				horizontalShiftView;
+	float				pixelsPerTanAngle;
+	float				maxTanAngle;	// edge of the eye texture
+	int					finestBlocks;	// blocks per side at the finest level
+	Array< UByte >		depths;			// depth of the block that covers each finest block
+};
+
+static void InitDistortionTessellator( distortionTessellator_t & tess, const hmdInfoInternal_t & hmdInfo, const int maxDepth )
+{
+	tess.hmdInfo = &hmdInfo;
+	tess.aspect = hmdInfo.widthPixels * 0.5 / hmdInfo.heightPixels;
+	const float	horizontalShiftMeters =  ( hmdInfo.lensSeparation / 2 ) - ( hmdInfo.widthMeters / 4 );
+	tess.horizontalShiftView = 2 * tess.aspect * horizontalShiftMeters / hmdInfo.widthMeters;
+	tess.pixelsPerTanAngle = DistortionMeshPixelsPerTanAngle( hmdInfo );
+	tess.maxTanAngle = tanf( DegreeToRad( hmdInfo.eyeTextureFov * 0.5f ) );
+	tess.finestBlocks = 1 << maxDepth;
+	tess.depths.Resize( tess.finestBlocks * tess.finestBlocks );
+}
+
+// Same as the verts of BuildDistortionBuffer() for xf, yf in [0,1].
+static void EvalDistortion( const distortionTessellator_t & tess, const int eye,
+		const float xf, const float yf, float v[6] )
+{
+	const float inTex[2] = { ( eye ? -tess.horizontalShiftView : tess.horizontalShiftView ) +
+			xf * tess.aspect + ( 1.0f - tess.aspect ) * 0.5f, yf };
+	WarpTexCoordChroma( *tess.hmdInfo, inTex, &v[0], &v[2], &v[4] );
+}
+
+// Largest distance between any of the color channels, in pixels. Pixels
+// that should not show the eye texture are black either way, and past the
+// edge of the texture the lens equations are not meant to be accurate, or
+// even continuous, so the error only counts where the exact green vector
+// is inside the eye texture.
+static float DistortionError( const distortionTessellator_t & tess, const float exact[6], const float b[6] )
+{
+	if ( fabsf( exact[2] ) > tess.maxTanAngle || fabsf( exact[3] ) > tess.maxTanAngle )
+	{
+		return 0.0f;
+	}
+	float maxSq = 0.0f;
+	for ( int i = 0; i < 6; i += 2 )
+	{
+		const float dx = exact[i+0] - b[i+0];
+		const float dy = exact[i+1] - b[i+1];
+		maxSq = Alg::Max( maxSq, dx * dx + dy * dy );
+	}
+	return sqrtf( maxSq ) * tess.pixelsPerTanAngle;
+}
+
+static void InterpolateTriangle( const float * v0, const float * v1, const float * v2,
+		const float b1, const float b2, float * out, const int count )
+{
+	for ( int i = 0; i < count; i++ )
+	{
+		out[i] = v0[i] + b1 * ( v1[i] - v0[i] ) + b2 * ( v2[i] - v0[i] );
+	}
+}
+
+// Largest error of linear interpolation over the triangle against the exact
+// distortion. The verts are xf, yf followed by the three color vectors.
+static float TriangleError( const distortionTessellator_t & tess, const int eye,
+		const float * v0, const float * v1, const float * v2 )
+{
+	const int SAMPLES = 4;
+	float maxError = 0.0f;
+	for ( int j = 0; j <= SAMPLES; j++ )
+	{
+		for ( int k = 0; j + k <= SAMPLES; k++ )
+		{
+			float lerped[DISTORTION_ADAPTIVE_VERTEX_FLOATS];
+			InterpolateTriangle( v0, v1, v2, (float)j / SAMPLES, (float)k / SAMPLES,
+					lerped, DISTORTION_ADAPTIVE_VERTEX_FLOATS );
+			float exact[6];
+			EvalDistortion( tess, eye, lerped[0], lerped[1], exact );
+			maxError = Alg::Max( maxError, DistortionError( tess, exact, lerped + 2 ) );
+		}
+	}
+	return maxError;
+}
+
+static void SetBlockDepth( distortionTessellator_t & tess, const distortionBlock_t & block )
+{
+	for ( int y = block.y; y < block.y + block.size; y++ )
+	{
+		for ( int x = block.x; x < block.x + block.size; x++ )
+		{
+			tess.depths[y * tess.finestBlocks + x] = (UByte)block.depth;
+		}
+	}
+}
+
+// Depth of the block that covers the finest block, 0 if it is
+// not known yet, or -1 outside the eye.
+static int NeighborDepth( const distortionTessellator_t & tess, const int x, const int y )
+{
+	if ( x < 0 || y < 0 || x >= tess.finestBlocks || y >= tess.finestBlocks )
+	{
+		return -1;
+	}
+	return tess.depths[y * tess.finestBlocks + x];
+}
+
+// Flip the triangulation in opposite corners, like the uniform grid,
+// so the diagonals run across the radial direction.
+static bool BlockUsesMainDiagonal( const distortionTessellator_t & tess, const distortionBlock_t & block )
+{
+	const int center2 = tess.finestBlocks;
+	return ( 2 * block.x + block.size < center2 ) ^ ( 2 * block.y + block.size < center2 );
+}
+
+// The counter clockwise triangles that cover the block, on the lattice of the
+// left eye, where the eye is twice the finest blocks wide. A block next to a
+// finer block is a fan around its center that includes the midpoint of the
+// shared edge, which is a corner of the finer blocks once the tree is balanced.
+// Returns the number of triangles.
+static int GetBlockTriangles( const distortionTessellator_t & tess, const distortionBlock_t & block,
+		int tris[8][3][2] )
+{
+	const int size = block.size;
+	const int x0 = 2 * block.x;
+	const int x1 = x0 + 2 * size;
+	const int y0 = 2 * block.y;
+	const int y1 = y0 + 2 * size;
+	const int xm = ( x0 + x1 ) >> 1;
+	const int ym = ( y0 + y1 ) >> 1;
+
+	const bool midBottom = NeighborDepth( tess, block.x, block.y - 1 ) > block.depth;
+	const bool midRight = NeighborDepth( tess, block.x + size, block.y ) > block.depth;
+	const bool midTop = NeighborDepth( tess, block.x, block.y + size ) > block.depth;
+	const bool midLeft = NeighborDepth( tess, block.x - 1, block.y ) > block.depth;
+
+	if ( !midBottom && !midRight && !midTop && !midLeft )
+	{
+		const bool mainDiagonal = BlockUsesMainDiagonal( tess, block );
+		const int quad[2][2][3][2] =
+		{
+			{ { { x0, y0 }, { x1, y0 }, { x0, y1 } }, { { x0, y1 }, { x1, y0 }, { x1, y1 } } },
+			{ { { x0, y0 }, { x1, y0 }, { x1, y1 } }, { { x0, y0 }, { x1, y1 }, { x0, y1 } } }
+		};
+		memcpy( tris, quad[mainDiagonal], sizeof( quad[0] ) );
+		return 2;
+	}
+
+	// Counter clockwise from the lower left corner.
+	int ring[8][2];
+	int ringCount = 0;
+	ring[ringCount][0] = x0; ring[ringCount][1] = y0; ringCount++;
+	if ( midBottom ) { ring[ringCount][0] = xm; ring[ringCount][1] = y0; ringCount++; }
+	ring[ringCount][0] = x1; ring[ringCount][1] = y0; ringCount++;
+	if ( midRight ) { ring[ringCount][0] = x1; ring[ringCount][1] = ym; ringCount++; }
+	ring[ringCount][0] = x1; ring[ringCount][1] = y1; ringCount++;
+	if ( midTop ) { ring[ringCount][0] = xm; ring[ringCount][1] = y1; ringCount++; }
+	ring[ringCount][0] = x0; ring[ringCount][1] = y1; ringCount++;
+	if ( midLeft ) { ring[ringCount][0] = x0; ring[ringCount][1] = ym; ringCount++; }
+
+	for ( int i = 0; i < ringCount; i++ )
+	{
+		const int next = ( i + 1 ) % ringCount;
+		tris[i][0][0] = xm;				tris[i][0][1] = ym;
+		tris[i][1][0] = ring[i][0];		tris[i][1][1] = ring[i][1];
+		tris[i][2][0] = ring[next][0];	tris[i][2][1] = ring[next][1];
+	}
+	return ringCount;
+}
+
+static void EvalLatticeVert( const distortionTessellator_t & tess, const int eye,
+		const int x, const int y, float v[DISTORTION_ADAPTIVE_VERTEX_FLOATS] )
+{
+	v[0] = (float)x / ( 2 * tess.finestBlocks );
+	v[1] = (float)y / ( 2 * tess.finestBlocks );
+	EvalDistortion( tess, eye, v[0], v[1], v + 2 );
+}
+
+// Largest error of the triangles that currently cover the block.
+static float BlockError( const distortionTessellator_t & tess, const distortionBlock_t & block )
+{
+	int tris[8][3][2];
+	const int numTris = GetBlockTriangles( tess, block, tris );
+	float maxError = 0.0f;
+	for ( int i = 0; i < numTris; i++ )
+	{
+		float v[3][DISTORTION_ADAPTIVE_VERTEX_FLOATS];
+		for ( int j = 0; j < 3; j++ )
+		{
+			EvalLatticeVert( tess, 0, tris[i][j][0], tris[i][j][1], v[j] );
+		}
+		maxError = Alg::Max( maxError, TriangleError( tess, 0, v[0], v[1], v[2] ) );
+	}
+	return maxError;
+}
+
+static void SplitBlock( const distortionBlock_t & block, Array< distortionBlock_t > & blocks )
+{
+	const int half = block.size >> 1;
+	for ( int i = 0; i < 4; i++ )
+	{
+		distortionBlock_t child;
+		child.x = (UInt16)( block.x + ( i & 1 ) * half );
+		child.y = (UInt16)( block.y + ( i >> 1 ) * half );
+		child.depth = (UInt16)( block.depth + 1 );
+		child.size = (UInt16)half;
+		blocks.PushBack( child );
+	}
+}
+
+static void BuildDistortionBlocks( distortionTessellator_t & tess, const float maxErrorPixels,
+		const int minDepth, const int maxDepth, Array< distortionBlock_t > & leaves )
+{
+	// Split until the error is small enough.
+	Array< distortionBlock_t > pending;
+	const int minBlocks = 1 << minDepth;
+	const int minSize = tess.finestBlocks >> minDepth;
+	for ( int y = 0; y < minBlocks; y++ )
+	{
+		for ( int x = 0; x < minBlocks; x++ )
+		{
+			distortionBlock_t block;
+			block.x = (UInt16)( x * minSize );
+			block.y = (UInt16)( y * minSize );
+			block.depth = (UInt16)minDepth;
+			block.size = (UInt16)minSize;
+			pending.PushBack( block );
+		}
+	}
+	memset( &tess.depths[0], 0, tess.depths.GetSize() );
+	leaves.Clear();
+	while ( pending.GetSizeI() > 0 )
+	{
+		const distortionBlock_t block = pending.Pop();
+		if ( block.depth < maxDepth && BlockError( tess, block ) > maxErrorPixels )
+		{
+			SplitBlock( block, pending );
+		}
+		else
+		{
+			SetBlockDepth( tess, block );
+			leaves.PushBack( block );
+		}
+	}
+
+	for ( ; ; )
+	{
+		// Split blocks that are more than one level coarser than a neighbor,
+		// until nothing changes.
+		for ( bool changed = true; changed; )
+		{
+			changed = false;
+			Array< distortionBlock_t > balanced;
+			for ( int i = 0; i < leaves.GetSizeI(); i++ )
+			{
+				const distortionBlock_t & block = leaves[i];
+				const int size = block.size;
+				bool split = false;
+				for ( int j = 0; j < size && !split; j++ )
+				{
+					split = NeighborDepth( tess, block.x + j, block.y - 1 ) > block.depth + 1 ||
+							NeighborDepth( tess, block.x + j, block.y + size ) > block.depth + 1 ||
+							NeighborDepth( tess, block.x - 1, block.y + j ) > block.depth + 1 ||
+							NeighborDepth( tess, block.x + size, block.y + j ) > block.depth + 1;
+				}
+				if ( split )
+				{
+					const int first = balanced.GetSizeI();
+					SplitBlock( block, balanced );
+					for ( int j = first; j < balanced.GetSizeI(); j++ )
+					{
+						SetBlockDepth( tess, balanced[j] );
+					}
+					changed = true;
+				}
+				else
+				{
+					balanced.PushBack( block );
+				}
+			}
+			leaves = balanced;
+		}
+
+		// Blocks next to finer blocks turned into fans, and balancing made
+		// blocks that were never checked, so check them all again.
+		bool refined = false;
+		Array< distortionBlock_t > checked;
+		for ( int i = 0; i < leaves.GetSizeI(); i++ )
+		{
+			const distortionBlock_t & block = leaves[i];
+			if ( block.depth < maxDepth && BlockError( tess, block ) > maxErrorPixels )
+			{
+				const int first = checked.GetSizeI();
+				SplitBlock( block, checked );
+				for ( int j = first; j < checked.GetSizeI(); j++ )
+				{
+					SetBlockDepth( tess, checked[j] );
+				}
+				refined = true;
+			}
+			else
+			{
+				checked.PushBack( block );
+			}
+		}
+		leaves = checked;
+		if ( !refined )
+		{
+			break;
+		}
+	}
+}
+
+struct distortionMeshBuilder_t
+{
+	const distortionTessellator_t *	tess;
+	int					eye;
+	Array< int >		latticeVerts;	// vert number of each lattice point, -1 if not used yet
+	Array< float >		verts;			// both eyes, xf, yf, red, green, blue
+	Array< UInt16 >		indices;
+};
+
+// x and y are on the lattice of the eye that is being built.
+static int AddLatticeVert( distortionMeshBuilder_t & mesh, const int x, const int y )
+{
+	const int latticeSize = 2 * mesh.tess->finestBlocks + 1;
+	int & vert = mesh.latticeVerts[y * latticeSize + x];
+	if ( vert < 0 )
+	{
+		vert = mesh.verts.GetSizeI() / DISTORTION_ADAPTIVE_VERTEX_FLOATS;
+		float v[DISTORTION_ADAPTIVE_VERTEX_FLOATS];
+		EvalLatticeVert( *mesh.tess, mesh.eye, x, y, v );
+		for ( int i = 0; i < DISTORTION_ADAPTIVE_VERTEX_FLOATS; i++ )
+		{
+			mesh.verts.PushBack( v[i] );
+		}
+	}
+	return vert;
+}
+
+static void AddBlockTriangles( distortionMeshBuilder_t & mesh, const distortionBlock_t & block )
+{
+	int tris[8][3][2];
+	const int numTris = GetBlockTriangles( *mesh.tess, block, tris );
+	const int latticeMax = 2 * mesh.tess->finestBlocks;
+	for ( int i = 0; i < numTris; i++ )
+	{
+		int verts[3];
+		for ( int j = 0; j < 3; j++ )
+		{
+			// The right eye is the mirror image of the left eye.
+			const int x = mesh.eye ? latticeMax - tris[i][j][0] : tris[i][j][0];
+			verts[j] = AddLatticeVert( mesh, x, tris[i][j][1] );
+		}
+		// Mirroring reverses the winding.
+		mesh.indices.PushBack( (UInt16)verts[0] );
+		mesh.indices.PushBack( (UInt16)verts[mesh.eye ? 2 : 1] );
+		mesh.indices.PushBack( (UInt16)verts[mesh.eye ? 1 : 2] );
+	}
+}
+
+float DistortionMeshPixelsPerTanAngle( const hmdInfoInternal_t & hmdInfo )
+{
+	return hmdInfo.lens.MetersPerTanAngleAtCenter * hmdInfo.widthPixels / hmdInfo.widthMeters;
+}
+
+MemBuffer BuildAdaptiveDistortionBuffer( const hmdInfoInternal_t & hmdInfo,
+		const float maxErrorPixels, int minDepth, int maxDepth )
+{
+	maxDepth = Alg::Clamp( maxDepth, 1, DISTORTION_ADAPTIVE_MAX_DEPTH );
+	minDepth = Alg::Clamp( minDepth, 1, maxDepth );
+
+	distortionTessellator_t tess;
+	InitDistortionTessellator( tess, hmdInfo, maxDepth );
+
+	Array< distortionBlock_t > blocks;
+	BuildDistortionBlocks( tess, maxErrorPixels, minDepth, maxDepth, blocks );
+
+	distortionMeshBuilder_t mesh;
+	mesh.tess = &tess;
+	const int latticeSize = 2 * tess.finestBlocks + 1;
+	for ( int eye = 0; eye < 2; eye++ )
+	{
+		mesh.eye = eye;
+		mesh.latticeVerts.Resize( latticeSize * latticeSize );
+		for ( int i = 0; i < mesh.latticeVerts.GetSizeI(); i++ )
+		{
+			mesh.latticeVerts[i] = -1;
+		}
+		Alg::QuickSortSliced( blocks, 0, blocks.GetSize(), eye ? RightEyeBlockOrder : LeftEyeBlockOrder );
+		for ( int i = 0; i < blocks.GetSizeI(); i++ )
+		{
+			AddBlockTriangles( mesh, blocks[i] );
+		}
+	}
+
+	const int numVerts = mesh.verts.GetSizeI() / DISTORTION_ADAPTIVE_VERTEX_FLOATS;
+	if ( numVerts > 65536 )
+	{
+		LOG( "BuildAdaptiveDistortionBuffer: %i verts don't fit 16 bit indices", numVerts );
+		return MemBuffer();
+	}
+
+	const int numIndices = mesh.indices.GetSizeI();
+	const int vertBytes = numVerts * DISTORTION_ADAPTIVE_VERTEX_FLOATS * sizeof( float );
+	MemBuffer buf( 12 + vertBytes + numIndices * sizeof( UInt16 ) );
+	((int *)buf.Buffer)[0] = DISTORTION_ADAPTIVE_BUFFER_MAGIC;
+	((int *)buf.Buffer)[1] = numVerts;
+	((int *)buf.Buffer)[2] = numIndices;
+	memcpy( (UByte *)buf.Buffer + 12, &mesh.verts[0], vertBytes );
+	memcpy( (UByte *)buf.Buffer + 12 + vertBytes, &mesh.indices[0], numIndices * sizeof( UInt16 ) );
+	return buf;
+}
+
+float MeasureDistortionBufferError( const hmdInfoInternal_t & hmdInfo, const MemBuffer & buf )
+{
+	distortionTessellator_t tess;
+	InitDistortionTessellator( tess, hmdInfo, 0 );
+
+	Array< float > verts;
+	Array< int > indices;
+	const int * header = (const int *)buf.Buffer;
+	if ( buf.Length >= 12 && header[0] == DISTORTION_BUFFER_MAGIC )
+	{
+		// Same triangles as LoadMeshFromMemory() with a single slice.
+		const int blocksWide = header[1];
+		const int blocksHigh = header[2];
+		const float * tanAngles = (const float *)buf.Buffer + 3;
+		for ( int eye = 0; eye < 2; eye++ )
+		{
+			for ( int y = 0; y <= blocksHigh; y++ )
+			{
+				for ( int x = 0; x <= blocksWide; x++ )
+				{
+					verts.PushBack( (float)x / blocksWide );
+					verts.PushBack( (float)y / blocksHigh );
+					const float * v = &tanAngles[( y * ( blocksWide + 1 ) * 2 + eye * ( blocksWide + 1 ) + x ) * 6];
+					for ( int i = 0; i < 6; i++ )
+					{
+						verts.PushBack( v[i] );
+					}
+				}
+			}
+			const int base = eye * ( blocksWide + 1 ) * ( blocksHigh + 1 );
+			for ( int x = 0; x < blocksWide; x++ )
+			{
+				for ( int y = 0; y < blocksHigh; y++ )
+				{
+					const int v00 = base + y * ( blocksWide + 1 ) + x;
+					const int v10 = v00 + 1;
+					const int v01 = v00 + blocksWide + 1;
+					const int v11 = v01 + 1;
+					const int tris[2][2][3] = { { { v00, v10, v11 }, { v00, v11, v01 } },
+												{ { v00, v10, v01 }, { v01, v10, v11 } } };
+					const int flip = !( ( x < blocksWide / 2 ) ^ ( y < blocksHigh / 2 ) );
+					for ( int i = 0; i < 6; i++ )
+					{
+						indices.PushBack( tris[flip][i / 3][i % 3] );
+					}
+				}
+			}
+		}
+	}
+	else if ( buf.Length >= 12 && header[0] == DISTORTION_ADAPTIVE_BUFFER_MAGIC )
+	{
+		const int numVerts = header[1];
+		const int numIndices = header[2];
+		const float * v = (const float *)( (const UByte *)buf.Buffer + 12 );
+		const UInt16 * idx = (const UInt16 *)( v + numVerts * DISTORTION_ADAPTIVE_VERTEX_FLOATS );
+		verts.Resize( numVerts * DISTORTION_ADAPTIVE_VERTEX_FLOATS );
+		memcpy( &verts[0], v, verts.GetSizeI() * sizeof( float ) );
+		for ( int i = 0; i < numIndices; i++ )
+		{
+			indices.PushBack( idx[i] );
+		}
+	}
+	else
+	{
+		return -1.0f;
+	}
+
+	// Both eyes have the same number of triangles.
+	const int eyeIndices = indices.GetSizeI() / 2;
+	float maxError = 0.0f;
+	for ( int i = 0; i < indices.GetSizeI(); i += 3 )
+	{
+		maxError = Alg::Max( maxError, TriangleError( tess, ( i >= eyeIndices ),
+				&verts[indices[i+0] * DISTORTION_ADAPTIVE_VERTEX_FLOATS],
+				&verts[indices[i+1] * DISTORTION_ADAPTIVE_VERTEX_FLOATS],
+				&verts[indices[i+2] * DISTORTION_ADAPTIVE_VERTEX_FLOATS] ) );
+	}
+	return maxError;
+}
+
+//=============================================================================================
+// Distortion benchmark
+//=============================================================================================
+
+// The original single threaded, one vert at a time mesh generation.
+static MemBuffer BuildDistortionBufferReference( const hmdInfoInternal_t & hmdInfo,
+		int eyeBlocksWide, int eyeBlocksHigh )
 {
 	const int vertexCount = 2 * ( eyeBlocksWide + 1 ) * ( eyeBlocksHigh + 1 );
 	MemBuffer	buf( 12 + 4 * vertexCount * 6 );
@@ -149,4 +1071,172 @@ MemBuffer BuildDistortionBuffer( const hmdInfoInternal_t & hmdInfo,
 	return buf;
 }
 
+// Returns the largest difference in ulp between the reciprocal polynomials of
+// DistortionFnScaleRadiusSquared4() and the scalar 1.0f / x, over every float in
+// [1,2), which covers the normal range because a power of two only changes the
+// exponent. Each lane gets a constant segment, so the polynomial is x exactly.
+static int MaxReciprocalUlpError()
+{
+	union float4_t
+	{
+		float	f[4];
+		UInt32	u[4];
+	};
+
+	distortionFn_t fn;
+	memset( &fn, 0, sizeof( fn ) );
+	fn.spline = true;
+	fn.reciprocal = true;
+	fn.segmentsPerRsq = 1.0f;
+	fn.maxSegment = 3;
+	const float rsq[4] = { 0.0f, 1.0f, 2.0f, 3.0f };
+
+	int maxUlp = 0;
+	for ( UInt32 bits = 0x3F800000; bits < 0x40000000; bits += 4 )
+	{
+		float4_t x;
+		float4_t scale;
+		for ( int i = 0; i < 4; i++ )
+		{
+			x.u[i] = bits + i;
+			fn.coefficients[i][0] = x.f[i];
+		}
+		DistortionFnScaleRadiusSquared4( fn, rsq, scale.f );
+		for ( int i = 0; i < 4; i++ )
+		{
+			float4_t d;
+			d.f[0] = 1.0f / x.f[i];
+			maxUlp = Alg::Max( maxUlp, Alg::Abs( (int)( scale.u[i] - d.u[0] ) ) );
+		}
+	}
+	return maxUlp;
+}
+
+void DistortionBenchmark( void * appPtr, const char * cmd )
+{
+	int eyeBlocksWide = 64;
+	int eyeBlocksHigh = 72;
+	char cacheDirectory[1024] = {};
+	sscanf( cmd, "%i %i %1023s", &eyeBlocksWide, &eyeBlocksHigh, cacheDirectory );
+	eyeBlocksWide = Alg::Max( eyeBlocksWide, 1 );
+	eyeBlocksHigh = Alg::Max( eyeBlocksHigh, 1 );
+
+	LOG( "distortionBenchmark: %dx%d blocks per eye, %d threads", eyeBlocksWide, eyeBlocksHigh, Thread::GetCPUCount() );
+
+	int totalErrors = 0;
+	for ( int type = 0; type < GetNumKnownHmdTypes(); type++ )
+	{
+		const hmdInfoInternal_t hmdInfo = GetKnownHmdInfo( type );
+
+		const double start = LogCpuTime::GetNanoSeconds();
+		MemBuffer reference = BuildDistortionBufferReference( hmdInfo, eyeBlocksWide, eyeBlocksHigh );
+		const double referenceEnd = LogCpuTime::GetNanoSeconds();
+		MemBuffer simd = BuildDistortionBuffer( hmdInfo, eyeBlocksWide, eyeBlocksHigh, 1 );
+		const double simdEnd = LogCpuTime::GetNanoSeconds();
+		MemBuffer threaded = BuildDistortionBuffer( hmdInfo, eyeBlocksWide, eyeBlocksHigh );
+		const double threadedEnd = LogCpuTime::GetNanoSeconds();
+
+		// Relative to the size of the tan angles, which go up to about 2. Past the
+		// last spline knot, the Hermite evaluation in the reference loses a few
+		// bits that the power basis keeps, so this is not a bit exact comparison.
+		const int numFloats = ( reference.Length - 12 ) / 4;
+		const float * r = (const float *)reference.Buffer + 3;
+		const float * s = (const float *)simd.Buffer + 3;
+		const float * t = (const float *)threaded.Buffer + 3;
+		float maxError = 0.0f;
+		int errors = 0;
+		for ( int i = 0; i < numFloats; i++ )
+		{
+			const float error = Alg::Max( fabsf( s[i] - r[i] ), fabsf( t[i] - r[i] ) );
+			maxError = Alg::Max( maxError, error );
+			errors += ( error > 1e-4f * Alg::Max( 1.0f, fabsf( r[i] ) ) );
+		}
+		totalErrors += errors;
+
+		LOG( "distortionBenchmark: %-20s reference %6.2f ms, simd %6.2f ms, threaded %6.2f ms, max error %.2e, %d errors",
+				GetKnownHmdTypeName( type ), ( referenceEnd - start ) * 1e-6,
+				( simdEnd - referenceEnd ) * 1e-6, ( threadedEnd - simdEnd ) * 1e-6, maxError, errors );
+
+		if ( cacheDirectory[0] != '\0' )
+		{
+			// The first load may have to build and write the file, the second one has to hit the cache.
+			const double cacheStart = LogCpuTime::GetNanoSeconds();
+			MemBuffer first = LoadCachedDistortionBuffer( hmdInfo, eyeBlocksWide, eyeBlocksHigh, cacheDirectory );
+			const double cacheMiddle = LogCpuTime::GetNanoSeconds();
+			MemBuffer second = LoadCachedDistortionBuffer( hmdInfo, eyeBlocksWide, eyeBlocksHigh, cacheDirectory );
+			const double cacheEnd = LogCpuTime::GetNanoSeconds();
+			const bool same = ( first.Length == threaded.Length && second.Length == threaded.Length &&
+					memcmp( first.Buffer, threaded.Buffer, threaded.Length ) == 0 &&
+					memcmp( second.Buffer, threaded.Buffer, threaded.Length ) == 0 );
+			totalErrors += !same;
+			LOG( "distortionBenchmark: %-20s cache first load %6.2f ms, cached load %6.2f ms%s",
+					GetKnownHmdTypeName( type ), ( cacheMiddle - cacheStart ) * 1e-6,
+					( cacheEnd - cacheMiddle ) * 1e-6, same ? "" : ", MISMATCH" );
+			first.FreeData();
+			second.FreeData();
+		}
+
+		reference.FreeData();
+		simd.FreeData();
+		threaded.FreeData();
+	}
+
+	// The reciprocal lens equations can't match the scalar divide exactly with NEON.
+	const int reciprocalUlp = MaxReciprocalUlpError();
+	totalErrors += ( reciprocalUlp > 2 );
+	LOG( "distortionBenchmark: reciprocal within %d ulp of the divide", reciprocalUlp );
+
+	LOG( "distortionBenchmark: %s, %d errors", totalErrors == 0 ? "PASSED" : "FAILED", totalErrors );
 }
+
+void DistortionMeshReport( void * appPtr, const char * cmd )
+{
+	float maxErrorPixels = 0.5f;
+	int maxDepth = DISTORTION_ADAPTIVE_MAX_DEPTH;
+	sscanf( cmd, "%f %i", &maxErrorPixels, &maxDepth );
+	maxDepth = Alg::Clamp( maxDepth, 2, DISTORTION_ADAPTIVE_MAX_DEPTH );
+
+	LOG( "distortionMeshReport: max error %4.2f pixels, max depth %d", maxErrorPixels, maxDepth );
+
+	for ( int type = 0; type < GetNumKnownHmdTypes(); type++ )
+	{
+		const hmdInfoInternal_t hmdInfo = GetKnownHmdInfo( type );
+
+		// The grid that TimeWarp builds by default.
+		MemBuffer uniform = BuildDistortionBuffer( hmdInfo, 32, 32 );
+		const float uniformError = MeasureDistortionBufferError( hmdInfo, uniform );
+		uniform.FreeData();
+		LOG( "distortionMeshReport: %-20s uniform   32x32 %6d verts, max error %6.3f pixels",
+				GetKnownHmdTypeName( type ), 2 * 33 * 33, uniformError );
+
+		// The coarsest square grid that meets the error bound.
+		for ( int blocks = 4; blocks <= ( 1 << maxDepth ); blocks *= 2 )
+		{
+			MemBuffer grid = BuildDistortionBuffer( hmdInfo, blocks, blocks );
+			const float gridError = MeasureDistortionBufferError( hmdInfo, grid );
+			grid.FreeData();
+			if ( gridError <= maxErrorPixels || blocks == ( 1 << maxDepth ) )
+			{
+				LOG( "distortionMeshReport: %-20s uniform %3dx%-3d %6d verts, max error %6.3f pixels",
+						GetKnownHmdTypeName( type ), blocks, blocks, 2 * ( blocks + 1 ) * ( blocks + 1 ), gridError );
+				break;
+			}
+		}
+
+		const double start = LogCpuTime::GetNanoSeconds();
+		MemBuffer adaptive = BuildAdaptiveDistortionBuffer( hmdInfo, maxErrorPixels, 2, maxDepth );
+		const double end = LogCpuTime::GetNanoSeconds();
+		if ( adaptive.Buffer == NULL )
+		{
+			continue;
+		}
+		const int numVerts = ((int *)adaptive.Buffer)[1];
+		const int numIndices = ((int *)adaptive.Buffer)[2];
+		const float adaptiveError = MeasureDistortionBufferError( hmdInfo, adaptive );
+		adaptive.FreeData();
+		LOG( "distortionMeshReport: %-20s adaptive        %6d verts, max error %6.3f pixels, %d triangles, built in %5.2f ms",
+				GetKnownHmdTypeName( type ), numVerts, adaptiveError, numIndices / 3, ( end - start ) * 1e-6 );
+	}
+}
+
+}	// namespace OVR
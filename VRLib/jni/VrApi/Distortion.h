@@ -47,9 +47,69 @@ namespace OVR
 
 static const int DISTORTION_BUFFER_MAGIC = 0x56347805;
 
+// The distortion function is evaluated four verts at a time with SIMD,
+// and large meshes are built by all cores, one row of one eye at a time.
 MemBuffer BuildDistortionBuffer( const hmdInfoInternal_t & hmdInfo,
 		int eyeBlocksWide, int eyeBlocksHigh );
 
+// Identifies the mesh that BuildDistortionBuffer() returns for these parameters.
+UInt64 DistortionBufferHash( const hmdInfoInternal_t & hmdInfo,
+		int eyeBlocksWide, int eyeBlocksHigh );
+
+// Loads the mesh from "<cacheDirectory>distortion_<hash>.bin", or builds it and
+// writes that file if it is missing or invalid. The cacheDirectory should end
+// with a slash. With a NULL or empty cacheDirectory this just builds the mesh.
+MemBuffer LoadCachedDistortionBuffer( const hmdInfoInternal_t & hmdInfo,
+		int eyeBlocksWide, int eyeBlocksHigh, const char * cacheDirectory );
+
+/*
+ The adaptive buffer covers the screen with an indexed mesh that is only
+ as fine as it needs to be to stay within an error bound:
+
+ int	magic
+ int	vertexCount
+ int	indexCount
+
+ // The left eye verts, then the right eye verts.
+ // xy is the position in the eye from 0,0 (lower left) to 1,1 (upper right),
+ // followed by the xy vectors for red, green, and blue channels.
+ float	verts[vertexCount][8]
+
+ // The left eye triangles, then the same number of right eye triangles.
+ unsigned short	indices[indexCount]
+ */
+
+static const int DISTORTION_ADAPTIVE_BUFFER_MAGIC = 0x56347806;
+static const int DISTORTION_ADAPTIVE_VERTEX_FLOATS = 8;
+static const int DISTORTION_ADAPTIVE_MAX_DEPTH = 7;
+
+// The error is measured in screen pixels at the center of the lens.
+float DistortionMeshPixelsPerTanAngle( const hmdInfoInternal_t & hmdInfo );
+
+// Splits the blocks of a quadtree over each eye, from 1 << minDepth to at most
+// 1 << maxDepth blocks wide, until linear interpolation over the triangles
+// is within maxErrorPixels of the distortion. Returns an empty buffer if
+// the mesh does not fit 16 bit indices.
+MemBuffer BuildAdaptiveDistortionBuffer( const hmdInfoInternal_t & hmdInfo,
+		const float maxErrorPixels, int minDepth, int maxDepth );
+
+// Largest error in pixels of either kind of distortion buffer, sampled
+// over each triangle, or -1 if the buffer is not a distortion buffer.
+float MeasureDistortionBufferError( const hmdInfoInternal_t & hmdInfo, const MemBuffer & buf );
+
+// Logs the time to build the mesh for each known HMD, one vert at a time,
+// with SIMD and with SIMD on all cores, and the differences between them.
+// Registered as the "distortionBenchmark" console command, optional parms:
+// "<eyeBlocksWide> <eyeBlocksHigh> <cacheDirectory>"
+// If a cacheDirectory is given, the cached load is timed and verified as well.
+void DistortionBenchmark( void * appPtr, const char * cmd );
+
+// Logs the vertex count and the measured error of the default uniform grid,
+// the coarsest uniform grid within the error bound and the adaptive mesh for
+// each known HMD. Registered as the "distortionMeshReport" console command,
+// optional parms: "<maxErrorPixels> <maxDepth>"
+void DistortionMeshReport( void * appPtr, const char * cmd );
+
 }	// namespace OVR
 
 #endif	// OVR_Distortion_h
@@ -450,4 +450,51 @@ hmdInfoInternal_t GetDeviceHmdInfo( JNIEnv *env, jobject activity, jclass vrActi
     return hmdInfo;
 }
 
+struct knownHmd_t
+{
+	hmdType_t		type;
+	const char *	name;
+	float			widthMeters;	// landscape
+	float			heightMeters;
+	int				widthPixels;
+	int				heightPixels;
+};
+
+static const knownHmd_t KnownHmds[] =
+{
+	{ HMD_GALAXY_OCULUS,	"HMD_GALAXY_OCULUS",	0.11047f, 0.06214f, 1920, 1080 },
+	{ HMD_S4_GALAXY,		"HMD_S4_GALAXY",		0.11047f, 0.06214f, 1920, 1080 },
+	{ HMD_NOTE,				"HMD_NOTE",				0.12640f, 0.07110f, 1920, 1080 },
+	{ HMD_NOTE_4,			"HMD_NOTE_4",			0.12500f, 0.07070f, 2560, 1440 },
+	{ HMD_PM_GALAXY,		"HMD_PM_GALAXY",		0.11290f, 0.06350f, 1920, 1080 },
+	{ HMD_QM_GALAXY,		"HMD_QM_GALAXY",		0.11290f, 0.06350f, 1920, 1080 },
+	{ HMD_PM_GALAXY_WQHD,	"HMD_PM_GALAXY_WQHD",	0.11290f, 0.06350f, 2560, 1440 },
+	{ HMD_QM_GALAXY_WQHD,	"HMD_QM_GALAXY_WQHD",	0.11290f, 0.06350f, 2560, 1440 }
+};
+
+int GetNumKnownHmdTypes()
+{
+	return sizeof( KnownHmds ) / sizeof( KnownHmds[0] );
+}
+
+const char * GetKnownHmdTypeName( const int index )
+{
+	return KnownHmds[index].name;
+}
+
+hmdInfoInternal_t GetKnownHmdInfo( const int index )
+{
+	const knownHmd_t & known = KnownHmds[index];
+	hmdInfoInternal_t hmdInfo = GetHmdInfo( known.type );
+	// Same as GetDeviceHmdInfo(), only use the screen size if the type doesn't set it.
+	if ( hmdInfo.widthMeters == 0 )
+	{
+		hmdInfo.widthMeters = known.widthMeters;
+		hmdInfo.heightMeters = known.heightMeters;
+	}
+	hmdInfo.widthPixels = known.widthPixels;
+	hmdInfo.heightPixels = known.heightPixels;
+	return hmdInfo;
+}
+
 }
@@ -53,6 +53,12 @@ struct hmdInfoInternal_t
 hmdInfoInternal_t	GetDeviceHmdInfo( JNIEnv *env, jobject activity, jclass vrActivityClass,
 	ovrHmd hmd, const char * buildModel);
 
+// For tools and benchmarks that run without the device: the info of each known
+// HMD type, with the screen of the phone that goes with it.
+int					GetNumKnownHmdTypes();
+const char *		GetKnownHmdTypeName( const int index );
+hmdInfoInternal_t	GetKnownHmdInfo( const int index );
+
 }
 
 #endif	// OVR_HmdInfo_h
@@ -25,10 +25,12 @@ Copyright   :   Copyright 2014 Oculus VR, LLC. All Rights reserved.
 #include <sched.h>
 #include <unistd.h>
 #include <poll.h>
+#include <stdio.h>
 
 
 #include "OVR_CAPI.h"		// for TimeInSeconds()
 #include "Log.h"
+#include "Kernel/OVR_Alg.h"
 
 namespace OVR {
 
@@ -192,6 +194,26 @@ int BindToPort( const int sock, const int port )
 	}
 }
 
+// Returns the number of bytes written, which is less than bytes on error.
+static int WriteAll( const int sock, const void * data, const int bytes )
+{
+	int written = 0;
+	while ( written < bytes )
+	{
+		const int w = write( sock, (const char *)data + written, bytes - written );
+		if ( w <= 0 )
+		{
+			if ( w == -1 && errno == EINTR )
+			{
+				continue;
+			}
+			break;
+		}
+		written += w;
+	}
+	return written;
+}
+
 //static short	testData[256*256];
 
 void ImageServer::ServerThread()
@@ -367,8 +389,19 @@ void ImageServer::ServerThread()
 			data[r] = 0;
 			ImageServerRequest	isr;
 
-			isr.Resolution = atoi( data );
-			if ( isr.Resolution < 64 || isr.Resolution > 2048 )
+			// A raw request is just the resolution, a stream request is
+			// "s<resolution> <sequence of the last frame the client decoded>".
+			const bool stream = ( data[0] == 's' );
+			unsigned int clientSequence = 0;
+			if ( stream )
+			{
+				sscanf( data + 1, "%i %u", &isr.Resolution, &clientSequence );
+			}
+			else
+			{
+				isr.Resolution = atoi( data );
+			}
+			if ( isr.Resolution < 64 || isr.Resolution > IMAGE_STREAM_MAX_RESOLUTION )
 			{
 				LOG( "Rejecting resolution request: %s", data );
 				close( TcpClientSocket );
@@ -402,8 +435,17 @@ void ImageServer::ServerThread()
 				continue;
 			}
 
-			const int bytes = resp.Resolution * resp.Resolution * 2;
-			const int w = write( TcpClientSocket, resp.Data, bytes );
+			const void * sendData = resp.Data;
+			int bytes = resp.Resolution * resp.Resolution * 2;
+			if ( stream )
+			{
+				// Only send a delta if the client has the frame it is a delta of.
+				const bool keyFrame = ( clientSequence == 0 || clientSequence != StreamEncoder.GetSequence() );
+				const Array< UByte > & message = StreamEncoder.Encode( (const UInt16 *)resp.Data, resp.Resolution, keyFrame );
+				sendData = &message[0];
+				bytes = message.GetSizeI();
+			}
+			const int w = WriteAll( TcpClientSocket, sendData, bytes );
 			if ( w != bytes )
 			{
 				LOG( "Only write %i of %i bytes", w, bytes );
@@ -605,5 +647,233 @@ void	ImageServer::LeaveWarpSwap()
 	pthread_cond_signal( &ResponseCondition );
 }
 
+//=============================================================================================
+// Loopback client
+//=============================================================================================
+
+// Returns the number of bytes read, which is less than bytes on error or disconnect.
+static int ReadAll( const int sock, void * data, const int bytes )
+{
+	int got = 0;
+	while ( got < bytes )
+	{
+		const int r = read( sock, (char *)data + got, bytes - got );
+		if ( r <= 0 )
+		{
+			if ( r == -1 && errno == EINTR )
+			{
+				continue;
+			}
+			break;
+		}
+		got += r;
+	}
+	return got;
+}
+
+// Asks the image server on this device for the port of its TCP accept socket.
+// Returns -1 if no image server answers.
+static int FindLocalImageServer()
+{
+	const int sock = socket( AF_INET, SOCK_DGRAM, IPPROTO_UDP );
+	if ( sock == -1 )
+	{
+		LOG( "socket: %s", strerror( errno ) );
+		return -1;
+	}
+	sockaddr_in server;
+	memset( &server, 0, sizeof( server ) );
+	server.sin_family = AF_INET;
+	server.sin_addr.s_addr = htonl( INADDR_LOOPBACK );
+	server.sin_port = htons( IMAGE_SERVER_PORT );
+
+	int port = -1;
+	for ( int attempt = 0; attempt < 3 && port == -1; attempt++ )
+	{
+		if ( sendto( sock, IMAGE_SERVER_REQUEST, strlen( IMAGE_SERVER_REQUEST ), 0,
+				(sockaddr *)&server, sizeof( server ) ) == -1 )
+		{
+			LOG( "sendto: %s", strerror( errno ) );
+			break;
+		}
+		struct pollfd pfd;
+		pfd.fd = sock;
+		pfd.events = POLLIN;
+		pfd.revents = 0;
+		if ( poll( &pfd, 1, 1000 ) > 0 && ( pfd.revents & POLLIN ) )
+		{
+			char response[128];
+			const int r = recv( sock, response, sizeof( response ) - 1, 0 );
+			if ( r > 0 )
+			{
+				response[r] = 0;
+				port = atoi( response );
+			}
+		}
+	}
+	close( sock );
+	return port;
+}
+
+struct imageServerClientStats_t
+{
+	int			frames;
+	int			keyFrames;
+	int			resyncs;
+	double		bytes;
+	double		seconds;
+};
+
+// Requests frames from the image server for the given time, like a viewer would.
+// Returns false if the connection failed.
+static bool RunImageServerClient( const int port, const int resolution, const bool stream,
+		const double seconds, imageServerClientStats_t & stats )
+{
+	memset( &stats, 0, sizeof( stats ) );
+
+	const int sock = socket( AF_INET, SOCK_STREAM, 0 );
+	if ( sock == -1 )
+	{
+		LOG( "socket: %s", strerror( errno ) );
+		return false;
+	}
+	sockaddr_in server;
+	memset( &server, 0, sizeof( server ) );
+	server.sin_family = AF_INET;
+	server.sin_addr.s_addr = htonl( INADDR_LOOPBACK );
+	server.sin_port = htons( port );
+	if ( connect( sock, (sockaddr *)&server, sizeof( server ) ) == -1 )
+	{
+		LOG( "connect: %s", strerror( errno ) );
+		close( sock );
+		return false;
+	}
+
+	ImageStreamDecoder decoder;
+	Array< UByte > buffer;
+	bool ok = true;
+	const double start = ovr_GetTimeInSeconds();
+	while ( ovr_GetTimeInSeconds() - start < seconds )
+	{
+		char request[64];
+		if ( stream )
+		{
+			sprintf( request, "s%i %u", resolution, decoder.GetSequence() );
+		}
+		else
+		{
+			sprintf( request, "%i", resolution );
+		}
+		const int requestBytes = strlen( request );
+		if ( WriteAll( sock, request, requestBytes ) != requestBytes )
+		{
+			ok = false;
+			break;
+		}
+
+		int bytes = 0;
+		if ( stream )
+		{
+			imageStreamHeader_t header;
+			if ( ReadAll( sock, &header, sizeof( header ) ) != sizeof( header ) || header.magic != IMAGE_STREAM_MAGIC )
+			{
+				ok = false;
+				break;
+			}
+			bytes = sizeof( header ) + header.compressedBytes;
+			buffer.Resize( bytes );
+			memcpy( &buffer[0], &header, sizeof( header ) );
+			if ( ReadAll( sock, &buffer[sizeof( header )], header.compressedBytes ) != (int)header.compressedBytes )
+			{
+				ok = false;
+				break;
+			}
+			if ( header.baseSequence == 0 )
+			{
+				stats.keyFrames++;
+			}
+			if ( !decoder.Decode( &buffer[0], bytes ) )
+			{
+				// The next request asks for a key frame.
+				decoder.Reset();
+				stats.resyncs++;
+			}
+		}
+		else
+		{
+			bytes = resolution * resolution * 2;
+			buffer.Resize( bytes );
+			if ( ReadAll( sock, &buffer[0], bytes ) != bytes )
+			{
+				ok = false;
+				break;
+			}
+		}
+		stats.frames++;
+		stats.bytes += bytes;
+	}
+	stats.seconds = ovr_GetTimeInSeconds() - start;
+	close( sock );
+	return ok;
+}
+
+struct imageServerLoopbackParms_t
+{
+	int		resolution;
+	double	seconds;
+};
+
+static void * ImageServerLoopbackThread( void * parm )
+{
+	imageServerLoopbackParms_t * parms = (imageServerLoopbackParms_t *)parm;
+
+	const int port = FindLocalImageServer();
+	if ( port == -1 )
+	{
+		LOG( "imageServerLoopback: no image server, it needs ovrModeParms::EnableImageServer" );
+		delete parms;
+		return NULL;
+	}
+
+	for ( int stream = 0; stream < 2; stream++ )
+	{
+		imageServerClientStats_t stats;
+		if ( !RunImageServerClient( port, parms->resolution, stream != 0, parms->seconds, stats ) )
+		{
+			LOG( "imageServerLoopback: connection failed after %i frames", stats.frames );
+		}
+		const int frames = Alg::Max( stats.frames, 1 );
+		LOG( "imageServerLoopback: %-6s %4ix%-4i %5i frames, %5.1f fps, %8.0f bytes per frame, %6.2f MB/s, %i key frames, %i resyncs",
+				stream ? "stream" : "raw", parms->resolution, parms->resolution, stats.frames,
+				stats.frames / stats.seconds, stats.bytes / frames, stats.bytes / stats.seconds / ( 1024.0 * 1024.0 ),
+				stats.keyFrames, stats.resyncs );
+	}
+
+	delete parms;
+	return NULL;
+}
+
+void ImageServerLoopbackTest( void * appPtr, const char * cmd )
+{
+	imageServerLoopbackParms_t * parms = new imageServerLoopbackParms_t;
+	parms->resolution = 512;
+	parms->seconds = 5.0;
+	sscanf( cmd, "%i %lf", &parms->resolution, &parms->seconds );
+	parms->resolution = Alg::Clamp( parms->resolution, 64, IMAGE_STREAM_MAX_RESOLUTION );	// the server drops anything else
+
+	// The frames are captured by TimeWarp, so don't block the calling thread.
+	pthread_attr_t attr;
+	pthread_attr_init( &attr );
+	pthread_attr_setdetachstate( &attr, PTHREAD_CREATE_DETACHED );
+	pthread_t thread;
+	const int createErr = pthread_create( &thread, &attr, ImageServerLoopbackThread, parms );
+	pthread_attr_destroy( &attr );
+	if ( createErr != 0 )
+	{
+		LOG( "pthread_create returned %i", createErr );
+		delete parms;
+	}
+}
+
 }	// namespace OVR
 
@@ -18,6 +18,7 @@ Copyright   :   Copyright 2014 Oculus VR, LLC. All Rights reserved.
 #include "GlUtils.h"
 #include "GlGeometry.h"
 #include "GlProgram.h"
+#include "ImageStream.h"
 
 namespace OVR
 {
@@ -93,8 +94,18 @@ private:
 	pthread_cond_t		StartStopCondition;
 
 	int					CountdownToSend;
+
+	// Only used by the server thread, for clients that request a stream.
+	ImageStreamEncoder	StreamEncoder;
 };
 
+// Connects to the image server of this device over the loopback interface, and
+// logs the bytes per frame and frames per second of raw frames, then of the
+// compressed stream. Runs on a thread of its own, because the frames come from
+// TimeWarp. Registered as the "imageServerLoopback" console command, optional
+// parms: "<resolution> <seconds for each test>"
+void ImageServerLoopbackTest( void * appPtr, const char * cmd );
+
 }
 
 #endif	// OVR_ImageServer_h
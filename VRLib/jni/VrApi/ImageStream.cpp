@@ -0,0 +1,435 @@
+/************************************************************************************
+
+Filename    :   ImageStream.cpp
+Content     :   Tile delta and LZ compression of image server frames
+Created     :   October, 2026
+
+Copyright   :   Copyright 2014 Oculus VR, LLC. All Rights reserved.
+
+*************************************************************************************/
+
+#include "ImageStream.h"
+
+#include <string.h>
+#include "Kernel/OVR_Alg.h"
+
+namespace OVR
+{
+
+//=============================================================================================
+// LZ compression
+//=============================================================================================
+
+/*
+	The compressed data is a sequence of:
+
+	UByte	token						// literal count << 4 | ( match length - 4 )
+	UByte	literalCountExtra[]			// if the count is 15, add bytes until one is not 255
+	UByte	literals[literalCount]
+	UInt16	matchOffset					// little endian, back from the current output
+	UByte	matchLengthExtra[]			// if the length is 15 + 4, add bytes until one is not 255
+
+	The last sequence only has literals, and ends the data.
+*/
+
+static const int LZ_MIN_MATCH = 4;
+static const int LZ_MAX_OFFSET = 65535;
+static const int LZ_HASH_BITS = 13;
+
+static inline UInt32 ReadUInt32( const UByte * p )
+{
+	UInt32 value;
+	memcpy( &value, p, sizeof( value ) );
+	return value;
+}
+
+static inline int HashUInt32( const UInt32 value )
+{
+	return (int)( ( value * 2654435761U ) >> ( 32 - LZ_HASH_BITS ) );
+}
+
+// Returns false if the output is full.
+static bool WriteCount( UByte * & op, const UByte * oend, int count )
+{
+	for ( ; count >= 255; count -= 255 )
+	{
+		if ( op >= oend )
+		{
+			return false;
+		}
+		*op++ = 255;
+	}
+	if ( op >= oend )
+	{
+		return false;
+	}
+	*op++ = (UByte)count;
+	return true;
+}
+
+// Returns false if the input is corrupt.
+static bool ReadCount( const UByte * & ip, const UByte * iend, int & count )
+{
+	for ( ; ; )
+	{
+		if ( ip >= iend )
+		{
+			return false;
+		}
+		const int b = *ip++;
+		count += b;
+		if ( b != 255 )
+		{
+			return true;
+		}
+	}
+}
+
+static bool WriteSequence( UByte * & op, const UByte * oend, const UByte * literals, const int literalCount,
+		const int matchOffset, const int matchLength )
+{
+	if ( op >= oend )
+	{
+		return false;
+	}
+	UByte * token = op++;
+	const int lengthCode = matchLength - LZ_MIN_MATCH;
+	*token = (UByte)( ( Alg::Min( literalCount, 15 ) << 4 ) | ( matchLength > 0 ? Alg::Min( lengthCode, 15 ) : 0 ) );
+	if ( literalCount >= 15 && !WriteCount( op, oend, literalCount - 15 ) )
+	{
+		return false;
+	}
+	if ( oend - op < literalCount )
+	{
+		return false;
+	}
+	memcpy( op, literals, literalCount );
+	op += literalCount;
+	if ( matchLength == 0 )
+	{
+		return true;
+	}
+	if ( oend - op < 2 )
+	{
+		return false;
+	}
+	*op++ = (UByte)( matchOffset & 255 );
+	*op++ = (UByte)( matchOffset >> 8 );
+	if ( lengthCode >= 15 && !WriteCount( op, oend, lengthCode - 15 ) )
+	{
+		return false;
+	}
+	return true;
+}
+
+int ImageStreamMaxCompressedBytes( const int inBytes )
+{
+	return inBytes + inBytes / 255 + 16;
+}
+
+int ImageStreamCompress( const UByte * in, const int inBytes, UByte * out, const int outCapacity )
+{
+	// Positions + 1 of the last 4 bytes with each hash, 0 if there are none.
+	int table[1 << LZ_HASH_BITS];
+	memset( table, 0, sizeof( table ) );
+
+	const UByte * ip = in;
+	const UByte * anchor = in;
+	const UByte * const iend = in + inBytes;
+	UByte * op = out;
+	const UByte * const oend = out + outCapacity;
+
+	while ( iend - ip >= LZ_MIN_MATCH )
+	{
+		const UInt32 value = ReadUInt32( ip );
+		const int hash = HashUInt32( value );
+		const int pos = (int)( ip - in );
+		const int ref = table[hash] - 1;
+		table[hash] = pos + 1;
+
+		if ( ref < 0 || pos - ref > LZ_MAX_OFFSET || ReadUInt32( in + ref ) != value )
+		{
+			ip++;
+			continue;
+		}
+
+		int length = LZ_MIN_MATCH;
+		while ( ip + length < iend && in[ref + length] == ip[length] )
+		{
+			length++;
+		}
+
+		if ( !WriteSequence( op, oend, anchor, (int)( ip - anchor ), pos - ref, length ) )
+		{
+			return -1;
+		}
+		ip += length;
+		anchor = ip;
+
+		// Keep the table up to date at the end of the match, so a following
+		// run of the same bytes is found right away.
+		if ( iend - ip >= LZ_MIN_MATCH )
+		{
+			table[HashUInt32( ReadUInt32( ip - 2 ) )] = (int)( ip - 2 - in ) + 1;
+		}
+	}
+
+	if ( !WriteSequence( op, oend, anchor, (int)( iend - anchor ), 0, 0 ) )
+	{
+		return -1;
+	}
+	return (int)( op - out );
+}
+
+int ImageStreamDecompress( const UByte * in, const int inBytes, UByte * out, const int outCapacity )
+{
+	const UByte * ip = in;
+	const UByte * const iend = in + inBytes;
+	UByte * op = out;
+	const UByte * const oend = out + outCapacity;
+
+	while ( ip < iend )
+	{
+		const int token = *ip++;
+
+		int literalCount = token >> 4;
+		if ( literalCount == 15 && !ReadCount( ip, iend, literalCount ) )
+		{
+			return -1;
+		}
+		if ( iend - ip < literalCount || oend - op < literalCount )
+		{
+			return -1;
+		}
+		memcpy( op, ip, literalCount );
+		ip += literalCount;
+		op += literalCount;
+
+		if ( ip == iend )
+		{
+			break;	// the last sequence has no match
+		}
+
+		if ( iend - ip < 2 )
+		{
+			return -1;
+		}
+		const int offset = ip[0] | ( ip[1] << 8 );
+		ip += 2;
+		int length = token & 15;
+		if ( length == 15 && !ReadCount( ip, iend, length ) )
+		{
+			return -1;
+		}
+		length += LZ_MIN_MATCH;
+		if ( offset == 0 || offset > op - out || oend - op < length )
+		{
+			return -1;
+		}
+
+		// The match may overlap the output, so copy byte by byte.
+		const UByte * match = op - offset;
+		for ( int i = 0; i < length; i++ )
+		{
+			op[i] = match[i];
+		}
+		op += length;
+	}
+	return (int)( op - out );
+}
+
+//=============================================================================================
+// Tile delta frames
+//=============================================================================================
+
+static int TilesPerSide( const int resolution )
+{
+	return ( resolution + IMAGE_STREAM_TILE_SIZE - 1 ) / IMAGE_STREAM_TILE_SIZE;
+}
+
+ImageStreamEncoder::ImageStreamEncoder() :
+	Sequence( 0 ),
+	Resolution( 0 )
+{
+}
+
+const Array< UByte > & ImageStreamEncoder::Encode( const UInt16 * pixels, const int resolution, bool keyFrame )
+{
+	const int numPixels = resolution * resolution;
+	if ( resolution != Resolution || Sequence == 0 )
+	{
+		keyFrame = true;
+		Resolution = resolution;
+		Previous.Resize( numPixels );
+	}
+
+	const int tilesPerSide = TilesPerSide( resolution );
+	const int numTiles = tilesPerSide * tilesPerSide;
+	const int bitmapBytes = ( numTiles + 7 ) / 8;
+
+	Raw.Resize( bitmapBytes + numPixels * sizeof( UInt16 ) );
+	memset( &Raw[0], 0, bitmapBytes );
+	UInt16 * tilePixels = (UInt16 *)( &Raw[0] + bitmapBytes );
+	int numTilePixels = 0;
+	int changedTiles = 0;
+
+	for ( int tile = 0; tile < numTiles; tile++ )
+	{
+		const int x0 = ( tile % tilesPerSide ) * IMAGE_STREAM_TILE_SIZE;
+		const int y0 = ( tile / tilesPerSide ) * IMAGE_STREAM_TILE_SIZE;
+		const int tileWidth = Alg::Min( IMAGE_STREAM_TILE_SIZE, resolution - x0 );
+		const int tileHeight = Alg::Min( IMAGE_STREAM_TILE_SIZE, resolution - y0 );
+
+		bool changed = keyFrame;
+		for ( int y = y0; y < y0 + tileHeight && !changed; y++ )
+		{
+			changed = memcmp( &pixels[y * resolution + x0], &Previous[y * resolution + x0], tileWidth * sizeof( UInt16 ) ) != 0;
+		}
+		if ( !changed )
+		{
+			continue;
+		}
+
+		Raw[tile >> 3] |= (UByte)( 1 << ( tile & 7 ) );
+		changedTiles++;
+		for ( int y = y0; y < y0 + tileHeight; y++ )
+		{
+			const UInt16 * src = &pixels[y * resolution + x0];
+			UInt16 * prev = &Previous[y * resolution + x0];
+			UInt16 * dst = &tilePixels[numTilePixels];
+			if ( keyFrame )
+			{
+				memcpy( dst, src, tileWidth * sizeof( UInt16 ) );
+			}
+			else
+			{
+				for ( int x = 0; x < tileWidth; x++ )
+				{
+					dst[x] = src[x] ^ prev[x];
+				}
+			}
+			memcpy( prev, src, tileWidth * sizeof( UInt16 ) );
+			numTilePixels += tileWidth;
+		}
+	}
+
+	const int rawBytes = bitmapBytes + numTilePixels * sizeof( UInt16 );
+	Message.Resize( sizeof( imageStreamHeader_t ) + ImageStreamMaxCompressedBytes( rawBytes ) );
+	const int compressedBytes = ImageStreamCompress( &Raw[0], rawBytes,
+			&Message[0] + sizeof( imageStreamHeader_t ), Message.GetSizeI() - sizeof( imageStreamHeader_t ) );
+	OVR_ASSERT( compressedBytes >= 0 );
+	Message.Resize( sizeof( imageStreamHeader_t ) + compressedBytes );
+
+	imageStreamHeader_t header;
+	header.magic = IMAGE_STREAM_MAGIC;
+	header.baseSequence = keyFrame ? 0 : Sequence;
+	header.sequence = ++Sequence;
+	header.resolution = (UInt16)resolution;
+	header.tileSize = (UInt16)IMAGE_STREAM_TILE_SIZE;
+	header.changedTiles = changedTiles;
+	header.compressedBytes = compressedBytes;
+	memcpy( &Message[0], &header, sizeof( header ) );
+
+	return Message;
+}
+
+ImageStreamDecoder::ImageStreamDecoder() :
+	Sequence( 0 ),
+	Resolution( 0 )
+{
+}
+
+bool ImageStreamDecoder::Decode( const UByte * message, const int bytes )
+{
+	if ( bytes < (int)sizeof( imageStreamHeader_t ) )
+	{
+		return false;
+	}
+	imageStreamHeader_t header;
+	memcpy( &header, message, sizeof( header ) );
+	if ( header.magic != IMAGE_STREAM_MAGIC || header.tileSize != IMAGE_STREAM_TILE_SIZE ||
+			header.resolution == 0 || header.resolution > IMAGE_STREAM_MAX_RESOLUTION ||
+			(int)header.compressedBytes != bytes - (int)sizeof( header ) )
+	{
+		return false;
+	}
+	const bool keyFrame = ( header.baseSequence == 0 );
+	if ( !keyFrame && ( header.baseSequence != Sequence || Sequence == 0 || header.resolution != Resolution ) )
+	{
+		return false;
+	}
+
+	const int resolution = header.resolution;
+	const int numPixels = resolution * resolution;
+	const int tilesPerSide = TilesPerSide( resolution );
+	const int numTiles = tilesPerSide * tilesPerSide;
+	const int bitmapBytes = ( numTiles + 7 ) / 8;
+
+	Raw.Resize( bitmapBytes + numPixels * sizeof( UInt16 ) );
+	const int rawBytes = ImageStreamDecompress( message + sizeof( header ), header.compressedBytes,
+			&Raw[0], Raw.GetSizeI() );
+	if ( rawBytes < bitmapBytes )
+	{
+		return false;
+	}
+
+	// Check the size before touching the pixels, so a bad frame leaves the last good one.
+	int numTilePixels = 0;
+	int changedTiles = 0;
+	for ( int tile = 0; tile < numTiles; tile++ )
+	{
+		if ( Raw[tile >> 3] & ( 1 << ( tile & 7 ) ) )
+		{
+			const int x0 = ( tile % tilesPerSide ) * IMAGE_STREAM_TILE_SIZE;
+			const int y0 = ( tile / tilesPerSide ) * IMAGE_STREAM_TILE_SIZE;
+			numTilePixels += Alg::Min( IMAGE_STREAM_TILE_SIZE, resolution - x0 ) *
+							Alg::Min( IMAGE_STREAM_TILE_SIZE, resolution - y0 );
+			changedTiles++;
+		}
+	}
+	if ( rawBytes != bitmapBytes + numTilePixels * (int)sizeof( UInt16 ) ||
+			changedTiles != (int)header.changedTiles || ( keyFrame && changedTiles != numTiles ) )
+	{
+		return false;
+	}
+
+	if ( keyFrame )
+	{
+		Pixels.Resize( numPixels );
+		Resolution = resolution;
+	}
+
+	const UInt16 * tilePixels = (const UInt16 *)( &Raw[0] + bitmapBytes );
+	for ( int tile = 0; tile < numTiles; tile++ )
+	{
+		if ( !( Raw[tile >> 3] & ( 1 << ( tile & 7 ) ) ) )
+		{
+			continue;
+		}
+		const int x0 = ( tile % tilesPerSide ) * IMAGE_STREAM_TILE_SIZE;
+		const int y0 = ( tile / tilesPerSide ) * IMAGE_STREAM_TILE_SIZE;
+		const int tileWidth = Alg::Min( IMAGE_STREAM_TILE_SIZE, resolution - x0 );
+		const int tileHeight = Alg::Min( IMAGE_STREAM_TILE_SIZE, resolution - y0 );
+		for ( int y = y0; y < y0 + tileHeight; y++ )
+		{
+			UInt16 * dst = &Pixels[y * resolution + x0];
+			if ( keyFrame )
+			{
+				memcpy( dst, tilePixels, tileWidth * sizeof( UInt16 ) );
+			}
+			else
+			{
+				for ( int x = 0; x < tileWidth; x++ )
+				{
+					dst[x] ^= tilePixels[x];
+				}
+			}
+			tilePixels += tileWidth;
+		}
+	}
+
+	Sequence = header.sequence;
+	return true;
+}
+
+}	// namespace OVR
@@ -0,0 +1,117 @@
+/************************************************************************************
+
+Filename    :   ImageStream.h
+Content     :   Tile delta and LZ compression of image server frames
+Created     :   October, 2026
+
+Copyright   :   Copyright 2014 Oculus VR, LLC. All Rights reserved.
+
+*************************************************************************************/
+#ifndef OVR_ImageStream_h
+#define OVR_ImageStream_h
+
+#include "Kernel/OVR_Types.h"
+#include "Kernel/OVR_Array.h"
+
+namespace OVR
+{
+
+/*
+	A raw RGB565 frame at the largest resolution is 8 MB, so mirroring a VR
+	session with raw frames saturates the link long before the frame rate
+	is anything to look at. Most of the frame does not change from one
+	capture to the next, though, and what does change compresses well.
+
+	A stream frame splits the image into square tiles and only includes the
+	tiles that changed since the previous frame, xor'ed with the previous
+	pixels, so mostly static content in a tile turns into runs of zeros.
+	The tile bitmap and the tiles are then compressed with a small LZ77
+	compressor that favors speed over ratio.
+
+	Every frame has a sequence number, and names the frame it is a delta of.
+	A decoder that does not have that frame rejects it, and the client asks
+	for a key frame, which does not depend on anything, to resync.
+
+	The message is the header followed by compressedBytes of payload:
+
+	imageStreamHeader_t	header
+	UByte				compressed[compressedBytes]
+
+	which decompresses to:
+
+	UByte				changedTileBits[( numTiles + 7 ) / 8]		// row major, low bit first
+	UInt16				tilePixels[]								// row by row, clipped to the image
+*/
+
+static const UInt32 IMAGE_STREAM_MAGIC = 0x31534D49;		// "IMS1"
+static const int IMAGE_STREAM_TILE_SIZE = 32;
+static const int IMAGE_STREAM_MAX_RESOLUTION = 2048;		// the ImageServer rejects larger requests
+
+struct imageStreamHeader_t
+{
+	UInt32		magic;
+	UInt32		sequence;			// starts at 1, incremented for each frame
+	UInt32		baseSequence;		// the frame the tiles are a delta of, 0 for a key frame
+	UInt16		resolution;			// square image
+	UInt16		tileSize;
+	UInt32		changedTiles;
+	UInt32		compressedBytes;
+};
+
+// Largest output of ImageStreamCompress() for inBytes of input.
+int ImageStreamMaxCompressedBytes( const int inBytes );
+
+// Returns the compressed size, or -1 if it does not fit outCapacity.
+int ImageStreamCompress( const UByte * in, const int inBytes, UByte * out, const int outCapacity );
+
+// Returns the decompressed size, or -1 if the input is corrupt or does not fit outCapacity.
+int ImageStreamDecompress( const UByte * in, const int inBytes, UByte * out, const int outCapacity );
+
+class ImageStreamEncoder
+{
+public:
+						ImageStreamEncoder();
+
+	// Encodes a delta of the previous frame, or a key frame if keyFrame is set,
+	// there is no previous frame, or the resolution changed. The returned message
+	// remains valid until the next call.
+	const Array< UByte > &	Encode( const UInt16 * pixels, const int resolution, bool keyFrame );
+
+	// The sequence of the last encoded frame, 0 if there is none.
+	UInt32				GetSequence() const { return Sequence; }
+
+private:
+	UInt32				Sequence;
+	int					Resolution;
+	Array< UInt16 >		Previous;
+	Array< UByte >		Raw;
+	Array< UByte >		Message;
+};
+
+class ImageStreamDecoder
+{
+public:
+						ImageStreamDecoder();
+
+	// Returns false if the message is corrupt, or if it is a delta of a frame the
+	// decoder does not have, in which case a key frame is needed to resync.
+	bool				Decode( const UByte * message, const int bytes );
+
+	// The sequence of the last decoded frame, 0 if there is none.
+	UInt32				GetSequence() const { return Sequence; }
+	int					GetResolution() const { return Resolution; }
+	const UInt16 *		GetPixels() const { return Pixels.GetSizeI() > 0 ? &Pixels[0] : NULL; }
+
+	// Forget the current frame, so only a key frame is accepted.
+	void				Reset() { Sequence = 0; }
+
+private:
+	UInt32				Sequence;
+	int					Resolution;
+	Array< UInt16 >		Pixels;
+	Array< UByte >		Raw;
+};
+
+}	// namespace OVR
+
+#endif	// OVR_ImageStream_h
@@ -499,6 +499,101 @@ static GlGeometry LoadMeshFromMemory( const MemBuffer & buf,
 	return geometry;
 }
 
+// Only for the single slice warp mesh, the slices need the same number of
+// triangles in each slice.
+static GlGeometry LoadAdaptiveMeshFromMemory( const MemBuffer & buf, const float fovScale )
+{
+	GlGeometry	geometry;
+
+	if ( buf.Length < 12 )
+	{
+		LOG( "bad buf.length %i", buf.Length );
+		return geometry;
+	}
+
+	const int magic = ((int *)buf.Buffer)[0];
+	const int vertexCount = ((int *)buf.Buffer)[1];
+	const int indexCount = ((int *)buf.Buffer)[2];
+
+	const int bufferBytes = 12 + vertexCount * DISTORTION_ADAPTIVE_VERTEX_FLOATS * sizeof( float ) +
+			indexCount * sizeof( unsigned short );
+	if ( buf.Length != bufferBytes )
+	{
+		LOG( "buf.length %i != %i", buf.Length, bufferBytes );
+		return geometry;
+	}
+	if ( magic != DISTORTION_ADAPTIVE_BUFFER_MAGIC || vertexCount < 3 || indexCount < 6 || vertexCount > 65536 )
+	{
+		LOG( "Bad distortion header" );
+		return geometry;
+	}
+	const float * bufferVerts = (const float *)( (const char *)buf.Buffer + 12 );
+	const unsigned short * bufferIndices = (const unsigned short *)( bufferVerts + vertexCount * DISTORTION_ADAPTIVE_VERTEX_FLOATS );
+
+	// build a VertexArrayObject
+	glGenVertexArraysOES_( 1, &geometry.vertexArrayObject );
+	glBindVertexArrayOES_( geometry.vertexArrayObject );
+
+	// Same layout as LoadMeshFromMemory().
+	const int attribCount = 10;
+	const int floatCount = vertexCount * attribCount;
+	float * tessVertices = new float[floatCount];
+
+	// The left eye verts come first.
+	const int eyeIndexCount = indexCount / 2;
+	int firstRightVert = vertexCount;
+	for ( int i = eyeIndexCount; i < indexCount; i++ )
+	{
+		firstRightVert = Alg::Min( firstRightVert, (int)bufferIndices[i] );
+	}
+
+	for ( int i = 0; i < vertexCount; i++ )
+	{
+		const float * in = &bufferVerts[i * DISTORTION_ADAPTIVE_VERTEX_FLOATS];
+		float * v = &tessVertices[i * attribCount];
+		const int eye = ( i >= firstRightVert );
+		v[0] = -1.0 + eye + in[0];
+		v[1] = in[1] * 2.0f - 1.0f;
+		for ( int j = 0 ; j < 6; j++ )
+		{
+			v[2+j] = fovScale * in[2+j];
+		}
+		v[8] = in[0];
+		v[9] = 1.0f;
+	}
+
+	glGenBuffers( 1, &geometry.vertexBuffer );
+	glBindBuffer( GL_ARRAY_BUFFER, geometry.vertexBuffer );
+	glBufferData( GL_ARRAY_BUFFER, floatCount * sizeof(*tessVertices), (void *)tessVertices, GL_STATIC_DRAW );
+	delete[] tessVertices;
+
+	geometry.vertexCount = vertexCount;
+	geometry.indexCount = indexCount;
+
+	glGenBuffers( 1, &geometry.indexBuffer );
+	glBindBuffer( GL_ELEMENT_ARRAY_BUFFER, geometry.indexBuffer );
+	glBufferData( GL_ELEMENT_ARRAY_BUFFER, indexCount * sizeof( unsigned short ), (void *)bufferIndices, GL_STATIC_DRAW );
+
+	glEnableVertexAttribArray( VERTEX_ATTRIBUTE_LOCATION_POSITION );
+	glVertexAttribPointer( VERTEX_ATTRIBUTE_LOCATION_POSITION, 2, GL_FLOAT, false, attribCount * sizeof( float ), (void *)( 0 * sizeof( float ) ) );
+
+	glEnableVertexAttribArray( VERTEX_ATTRIBUTE_LOCATION_NORMAL );
+	glVertexAttribPointer( VERTEX_ATTRIBUTE_LOCATION_NORMAL, 2, GL_FLOAT, false, attribCount * sizeof( float ), (void *)( 2 * sizeof( float ) ) );
+
+	glEnableVertexAttribArray( VERTEX_ATTRIBUTE_LOCATION_UV0 );
+	glVertexAttribPointer( VERTEX_ATTRIBUTE_LOCATION_UV0, 2, GL_FLOAT, false, attribCount * sizeof( float ), (void *)( 4 * sizeof( float ) ) );
+
+	glEnableVertexAttribArray( VERTEX_ATTRIBUTE_LOCATION_TANGENT );
+	glVertexAttribPointer( VERTEX_ATTRIBUTE_LOCATION_TANGENT, 2, GL_FLOAT, false, attribCount * sizeof( float ), (void *)( 6 * sizeof( float ) ) );
+
+	glEnableVertexAttribArray( VERTEX_ATTRIBUTE_LOCATION_UV1 );
+	glVertexAttribPointer( VERTEX_ATTRIBUTE_LOCATION_UV1, 2, GL_FLOAT, false, attribCount * sizeof( float ), (void *)( 8 * sizeof( float ) ) );
+
+	glBindVertexArrayOES_( 0 );
+
+	return geometry;
+}
+
 //=========================================================================================
 
 
@@ -2200,6 +2295,7 @@ void TimeWarpLocal::CreateFrameworkGraphics()
 
 	// Decide where we get our distortion mesh from
 	MemBuffer buf;
+	bool synthesized = false;
 	if ( InitParms.DistortionFileName )
 	{	// If we have an explicit distortion file request, use that.
 		MemBufferFile explicitFile( InitParms.DistortionFileName );
@@ -2224,14 +2320,26 @@ void TimeWarpLocal::CreateFrameworkGraphics()
 
 		if ( buf.Buffer == NULL )
 		{	// Synthesize the standard distortion
-			buf = BuildDistortionBuffer( InitParms.HmdInfo, 32, 32 );
+			buf = LoadCachedDistortionBuffer( InitParms.HmdInfo, 32, 32, InitParms.CacheDirectory.ToCStr() );
+			synthesized = true;
 		}
 	}
 
 	// Create the tesselated mesh for vertex warping
 
 	// single slice mesh for the normal rendering
-	warpMesh = LoadMeshFromMemory( buf, 1, calibrateFovScale );
+	if ( synthesized && InitParms.DistortionMeshMaxError > 0.0f )
+	{
+		MemBuffer adaptiveBuf = BuildAdaptiveDistortionBuffer( InitParms.HmdInfo,
+				InitParms.DistortionMeshMaxError, 2, DISTORTION_ADAPTIVE_MAX_DEPTH );
+		warpMesh = LoadAdaptiveMeshFromMemory( adaptiveBuf, calibrateFovScale );
+		LOG( "Adaptive warp mesh: %i verts, %i indices", warpMesh.vertexCount, warpMesh.indexCount );
+		adaptiveBuf.FreeData();
+	}
+	if ( warpMesh.indexCount == 0 )
+	{
+		warpMesh = LoadMeshFromMemory( buf, 1, calibrateFovScale );
+	}
 
 	// multi-slice mesh for sliced rendering
 	sliceMesh = LoadMeshFromMemory( buf, NUM_SLICES_PER_EYE, calibrateFovScale );
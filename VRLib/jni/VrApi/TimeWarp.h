@@ -51,6 +51,7 @@ public:
 		AsynchronousTimeWarp( true ),
 		EnableImageServer( false ),
 		DistortionFileName( NULL ),
+		DistortionMeshMaxError( 0.0f ),
 		Hmd( NULL ),
 		JavaVm( NULL ),
 		VrLibClass( NULL ),
@@ -77,6 +78,14 @@ public:
 	// directory to load external data from
 	String				ExternalStorageDirectory;
 
+	// directory to cache the synthesized distortion mesh in, none if empty
+	String				CacheDirectory;
+
+	// If not 0, the single slice warp mesh is an adaptive mesh that is only
+	// as fine as it needs to be to stay within this many pixels of the
+	// distortion, instead of the uniform grid.
+	float				DistortionMeshMaxError;
+
 	hmdInfoInternal_t	HmdInfo;
 	ovrHmd		        Hmd;
 
@@ -25,9 +25,21 @@ Copyright   :   Copyright 2014 Oculus VR, LLC. All Rights reserved.
 #include "VrApi_local.h"
 #include "Vsync.h"
 #include "Kernel/OVR_String.h"			// for ReadFreq()
-#include "OVR_JSON.h"
+#include "OVR_JSON.h"						// also for the jsonParseBenchmark console command
 #include "OVRVersion.h"					// for vrlib build version
 #include "LocalPreferences.h"			// for testing via local prefs
+#include "RayTracer/RtTraceBuilder.h"	// for the rtBenchmark console command
+#include "ModelFileBinary.h"				// for the modelConvert, modelLoadBenchmark and textureDecodeBenchmark console commands
+#include "ModelRender.h"					// for the cullBenchmark console command
+#include "ImageData.h"					// for the imageScaleBenchmark and mipChainTest console commands
+#include "MessageChannel.h"				// for the messageChannelBenchmark console command
+#include "OVR_SensorFusion.h"			// for the poseHistoryTest console command
+#include "OVR_SensorRecording.h"		// for the sensorReplay and sensorPredictionBenchmark console commands
+#include "Distortion.h"					// for the distortionBenchmark and distortionMeshReport console commands
+#include "ImageServer.h"				// for the imageServerLoopback console command
+#include "BitmapFont.h"					// for the fontSurfaceBenchmark console command
+#include "VRMenu/ThumbnailScheduler.h"		// for the thumbnailSchedulerBenchmark and thumbnailSchedulerTest console commands
+#include "VRMenu/VRMenuMgr.h"				// for the menuTransformBenchmark, menuHitTestBenchmark and menuObjectChurnBenchmark console commands
 
 /*
  * This interacts with the VrLib java class to deal with Android platform issues.
@@ -142,6 +154,92 @@ static void DebugPrint( void * appPtr, const char * cmd )
 	DROIDLOG( "OvrDebug", "%s", cmd );
 }
 
+// Optional parms: "<number of reader threads> <milliseconds per run>"
+static void LocklessBenchmark( void * appPtr, const char * cmd )
+{
+	int numReaders = 3;
+	int milliseconds = 1000;
+	sscanf( cmd, "%i %i", &numReaders, &milliseconds );
+	OVR::LocklessSnapshotBenchmark( numReaders, milliseconds );
+}
+
+// Optional parms: "<milliseconds per run>"
+static void PoseHistoryTest( void * appPtr, const char * cmd )
+{
+	int milliseconds = 1000;
+	sscanf( cmd, "%i", &milliseconds );
+	OVR::PoseHistoryTest( milliseconds );
+}
+
+// Parms: "<file>" to start recording, nothing or "stop" to stop recording.
+static void SensorRecordCommand( void * appPtr, const char * cmd )
+{
+	char path[1024] = {};
+	if ( sscanf( cmd, "%1023s", path ) != 1 || strcmp( path, "stop" ) == 0 )
+	{
+		ovrHmd_StopSensorRecording( OvrHmd );
+		return;
+	}
+	ovrHmd_StartSensorRecording( OvrHmd, path );
+}
+
+static OVR::PredictionMode ParsePredictionMode( const char * name )
+{
+	for ( int i = 0; i < OVR::Prediction_Count; i++ )
+	{
+		if ( OVR::OVR_stricmp( name, OVR::GetPredictionModeName( (OVR::PredictionMode)i ) ) == 0 )
+		{
+			return (OVR::PredictionMode)i;
+		}
+	}
+	return OVR::Prediction_Count;
+}
+
+// Parms: "<file> [prediction milliseconds] [velocity|acceleration|filtered]"
+static void SensorReplayCommand( void * appPtr, const char * cmd )
+{
+	char path[1024] = {};
+	float milliseconds = 32.0f;
+	char mode[64] = "velocity";
+	if ( sscanf( cmd, "%1023s %f %63s", path, &milliseconds, mode ) < 1 || ParsePredictionMode( mode ) == OVR::Prediction_Count )
+	{
+		LOG( "usage: sensorReplay <file> [prediction milliseconds] [velocity|acceleration|filtered]" );
+		return;
+	}
+	OVR::ReplaySensorRecording( path, ParsePredictionMode( mode ), milliseconds * 0.001f );
+}
+
+// Parms: "velocity", "acceleration" or "filtered"
+static void SensorPredictionCommand( void * appPtr, const char * cmd )
+{
+	char mode[64] = {};
+	sscanf( cmd, "%63s", mode );
+	const OVR::PredictionMode prediction = ParsePredictionMode( mode );
+	if ( prediction == OVR::Prediction_Count )
+	{
+		LOG( "usage: sensorPrediction <velocity|acceleration|filtered>" );
+		return;
+	}
+	ovrHmd_SetSensorPredictionMode( OvrHmd, (ovrSensorPredictionMode)prediction );
+	LOG( "sensor prediction: %s", OVR::GetPredictionModeName( prediction ) );
+}
+
+// Optional parms: "<recording file>", without a file a generated recording is used.
+static void SensorPredictionBenchmarkCommand( void * appPtr, const char * cmd )
+{
+	char path[1024] = {};
+	sscanf( cmd, "%1023s", path );
+	OVR::SensorPredictionBenchmark( path );
+}
+
+// Optional parms: "<json file>", without a file a generated models.json is used.
+static void JsonParseBenchmarkCommand( void * appPtr, const char * cmd )
+{
+	char path[1024] = {};
+	sscanf( cmd, "%1023s", path );
+	OVR::JsonParseBenchmark( path );
+}
+
 namespace OVR {
 
 class OvrConsole
@@ -514,6 +612,30 @@ void ovr_Init()
 	BuildStrings = new OVR::NativeBuildStrings( jni );
 
 	ovr_RegisterConsoleFunction( "print", DebugPrint );
+	ovr_RegisterConsoleFunction( "rtBenchmark", OVR::RtTraceBenchmark );
+	ovr_RegisterConsoleFunction( "modelConvert", OVR::ModelConvertCommand );
+	ovr_RegisterConsoleFunction( "modelLoadBenchmark", OVR::ModelLoadBenchmark );
+	ovr_RegisterConsoleFunction( "textureDecodeBenchmark", OVR::ModelTextureDecodeBenchmark );
+	ovr_RegisterConsoleFunction( "cullBenchmark", OVR::DrawSurfaceCullBenchmark );
+	ovr_RegisterConsoleFunction( "imageScaleBenchmark", OVR::ImageScaleBenchmark );
+	ovr_RegisterConsoleFunction( "mipChainTest", OVR::ImageMipChainTest );
+	ovr_RegisterConsoleFunction( "messageChannelBenchmark", OVR::MessageChannelBenchmark );
+	ovr_RegisterConsoleFunction( "locklessBenchmark", LocklessBenchmark );
+	ovr_RegisterConsoleFunction( "poseHistoryTest", PoseHistoryTest );
+	ovr_RegisterConsoleFunction( "sensorRecord", SensorRecordCommand );
+	ovr_RegisterConsoleFunction( "sensorReplay", SensorReplayCommand );
+	ovr_RegisterConsoleFunction( "sensorPrediction", SensorPredictionCommand );
+	ovr_RegisterConsoleFunction( "sensorPredictionBenchmark", SensorPredictionBenchmarkCommand );
+	ovr_RegisterConsoleFunction( "distortionBenchmark", OVR::DistortionBenchmark );
+	ovr_RegisterConsoleFunction( "distortionMeshReport", OVR::DistortionMeshReport );
+	ovr_RegisterConsoleFunction( "imageServerLoopback", OVR::ImageServerLoopbackTest );
+	ovr_RegisterConsoleFunction( "jsonParseBenchmark", JsonParseBenchmarkCommand );
+	ovr_RegisterConsoleFunction( "fontSurfaceBenchmark", OVR::BitmapFontSurfaceBenchmark );
+	ovr_RegisterConsoleFunction( "menuTransformBenchmark", OVR::VRMenuTransformBenchmark );
+	ovr_RegisterConsoleFunction( "menuHitTestBenchmark", OVR::VRMenuHitTestBenchmark );
+	ovr_RegisterConsoleFunction( "menuObjectChurnBenchmark", OVR::VRMenuObjectChurnBenchmark );
+	ovr_RegisterConsoleFunction( "thumbnailSchedulerBenchmark", OVR::ThumbnailSchedulerBenchmark );
+	ovr_RegisterConsoleFunction( "thumbnailSchedulerTest", OVR::ThumbnailSchedulerTest );
 }
 
 void ovr_StartPackageActivity( ovrMobile * ovr, const char * className, const char * commandString )
@@ -1234,6 +1356,21 @@ ovrMobile * ovr_EnterVrMode( ovrModeParms parms, ovrHmdInfo * returnedHmdInfo )
 	ovr->Jni->ReleaseStringUTFChars( externalStorageDirectoryString, externalStorageDirectoryStringUTFChars );
 	ovr->Jni->DeleteLocalRef( externalStorageDirectoryString );
 
+	// get internal cache directory for the distortion mesh cache
+	OVR::String internalCacheDirectory;
+	const jmethodID getInternalStorageCacheDirMethodId = ovr_GetStaticMethodID( ovr->Jni, VrLibClass, "getInternalStorageCacheDir", "(Landroid/app/Activity;)Ljava/lang/String;" );
+	if ( getInternalStorageCacheDirMethodId != NULL )
+	{
+		jstring internalCacheDirectoryString = (jstring)ovr->Jni->CallStaticObjectMethod( VrLibClass, getInternalStorageCacheDirMethodId, ovr->Parms.ActivityObject );
+		if ( internalCacheDirectoryString != NULL )
+		{
+			const char *internalCacheDirectoryStringUTFChars = ovr->Jni->GetStringUTFChars( internalCacheDirectoryString, NULL );
+			internalCacheDirectory = internalCacheDirectoryStringUTFChars;
+			ovr->Jni->ReleaseStringUTFChars( internalCacheDirectoryString, internalCacheDirectoryStringUTFChars );
+			ovr->Jni->DeleteLocalRef( internalCacheDirectoryString );
+		}
+	}
+
 	// Enable cpu and gpu clock locking
 	SetVrPlatformOptions( ovr->Jni, VrLibClass, ovr->Parms.ActivityObject,
 			ovr->Parms.CpuLevel, ovr->Parms.GpuLevel );
@@ -1251,6 +1388,7 @@ ovrMobile * ovr_EnterVrMode( ovrModeParms parms, ovrHmdInfo * returnedHmdInfo )
 	// frontbuffer can be forced off.
 	ovr->Twp.FrontBuffer = atoi( ovr_GetLocalPreferenceValueForKey( "frontbuffer", "1" ) );
 	ovr->Twp.DistortionFileName = ovr->Parms.DistortionFileName;
+	ovr->Twp.DistortionMeshMaxError = atof( ovr_GetLocalPreferenceValueForKey( "distortionMeshMaxError", "0" ) );
 	ovr->Twp.EnableImageServer = ovr->Parms.EnableImageServer;
 	ovr->Twp.HmdInfo = ovr->HmdInfo;
 	ovr->Twp.Hmd = OvrHmd;
@@ -1263,6 +1401,7 @@ ovrMobile * ovr_EnterVrMode( ovrModeParms parms, ovrHmdInfo * returnedHmdInfo )
 	// front buffer rendering.
 	ovr->Twp.BuildVersionSDK = BuildVersionSDK;
 	ovr->Twp.ExternalStorageDirectory = externalStorageDirectory;
+	ovr->Twp.CacheDirectory = internalCacheDirectory;
 	ovr->Warp = OVR::TimeWarp::Factory( ovr->Twp );
 
 	// Enable our real time scheduling.
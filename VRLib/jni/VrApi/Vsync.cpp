@@ -64,7 +64,7 @@ namespace OVR
 
 // This can be read without any locks, so a high priority rendering thread doesn't
 // have to worry about being blocked by a sensor thread that got preempted.
-OVR::LocklessUpdater<VsyncState>	UpdatedVsyncState;
+OVR::LocklessSnapshot<VsyncState>	UpdatedVsyncState;
 
 
 long long 	NanoTime()
@@ -11,7 +11,7 @@ Copyright   :   Copyright 2014 Oculus VR, LLC. All Rights reserved.
 #ifndef OVR_Vsync_h
 #define OVR_Vsync_h
 
-#include "Kernel/OVR_Lockless.h"	// for LocklessUpdater
+#include "Kernel/OVR_Lockless.h"	// for LocklessSnapshot
 
 // Application code should not interact with this, all timing information
 // should be taken from VrShell.
@@ -37,7 +37,7 @@ public:
 
 // This can be read without any locks, so a high priority rendering thread doesn't
 // have to worry about being blocked by a sensor thread that got preempted.
-extern OVR::LocklessUpdater<VsyncState>	UpdatedVsyncState;
+extern OVR::LocklessSnapshot<VsyncState>	UpdatedVsyncState;
 
 // Estimates the current vsync count and fraction based on the most
 // current timing provided from java.  This does not interact with
@@ -357,7 +357,8 @@ unsigned char * PanoBrowser::CreateThumbnail( const char * filename, int & outW,
 	}
 	else // otherwise we let ScaleImageRGBA upscale ( for users that really really want a low res pano )
 	{
-		outBuffer = ScaleImageRGBA( data, width, height, outW, outH, IMAGE_FILTER_CUBIC );
+		// called on a thumbnail worker thread, so scale on this thread only
+		outBuffer = ScaleImageRGBA( data, width, height, outW, outH, IMAGE_FILTER_CUBIC, 1 );
 	}
 	free( data );
 
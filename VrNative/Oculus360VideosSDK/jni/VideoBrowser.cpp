@@ -92,7 +92,7 @@ unsigned char * VideoBrowser::LoadThumbnail( const char * filename, int & width,
 		}
 
 		LOG( "VideoBrowser::LoadThumbnail resizing %s to %ix%i", filename, ThumbWidth, ThumbHeight );
-		unsigned char * outBuffer = ScaleImageRGBA( ( const unsigned char * )orig, width, height, ThumbWidth, ThumbHeight, IMAGE_FILTER_CUBIC );
+		unsigned char * outBuffer = ScaleImageRGBA( ( const unsigned char * )orig, width, height, ThumbWidth, ThumbHeight, IMAGE_FILTER_CUBIC, 1 );
 		free( orig );
 		
 		if ( outBuffer )
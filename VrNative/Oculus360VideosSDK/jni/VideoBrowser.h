@@ -58,6 +58,7 @@ public:
 	virtual void OnMediaNotFound( App * app, String & title, String & imageFile, String & message );
 
 private:
+	// Uses a single thumbnail worker, LoadThumbnail() reads from the apk, which isn't thread safe
 	VideoBrowser(
 		App * app,
 		const Array<String> & searchPaths,
@@ -69,7 +70,7 @@ private:
 		unsigned thumbWidth,
 		unsigned thumbHeight )
 		: OvrFolderBrowser( app, searchPaths, metaData,
-		panelWidth, panelHeight, radius, numSwipePanels, thumbWidth, thumbHeight )
+		panelWidth, panelHeight, radius, numSwipePanels, thumbWidth, thumbHeight, 1 )
 	{
 	}
 